@@ -25,31 +25,97 @@
  */
 
 #include "Application.h"
+#include "CommandLine.h"
+#include "Memory.h"
+#include "Startup.h"
+#include "Statistics.h"
 #include <config.h>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <glibmm/i18n.h>
 
 /**
  * Constructor of p GtkPassApplication. Initializes the base object and sets
- * its D-Bus name to "org.darth-revan.gtkpass".
+ * its D-Bus name to "org.darth-revan.gtkpass". Also registers the application's
+ * command line options. The about dialog is only created when it is shown.
  */
 GtkPassApplication::GtkPassApplication() :
-    Gtk::Application("org.darth-revan.gtkpass")
+    Gtk::Application("org.darth-revan.gtkpass"), m_printStatistics(false),
+    m_printStartup(false), m_appMenuLoaded(false)
     {
-        // set information for about dialog on startup
-        m_aboutDialog.set_program_name(PACKAGE_NAME);
-        m_aboutDialog.set_version(PACKAGE_VERSION);
-        m_aboutDialog.set_comments(_("A password generator with GTK-based graphical user interface."));
-        m_aboutDialog.set_license_type(Gtk::LICENSE_GPL_3_0);
-        m_aboutDialog.set_copyright(PROGRAM_AUTHOR);
-        m_aboutDialog.set_website("https://github.com/Darth-Revan/GtkPass");
-        m_aboutDialog.set_website_label(_("Visit on GitHub"));
-        m_aboutDialog.set_logo_icon_name("GtkPass");
-
-        std::vector<Glib::ustring> v_authors;
-        v_authors.push_back(PROGRAM_AUTHOR);
-        m_aboutDialog.set_authors(v_authors);
+        add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL, "stats", '\0',
+            _("Print password generation statistics on exit"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL, "startup-times", '\0',
+            _("Print the duration of the startup phases and quit after the first frame"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "manifest", 'm',
+            _("Provision passwords for the accounts in the CSV manifest FILE"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "output", 'o',
+            _("Write generated passwords to FILE instead of standard output"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT64, "count", 'n',
+            _("Write N passwords, one per line, without opening a window"),
+            _("N"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "policy", 'p',
+            _("Policy of the passwords written by --count or required by --audit"), _("POLICY"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "length", 'l',
+            _("Length of the passwords written by --count, minimum length for --audit"), _("N"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL, "unique", 'u',
+            _("Make every password written by --count unique"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "unique-memory", '\0',
+            _("Memory for finding duplicates in MiB before spilling to disk"),
+            _("MIB"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "format", 'f',
+            _("Output format of provisioned passwords: csv, jsonl or shell"),
+            _("FORMAT"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "file-method", '\0',
+            _("Write --count output files with mmap or pwrite"), _("METHOD"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "madvise", '\0',
+            _("Access advice for memory-mapped output files: normal, sequential, random or willneed"),
+            _("ADVICE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_STRING, "sync", '\0',
+            _("Flush --count output files to disk: none, async or full"),
+            _("MODE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL, "hash", '\0',
+            _("Also write an Argon2id hash of every provisioned password"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "hash-ops", '\0',
+            _("Number of passes of Argon2id"), _("N"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "hash-mem", '\0',
+            _("Memory used by a single hash in MiB"), _("MIB"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "hash-memory-budget", '\0',
+            _("Memory all parallel hashes may use together in MiB"), _("MIB"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "key", 'k',
+            _("Encrypt the provisioned passwords or decrypt an export with the key in FILE"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "generate-key", '\0',
+            _("Write a new random key for encrypted exports to FILE"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "decrypt", 'd',
+            _("Decrypt the encrypted export FILE"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "verify", '\0',
+            _("Check that the encrypted export FILE is complete and authentic"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "blocklist", '\0',
+            _("Generate passwords in the blocklist FILE again"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "build-blocklist", '\0',
+            _("Build a blocklist of the banned passwords in FILE, one per line"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "breach-index", '\0',
+            _("Warn about passwords found in the breach index FILE"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "build-breach-index", '\0',
+            _("Build a breach index of the sorted SHA-1 hashes in FILE"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "check-breached", '\0',
+            _("Write the passwords in FILE found in the breach index"), _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "audit", '\0',
+            _("Report the character classes, lengths and entropies of the passwords in FILE, one per line"),
+            _("FILE"));
+        add_main_option_entry(Gio::Application::OPTION_TYPE_INT, "threads", '\0',
+            _("Number of threads for hashing, encryption, writing files, --unique and --audit (default: one per hardware thread; hashing is also limited by its memory budget, encryption to 256 streams)"),
+            _("N"));
+        signal_handle_local_options().connect(
+            sigc::mem_fun(*this, &GtkPassApplication::on_handle_local_options),
+            false
+        );
     }
 
 
@@ -71,6 +137,9 @@ Glib::RefPtr<GtkPassApplication> GtkPassApplication::create() {
  */
 GtkPassWindow* GtkPassApplication::createApplicationWindow() {
     auto appWindow = GtkPassWindow::create();
+    appWindow->setBreachIndex(m_breachIndex.get());
+    appWindow->signal_firstFrame().connect(
+        sigc::mem_fun(*this, &GtkPassApplication::on_firstFrame));
     add_window(*appWindow);
     appWindow->signal_hide().connect(
         sigc::bind<Gtk::Window*>(sigc::mem_fun(
@@ -99,31 +168,185 @@ void GtkPassApplication::on_activate() {
 }
 
 /**
- * Overrides standard handler for \p on_startup(). Calls the original function
- * and builds the application's menu by using a \p Gtk::Builder.
+ * Overrides standard handler for \p on_startup(). Calls the original function,
+ * adds the application's actions and sets the application's menu, so it is
+ * known before the first window is realized. The menu stays empty until its
+ * items are loaded after the first frame of the window. The debug action
+ * "memory-report" has no menu item and is triggered with Ctrl+Shift+M or with
+ * "gapplication action org.darth-revan.gtkpass memory-report". The bulk
+ * generation dialog of the active window is opened with Ctrl+B.
  */
 void GtkPassApplication::on_startup() {
     Gtk::Application::on_startup();
     add_action("about",
         sigc::mem_fun(*this, &GtkPassApplication::on_actionAbout));
+    add_action("memory-report",
+        sigc::mem_fun(*this, &GtkPassApplication::on_actionMemoryReport));
+    set_accel_for_action("app.memory-report", "<Primary><Shift>m");
+    set_accel_for_action("win.bulk", "<Primary>b");
+    m_appMenu = Gio::Menu::create();
+    set_app_menu(m_appMenu);
+    markStartup("startup");
+}
+
+/**
+ * Signal handler for the first frame of a window. Loads the items of the
+ * application's menu if this was not done before. With
+ * \p --startup-times, prints the duration of the startup phases and quits.
+ */
+void GtkPassApplication::on_firstFrame() {
+    loadAppMenu();
+    if (!m_printStartup)
+        return;
+    markStartup("first frame");
+    printStartupTimes(std::cout, getStartupMarks());
+    m_printStartup = false;
+    quit();
+}
+
+/**
+ * Builds the application's menu by using a \p Gtk::Builder and copies its
+ * items into the menu set on startup. It is only shown on request, so it is
+ * not parsed before the window is visible.
+ */
+void GtkPassApplication::loadAppMenu() {
+    if (m_appMenuLoaded)
+        return;
+    m_appMenuLoaded = true;
 
     // create the builder
     auto refBuilder = Gtk::Builder::create();
     try {
         refBuilder->add_from_resource("/org/darth-revan/gtkpass/appMenu.ui");
     } catch (const Glib::Error& ex) {
-        std::cerr << "GtkPassApplication::on_startup(): " << ex.what()
+        std::cerr << "GtkPassApplication::loadAppMenu(): " << ex.what()
             << std::endl;
         return;
     }
 
-    // load the menu from resource and set it as menu
+    // load the menu from resource and fill the menu of the application
     auto obj = refBuilder->get_object("appmenu");
     auto appMenu = Glib::RefPtr<Gio::MenuModel>::cast_dynamic(obj);
-    if (appMenu)
-        set_app_menu(appMenu);
-    else
-        std::cerr << "GtkPassApplication::on_startup(): No \"appmenu\" object in appMenu.ui!" << std::endl;
+    if (appMenu) {
+        for (int i = 0; i < appMenu->get_n_items(); i++) {
+            m_appMenu->append_item(Gio::MenuItem::create(appMenu, i));
+        }
+    } else {
+        std::cerr << "GtkPassApplication::loadAppMenu(): No \"appmenu\" object in appMenu.ui!" << std::endl;
+    }
+}
+
+/**
+ * Overrides standard handler for \p on_shutdown(). Prints the generation
+ * statistics if requested on the command line and calls the original function.
+ */
+void GtkPassApplication::on_shutdown() {
+    if (m_printStatistics)
+        printStatistics(std::cout, getStatistics());
+    Gtk::Application::on_shutdown();
+}
+
+/**
+ * Signal handler for the command line options handled in the local instance.
+ * Runs the non-interactive modes without starting the GUI.
+ *
+ * \param options Dictionary holding the parsed command line options
+ * \return -1 to continue with the default processing of the application,
+ * otherwise the exit status of the non-interactive mode
+ */
+int GtkPassApplication::on_handle_local_options(
+    const Glib::RefPtr<Glib::VariantDict>& options) {
+    options->lookup_value("stats", m_printStatistics);
+    options->lookup_value("startup-times", m_printStartup);
+
+    cmdopts cmdOptions;
+    Glib::ustring value;
+    if (options->lookup_value("manifest", value))
+        cmdOptions.manifest = value;
+    if (options->lookup_value("output", value))
+        cmdOptions.output = value;
+
+    if (options->lookup_value("policy", value))
+        cmdOptions.policy = value;
+    gint64 count;
+    if (options->lookup_value("count", count)) {
+        if (count <= 0) {
+            std::cerr << "ERROR: Invalid count " << count << "!" << std::endl;
+            return 1;
+        }
+        cmdOptions.count = count;
+    }
+    if (options->lookup_value("format", value) &&
+        !parseOutputFormat(value, cmdOptions.provisioning.format)) {
+        std::cerr << "ERROR: Unknown output format \"" << value << "\"!" << std::endl;
+        return 1;
+    }
+    if (options->lookup_value("file-method", value) &&
+        !parseFileMethod(value, cmdOptions.file.method)) {
+        std::cerr << "ERROR: Unknown file output method \"" << value << "\"!" << std::endl;
+        return 1;
+    }
+    if (options->lookup_value("madvise", value) &&
+        !parseFileAdvice(value, cmdOptions.file.advice)) {
+        std::cerr << "ERROR: Unknown memory advice \"" << value << "\"!" << std::endl;
+        return 1;
+    }
+    if (options->lookup_value("sync", value) &&
+        !parseFileSync(value, cmdOptions.file.sync)) {
+        std::cerr << "ERROR: Unknown synchronization \"" << value << "\"!" << std::endl;
+        return 1;
+    }
+    options->lookup_value("unique", cmdOptions.unique);
+    options->lookup_value("hash", cmdOptions.provisioning.hash);
+    int number;
+    if (options->lookup_value("hash-ops", number))
+        cmdOptions.provisioning.hashing.opsLimit = number > 0 ? number : 0;
+    if (options->lookup_value("hash-mem", number))
+        cmdOptions.provisioning.hashing.memLimit = number > 0 ? size_t(number) << 20 : 0;
+    if (options->lookup_value("hash-memory-budget", number))
+        cmdOptions.provisioning.hashing.memoryBudget = number > 0 ? size_t(number) << 20 : 0;
+    if (options->lookup_value("unique-memory", number))
+        cmdOptions.uniqueness.memoryLimit = number > 0 ? size_t(number) << 20 : 0;
+    if (options->lookup_value("length", number))
+        cmdOptions.length = number > 0 ? number : 0;
+    if (options->lookup_value("threads", number))
+        cmdOptions.threads = number > 0 ? number : 0;
+
+    std::string path;
+    if (options->lookup_value("key", path))
+        cmdOptions.keyFile = path;
+    if (options->lookup_value("generate-key", path))
+        cmdOptions.generateKey = path;
+    if (options->lookup_value("decrypt", path))
+        cmdOptions.decrypt = path;
+    if (options->lookup_value("verify", path))
+        cmdOptions.verify = path;
+    if (options->lookup_value("blocklist", path))
+        cmdOptions.blocklist = path;
+    if (options->lookup_value("build-blocklist", path))
+        cmdOptions.buildBlocklist = path;
+    if (options->lookup_value("breach-index", path))
+        cmdOptions.breachIndex = path;
+    if (options->lookup_value("build-breach-index", path))
+        cmdOptions.buildBreachIndex = path;
+    if (options->lookup_value("check-breached", path))
+        cmdOptions.checkBreached = path;
+    if (options->lookup_value("audit", path))
+        cmdOptions.audit = path;
+
+    const int status = runCommandLine(cmdOptions);
+    if (status >= 0 && m_printStatistics)
+        printStatistics(std::cerr, getStatistics());
+    if (status < 0 && !cmdOptions.breachIndex.empty()) {
+        // the GUI keeps the index mapped while it is running
+        try {
+            m_breachIndex.reset(new BreachIndex(cmdOptions.breachIndex));
+        } catch (const std::runtime_error& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return status;
 }
 
 /**
@@ -137,10 +360,35 @@ void GtkPassApplication::on_hide_window(Gtk::Window* window) {
 
 /**
  * Handler for clicking on the menu item "About". Shows a simple about dialog
- * for the application.
+ * for the application, which is created the first time.
  */
 void GtkPassApplication::on_actionAbout() {
-    m_aboutDialog.set_transient_for(*(this->get_active_window()));
-    m_aboutDialog.show();
-    m_aboutDialog.present();
+    if (!m_aboutDialog) {
+        m_aboutDialog.reset(new Gtk::AboutDialog());
+        m_aboutDialog->set_program_name(PACKAGE_NAME);
+        m_aboutDialog->set_version(PACKAGE_VERSION);
+        m_aboutDialog->set_comments(_("A password generator with GTK-based graphical user interface."));
+        m_aboutDialog->set_license_type(Gtk::LICENSE_GPL_3_0);
+        m_aboutDialog->set_copyright(PROGRAM_AUTHOR);
+        m_aboutDialog->set_website("https://github.com/Darth-Revan/GtkPass");
+        m_aboutDialog->set_website_label(_("Visit on GitHub"));
+        m_aboutDialog->set_logo_icon_name("GtkPass");
+
+        std::vector<Glib::ustring> v_authors;
+        v_authors.push_back(PROGRAM_AUTHOR);
+        m_aboutDialog->set_authors(v_authors);
+    }
+    m_aboutDialog->set_transient_for(*(this->get_active_window()));
+    m_aboutDialog->show();
+    m_aboutDialog->present();
+}
+
+/**
+ * Handler for the debug action "memory-report". Prints the number of open
+ * windows and the memory usage of the process to the standard output.
+ */
+void GtkPassApplication::on_actionMemoryReport() {
+    std::cout << "Application windows:   " << get_windows().size() << std::endl
+        << "Toplevel windows:      " << Gtk::Window::list_toplevels().size() << std::endl;
+    printMemoryUsage(std::cout, getMemoryUsage());
 }
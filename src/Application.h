@@ -27,7 +27,9 @@
 #ifndef GTKPASS_APPLICATION_H
 #define GTKPASS_APPLICATION_H
 
+#include "BreachIndex.h"
 #include "MainWindow.h"
+#include <memory>
 
 /// GtkPass' application class as a subclass of \p Gtk::Application
 class GtkPassApplication : public Gtk::Application {
@@ -39,12 +41,30 @@ protected:
     GtkPassApplication();
     void on_activate() override;
     void on_startup() override;
+    void on_shutdown() override;
 
 private:
-    Gtk::AboutDialog m_aboutDialog;
+    /// About dialog, created when it is shown for the first time
+    std::unique_ptr<Gtk::AboutDialog> m_aboutDialog;
+    /// Whether to print the generation statistics on shutdown
+    bool m_printStatistics;
+    /// Whether to print the startup times after the first frame and quit
+    bool m_printStartup;
+    /// The application menu, set empty on startup and filled after the
+    /// first frame
+    Glib::RefPtr<Gio::Menu> m_appMenu;
+    /// Whether the items of the application menu were loaded
+    bool m_appMenuLoaded;
+    /// Index of breached passwords the windows check passwords against
+    /// (empty if none)
+    std::unique_ptr<BreachIndex> m_breachIndex;
+    int on_handle_local_options(const Glib::RefPtr<Glib::VariantDict>& options);
     GtkPassWindow* createApplicationWindow();
     void on_hide_window(Gtk::Window* window);
+    void on_firstFrame();
+    void loadAppMenu();
     void on_actionAbout();
+    void on_actionMemoryReport();
 
 }; // end of class GtkPassApplication
 
@@ -0,0 +1,317 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    AsyncGenerator.cpp
+ * \brief   Implements a class generating passwords on a worker thread.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a class generating passwords on a worker thread.
+ */
+
+#include "AsyncGenerator.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+/// Overwrites the characters of \p password with zeros and empties it
+void wipe(std::string& password) {
+    if (!password.empty())
+        sodium_memzero(&password[0], password.size());
+    password.clear();
+}
+
+} // end of anonymous namespace
+
+/**
+ * Password in the pool, stored in memory allocated with \p sodium_malloc()
+ * together with the number of the pool settings it was generated for.
+ */
+struct AsyncGenerator::PooledPassword {
+    /// Generates \p length characters of \p alphabet right into locked
+    /// memory
+    PooledPassword(uint64_t serial, size_t length, const std::string& alphabet) :
+        serial(serial), length(length), data(static_cast<char*>(sodium_malloc(length))) {
+        if (!data)
+            throw std::bad_alloc();
+        fillRandomChars(data, length, alphabet);
+    }
+
+    /// Wipes and frees the password
+    ~PooledPassword() {
+        sodium_free(data);
+    }
+
+    PooledPassword(const PooledPassword&) = delete;
+    PooledPassword& operator=(const PooledPassword&) = delete;
+
+    /// number of the pool settings
+    uint64_t serial;
+    /// number of characters
+    size_t length;
+    /// the characters
+    char* data;
+};
+
+/**
+ * Constructor of \p AsyncGenerator. Starts the worker thread.
+ *
+ * \param notify Function called on the worker thread whenever a password
+ * is ready to be taken with \p takePassword()
+ */
+AsyncGenerator::AsyncGenerator(const std::function<void()>& notify) :
+    m_notify(notify), m_serial(0), m_finished(0), m_length(0), m_options(),
+    m_poolSerial(0), m_poolLength(0), m_poolOptions(), m_pool(new Pool(ASYNC_POOL_SIZE)),
+    m_ready(false), m_stop(false) {
+    m_worker = std::thread(&AsyncGenerator::run, this);
+}
+
+/**
+ * Destructor of \p AsyncGenerator. Cancels the running generation and
+ * waits for the worker thread.
+ */
+AsyncGenerator::~AsyncGenerator() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_serial++;
+    }
+    m_requested.notify_one();
+    m_worker.join();
+    wipe(m_password);
+}
+
+/**
+ * Requests a password of \p length characters generated with
+ * \p options. A request with the same length and options as the one
+ * being generated is merged into it, so repeated clicks produce a single
+ * password; any other request cancels it.
+ *
+ * \param length The number of characters
+ * \param options The options for the generation
+ */
+void AsyncGenerator::request(uint32_t length, const genopts& options) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_finished != m_serial && m_length == length &&
+            getOptionsMask(m_options) == getOptionsMask(options))
+            return;
+        m_serial++;
+        m_length = length;
+        m_options = options;
+        // the new password replaces one that was not taken yet
+        wipe(m_password);
+        m_ready = false;
+    }
+    m_requested.notify_one();
+}
+
+/**
+ * Cancels the requested password. A password that is already ready is
+ * discarded as well.
+ */
+void AsyncGenerator::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_finished != m_serial)
+        m_serial++;
+    m_finished = m_serial;
+    wipe(m_password);
+    m_ready = false;
+}
+
+/**
+ * Sets the length and the options of the passwords to prefetch. The
+ * passwords prefetched for other settings are discarded and the pool
+ * is refilled by the worker. Must be called by the thread taking the
+ * passwords.
+ *
+ * \param length The number of characters (0 or more than
+ * \p ASYNC_POOL_MAX_LENGTH to stop prefetching)
+ * \param options The options for the generation
+ */
+void AsyncGenerator::prefetch(uint32_t length, const genopts& options) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_poolSerial++;
+        const bool enabled = length <= ASYNC_POOL_MAX_LENGTH && !getAlphabet(options).empty();
+        m_poolLength = enabled ? length : 0;
+        m_poolOptions = options;
+    }
+    // passwords the worker pushes for the old settings are discarded when
+    // they are taken
+    std::unique_ptr<PooledPassword> discarded;
+    while (m_pool->tryPop(discarded)) {
+        discarded.reset();
+    }
+    wake();
+}
+
+/**
+ * Moves a prefetched password into \p password without waiting.
+ *
+ * \param password Receives the password
+ * \return \p true if a password was prefetched, \p false if the pool is
+ * empty
+ */
+bool AsyncGenerator::takePrefetched(std::string& password) {
+    return takePrefetched([&password](const char* data, size_t length) {
+        password.assign(data, length);
+    });
+}
+
+/**
+ * Hands a prefetched password to \p consume without waiting. The
+ * characters are passed in the locked memory of the pool, which is wiped
+ * right after the call, so they can be copied into other locked memory
+ * without any copy in between.
+ *
+ * \param consume Function receiving the characters of the password and
+ * their number
+ * \return \p true if a password was prefetched, \p false if the pool is
+ * empty
+ */
+bool AsyncGenerator::takePrefetched(const PasswordConsumer& consume) {
+    std::unique_ptr<PooledPassword> pooled;
+    while (m_pool->tryPop(pooled)) {
+        if (pooled->serial == m_poolSerial.load()) {
+            consume(pooled->data, pooled->length);
+            pooled.reset();
+            wake();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns whether a requested password is not ready yet.
+ *
+ * \return \p true while generating, \p false otherwise
+ */
+bool AsyncGenerator::isBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished != m_serial;
+}
+
+/**
+ * Moves the last password that was generated into \p password.
+ *
+ * \param password Receives the password
+ * \return \p true if a password was ready, \p false otherwise
+ */
+bool AsyncGenerator::takePassword(std::string& password) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_ready)
+        return false;
+    password.swap(m_password);
+    wipe(m_password);
+    m_ready = false;
+    return true;
+}
+
+/**
+ * Hands the last password that was generated to \p consume and wipes it
+ * afterwards. \p consume is called with the lock held and must not call
+ * the generator.
+ *
+ * \param consume Function receiving the characters of the password and
+ * their number
+ * \return \p true if a password was ready, \p false otherwise
+ */
+bool AsyncGenerator::takePassword(const PasswordConsumer& consume) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_ready)
+        return false;
+    consume(m_password.data(), m_password.size());
+    wipe(m_password);
+    m_ready = false;
+    return true;
+}
+
+/**
+ * Generates the requested passwords until the generator is destroyed. The
+ * password is generated in chunks without holding the lock, and dropped if
+ * another request arrives in the meantime. Without request, the pool is
+ * filled one password at a time.
+ */
+void AsyncGenerator::run() {
+    std::string password;
+    while (true) {
+        uint64_t serial;
+        uint32_t length;
+        genopts options;
+        bool requested;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_requested.wait(lock, [this]() {
+                return m_stop || m_finished != m_serial ||
+                    (m_poolLength > 0 && m_pool->size() < ASYNC_POOL_SIZE);
+            });
+            if (m_stop)
+                return;
+            // requested passwords go first
+            requested = m_finished != m_serial;
+            serial = requested ? m_serial.load() : m_poolSerial.load();
+            length = requested ? m_length : m_poolLength;
+            options = requested ? m_options : m_poolOptions;
+        }
+
+        if (!requested) {
+            if (m_poolSerial == serial)
+                m_pool->tryPush(std::unique_ptr<PooledPassword>(
+                    new PooledPassword(serial, length, getAlphabet(options))));
+            continue;
+        }
+
+        // reserving the whole password leaves no copies in freed memory
+        password.reserve(length);
+        while (password.size() < length && m_serial == serial) {
+            const uint32_t chunk = std::min<uint32_t>(ASYNC_CHUNK_LENGTH,
+                length - static_cast<uint32_t>(password.size()));
+            std::string part = getRandomString(chunk, options);
+            password += part;
+            wipe(part);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_serial != serial) {
+                wipe(password);
+                continue;
+            }
+            password.swap(m_password);
+            m_ready = true;
+            m_finished = serial;
+        }
+        wipe(password);
+        m_notify();
+    }
+}
+
+/**
+ * Wakes the worker up. Taking the lock first ensures the worker either sees
+ * the change before it waits or gets the notification.
+ */
+void AsyncGenerator::wake() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_requested.notify_one();
+}
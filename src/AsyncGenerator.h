@@ -0,0 +1,217 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    AsyncGenerator.h
+ * \brief   Defines a class generating passwords on a worker thread.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a class that generates passwords on a worker thread, so
+ * the GTK main loop keeps drawing frames while long passwords are generated.
+ * The worker generates in chunks of \p ASYNC_CHUNK_LENGTH characters and
+ * checks between two chunks whether the request was replaced, so changing
+ * the options cancels a running generation within one chunk.
+ *
+ * While no password is requested, the worker fills a pool of passwords for
+ * the current settings, so a click can be answered without waiting at all.
+ * The pool is a lock-free ring of \p ASYNC_POOL_SIZE passwords filled by the
+ * worker and emptied by the main loop. The passwords are generated right
+ * into memory allocated with \p sodium_malloc(), which is locked into RAM,
+ * surrounded by guard pages and wiped when freed. A password can be handed
+ * to a function instead of a \p std::string, so it can be copied straight
+ * into other locked memory, like the buffer of the password field.
+ */
+
+#ifndef GTKPASS_ASYNCGENERATOR_H
+#define GTKPASS_ASYNCGENERATOR_H
+
+#include "RandomGenerator.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// Number of characters the worker generates before checking whether the
+/// request was cancelled
+#define ASYNC_CHUNK_LENGTH 65536
+/// Number of passwords prefetched for the current settings
+#define ASYNC_POOL_SIZE 8
+/// Maximum length of prefetched passwords; longer passwords are only
+/// generated on request, as the pool is locked into RAM
+#define ASYNC_POOL_MAX_LENGTH 4096
+
+/**
+ * Generates passwords on a worker thread. Requests are made and results are
+ * taken on one thread, usually the GTK main loop; the worker calls a
+ * notification function whenever a password is ready, which must hand it
+ * over to that thread, e.g. with a \p Glib::Dispatcher.
+ */
+class AsyncGenerator {
+
+public:
+    /// Function receiving the characters of a password and their number;
+    /// the characters are wiped after the call
+    typedef std::function<void(const char* password, size_t length)> PasswordConsumer;
+
+    /**
+     * Constructor of \p AsyncGenerator. Starts the worker thread.
+     *
+     * \param notify Function called on the worker thread whenever a password
+     * is ready to be taken with \p takePassword()
+     */
+    explicit AsyncGenerator(const std::function<void()>& notify);
+
+    /**
+     * Destructor of \p AsyncGenerator. Cancels the running generation and
+     * waits for the worker thread.
+     */
+    ~AsyncGenerator();
+
+    /**
+     * Requests a password of \p length characters generated with
+     * \p options. A request with the same length and options as the one
+     * being generated is merged into it, so repeated clicks produce a single
+     * password; any other request cancels it.
+     *
+     * \param length The number of characters
+     * \param options The options for the generation
+     */
+    void request(uint32_t length, const genopts& options);
+
+    /**
+     * Cancels the requested password. A password that is already ready is
+     * discarded as well.
+     */
+    void cancel();
+
+    /**
+     * Sets the length and the options of the passwords to prefetch. The
+     * passwords prefetched for other settings are discarded and the pool
+     * is refilled by the worker. Must be called by the thread taking the
+     * passwords.
+     *
+     * \param length The number of characters (0 or more than
+     * \p ASYNC_POOL_MAX_LENGTH to stop prefetching)
+     * \param options The options for the generation
+     */
+    void prefetch(uint32_t length, const genopts& options);
+
+    /**
+     * Moves a prefetched password into \p password without waiting.
+     *
+     * \param password Receives the password
+     * \return \p true if a password was prefetched, \p false if the pool is
+     * empty
+     */
+    bool takePrefetched(std::string& password);
+
+    /**
+     * Hands a prefetched password to \p consume without waiting. The
+     * characters are passed in the locked memory of the pool, which is wiped
+     * right after the call, so they can be copied into other locked memory
+     * without any copy in between.
+     *
+     * \param consume Function receiving the characters of the password and
+     * their number
+     * \return \p true if a password was prefetched, \p false if the pool is
+     * empty
+     */
+    bool takePrefetched(const PasswordConsumer& consume);
+
+    /**
+     * Returns whether a requested password is not ready yet.
+     *
+     * \return \p true while generating, \p false otherwise
+     */
+    bool isBusy() const;
+
+    /**
+     * Moves the last password that was generated into \p password.
+     *
+     * \param password Receives the password
+     * \return \p true if a password was ready, \p false otherwise
+     */
+    bool takePassword(std::string& password);
+
+    /**
+     * Hands the last password that was generated to \p consume and wipes it
+     * afterwards. \p consume is called with the lock held and must not call
+     * the generator.
+     *
+     * \param consume Function receiving the characters of the password and
+     * their number
+     * \return \p true if a password was ready, \p false otherwise
+     */
+    bool takePassword(const PasswordConsumer& consume);
+
+private:
+    AsyncGenerator(const AsyncGenerator&) = delete;
+    AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+    /// Password in the pool, defined in \p AsyncGenerator.cpp
+    struct PooledPassword;
+    /// Lock-free ring of prefetched passwords
+    typedef SpscQueue<std::unique_ptr<PooledPassword>> Pool;
+
+    /// Generates the requested passwords until the generator is destroyed
+    void run();
+    /// Wakes the worker up
+    void wake();
+
+    /// function called when a password is ready
+    std::function<void()> m_notify;
+    /// protects the members below, except the lock-free pool
+    mutable std::mutex m_mutex;
+    /// signals new requests to the worker
+    std::condition_variable m_requested;
+    /// number of the latest request, incremented by every request that is
+    /// not merged and by every cancellation
+    std::atomic<uint64_t> m_serial;
+    /// number of the request the worker has finished or dropped
+    uint64_t m_finished;
+    /// length of the latest request
+    uint32_t m_length;
+    /// options of the latest request
+    genopts m_options;
+    /// number of the pool settings, incremented by every \p prefetch();
+    /// pooled passwords of older numbers are discarded
+    std::atomic<uint64_t> m_poolSerial;
+    /// length of the prefetched passwords (0 for none)
+    uint32_t m_poolLength;
+    /// options of the prefetched passwords
+    genopts m_poolOptions;
+    /// the prefetched passwords, allocated on its own for the cache line
+    /// alignment of the indices
+    std::unique_ptr<Pool> m_pool;
+    /// the password ready to be taken
+    std::string m_password;
+    /// whether \p m_password holds a password
+    bool m_ready;
+    /// whether the worker has to stop
+    bool m_stop;
+    /// the worker generating the passwords
+    std::thread m_worker;
+
+}; // end of class AsyncGenerator
+
+#endif
@@ -0,0 +1,104 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    AsyncGenerator_Bench.cpp
+ * \brief   Benchmarks the files \p AsyncGenerator.h and \p AsyncGenerator.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p AsyncGenerator.h and \p AsyncGenerator.cpp.
+ */
+
+#include "Benchmark.h"
+#include "AsyncGenerator.h"
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+/// Number of clicks per length and method
+static const size_t CLICKS = 200;
+
+/// Writes the median and the largest of the latencies in \p samples to
+/// \p out
+static void printLatency(std::ostream& out, const char* label, uint32_t length,
+    std::vector<uint64_t>& samples) {
+    const uint64_t p50 = getPercentile(samples, 50.0);
+    const uint64_t max = getPercentile(samples, 100.0);
+    out << std::left << std::setw(12) << label << std::right << std::setw(8) << length
+        << " characters: p50 " << std::setw(9) << std::fixed << std::setprecision(1)
+        << p50 / 1000.0 << " us  max " << std::setw(9) << max / 1000.0 << " us"
+        << std::endl;
+}
+
+/// Measures the time from a click on "Generate" until the password can be
+/// shown: generating on the main loop, requesting it from the worker thread
+/// and taking a prefetched one. The clicks are 2 ms apart, so the pool is
+/// refilled in between like between the clicks of a user.
+BENCHMARK_CASE(click_latency) {
+    std::mutex mutex;
+    std::condition_variable arrived;
+    bool ready = false;
+    AsyncGenerator generator([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready = true;
+        arrived.notify_one();
+    });
+    genopts options;
+    options.bIncludeSpecial = true;
+    std::string password;
+
+    for (const uint32_t length : {12, 100, ASYNC_POOL_MAX_LENGTH}) {
+        std::vector<uint64_t> samples;
+        for (size_t i = 0; i < CLICKS; i++) {
+            const uint64_t start = getNanoseconds();
+            password = getRandomString(length, options);
+            samples.push_back(getNanoseconds() - start);
+        }
+        printLatency(out, "synchronous", length, samples);
+
+        samples.clear();
+        for (size_t i = 0; i < CLICKS; i++) {
+            const uint64_t start = getNanoseconds();
+            generator.request(length, options);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                arrived.wait(lock, [&]() { return ready; });
+                ready = false;
+            }
+            generator.takePassword(password);
+            samples.push_back(getNanoseconds() - start);
+        }
+        printLatency(out, "worker", length, samples);
+
+        samples.clear();
+        generator.prefetch(length, options);
+        for (size_t i = 0; i < CLICKS; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            const uint64_t start = getNanoseconds();
+            if (!generator.takePrefetched(password))
+                continue;
+            samples.push_back(getNanoseconds() - start);
+        }
+        out << "prefetched " << samples.size() << " of " << CLICKS << " clicks" << std::endl;
+        if (!samples.empty())
+            printLatency(out, "prefetched", length, samples);
+        generator.prefetch(0, options);
+    }
+}
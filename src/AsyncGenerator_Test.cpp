@@ -0,0 +1,243 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    AsyncGenerator_Test.cpp
+ * \brief   Tests the files \p AsyncGenerator.h and \p AsyncGenerator.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p AsyncGenerator.h and \p AsyncGenerator.cpp.
+ */
+
+#include "catch.hpp"
+#include "AsyncGenerator.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/// Number of characters of the long passwords, 10 MB
+static const uint32_t LONG_LENGTH = 10000000;
+
+/// Counts the notifications of an \p AsyncGenerator like a dispatcher
+struct Notifications {
+    Notifications() : count(0) {}
+
+    /// Called by the worker thread
+    void notify() {
+        std::lock_guard<std::mutex> lock(mutex);
+        count++;
+        arrived.notify_all();
+    }
+
+    /// Returns the number of notifications
+    unsigned int get() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    /// Waits until \p expected notifications arrived
+    void wait(unsigned int expected) {
+        std::unique_lock<std::mutex> lock(mutex);
+        arrived.wait(lock, [&]() { return count >= expected; });
+    }
+
+    /// protects \p count
+    std::mutex mutex;
+    /// signals new notifications
+    std::condition_variable arrived;
+    /// number of notifications
+    unsigned int count;
+};
+
+/// Returns whether every character of \p password is in the alphabet of
+/// \p options
+static bool isInAlphabet(const std::string& password, const genopts& options) {
+    return password.find_first_not_of(getAlphabet(options)) == std::string::npos;
+}
+
+/// Tests the class \p AsyncGenerator
+TEST_CASE("AsyncGenerator", "[AsyncGenerator]") {
+    Notifications notifications;
+    AsyncGenerator generator([&]() { notifications.notify(); });
+    genopts options;
+    std::string password;
+    REQUIRE(generator.isBusy() == false);
+    REQUIRE(generator.takePassword(password) == false);
+
+    SECTION("Single password") {
+        generator.request(20, options);
+        notifications.wait(1);
+        REQUIRE(generator.isBusy() == false);
+        REQUIRE(generator.takePassword(password));
+        REQUIRE(password.size() == 20);
+        REQUIRE(isInAlphabet(password, options));
+        REQUIRE(generator.takePassword(password) == false);
+    }
+
+    SECTION("Repeated requests are merged") {
+        for (size_t i = 0; i < 50; i++) {
+            generator.request(LONG_LENGTH, options);
+        }
+        notifications.wait(1);
+        REQUIRE(generator.isBusy() == false);
+        REQUIRE(generator.takePassword(password));
+        REQUIRE(password.size() == LONG_LENGTH);
+        REQUIRE(notifications.get() == 1);
+    }
+
+    SECTION("Changed options cancel the generation") {
+        generator.request(LONG_LENGTH, options);
+        genopts numbers;
+        numbers.bIncludeLettersLower = false;
+        numbers.bIncludeLettersUpper = false;
+        generator.request(10, numbers);
+        // the cancelled password may or may not have been finished before
+        notifications.wait(1);
+        while (generator.isBusy()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(generator.takePassword(password));
+        REQUIRE(password.size() == 10);
+        REQUIRE(isInAlphabet(password, numbers));
+    }
+
+    SECTION("Cancel") {
+        generator.request(LONG_LENGTH, options);
+        generator.cancel();
+        REQUIRE(generator.isBusy() == false);
+        REQUIRE(generator.takePassword(password) == false);
+        const unsigned int before = notifications.get();
+        generator.request(5, options);
+        notifications.wait(before + 1);
+        REQUIRE(generator.takePassword(password));
+        REQUIRE(password.size() == 5);
+    }
+}
+
+/// Takes a prefetched password from \p generator into \p password,
+/// waiting up to a second for the pool to be filled
+static bool waitForPrefetched(AsyncGenerator& generator, std::string& password) {
+    for (size_t i = 0; i < 1000; i++) {
+        if (generator.takePrefetched(password))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/// Tests the pool of prefetched passwords of \p AsyncGenerator
+TEST_CASE("AsyncGenerator pool", "[AsyncGenerator]") {
+    Notifications notifications;
+    AsyncGenerator generator([&]() { notifications.notify(); });
+    genopts options;
+    std::string password;
+    REQUIRE(generator.takePrefetched(password) == false);
+
+    generator.prefetch(16, options);
+    std::set<std::string> passwords;
+    for (size_t i = 0; i < 3 * ASYNC_POOL_SIZE; i++) {
+        REQUIRE(waitForPrefetched(generator, password));
+        REQUIRE(password.size() == 16);
+        REQUIRE(isInAlphabet(password, options));
+        passwords.insert(password);
+    }
+    REQUIRE(passwords.size() == 3 * ASYNC_POOL_SIZE);
+
+    // passwords of the old settings are never taken
+    genopts numbers;
+    numbers.bIncludeLettersLower = false;
+    numbers.bIncludeLettersUpper = false;
+    generator.prefetch(6, numbers);
+    for (size_t i = 0; i < 3 * ASYNC_POOL_SIZE; i++) {
+        REQUIRE(waitForPrefetched(generator, password));
+        REQUIRE(password.size() == 6);
+        REQUIRE(isInAlphabet(password, numbers));
+    }
+
+    // the characters can be handed to a function instead of a string
+    std::string consumed;
+    const auto consume = [&consumed](const char* data, size_t length) {
+        consumed.assign(data, length);
+    };
+    bool taken = false;
+    for (size_t i = 0; i < 1000 && !taken; i++) {
+        taken = generator.takePrefetched(consume);
+        if (!taken)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(taken);
+    REQUIRE(consumed.size() == 6);
+    REQUIRE(isInAlphabet(consumed, numbers));
+
+    // requests are not taken from the pool and go first
+    generator.request(20, options);
+    notifications.wait(1);
+    REQUIRE(generator.takePassword(password));
+    REQUIRE(password.size() == 20);
+    generator.request(30, options);
+    notifications.wait(2);
+    REQUIRE(generator.takePassword(consume));
+    REQUIRE(consumed.size() == 30);
+    REQUIRE(generator.takePassword(consume) == false);
+
+    generator.prefetch(ASYNC_POOL_MAX_LENGTH + 1, options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(generator.takePrefetched(password) == false);
+    generator.prefetch(0, options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(generator.takePrefetched(password) == false);
+}
+
+/// Tests that neither \p request() nor polling with \p takePassword() blocks
+/// the calling thread while a password of 10 MB is generated. The thread
+/// sleeps between polls like an idle main loop; it is not a GLib main loop,
+/// so this bounds the time spent in the generator's calls, not the frame
+/// times of the window.
+TEST_CASE("AsyncGenerator request and poll latency", "[AsyncGenerator]") {
+    typedef std::chrono::steady_clock clock;
+    Notifications notifications;
+    AsyncGenerator generator([&]() { notifications.notify(); });
+    genopts options;
+    options.bIncludeSpecial = true;
+
+    clock::time_point last = clock::now();
+    generator.request(LONG_LENGTH, options);
+    clock::duration longestPoll = clock::now() - last;
+    size_t polls = 0;
+    std::string password;
+    while (!generator.takePassword(password)) {
+        // one iteration of a polling loop with nothing else to do
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const clock::time_point now = clock::now();
+        longestPoll = std::max(longestPoll, now - last);
+        last = now;
+        polls++;
+    }
+    INFO(polls << " polls, longest iteration "
+        << std::chrono::duration_cast<std::chrono::microseconds>(longestPoll).count()
+        << " us");
+    REQUIRE(password.size() == LONG_LENGTH);
+    REQUIRE(isInAlphabet(password, options));
+    // an iteration must fit into a frame at 60 Hz (16.7 ms) with room to
+    // spare; generating synchronously blocks for the whole password
+    REQUIRE(longestPoll < std::chrono::milliseconds(50));
+    REQUIRE(polls > 1);
+}
@@ -0,0 +1,573 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Audit.cpp
+ * \brief   Implements functions for auditing lists of existing passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for auditing lists of existing passwords.
+ */
+
+#include "Audit.h"
+#include "Policy.h"
+#include "Scheduler.h"
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <tmmintrin.h>
+#   define AUDIT_HAVE_SSSE3
+#endif
+
+namespace {
+
+/// Number of bytes classified at once by the vectorized classification
+const size_t BLOCK_SIZE = 64;
+/// Number of bytes of a regular file audited by one task
+const size_t PART_SIZE = 64 << 20;
+/// Number of bytes read at once from files that cannot be mapped
+const size_t READ_SIZE = 16 << 20;
+/// Class bit of a character that is similar to another one
+const unsigned int SIMILAR_CHARACTER = 0x40;
+/// Class bits of the character classes of \p genopts
+const unsigned int CHARACTER_CLASSES = GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER |
+    GENOPTS_NUMBERS | GENOPTS_SPACE | GENOPTS_DASH | GENOPTS_SPECIAL;
+/// Smallest entropies of the entropy levels 2 to 5 in bits, as used by the
+/// level bar of the window
+const unsigned int ENTROPY_LEVEL_BITS[AUDIT_ENTROPY_LEVELS - 1] = {64, 80, 96, 112};
+
+/**
+ * Lookup table of the classes of every byte: the \p GENOPTS_* class bits
+ * and \p SIMILAR_CHARACTER, or 0 for bytes in no class.
+ */
+struct ClassTable {
+    ClassTable() : classes() {
+        const struct {
+            const char* characters;
+            unsigned int bits;
+        } alphabets[] = {
+            {ALPHA_LETTERS_LOWER, GENOPTS_LETTERS_LOWER},
+            {ALPHA_LETTERS_UPPER, GENOPTS_LETTERS_UPPER},
+            {ALPHA_NUMBERS, GENOPTS_NUMBERS},
+            {ALPHA_SPACE, GENOPTS_SPACE},
+            {ALPHA_DASH, GENOPTS_DASH},
+            {ALPHA_SPECIAL, GENOPTS_SPECIAL},
+            {ALPHA_SIMILAR, SIMILAR_CHARACTER}
+        };
+        for (const auto& alphabet : alphabets) {
+            for (const char* c = alphabet.characters; *c != '\0'; ++c) {
+                classes[static_cast<unsigned char>(*c)] |= alphabet.bits;
+            }
+        }
+        for (unsigned int mask = 0; mask < GENOPTS_COMBINATIONS; mask++) {
+            const size_t size = getAlphabet(getOptionsFromMask(mask)).size();
+            log2AlphabetSize[mask] = size > 0 ? std::log2(double(size)) : 0;
+        }
+    }
+    /// the classes of every byte
+    unsigned char classes[256];
+    /// binary logarithm of the size of the alphabet of every options mask
+    double log2AlphabetSize[GENOPTS_COMBINATIONS];
+};
+
+const ClassTable CLASS_TABLE;
+
+/// Returns the current time in nanoseconds
+uint64_t getNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Adds \p count passwords of \p length characters with the class mask
+/// \p mask to \p report
+void addPasswords(auditrep& report, unsigned int mask, size_t length, uint64_t count,
+    unsigned int policyMask, const auditopts& options) {
+    report.passwords += count;
+    report.characters += length * count;
+    report.classes[mask] += count;
+    report.lengths[length < AUDIT_MAX_LENGTH ? length : AUDIT_MAX_LENGTH] += count;
+    const unsigned int entropy = getMaskEntropy(mask, length);
+    size_t level = 0;
+    while (level < AUDIT_ENTROPY_LEVELS - 1 && entropy >= ENTROPY_LEVEL_BITS[level]) {
+        level++;
+    }
+    report.entropyLevels[level] += count;
+    report.entropyBits += double(entropy) * count;
+    // the classes must be allowed and similar characters avoided if the
+    // policy says so
+    if (options.checkPolicy && length >= options.minLength &&
+        (mask & ~policyMask & (CHARACTER_CLASSES | AUDIT_CLASS_OTHER)) == 0 &&
+        ((mask & GENOPTS_AVOID_SIMILAR) || !(policyMask & GENOPTS_AVOID_SIMILAR)))
+        report.compliant += count;
+}
+
+/**
+ * Password being audited and the counts of the passwords before. Characters
+ * are added until the end of the line, then the password is counted by its
+ * class mask and length; the counts are added to the report at the end.
+ */
+struct LineAuditor {
+    LineAuditor(auditrep& report, const auditopts& options) : report(report),
+        options(options), policyMask(getOptionsMask(options.policy)), classes(0),
+        length(0), counts(AUDIT_CLASS_MASKS * AUDIT_MAX_LENGTH) {}
+
+    /// Adds the counts to the report
+    ~LineAuditor() {
+        for (unsigned int mask = 0; mask < AUDIT_CLASS_MASKS; mask++) {
+            for (size_t length = 1; length < AUDIT_MAX_LENGTH; length++) {
+                const uint64_t count = counts[mask * AUDIT_MAX_LENGTH + length];
+                if (count > 0)
+                    addPasswords(report, mask, length, count, policyMask, options);
+            }
+        }
+    }
+
+    /// Counts the current password and starts the next one
+    void endLine() {
+        if (length > 0) {
+            unsigned int mask = classes & (CHARACTER_CLASSES | AUDIT_CLASS_OTHER);
+            if (!(classes & SIMILAR_CHARACTER))
+                mask |= GENOPTS_AVOID_SIMILAR;
+            if (length < AUDIT_MAX_LENGTH)
+                counts[mask * AUDIT_MAX_LENGTH + length]++;
+            else
+                addPasswords(report, mask, length, 1, policyMask, options);
+        }
+        classes = 0;
+        length = 0;
+    }
+
+    /// the report to add the passwords to
+    auditrep& report;
+    /// the options of the audit
+    const auditopts& options;
+    /// options mask of the required policy
+    unsigned int policyMask;
+    /// class bits of the characters of the current password, with
+    /// \p AUDIT_CLASS_OTHER for characters in no class
+    unsigned int classes;
+    /// number of characters of the current password
+    size_t length;
+    /// number of passwords shorter than \p AUDIT_MAX_LENGTH characters by
+    /// class mask and length
+    std::vector<uint64_t> counts;
+};
+
+/// Audits the \p length bytes at \p data with the lookup table
+void auditScalar(const char* data, size_t length, LineAuditor& line) {
+    const char* end = data + length;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+        const char* lineEnd = newline ? newline : end;
+        const char* passwordEnd = lineEnd;
+        if (passwordEnd > data && passwordEnd[-1] == '\r')
+            passwordEnd--;
+        for (const char* c = data; c < passwordEnd; ++c) {
+            const unsigned int classes = CLASS_TABLE.classes[static_cast<unsigned char>(*c)];
+            line.classes |= classes != 0 ? classes : AUDIT_CLASS_OTHER;
+        }
+        line.length = passwordEnd - data;
+        line.endLine();
+        data = lineEnd + 1;
+    }
+}
+
+#ifdef AUDIT_HAVE_SSSE3
+/**
+ * Bitmasks of a block of \p BLOCK_SIZE bytes with one bit per byte: the
+ * line breaks, the carriage returns, the bytes in no class and the bytes of
+ * every class bit.
+ */
+struct BlockMasks {
+    /// bytes that are \p '\\n'
+    uint64_t newlines;
+    /// bytes that are \p '\\r'
+    uint64_t returns;
+    /// bytes in no class, except line breaks and carriage returns
+    uint64_t other;
+    /// bytes of the class bits \p 0x01 to \p 0x40
+    uint64_t classes[7];
+};
+
+/**
+ * Classifies the \p BLOCK_SIZE bytes at \p data. Every class is a union of
+ * rectangles of high and low nibbles, e.g. the lower case letters are the
+ * bytes 0x61 to 0x6f and 0x70 to 0x7a. A byte is in a rectangle if both its
+ * nibbles select a table entry with the bit of the rectangle. Two pairs of
+ * tables hold the rectangles; the rectangles that share a table with another
+ * rectangle of the same class use a spare bit that is moved to the class
+ * bit afterwards (bit 7 to the special characters in both pairs, bit 2 of
+ * the second pair to the similar characters). Bytes from 0x80 have no bit
+ * in the tables of the high nibble.
+ */
+__attribute__((target("ssse3")))
+inline void classifyBlock(const char* data, BlockMasks& masks) {
+    // a-o, A-O, 0-9, ' ', '-', !"#$%&'()*+,./, 0 and 1, @ and `
+    const __m128i low1 = _mm_setr_epi8(0xcc - 256, 0x67, 0x27, 0x27, 0x27, 0x27,
+        0x27, 0x27, 0x27, 0x27, 0x23, 0x23, 0x23, 0x13, 0x23, 0x23);
+    const __m128i high1 = _mm_setr_epi8(0, 0, 0x38, 0x44, 0x82 - 256, 0, 0x81 - 256,
+        0, 0, 0, 0, 0, 0, 0, 0, 0);
+    // p-z, P-Z, l and |, :;<=>?, I and O, [\]^ and {|}~
+    const __m128i low2 = _mm_setr_epi8(0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03,
+        0x03, 0x03, 0x43, 0x23, 0xa0 - 256, 0xa4 - 256, 0xa0 - 256, 0xa0 - 256, 0x60);
+    const __m128i high2 = _mm_setr_epi8(0, 0, 0, 0x20, 0x40, 0x82 - 256, 0x04,
+        0x85 - 256, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    const __m128i zero = _mm_setzero_si128();
+
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i low = _mm_and_si128(bytes, nibble);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        const __m128i first = _mm_and_si128(_mm_shuffle_epi8(low1, low),
+            _mm_shuffle_epi8(high1, high));
+        const __m128i second = _mm_and_si128(_mm_shuffle_epi8(low2, low),
+            _mm_shuffle_epi8(high2, high));
+        const __m128i spare = _mm_or_si128(first, second);
+        const __m128i classes = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(first, _mm_set1_epi8(0x7f)),
+                _mm_and_si128(second, _mm_set1_epi8(0x7b))),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi16(spare, 2), _mm_set1_epi8(0x20)),
+                _mm_and_si128(_mm_slli_epi16(second, 4), _mm_set1_epi8(0x40))));
+
+        const uint64_t newlines = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+        const uint64_t returns = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, carriageReturn)));
+        const uint64_t unclassified = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(classes, zero)));
+        masks.newlines |= newlines << i;
+        masks.returns |= returns << i;
+        masks.other |= (unclassified & ~newlines & ~returns) << i;
+        // shifting class bit k to bit 7 of every byte lets movemask read it
+        masks.classes[0] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 7)))) << i;
+        masks.classes[1] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 6)))) << i;
+        masks.classes[2] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 5)))) << i;
+        masks.classes[3] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 4)))) << i;
+        masks.classes[4] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 3)))) << i;
+        masks.classes[5] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 2)))) << i;
+        masks.classes[6] |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_slli_epi16(classes, 1)))) << i;
+    }
+}
+
+/// Adds the classes of the bytes selected by \p range to \p line
+inline void addClasses(const BlockMasks& masks, uint64_t range, LineAuditor& line) {
+    unsigned int classes = (masks.other & range) ? AUDIT_CLASS_OTHER : 0;
+    classes |= ((masks.classes[0] & range) != 0) | ((masks.classes[1] & range) != 0) << 1 |
+        ((masks.classes[2] & range) != 0) << 2 | ((masks.classes[3] & range) != 0) << 3 |
+        ((masks.classes[4] & range) != 0) << 4 | ((masks.classes[5] & range) != 0) << 5 |
+        ((masks.classes[6] & range) != 0) << 6;
+    line.classes |= classes;
+}
+
+/// Audits the \p length bytes at \p data with the SSSE3 classification
+__attribute__((target("ssse3")))
+void auditVectorized(const char* data, size_t length, LineAuditor& line) {
+    char tail[BLOCK_SIZE];
+    // whether the last byte of the previous block was a carriage return
+    bool pendingReturn = false;
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+        const size_t count = std::min(BLOCK_SIZE, length - offset);
+        const char* block = data + offset;
+        if (count < BLOCK_SIZE) {
+            memcpy(tail, block, count);
+            memset(tail + count, 0, BLOCK_SIZE - count);
+            block = tail;
+        }
+        BlockMasks masks;
+        memset(&masks, 0, sizeof(masks));
+        classifyBlock(block, masks);
+        const uint64_t valid = count < BLOCK_SIZE ? (uint64_t(1) << count) - 1 : ~uint64_t(0);
+        const uint64_t last = uint64_t(1) << (count - 1);
+        uint64_t newlines = masks.newlines & valid;
+
+        // a carriage return only ends a password directly before a line
+        // break, all others are characters in no class
+        if (pendingReturn && !(newlines & 1))
+            line.classes |= AUDIT_CLASS_OTHER;
+        if (masks.returns & valid & ~(newlines >> 1) & ~last)
+            masks.other |= masks.returns & ~(newlines >> 1) & ~last;
+
+        size_t start = 0;
+        while (newlines != 0) {
+            const size_t end = __builtin_ctzll(newlines);
+            const uint64_t range = ((uint64_t(1) << end) - 1) & ~((uint64_t(1) << start) - 1);
+            addClasses(masks, range, line);
+            bool endsWithReturn;
+            if (end > start)
+                endsWithReturn = (masks.returns >> (end - 1)) & 1;
+            else
+                endsWithReturn = end == 0 && pendingReturn;
+            line.length += end - start;
+            line.length -= endsWithReturn;
+            line.endLine();
+            pendingReturn = false;
+            start = end + 1;
+            newlines &= newlines - 1;
+        }
+        if (start < count) {
+            const uint64_t range = valid & ~((uint64_t(1) << start) - 1);
+            addClasses(masks, range, line);
+            line.length += count - start;
+            pendingReturn = (masks.returns & last) != 0;
+        }
+    }
+    if (line.length > 0) {
+        line.length -= pendingReturn;
+        line.endLine();
+    }
+}
+
+/// Returns whether the CPU supports SSSE3
+bool hasSsse3() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+
+/// Adds the counts of \p other to \p report
+void mergeReports(auditrep& report, const auditrep& other) {
+    report.passwords += other.passwords;
+    report.characters += other.characters;
+    for (size_t i = 0; i < AUDIT_CLASS_MASKS; i++) {
+        report.classes[i] += other.classes[i];
+    }
+    for (size_t i = 0; i <= AUDIT_MAX_LENGTH; i++) {
+        report.lengths[i] += other.lengths[i];
+    }
+    for (size_t i = 0; i < AUDIT_ENTROPY_LEVELS; i++) {
+        report.entropyLevels[i] += other.entropyLevels[i];
+    }
+    report.entropyBits += other.entropyBits;
+    report.compliant += other.compliant;
+}
+
+/// Audits the regular file of \p size bytes at \p fd in parts on several
+/// threads
+bool auditMapped(int fd, size_t size, std::ostream& errors, auditrep& report,
+    const auditopts& options) {
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory == MAP_FAILED) {
+        errors << "ERROR: mmap() failed: " << strerror(errno) << "!" << std::endl;
+        return false;
+    }
+    madvise(memory, size, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(memory);
+
+    // every part starts after a line break
+    std::vector<size_t> starts(1, 0);
+    for (size_t offset = PART_SIZE; offset < size; offset += PART_SIZE) {
+        const size_t from = std::max(offset - 1, starts.back());
+        const void* newline = memchr(data + from, '\n', size - from);
+        if (!newline)
+            break;
+        starts.push_back(static_cast<const char*>(newline) - data + 1);
+    }
+    starts.push_back(size);
+
+    std::vector<auditrep> reports(starts.size() - 1);
+    runParallel(reports.size(), options.threads, [&](size_t part) {
+        auditBuffer(data + starts[part], starts[part + 1] - starts[part],
+            reports[part], options);
+    });
+    munmap(memory, size);
+    for (const auto& part : reports) {
+        mergeReports(report, part);
+    }
+    return true;
+}
+
+/// Audits everything read from \p fd, keeping incomplete lines for the next
+/// read
+bool auditStream(int fd, std::ostream& errors, auditrep& report,
+    const auditopts& options) {
+    std::vector<char> buffer(READ_SIZE);
+    size_t filled = 0;
+    while (true) {
+        if (filled == buffer.size())
+            buffer.resize(2 * buffer.size());
+        const ssize_t bytes = read(fd, buffer.data() + filled, buffer.size() - filled);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0) {
+            errors << "ERROR: read() failed: " << strerror(errno) << "!" << std::endl;
+            return false;
+        }
+        if (bytes == 0)
+            break;
+        filled += bytes;
+        size_t complete = filled;
+        while (complete > 0 && buffer[complete - 1] != '\n') {
+            complete--;
+        }
+        auditBuffer(buffer.data(), complete, report, options);
+        memmove(buffer.data(), buffer.data() + complete, filled - complete);
+        filled -= complete;
+    }
+    auditBuffer(buffer.data(), filled, report, options);
+    return true;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Returns the class mask of the \p length characters at \p password (see
+ * \p auditrep::classes).
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ * \return The class mask
+ */
+unsigned int getClassMask(const char* password, size_t length) {
+    unsigned int classes = 0;
+    for (size_t i = 0; i < length; i++) {
+        const unsigned int bits = CLASS_TABLE.classes[static_cast<unsigned char>(password[i])];
+        classes |= bits != 0 ? bits : AUDIT_CLASS_OTHER;
+    }
+    unsigned int mask = classes & (CHARACTER_CLASSES | AUDIT_CLASS_OTHER);
+    if (!(classes & SIMILAR_CHARACTER))
+        mask |= GENOPTS_AVOID_SIMILAR;
+    return mask;
+}
+
+/**
+ * Returns the entropy of passwords of \p length characters generated with
+ * the options of the class mask \p mask in bits, rounded up like the entropy
+ * shown in the window.
+ *
+ * \param mask The class mask (see \p auditrep::classes)
+ * \param length The number of characters
+ * \return The entropy in bits
+ */
+unsigned int getMaskEntropy(unsigned int mask, size_t length) {
+    return static_cast<unsigned int>(std::ceil(
+        length * CLASS_TABLE.log2AlphabetSize[mask % GENOPTS_COMBINATIONS]));
+}
+
+/**
+ * Audits the passwords in the \p length bytes at \p data, one per line, and
+ * adds them to \p report. A trailing carriage return is removed from every
+ * line and the last line needs no line break.
+ *
+ * \param data The passwords
+ * \param length The number of bytes
+ * \param report The report to add the passwords to
+ * \param options The options of the audit (the threads are ignored)
+ */
+void auditBuffer(const char* data, size_t length, auditrep& report,
+    const auditopts& options) {
+    LineAuditor line(report, options);
+#ifdef AUDIT_HAVE_SSSE3
+    if (options.vectorized && hasSsse3()) {
+        auditVectorized(data, length, line);
+        return;
+    }
+#endif
+    auditScalar(data, length, line);
+}
+
+/**
+ * Audits the passwords read from the file descriptor \p fd, one per line.
+ * Regular files are mapped into memory and audited by several threads,
+ * everything else is read sequentially.
+ *
+ * \param fd The file descriptor to read from
+ * \param errors The stream to report errors to
+ * \param report Receives the results of the audit
+ * \param options The options of the audit
+ * \return \p true on success, \p false if reading failed
+ */
+bool auditFile(int fd, std::ostream& errors, auditrep& report,
+    const auditopts& options) {
+    const uint64_t start = getNanoseconds();
+    report = auditrep();
+    struct stat status;
+    bool success;
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+        success = auditMapped(fd, status.st_size, errors, report, options);
+    else
+        success = auditStream(fd, errors, report, options);
+    report.elapsedNanoseconds = getNanoseconds() - start;
+    return success;
+}
+
+/**
+ * Writes the results in \p report to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param report The results of an audit
+ * \param options The options of the audit
+ */
+void printAuditReport(std::ostream& out, const auditrep& report,
+    const auditopts& options) {
+    const double elapsed = report.elapsedNanoseconds / 1e9;
+    const double passwords = report.passwords > 0 ? double(report.passwords) : 1.0;
+    out << std::fixed << std::setprecision(1)
+        << "Passwords:             " << report.passwords << std::endl
+        << "Average length:        " << report.characters / passwords << std::endl
+        << "Average entropy:       " << report.entropyBits / passwords << " Bit" << std::endl;
+    if (options.checkPolicy) {
+        out << "Complying with " << getPolicyName(options.policy) << ", at least "
+            << options.minLength << " characters: " << report.compliant << " ("
+            << 100.0 * report.compliant / passwords << " %)" << std::endl;
+    }
+    out << std::setprecision(0)
+        << "Passwords/s:           " << (elapsed > 0 ? report.passwords / elapsed : 0.0)
+        << std::endl << std::setprecision(1);
+
+    out << "Character classes:" << std::endl;
+    for (size_t mask = 0; mask < AUDIT_CLASS_MASKS; mask++) {
+        if (report.classes[mask] == 0)
+            continue;
+        // passwords without any classified character have no policy
+        const genopts classes = getOptionsFromMask(mask % GENOPTS_COMBINATIONS);
+        std::string name = mask & CHARACTER_CLASSES ? getPolicyName(classes) : "none";
+        if (mask & AUDIT_CLASS_OTHER)
+            name += " (and other characters)";
+        out << "  " << name << ": " << report.classes[mask] << " ("
+            << 100.0 * report.classes[mask] / passwords << " %)" << std::endl;
+    }
+
+    out << "Lengths:" << std::endl;
+    for (size_t length = 1; length <= AUDIT_MAX_LENGTH; length++) {
+        if (report.lengths[length] == 0)
+            continue;
+        out << "  " << length << (length == AUDIT_MAX_LENGTH ? "+" : "") << ": "
+            << report.lengths[length] << std::endl;
+    }
+
+    out << "Entropy:" << std::endl;
+    for (size_t level = 0; level < AUDIT_ENTROPY_LEVELS; level++) {
+        out << "  ";
+        if (level == 0)
+            out << "< " << ENTROPY_LEVEL_BITS[0];
+        else if (level == AUDIT_ENTROPY_LEVELS - 1)
+            out << ">= " << ENTROPY_LEVEL_BITS[level - 1];
+        else
+            out << ENTROPY_LEVEL_BITS[level - 1] << "-" << ENTROPY_LEVEL_BITS[level] - 1;
+        out << " Bit: " << report.entropyLevels[level] << " ("
+            << 100.0 * report.entropyLevels[level] / passwords << " %)" << std::endl;
+    }
+}
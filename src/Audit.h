@@ -0,0 +1,166 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Audit.h
+ * \brief   Defines functions for auditing lists of existing passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for auditing existing passwords, one per line,
+ * against the character classes of \p genopts. Every password gets a mask of
+ * the \p GENOPTS_* classes its characters belong to, which is the smallest
+ * policy that could have generated it, and the entropy of a password of its
+ * length generated with that policy. The audit only reports histograms of
+ * the masks, lengths and entropies, never the passwords themselves.
+ *
+ * The characters are classified 16 at a time: the low and the high nibble
+ * of every byte select entries of two pairs of 16-byte tables with
+ * \p pshufb, and the classes of the whole input are turned into bitmasks of
+ * 64 bytes that are cut at the line breaks. CPUs without SSSE3 use a
+ * lookup table of 256 entries instead. Regular files are mapped into memory
+ * and split into parts audited by all threads in parallel.
+ */
+
+#ifndef GTKPASS_AUDIT_H
+#define GTKPASS_AUDIT_H
+
+#include "RandomGenerator.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/// Flag of the class mask of a password with characters outside all
+/// alphabets, e.g. control characters, \p '_' or non-ASCII bytes
+#define AUDIT_CLASS_OTHER 0x80
+/// Number of different class masks
+#define AUDIT_CLASS_MASKS 0x100
+/// Number of entries of the length histogram; longer passwords are counted
+/// in the last one
+#define AUDIT_MAX_LENGTH 64
+/// Number of entropy levels, as shown by the level bar of the window
+#define AUDIT_ENTROPY_LEVELS 5
+
+/**
+ * \typedef auditopts
+ * \brief Defines a struct holding the options of an audit.
+ */
+typedef struct auditoptions {
+    /// Initializes the options for an audit without required policy on the
+    /// default number of threads with the vectorized classification
+    auditoptions() : checkPolicy(false), minLength(0), threads(0),
+        vectorized(true) {}
+    /// whether the passwords are checked against \p policy and \p minLength
+    bool checkPolicy;
+    /// the policy the passwords have to comply with
+    genopts policy;
+    /// the number of characters the passwords must at least have
+    unsigned int minLength;
+    /// number of threads auditing regular files (0 for the default)
+    unsigned int threads;
+    /// whether to use the SSSE3 classification if the CPU supports it
+    bool vectorized;
+} auditopts;
+
+/**
+ * \typedef auditrep
+ * \brief Defines a struct holding the results of an audit.
+ */
+typedef struct auditreport {
+    /// Initializes an empty report
+    auditreport() : passwords(0), characters(0), classes(), lengths(),
+        entropyLevels(), entropyBits(0), compliant(0), elapsedNanoseconds(0) {}
+    /// number of passwords (empty lines are skipped)
+    uint64_t passwords;
+    /// number of characters of all passwords
+    uint64_t characters;
+    /// number of passwords per class mask: the \p GENOPTS_* classes of the
+    /// characters, \p GENOPTS_AVOID_SIMILAR if none of them is similar to
+    /// another one and \p AUDIT_CLASS_OTHER if some are in no class
+    uint64_t classes[AUDIT_CLASS_MASKS];
+    /// number of passwords per length
+    uint64_t lengths[AUDIT_MAX_LENGTH + 1];
+    /// number of passwords per entropy level (below 64, 80, 96 and 112 bits
+    /// and above)
+    uint64_t entropyLevels[AUDIT_ENTROPY_LEVELS];
+    /// sum of the entropies of all passwords in bits
+    double entropyBits;
+    /// number of passwords complying with the required policy
+    uint64_t compliant;
+    /// wall clock time of the audit
+    uint64_t elapsedNanoseconds;
+} auditrep;
+
+/**
+ * Returns the class mask of the \p length characters at \p password (see
+ * \p auditrep::classes).
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ * \return The class mask
+ */
+unsigned int getClassMask(const char* password, size_t length);
+
+/**
+ * Returns the entropy of passwords of \p length characters generated with
+ * the options of the class mask \p mask in bits, rounded up like the entropy
+ * shown in the window.
+ *
+ * \param mask The class mask (see \p auditrep::classes)
+ * \param length The number of characters
+ * \return The entropy in bits
+ */
+unsigned int getMaskEntropy(unsigned int mask, size_t length);
+
+/**
+ * Audits the passwords in the \p length bytes at \p data, one per line, and
+ * adds them to \p report. A trailing carriage return is removed from every
+ * line and the last line needs no line break.
+ *
+ * \param data The passwords
+ * \param length The number of bytes
+ * \param report The report to add the passwords to
+ * \param options The options of the audit (the threads are ignored)
+ */
+void auditBuffer(const char* data, size_t length, auditrep& report,
+    const auditopts& options = auditopts());
+
+/**
+ * Audits the passwords read from the file descriptor \p fd, one per line.
+ * Regular files are mapped into memory and audited by several threads,
+ * everything else is read sequentially.
+ *
+ * \param fd The file descriptor to read from
+ * \param errors The stream to report errors to
+ * \param report Receives the results of the audit
+ * \param options The options of the audit
+ * \return \p true on success, \p false if reading failed
+ */
+bool auditFile(int fd, std::ostream& errors, auditrep& report,
+    const auditopts& options = auditopts());
+
+/**
+ * Writes the results in \p report to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param report The results of an audit
+ * \param options The options of the audit
+ */
+void printAuditReport(std::ostream& out, const auditrep& report,
+    const auditopts& options = auditopts());
+
+#endif
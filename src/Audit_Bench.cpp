@@ -0,0 +1,96 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Audit_Bench.cpp
+ * \brief   Benchmarks the files \p Audit.h and \p Audit.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Audit.h and \p Audit.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Audit.h"
+#include "Scheduler.h"
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <unistd.h>
+
+/// Number of bytes of passwords audited
+static const size_t AUDIT_BYTES = size_t(1) << 30;
+
+/// Writes the throughput of auditing \p AUDIT_BYTES bytes in \p elapsed
+/// nanoseconds to \p out
+static void printThroughput(std::ostream& out, const std::string& label,
+    uint64_t elapsed) {
+    out << std::left << std::setw(32) << label << std::right << std::fixed
+        << std::setprecision(2) << std::setw(8) << AUDIT_BYTES / (elapsed / 1e9) / 1e9
+        << " GB/s" << std::endl;
+}
+
+/// Measures the throughput of auditing 1 GiB of passwords of 6 to 20
+/// characters with the scalar and the vectorized classification in memory
+/// and from a file on all threads
+BENCHMARK_CASE(audit_throughput) {
+    std::string data;
+    data.reserve(AUDIT_BYTES);
+    genopts options;
+    options.bIncludeSpecial = true;
+    std::vector<std::string> passwords;
+    for (size_t i = 0; i < 100000; i++) {
+        passwords.push_back(getRandomString(6 + getRandomNumber(15), options) + "\n");
+    }
+    for (size_t i = 0; data.size() < AUDIT_BYTES; i++) {
+        data += passwords[i % passwords.size()];
+    }
+    data.resize(AUDIT_BYTES);
+
+    for (const bool vectorized : {false, true}) {
+        auditopts audit;
+        audit.vectorized = vectorized;
+        auditrep report;
+        const uint64_t start = getNanoseconds();
+        auditBuffer(data.data(), data.size(), report, audit);
+        printThroughput(out, vectorized ? "in memory, vectorized" : "in memory, scalar",
+            getNanoseconds() - start);
+    }
+
+    const char* directory = getenv("TMPDIR");
+    std::string path = std::string(directory ? directory : "/var/tmp") +
+        "/gtkpass-bench-audit-XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        out << "mkstemp() failed" << std::endl;
+        return;
+    }
+    unlink(path.c_str());
+    if (write(fd, data.data(), data.size()) != ssize_t(data.size())) {
+        out << "write() failed" << std::endl;
+        close(fd);
+        return;
+    }
+    data.clear();
+    data.shrink_to_fit();
+    auditrep report;
+    auditopts audit;
+    auditFile(fd, out, report, audit);
+    printThroughput(out, "file, " + std::to_string(getDefaultThreadCount()) + " threads",
+        report.elapsedNanoseconds);
+    close(fd);
+}
@@ -0,0 +1,200 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Audit_Test.cpp
+ * \brief   Tests the files \p Audit.h and \p Audit.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Audit.h and \p Audit.cpp.
+ */
+
+#include "catch.hpp"
+#include "Audit.h"
+#include "Policy.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+/// Returns whether the reports \p a and \p b hold the same counts
+static bool isSameReport(const auditrep& a, const auditrep& b) {
+    return a.passwords == b.passwords && a.characters == b.characters &&
+        memcmp(a.classes, b.classes, sizeof(a.classes)) == 0 &&
+        memcmp(a.lengths, b.lengths, sizeof(a.lengths)) == 0 &&
+        memcmp(a.entropyLevels, b.entropyLevels, sizeof(a.entropyLevels)) == 0 &&
+        a.entropyBits == b.entropyBits && a.compliant == b.compliant;
+}
+
+/// Audits \p data with the vectorized and with the scalar classification
+/// and returns whether both give the same results
+static bool isSameAudit(const std::string& data, const auditopts& options = auditopts()) {
+    auditrep vectorized;
+    auditrep scalar;
+    auditopts scalarOptions = options;
+    scalarOptions.vectorized = false;
+    auditBuffer(data.data(), data.size(), vectorized, options);
+    auditBuffer(data.data(), data.size(), scalar, scalarOptions);
+    return isSameReport(vectorized, scalar);
+}
+
+/// Tests the functions \p getClassMask and \p getMaskEntropy
+TEST_CASE("Class masks", "[Audit]") {
+    REQUIRE(getClassMask("abc", 3) == (GENOPTS_LETTERS_LOWER | GENOPTS_AVOID_SIMILAR));
+    REQUIRE(getClassMask("aBc1", 4) == (GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER |
+        GENOPTS_NUMBERS));
+    REQUIRE(getClassMask("a b-c!", 6) == (GENOPTS_LETTERS_LOWER | GENOPTS_SPACE |
+        GENOPTS_DASH | GENOPTS_SPECIAL | GENOPTS_AVOID_SIMILAR));
+    REQUIRE(getClassMask("a_b", 3) == (GENOPTS_LETTERS_LOWER | GENOPTS_AVOID_SIMILAR |
+        AUDIT_CLASS_OTHER));
+    REQUIRE(getClassMask("\xc3\xa4", 2) == (GENOPTS_AVOID_SIMILAR | AUDIT_CLASS_OTHER));
+    REQUIRE(getClassMask("", 0) == GENOPTS_AVOID_SIMILAR);
+
+    // the entropy of the generator settings as shown in the window
+    genopts options;
+    REQUIRE(getMaskEntropy(getOptionsMask(options), 12) ==
+        static_cast<unsigned int>(std::ceil(12 * std::log2(62.0))));
+    options.bAvoidSimilarChars = true;
+    REQUIRE(getMaskEntropy(getOptionsMask(options), 12) ==
+        static_cast<unsigned int>(std::ceil(12 * std::log2(57.0))));
+    REQUIRE(getMaskEntropy(GENOPTS_NUMBERS | AUDIT_CLASS_OTHER, 4) == 14);
+    REQUIRE(getMaskEntropy(AUDIT_CLASS_OTHER, 10) == 0);
+}
+
+/// Tests the function \p auditBuffer
+TEST_CASE("auditBuffer", "[Audit]") {
+    SECTION("Histograms") {
+        const std::string data = "password\nPassw0rd!\r\n\n1234\nabc_def\n"
+            "correct horse battery staple\neast";
+        auditrep report;
+        auditBuffer(data.data(), data.size(), report);
+        REQUIRE(report.passwords == 6);
+        REQUIRE(report.characters == 8 + 9 + 4 + 7 + 28 + 4);
+        REQUIRE(report.classes[GENOPTS_LETTERS_LOWER | GENOPTS_AVOID_SIMILAR] == 2);
+        REQUIRE(report.classes[GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER |
+            GENOPTS_NUMBERS | GENOPTS_SPECIAL] == 1);
+        REQUIRE(report.classes[GENOPTS_NUMBERS] == 1);
+        REQUIRE(report.classes[GENOPTS_LETTERS_LOWER | GENOPTS_AVOID_SIMILAR |
+            AUDIT_CLASS_OTHER] == 1);
+        REQUIRE(report.classes[GENOPTS_LETTERS_LOWER | GENOPTS_SPACE] == 1);
+        REQUIRE(report.lengths[4] == 2);
+        REQUIRE(report.lengths[8] == 1);
+        REQUIRE(report.lengths[28] == 1);
+        REQUIRE(report.entropyLevels[0] == 5);
+        REQUIRE(report.entropyLevels[4] == 1);
+        REQUIRE(report.compliant == 0);
+    }
+
+    SECTION("Policies") {
+        const std::string data = "abcdefgh\nabcdefgh2\nabcdefghl\nabc\nABCDEFGH\n";
+        auditopts options;
+        options.checkPolicy = true;
+        options.minLength = 8;
+        REQUIRE(parsePolicy("lower+numbers+nosimilar", options.policy));
+        auditrep report;
+        auditBuffer(data.data(), data.size(), report, options);
+        REQUIRE(report.compliant == 2);
+        REQUIRE(isSameAudit(data, options));
+    }
+
+    SECTION("Vectorized and scalar classification") {
+        // every byte on its own, within a password and at the block borders
+        for (unsigned int byte = 0; byte < 256; byte++) {
+            const char c = static_cast<char>(byte);
+            REQUIRE(isSameAudit(std::string(1, c)));
+            REQUIRE(isSameAudit("ab" + std::string(1, c) + "cd\n"));
+            REQUIRE(isSameAudit(std::string(63, 'x') + c + "\nyz"));
+        }
+        // carriage returns before, after and across the block borders
+        for (size_t offset = 60; offset < 68; offset++) {
+            std::string data(offset, 'a');
+            REQUIRE(isSameAudit(data + "\r\nb"));
+            REQUIRE(isSameAudit(data + "\rb\n"));
+            REQUIRE(isSameAudit(data + "\r"));
+            REQUIRE(isSameAudit(data + "\n\r\n\r\r\n"));
+            data[offset / 2] = '\n';
+            REQUIRE(isSameAudit(data + "\r\n\n"));
+        }
+        // random lines of random bytes
+        std::string data;
+        for (size_t i = 0; i < 200000; i++) {
+            const unsigned int value = getRandomNumber(1000);
+            if (value < 60)
+                data += '\n';
+            else if (value < 70)
+                data += '\r';
+            else
+                data += static_cast<char>(value < 500 ? 32 + value % 95 : getRandomNumber(256));
+        }
+        REQUIRE(isSameAudit(data));
+    }
+}
+
+/// Tests the functions \p auditFile and \p printAuditReport
+TEST_CASE("auditFile", "[Audit]") {
+    std::string data;
+    genopts options;
+    for (size_t i = 0; i < 10000; i++) {
+        data += getRandomString(1 + getRandomNumber(70), options) + "\n";
+    }
+    auditrep expected;
+    auditBuffer(data.data(), data.size(), expected);
+    REQUIRE(expected.passwords == 10000);
+
+    SECTION("Regular file") {
+        char path[] = "/tmp/gtkpass-audit-XXXXXX";
+        const int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        unlink(path);
+        REQUIRE(write(fd, data.data(), data.size()) == ssize_t(data.size()));
+        std::ostringstream errors;
+        auditrep report;
+        REQUIRE(auditFile(fd, errors, report));
+        close(fd);
+        REQUIRE(isSameReport(report, expected));
+    }
+
+    SECTION("Pipe") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        std::thread writer([&]() {
+            // write in pieces that split the lines
+            for (size_t offset = 0; offset < data.size(); offset += 1000) {
+                const size_t bytes = std::min(size_t(1000), data.size() - offset);
+                if (write(fds[1], data.data() + offset, bytes) != ssize_t(bytes))
+                    break;
+            }
+            close(fds[1]);
+        });
+        std::ostringstream errors;
+        auditrep report;
+        const bool success = auditFile(fds[0], errors, report);
+        writer.join();
+        close(fds[0]);
+        REQUIRE(success);
+        REQUIRE(isSameReport(report, expected));
+
+        std::ostringstream out;
+        printAuditReport(out, report);
+        REQUIRE(out.str().find("Passwords:             10000") != std::string::npos);
+        REQUIRE(out.str().find("lower+upper+numbers") != std::string::npos);
+    }
+}
@@ -0,0 +1,98 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BatchGenerator.cpp
+ * \brief   Implements functions for generating many random strings with
+ *          mixed options in parallel.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for generating many random strings with
+ * mixed options in parallel.
+ */
+
+#include "BatchGenerator.h"
+#include "Scheduler.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace {
+
+/// A contiguous range of strings of a single job
+struct Chunk {
+    /// index of the job
+    size_t job;
+    /// index of the first string in the result
+    size_t first;
+    /// number of strings in the chunk
+    size_t count;
+};
+
+} // end of anonymous namespace
+
+/**
+ * Generates the strings of all \p jobs on \p threadCount threads. The jobs are
+ * split into chunks of at most \p BATCH_CHUNK_CHARS characters which are
+ * distributed by a work-stealing scheduler, so jobs of very different size do
+ * not leave threads idle. The order of the result does not depend on the
+ * scheduling: it holds the strings of the first job, followed by the strings
+ * of the second job and so on.
+ *
+ * \param jobs The jobs to generate strings for
+ * \param threadCount The number of threads to use (0 for the default)
+ * \return The generated strings
+ */
+std::vector<std::string> generateBatch(const std::vector<genjob>& jobs,
+    unsigned int threadCount) {
+    std::vector<Chunk> chunks;
+    size_t total = 0;
+
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const genjob& job = jobs[j];
+        size_t perChunk = job.length > 0 ? BATCH_CHUNK_CHARS / job.length : job.count;
+        if (perChunk == 0)
+            perChunk = 1;
+        for (size_t first = 0; first < job.count; first += perChunk) {
+            Chunk chunk;
+            chunk.job = j;
+            chunk.first = total + first;
+            chunk.count = std::min(perChunk, job.count - first);
+            chunks.push_back(chunk);
+        }
+        total += job.count;
+    }
+
+    // every chunk writes to its own slots of the result, so no locking is
+    // needed and the order stays stable
+    std::vector<std::string> result(total);
+    runParallel(chunks.size(), threadCount, [&](size_t index) {
+        const Chunk& chunk = chunks[index];
+        const genjob& job = jobs[chunk.job];
+        const std::string& alpha = getAlphabet(job.options);
+        if (job.length == 0 || alpha.empty())
+            return;
+
+        for (size_t i = chunk.first; i < chunk.first + chunk.count; i++) {
+            result[i].resize(job.length);
+            fillRandomChars(&result[i][0], job.length, alpha);
+        }
+        statsRecordBatch(chunk.count, chunk.count * job.length);
+    });
+
+    return result;
+}
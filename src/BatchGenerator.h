@@ -0,0 +1,74 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BatchGenerator.h
+ * \brief   Defines functions for generating many random strings with mixed
+ *          options in parallel.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for generating many random strings with mixed
+ * options in parallel.
+ */
+
+#ifndef GTKPASS_BATCHGENERATOR_H
+#define GTKPASS_BATCHGENERATOR_H
+
+#include "RandomGenerator.h"
+#include <vector>
+
+/// Number of characters a single task of a batch generates at most (unless a
+/// single string is longer)
+#define BATCH_CHUNK_CHARS 65536
+
+/**
+ * \typedef genjob
+ * \brief Defines a struct describing a number of random strings to generate
+ * with the same options and length.
+ */
+typedef struct job {
+    /// Initializes the job with default options, a length of 12 and a count
+    /// of 1
+    job() : options(), length(12), count(1) {}
+    /// Initializes the job with the given values
+    job(const genopts& options, unsigned int length, size_t count) :
+        options(options), length(length), count(count) {}
+    /// options for generating the strings
+    genopts options;
+    /// number of characters per string
+    unsigned int length;
+    /// number of strings to generate
+    size_t count;
+} genjob;
+
+/**
+ * Generates the strings of all \p jobs on \p threadCount threads. The jobs are
+ * split into chunks of at most \p BATCH_CHUNK_CHARS characters which are
+ * distributed by a work-stealing scheduler, so jobs of very different size do
+ * not leave threads idle. The order of the result does not depend on the
+ * scheduling: it holds the strings of the first job, followed by the strings
+ * of the second job and so on.
+ *
+ * \param jobs The jobs to generate strings for
+ * \param threadCount The number of threads to use (0 for the default)
+ * \return The generated strings
+ */
+std::vector<std::string> generateBatch(const std::vector<genjob>& jobs,
+    unsigned int threadCount = 0);
+
+#endif
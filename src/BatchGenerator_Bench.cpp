@@ -0,0 +1,109 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BatchGenerator_Bench.cpp
+ * \brief   Benchmarks the files \p BatchGenerator.h and
+ *          \p BatchGenerator.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p BatchGenerator.h and \p BatchGenerator.cpp.
+ */
+
+#include "Benchmark.h"
+#include "BatchGenerator.h"
+#include "Scheduler.h"
+#include <iomanip>
+#include <thread>
+
+/**
+ * Generates the strings of all \p jobs by splitting the list of jobs into
+ * \p threadCount contiguous parts of equal job count, one per thread. Serves
+ * as baseline for the comparison with the work-stealing scheduler.
+ */
+static std::vector<std::string> generateStaticSplit(
+    const std::vector<genjob>& jobs, unsigned int threadCount) {
+    std::vector<size_t> offsets(jobs.size() + 1, 0);
+    for (size_t j = 0; j < jobs.size(); j++) {
+        offsets[j + 1] = offsets[j] + jobs[j].count;
+    }
+
+    std::vector<std::string> result(offsets.back());
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            const size_t first = jobs.size() * t / threadCount;
+            const size_t last = jobs.size() * (t + 1) / threadCount;
+            for (size_t j = first; j < last; j++) {
+                const std::string& alpha = getAlphabet(jobs[j].options);
+                for (size_t i = offsets[j]; i < offsets[j + 1]; i++) {
+                    result[i].resize(jobs[j].length);
+                    fillRandomChars(&result[i][0], jobs[j].length, alpha);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return result;
+}
+
+/// Measures the time \p generate needs for \p jobs and writes it to \p out
+template <typename Function>
+static void measureBatch(std::ostream& out, const char* label,
+    const std::vector<genjob>& jobs, unsigned int threadCount,
+    Function generate) {
+    const uint64_t start = getNanoseconds();
+    const auto result = generate(jobs, threadCount);
+    const uint64_t elapsed = getNanoseconds() - start;
+
+    size_t characters = 0;
+    for (const auto& str : result) {
+        characters += str.length();
+    }
+    out << std::left << std::setw(14) << label << std::right
+        << std::setw(4) << threadCount << " threads: "
+        << std::setw(8) << elapsed / 1000000 << " ms  "
+        << std::setw(8) << std::fixed << std::setprecision(1)
+        << characters * 1000.0 / elapsed << " MB/s" << std::endl;
+}
+
+/// Compares the work-stealing scheduler with a static split of the jobs on a
+/// skewed mix of 8 character PINs and 4 KiB key blobs
+BENCHMARK_CASE(skewed_batch) {
+    genopts pin;
+    pin.bIncludeLettersLower = false;
+    pin.bIncludeLettersUpper = false;
+    genopts key;
+    key.bIncludeSpecial = true;
+
+    // all expensive jobs are at the end of the list, so a static split puts
+    // them all on the last thread
+    std::vector<genjob> jobs;
+    for (size_t i = 0; i < 60; i++) {
+        jobs.emplace_back(pin, 8, 2000);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        jobs.emplace_back(key, 4096, 2000);
+    }
+
+    const unsigned int threadCount = getDefaultThreadCount();
+    measureBatch(out, "static split", jobs, threadCount, generateStaticSplit);
+    measureBatch(out, "work stealing", jobs, threadCount, generateBatch);
+}
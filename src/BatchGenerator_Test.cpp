@@ -0,0 +1,63 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BatchGenerator_Test.cpp
+ * \brief   Tests the files \p BatchGenerator.h and \p BatchGenerator.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p BatchGenerator.h and \p BatchGenerator.cpp.
+ */
+
+
+#include "catch.hpp"
+#include "BatchGenerator.h"
+
+/// Tests the function \p generateBatch of \p BatchGenerator
+TEST_CASE("generateBatch", "[BatchGenerator]") {
+    genopts pin;
+    pin.bIncludeLettersLower = false;
+    pin.bIncludeLettersUpper = false;
+    genopts key;
+    key.bIncludeSpecial = true;
+
+    std::vector<genjob> jobs;
+    jobs.emplace_back(pin, 8, 5000);
+    jobs.emplace_back(key, 4096, 40);
+    jobs.emplace_back(pin, 0, 3);
+    jobs.emplace_back(genopts(), 12, 1);
+
+    const auto result = generateBatch(jobs, 4);
+    REQUIRE(result.size() == 5044);
+
+    // the order of the strings follows the order of the jobs
+    for (size_t i = 0; i < 5000; i++) {
+        REQUIRE(result[i].length() == 8);
+        REQUIRE(result[i].find_first_not_of(ALPHA_NUMBERS) == std::string::npos);
+    }
+    for (size_t i = 5000; i < 5040; i++) {
+        REQUIRE(result[i].length() == 4096);
+        REQUIRE(result[i].find_first_of(ALPHA_SPECIAL) != std::string::npos);
+    }
+    for (size_t i = 5040; i < 5043; i++) {
+        REQUIRE(result[i].empty());
+    }
+    REQUIRE(result[5043].length() == 12);
+
+    REQUIRE(generateBatch(std::vector<genjob>()).empty());
+}
@@ -0,0 +1,163 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Benchmark.cpp
+ * \brief   Implements a minimal framework for \p GtkPass' benchmarks.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a minimal framework for \p GtkPass' benchmarks.
+ */
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <utility>
+
+/// Returns the list of all registered benchmarks
+static std::vector<std::pair<std::string, BenchmarkFunction>>& getBenchmarks() {
+    static std::vector<std::pair<std::string, BenchmarkFunction>> benchmarks;
+    return benchmarks;
+}
+
+/// Name of the running benchmark and the metrics recorded by it
+struct BenchmarkResults {
+    /// name of the benchmark
+    std::string name;
+    /// names and values of the metrics in the order they were recorded
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+/// Returns the results of the benchmarks that ran, the last one is running
+static std::vector<BenchmarkResults>& getResults() {
+    static std::vector<BenchmarkResults> results;
+    return results;
+}
+
+/**
+ * Registers the benchmark \p function with the name \p name.
+ *
+ * \param name The name of the benchmark
+ * \param function The function implementing the benchmark
+ */
+BenchmarkRegistrar::BenchmarkRegistrar(const char* name,
+    BenchmarkFunction function) {
+    getBenchmarks().emplace_back(name, function);
+}
+
+/**
+ * Runs all registered benchmarks whose name is in \p names, or all of them if
+ * \p names is empty, and writes their results to \p out.
+ *
+ * \param out The stream to write the results to
+ * \param names The names of the benchmarks to run
+ * \return Number of names that do not belong to a registered benchmark
+ */
+int runBenchmarks(std::ostream& out, const std::vector<std::string>& names) {
+    auto benchmarks = getBenchmarks();
+    std::sort(benchmarks.begin(), benchmarks.end());
+
+    int unknown = 0;
+    for (const auto& name : names) {
+        auto it = std::find_if(benchmarks.begin(), benchmarks.end(),
+            [&name](const std::pair<std::string, BenchmarkFunction>& b) {
+                return b.first == name;
+            });
+        if (it == benchmarks.end()) {
+            out << "Unknown benchmark: " << name << std::endl;
+            unknown++;
+        }
+    }
+
+    for (const auto& benchmark : benchmarks) {
+        if (!names.empty() &&
+            std::find(names.begin(), names.end(), benchmark.first) == names.end())
+            continue;
+        out << "=== " << benchmark.first << " ===" << std::endl;
+        getResults().push_back(BenchmarkResults());
+        getResults().back().name = benchmark.first;
+        benchmark.second(out);
+        out << std::endl;
+    }
+    return unknown;
+}
+
+/**
+ * Returns the current time of a monotonic clock in nanoseconds.
+ *
+ * \return Monotonic time in nanoseconds
+ */
+uint64_t getNanoseconds() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Sorts \p samples and returns the value below which \p percentile percent of
+ * the samples are.
+ *
+ * \param samples The samples to get the percentile of (must not be empty)
+ * \param percentile The percentile between 0 and 100
+ * \return The percentile of the samples
+ */
+uint64_t getPercentile(std::vector<uint64_t>& samples, double percentile) {
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(percentile / 100.0 * samples.size());
+    if (index >= samples.size())
+        index = samples.size() - 1;
+    return samples[index];
+}
+
+/**
+ * Records the value \p value of the metric \p metric of the running
+ * benchmark for \p writeResultsJson(). The unit belongs into the name of the
+ * metric, e.g. "handler_p99_us".
+ *
+ * \param metric The name of the metric
+ * \param value The value of the metric
+ */
+void recordResult(const std::string& metric, double value) {
+    if (!getResults().empty())
+        getResults().back().metrics.emplace_back(metric, value);
+}
+
+/**
+ * Writes the results recorded by the benchmarks that ran as a JSON object
+ * with one object of metrics per benchmark to \p out, e.g. for tracking
+ * regressions.
+ *
+ * \param out The stream to write the JSON object to
+ */
+void writeResultsJson(std::ostream& out) {
+    // benchmark and metric names are identifiers, so nothing is escaped
+    out << "{";
+    const auto& results = getResults();
+    for (size_t i = 0; i < results.size(); i++) {
+        out << (i > 0 ? "," : "") << "\n  \"" << results[i].name << "\": {";
+        const auto& metrics = results[i].metrics;
+        for (size_t j = 0; j < metrics.size(); j++) {
+            out << (j > 0 ? "," : "") << "\n    \"" << metrics[j].first << "\": "
+                << std::setprecision(6) << metrics[j].second;
+        }
+        out << (metrics.empty() ? "}" : "\n  }");
+    }
+    out << (results.empty() ? "}" : "\n}") << std::endl;
+}
@@ -0,0 +1,102 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Benchmark.h
+ * \brief   Defines a minimal framework for \p GtkPass' benchmarks.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a minimal framework for \p GtkPass' benchmarks. Similar
+ * to the unit tests, benchmarks are written in separate files and register
+ * themselves with \p BENCHMARK_CASE. The benchmark program runs all
+ * registered benchmarks or the ones named on the command line.
+ */
+
+#ifndef GTKPASS_BENCHMARK_H
+#define GTKPASS_BENCHMARK_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Signature of a function implementing a benchmark
+typedef void (*BenchmarkFunction)(std::ostream& out);
+
+/// Registers a benchmark at static initialization time
+class BenchmarkRegistrar {
+
+public:
+    BenchmarkRegistrar(const char* name, BenchmarkFunction function);
+
+}; // end of class BenchmarkRegistrar
+
+/// Defines and registers a benchmark with the name \p name. The body of the
+/// benchmark follows the macro and writes its results to \p out.
+#define BENCHMARK_CASE(name) \
+    static void benchmark_##name(std::ostream& out); \
+    static BenchmarkRegistrar registrar_##name(#name, &benchmark_##name); \
+    static void benchmark_##name(std::ostream& out)
+
+/**
+ * Runs all registered benchmarks whose name is in \p names, or all of them if
+ * \p names is empty, and writes their results to \p out.
+ *
+ * \param out The stream to write the results to
+ * \param names The names of the benchmarks to run
+ * \return Number of names that do not belong to a registered benchmark
+ */
+int runBenchmarks(std::ostream& out, const std::vector<std::string>& names);
+
+/**
+ * Returns the current time of a monotonic clock in nanoseconds.
+ *
+ * \return Monotonic time in nanoseconds
+ */
+uint64_t getNanoseconds();
+
+/**
+ * Sorts \p samples and returns the value below which \p percentile percent of
+ * the samples are.
+ *
+ * \param samples The samples to get the percentile of (must not be empty)
+ * \param percentile The percentile between 0 and 100
+ * \return The percentile of the samples
+ */
+uint64_t getPercentile(std::vector<uint64_t>& samples, double percentile);
+
+/**
+ * Records the value \p value of the metric \p metric of the running
+ * benchmark for \p writeResultsJson(). The unit belongs into the name of the
+ * metric, e.g. "handler_p99_us".
+ *
+ * \param metric The name of the metric
+ * \param value The value of the metric
+ */
+void recordResult(const std::string& metric, double value);
+
+/**
+ * Writes the results recorded by the benchmarks that ran as a JSON object
+ * with one object of metrics per benchmark to \p out, e.g. for tracking
+ * regressions.
+ *
+ * \param out The stream to write the JSON object to
+ */
+void writeResultsJson(std::ostream& out);
+
+#endif
@@ -0,0 +1,377 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Blocklist.cpp
+ * \brief   Implements a memory-mapped blocklist of banned passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a memory-mapped blocklist of banned passwords.
+ */
+
+#include "Blocklist.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Header of a blocklist file
+struct Header {
+    /// \p BLOCKLIST_MAGIC without terminator
+    char magic[8];
+    /// \p BLOCKLIST_VERSION
+    uint32_t version;
+    /// always 0
+    uint32_t reserved;
+    /// seed of the hash function
+    uint64_t seed;
+    /// number of fingerprints in every block of the filter
+    uint64_t blockLength;
+    /// number of strings
+    uint64_t count;
+    /// total length of all strings
+    uint64_t stringBytes;
+    /// always 0
+    uint64_t padding[2];
+};
+
+static_assert(sizeof(Header) == 64, "unexpected size of the blocklist header");
+
+/// Maximum number of attempts to find a seed for which the filter can be built
+const unsigned int MAX_SEEDS = 100;
+
+/// Returns \p value rotated left by \p bits bits
+inline uint64_t rotateLeft(uint64_t value, unsigned int bits) {
+    return (value << bits) | (value >> ((64 - bits) & 63));
+}
+
+/// Finishes a hash value, so every bit depends on every input bit
+inline uint64_t finishHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/// Returns the hash of the \p length bytes at \p str with the seed \p seed,
+/// processing 8 bytes at a time
+uint64_t hashString(const char* str, size_t length, uint64_t seed) {
+    uint64_t hash = seed ^ (length * 0x9e3779b97f4a7c15ULL);
+    uint64_t word;
+    for (; length >= 8; str += 8, length -= 8) {
+        memcpy(&word, str, 8);
+        hash ^= rotateLeft(word * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+        hash = rotateLeft(hash, 27) * 5 + 0x52dce729;
+    }
+    word = 0;
+    memcpy(&word, str, length);
+    hash ^= rotateLeft(word * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+    return finishHash(hash);
+}
+
+/// Returns the fingerprint of the hash \p hash
+inline uint8_t getFingerprint(uint64_t hash) {
+    return static_cast<uint8_t>(hash ^ (hash >> 32));
+}
+
+/// Returns the index of the fingerprint of \p hash in the block \p block of
+/// a filter with blocks of \p blockLength fingerprints
+inline uint64_t getIndex(uint64_t hash, unsigned int block, uint64_t blockLength) {
+    const uint32_t bits = static_cast<uint32_t>(rotateLeft(hash, 21 * block));
+    return ((uint64_t(bits) * blockLength) >> 32) + block * blockLength;
+}
+
+/// Returns the next value of the SplitMix64 generator with state \p state
+uint64_t nextSeed(uint64_t& state) {
+    state += 0x9e3779b97f4a7c15ULL;
+    return finishHash(state);
+}
+
+/// Compares two strings like \p std::string does
+int compareStrings(const char* a, size_t lengthA, const char* b, size_t lengthB) {
+    const int result = memcmp(a, b, std::min(lengthA, lengthB));
+    if (result != 0)
+        return result;
+    return lengthA < lengthB ? -1 : (lengthA > lengthB ? 1 : 0);
+}
+
+/**
+ * Builds the fingerprints of an xor filter for the sorted, unique \p hashes
+ * by peeling the hypergraph whose edges are the three slots of every hash.
+ * Returns \p false if the graph has a cycle, so another seed is needed.
+ */
+bool buildFilter(const std::vector<uint64_t>& hashes, uint64_t blockLength,
+    std::vector<uint8_t>& fingerprints) {
+    const uint64_t slots = 3 * blockLength;
+    std::vector<uint64_t> xorMasks(slots, 0);
+    std::vector<uint32_t> counts(slots, 0);
+    for (const uint64_t hash : hashes) {
+        for (unsigned int block = 0; block < 3; block++) {
+            const uint64_t index = getIndex(hash, block, blockLength);
+            xorMasks[index] ^= hash;
+            counts[index]++;
+        }
+    }
+
+    // repeatedly remove a hash that is the only one in one of its slots
+    std::vector<uint64_t> queue;
+    for (uint64_t index = 0; index < slots; index++) {
+        if (counts[index] == 1)
+            queue.push_back(index);
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> stack;
+    stack.reserve(hashes.size());
+    while (!queue.empty()) {
+        const uint64_t index = queue.back();
+        queue.pop_back();
+        if (counts[index] != 1)
+            continue;
+        const uint64_t hash = xorMasks[index];
+        stack.emplace_back(index, hash);
+        for (unsigned int block = 0; block < 3; block++) {
+            const uint64_t other = getIndex(hash, block, blockLength);
+            xorMasks[other] ^= hash;
+            if (--counts[other] == 1)
+                queue.push_back(other);
+        }
+    }
+    if (stack.size() != hashes.size())
+        return false;
+
+    // assign in reverse order, so the slot of every hash is still free
+    fingerprints.assign(slots, 0);
+    for (auto entry = stack.rbegin(); entry != stack.rend(); ++entry) {
+        const uint64_t hash = entry->second;
+        fingerprints[entry->first] = getFingerprint(hash) ^
+            fingerprints[getIndex(hash, 0, blockLength)] ^
+            fingerprints[getIndex(hash, 1, blockLength)] ^
+            fingerprints[getIndex(hash, 2, blockLength)];
+    }
+    return true;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Constructor of \p Blocklist. Maps the blocklist file \p path into
+ * memory.
+ *
+ * \param path The path of the file
+ * \throws std::runtime_error if the file cannot be mapped or is not a
+ * valid blocklist
+ */
+Blocklist::Blocklist(const std::string& path) : m_data(nullptr), m_size(0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open blocklist \"" + path + "\"!");
+    struct stat status;
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error("Invalid blocklist \"" + path + "\"!");
+    }
+    m_size = status.st_size;
+    void* memory = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Failed to map blocklist \"" + path + "\"!");
+    m_data = static_cast<const unsigned char*>(memory);
+
+    Header header;
+    memcpy(&header, m_data, sizeof(header));
+    m_seed = header.seed;
+    m_blockLength = header.blockLength;
+    m_count = header.count;
+
+    // check every size before using it, so a corrupt file cannot make a
+    // lookup read outside of the mapping
+    const uint64_t available = m_size - sizeof(Header);
+    const uint64_t filterBytes = (3 * m_blockLength + 7) / 8 * 8;
+    bool valid = memcmp(header.magic, BLOCKLIST_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == BLOCKLIST_VERSION &&
+        m_blockLength > 0 && m_blockLength < (uint64_t(1) << 32) &&
+        filterBytes <= available &&
+        m_count < (available - filterBytes) / 8 &&
+        header.stringBytes == available - filterBytes - 8 * (m_count + 1);
+    if (valid) {
+        m_fingerprints = m_data + sizeof(Header);
+        m_offsets = reinterpret_cast<const uint64_t*>(m_fingerprints + filterBytes);
+        m_strings = reinterpret_cast<const char*>(m_offsets + m_count + 1);
+        valid = m_offsets[0] == 0 && m_offsets[m_count] == header.stringBytes;
+        for (uint64_t i = 0; valid && i < m_count; i++) {
+            valid = m_offsets[i] <= m_offsets[i + 1];
+        }
+    }
+    if (!valid) {
+        munmap(memory, m_size);
+        throw std::runtime_error("Invalid blocklist \"" + path + "\"!");
+    }
+}
+
+/**
+ * Destructor of \p Blocklist. Unmaps the file.
+ */
+Blocklist::~Blocklist() {
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+/**
+ * Checks the \p length characters at \p str against the filter only. The
+ * result is \p true for every banned string and for a small fraction of
+ * the other strings.
+ *
+ * \param str The characters to check
+ * \param length The number of characters
+ * \return \p false if the string is certainly not banned, \p true if it
+ * may be banned
+ */
+bool Blocklist::mayContain(const char* str, size_t length) const {
+    const uint64_t value = hash(str, length);
+    return getFingerprint(value) == (m_fingerprints[getIndex(value, 0, m_blockLength)] ^
+        m_fingerprints[getIndex(value, 1, m_blockLength)] ^
+        m_fingerprints[getIndex(value, 2, m_blockLength)]);
+}
+
+/**
+ * Checks whether the \p length characters at \p str are banned: against
+ * the filter first and against the list of strings on a hit.
+ *
+ * \param str The characters to check
+ * \param length The number of characters
+ * \return \p true if the string is banned, \p false otherwise
+ */
+bool Blocklist::contains(const char* str, size_t length) const {
+    if (!mayContain(str, length))
+        return false;
+    uint64_t low = 0;
+    uint64_t high = m_count;
+    while (low < high) {
+        const uint64_t middle = low + (high - low) / 2;
+        const int result = compareStrings(str, length, m_strings + m_offsets[middle],
+            m_offsets[middle + 1] - m_offsets[middle]);
+        if (result == 0)
+            return true;
+        if (result < 0)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return false;
+}
+
+/**
+ * Returns the number of banned strings.
+ *
+ * \return The number of strings in the blocklist
+ */
+uint64_t Blocklist::size() const {
+    return m_count;
+}
+
+/// Returns the hash of the \p length characters at \p str
+uint64_t Blocklist::hash(const char* str, size_t length) const {
+    return hashString(str, length, m_seed);
+}
+
+/**
+ * Reads banned strings from \p words, one per line, and writes a blocklist
+ * file with all of them to \p output. Empty lines are skipped, duplicates
+ * are removed.
+ *
+ * \param words The stream to read the banned strings from
+ * \param output The stream to write the blocklist to
+ * \param errors The stream to report errors to
+ * \return \p true on success, \p false if writing failed
+ */
+bool buildBlocklist(std::istream& words, std::ostream& output,
+    std::ostream& errors) {
+    std::vector<std::string> strings;
+    std::string line;
+    while (std::getline(words, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (!line.empty())
+            strings.push_back(line);
+    }
+    std::sort(strings.begin(), strings.end());
+    strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+
+    // a filter of 1.23 fingerprints per string can be built for almost every
+    // seed; the seeds are fixed, so the same list gives the same file
+    const uint64_t blockLength = (32 + strings.size() * 123 / 100) / 3 + 1;
+    if (blockLength >= (uint64_t(1) << 32)) {
+        errors << "ERROR: Too many strings for a blocklist!" << std::endl;
+        return false;
+    }
+    std::vector<uint64_t> hashes(strings.size());
+    std::vector<uint8_t> fingerprints;
+    uint64_t state = 0;
+    uint64_t seed = 0;
+    bool built = false;
+    for (unsigned int attempt = 0; !built && attempt < MAX_SEEDS; attempt++) {
+        seed = nextSeed(state);
+        for (size_t i = 0; i < strings.size(); i++) {
+            hashes[i] = hashString(strings[i].data(), strings[i].size(), seed);
+        }
+        // strings with the same hash share their fingerprint
+        std::sort(hashes.begin(), hashes.end());
+        std::vector<uint64_t> unique(hashes.begin(),
+            std::unique(hashes.begin(), hashes.end()));
+        built = buildFilter(unique, blockLength, fingerprints);
+    }
+    if (!built) {
+        errors << "ERROR: Failed to build the blocklist filter!" << std::endl;
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BLOCKLIST_MAGIC, sizeof(header.magic));
+    header.version = BLOCKLIST_VERSION;
+    header.seed = seed;
+    header.blockLength = blockLength;
+    header.count = strings.size();
+    std::vector<uint64_t> offsets(1, 0);
+    for (const auto& str : strings) {
+        offsets.push_back(offsets.back() + str.size());
+    }
+    header.stringBytes = offsets.back();
+    fingerprints.resize((fingerprints.size() + 7) / 8 * 8, 0);
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(fingerprints.data()), fingerprints.size());
+    output.write(reinterpret_cast<const char*>(offsets.data()),
+        offsets.size() * sizeof(uint64_t));
+    for (const auto& str : strings) {
+        output.write(str.data(), str.size());
+    }
+    output.flush();
+    if (!output) {
+        errors << "ERROR: Failed to write the blocklist!" << std::endl;
+        return false;
+    }
+    return true;
+}
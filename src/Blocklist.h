@@ -0,0 +1,152 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Blocklist.h
+ * \brief   Defines a memory-mapped blocklist of banned passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a blocklist of banned passwords stored in a compact
+ * binary file, which is mapped into memory instead of being read. The file
+ * holds an xor filter with 8 bit fingerprints (Graf and Lemire, "Xor Filters:
+ * Faster and Smaller Than Bloom and Cuckoo Filters") and the sorted list of
+ * all banned strings.
+ *
+ * A lookup hashes the candidate once and compares its fingerprint with the
+ * xor of three bytes of the filter. The filter never misses a banned string
+ * and wrongly reports about 0.4 % of the other strings, so only these hits
+ * are checked with a binary search in the sorted list. The filter needs
+ * about 1.23 bytes per banned string, so even large blocklists stay in the
+ * cache and a lookup costs a few dozen nanoseconds.
+ *
+ * The file starts with a header of 64 bytes in native byte order: the magic
+ * "GPXBLOCK", the format version and a reserved field (32 bit each), the
+ * seed of the hash function, the length of one of the three blocks of the
+ * filter, the number of strings and the total length of the strings (64 bit
+ * each) and 16 reserved bytes. It is followed by the fingerprints (padded to
+ * a multiple of 8 bytes), the 64 bit offsets of the strings plus the end of
+ * the last one and finally the strings without terminators.
+ */
+
+#ifndef GTKPASS_BLOCKLIST_H
+#define GTKPASS_BLOCKLIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/// Magic bytes at the start of a blocklist file
+#define BLOCKLIST_MAGIC "GPXBLOCK"
+/// Version of the blocklist file format
+#define BLOCKLIST_VERSION 1
+/// Number of times a blocked password is generated again before giving up
+#define BLOCKLIST_MAX_ATTEMPTS 1000
+
+/**
+ * Blocklist of banned passwords mapped into memory from a file written by
+ * \p buildBlocklist(). Lookups may be run by several threads at once.
+ */
+class Blocklist {
+
+public:
+    /**
+     * Constructor of \p Blocklist. Maps the blocklist file \p path into
+     * memory.
+     *
+     * \param path The path of the file
+     * \throws std::runtime_error if the file cannot be mapped or is not a
+     * valid blocklist
+     */
+    explicit Blocklist(const std::string& path);
+
+    /**
+     * Destructor of \p Blocklist. Unmaps the file.
+     */
+    ~Blocklist();
+
+    /**
+     * Checks the \p length characters at \p str against the filter only. The
+     * result is \p true for every banned string and for a small fraction of
+     * the other strings.
+     *
+     * \param str The characters to check
+     * \param length The number of characters
+     * \return \p false if the string is certainly not banned, \p true if it
+     * may be banned
+     */
+    bool mayContain(const char* str, size_t length) const;
+
+    /**
+     * Checks whether the \p length characters at \p str are banned: against
+     * the filter first and against the list of strings on a hit.
+     *
+     * \param str The characters to check
+     * \param length The number of characters
+     * \return \p true if the string is banned, \p false otherwise
+     */
+    bool contains(const char* str, size_t length) const;
+
+    /**
+     * Returns the number of banned strings.
+     *
+     * \return The number of strings in the blocklist
+     */
+    uint64_t size() const;
+
+private:
+    Blocklist(const Blocklist&) = delete;
+    Blocklist& operator=(const Blocklist&) = delete;
+
+    /// Returns the hash of the \p length characters at \p str
+    uint64_t hash(const char* str, size_t length) const;
+
+    /// the mapped file
+    const unsigned char* m_data;
+    /// the size of the mapped file
+    size_t m_size;
+    /// seed of the hash function
+    uint64_t m_seed;
+    /// number of fingerprints in every block of the filter
+    uint64_t m_blockLength;
+    /// the fingerprints of the filter
+    const uint8_t* m_fingerprints;
+    /// number of strings
+    uint64_t m_count;
+    /// offsets of the strings in \p m_strings plus the end of the last one
+    const uint64_t* m_offsets;
+    /// the sorted strings without terminators
+    const char* m_strings;
+
+}; // end of class Blocklist
+
+/**
+ * Reads banned strings from \p words, one per line, and writes a blocklist
+ * file with all of them to \p output. Empty lines are skipped, duplicates
+ * are removed.
+ *
+ * \param words The stream to read the banned strings from
+ * \param output The stream to write the blocklist to
+ * \param errors The stream to report errors to
+ * \return \p true on success, \p false if writing failed
+ */
+bool buildBlocklist(std::istream& words, std::ostream& output,
+    std::ostream& errors);
+
+#endif
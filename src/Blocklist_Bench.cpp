@@ -0,0 +1,119 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Blocklist_Bench.cpp
+ * \brief   Benchmarks the files \p Blocklist.h and \p Blocklist.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Blocklist.h and \p Blocklist.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Blocklist.h"
+#include "RandomGenerator.h"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+/// Number of banned strings in the blocklist
+static const size_t BANNED_COUNT = 1000000;
+/// Number of lookups per measurement
+static const size_t LOOKUPS = 10000000;
+/// Length of the generated passwords
+static const unsigned int PASSWORD_LENGTH = 12;
+
+/// Runs \p lookups lookups of the strings in \p words with \p lookup and
+/// writes the time per lookup to \p out
+template <typename Lookup>
+static void measureLookups(std::ostream& out, const char* label,
+    const std::vector<std::string>& words, Lookup lookup) {
+    size_t hits = 0;
+    const uint64_t start = getNanoseconds();
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        const std::string& word = words[i % words.size()];
+        hits += lookup(word.data(), word.size());
+    }
+    const uint64_t elapsed = getNanoseconds() - start;
+    out << std::left << std::setw(32) << label << std::right << std::fixed
+        << std::setprecision(1) << std::setw(8) << double(elapsed) / LOOKUPS
+        << " ns/lookup, " << std::setprecision(3) << 100.0 * hits / LOOKUPS
+        << " % hits" << std::endl;
+}
+
+/// Measures lookups in a blocklist of one million banned strings, and the
+/// throughput of generating passwords with and without checking them
+BENCHMARK_CASE(blocklist_lookup) {
+    genopts options;
+    std::vector<std::string> banned;
+    std::ostringstream words;
+    for (size_t i = 0; i < BANNED_COUNT; i++) {
+        banned.push_back(getRandomString(PASSWORD_LENGTH, options));
+        words << banned.back() << "\n";
+    }
+    char path[] = "/tmp/gtkpass-bench-blocklist-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        out << "mkstemp() failed" << std::endl;
+        return;
+    }
+    close(fd);
+    {
+        std::istringstream input(words.str());
+        std::ofstream output(path, std::ios::binary);
+        const uint64_t start = getNanoseconds();
+        buildBlocklist(input, output, out);
+        out << "Building: " << std::fixed << std::setprecision(2)
+            << (getNanoseconds() - start) / 1e9 << " s" << std::endl;
+    }
+    const Blocklist blocklist(path);
+    unlink(path);
+
+    std::vector<std::string> others;
+    for (size_t i = 0; i < BANNED_COUNT; i++) {
+        others.push_back(getRandomString(PASSWORD_LENGTH, options));
+    }
+    measureLookups(out, "filter, not banned", others, [&](const char* str, size_t length) {
+        return blocklist.mayContain(str, length);
+    });
+    measureLookups(out, "filter + exact, not banned", others, [&](const char* str, size_t length) {
+        return blocklist.contains(str, length);
+    });
+    measureLookups(out, "filter + exact, banned", banned, [&](const char* str, size_t length) {
+        return blocklist.contains(str, length);
+    });
+
+    const std::string& alphabet = getAlphabet(options);
+    std::string password(PASSWORD_LENGTH, '\0');
+    for (int check = 0; check < 2; check++) {
+        const uint64_t start = getNanoseconds();
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            do {
+                fillRandomChars(&password[0], PASSWORD_LENGTH, alphabet);
+            } while (check && blocklist.contains(password.data(), PASSWORD_LENGTH));
+        }
+        const uint64_t elapsed = getNanoseconds() - start;
+        out << std::left << std::setw(32)
+            << (check ? "generate + check" : "generate") << std::right
+            << std::setprecision(1) << std::setw(8) << double(elapsed) / LOOKUPS
+            << " ns/password" << std::endl;
+    }
+}
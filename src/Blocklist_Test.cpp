@@ -0,0 +1,253 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Blocklist_Test.cpp
+ * \brief   Tests the files \p Blocklist.h and \p Blocklist.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Blocklist.h and \p Blocklist.cpp.
+ */
+
+#include "catch.hpp"
+#include "Blocklist.h"
+#include "Provisioning.h"
+#include "RandomGenerator.h"
+#include "Uniqueness.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+/// Temporary blocklist file built from a list of words, removed on
+/// destruction
+struct TemporaryBlocklist {
+    /// Builds a blocklist of the lines in \p words
+    explicit TemporaryBlocklist(const std::string& words) {
+        char name[] = "/tmp/gtkpass-blocklist-XXXXXX";
+        const int fd = mkstemp(name);
+        REQUIRE(fd >= 0);
+        close(fd);
+        path = name;
+        std::istringstream input(words);
+        std::ofstream output(path, std::ios::binary);
+        std::ostringstream errors;
+        REQUIRE(buildBlocklist(input, output, errors));
+        REQUIRE(errors.str().empty());
+    }
+
+    /// Removes the file
+    ~TemporaryBlocklist() {
+        unlink(path.c_str());
+    }
+
+    /// path of the file
+    std::string path;
+};
+
+/// Returns \p count random words of 4 to 16 alphanumeric characters
+static std::vector<std::string> randomWords(size_t count) {
+    genopts options;
+    std::vector<std::string> words;
+    for (size_t i = 0; i < count; i++) {
+        words.push_back(getRandomString(4 + getRandomNumber(13), options));
+    }
+    return words;
+}
+
+/// Tests the class \p Blocklist and the function \p buildBlocklist
+TEST_CASE("Blocklist", "[Blocklist]") {
+    SECTION("Lookups") {
+        const std::vector<std::string> banned = randomWords(10000);
+        std::string words = "\n";
+        for (const auto& word : banned) {
+            words += word + "\r\n" + word + "\n";
+        }
+        const TemporaryBlocklist file(words);
+        const Blocklist blocklist(file.path);
+        REQUIRE(blocklist.size() == std::set<std::string>(banned.begin(), banned.end()).size());
+
+        bool allFound = true;
+        for (const auto& word : banned) {
+            allFound = allFound && blocklist.mayContain(word.data(), word.size()) &&
+                blocklist.contains(word.data(), word.size());
+        }
+        REQUIRE(allFound);
+
+        // other strings are rarely hits of the filter and never banned
+        const std::set<std::string> bannedSet(banned.begin(), banned.end());
+        size_t filterHits = 0;
+        bool noneBanned = true;
+        for (const auto& word : randomWords(100000)) {
+            if (bannedSet.count(word) != 0)
+                continue;
+            filterHits += blocklist.mayContain(word.data(), word.size());
+            noneBanned = noneBanned && !blocklist.contains(word.data(), word.size());
+        }
+        REQUIRE(noneBanned);
+        REQUIRE(filterHits < 1000);
+        REQUIRE_FALSE(blocklist.contains("", 0));
+    }
+
+    SECTION("Empty list") {
+        const TemporaryBlocklist file("\n\n");
+        const Blocklist blocklist(file.path);
+        REQUIRE(blocklist.size() == 0);
+        REQUIRE_FALSE(blocklist.contains("password", 8));
+    }
+
+    SECTION("Invalid files") {
+        REQUIRE_THROWS_AS(Blocklist("/nonexistent/blocklist"), const std::runtime_error&);
+
+        const TemporaryBlocklist file("password\n123456\n");
+        std::string content;
+        {
+            std::ifstream input(file.path, std::ios::binary);
+            content.assign(std::istreambuf_iterator<char>(input),
+                std::istreambuf_iterator<char>());
+        }
+        // truncated file and wrong magic
+        const std::string corrupt[] = {
+            content.substr(0, content.size() - 1),
+            "X" + content.substr(1)
+        };
+        for (const auto& data : corrupt) {
+            std::ofstream(file.path, std::ios::binary | std::ios::trunc) << data;
+            REQUIRE_THROWS_AS(Blocklist(file.path), const std::runtime_error&);
+        }
+    }
+}
+
+/// Tests the filter stage of \p runProvisioning with a blocklist
+TEST_CASE("runProvisioning with blocklist", "[Blocklist]") {
+    const TemporaryBlocklist file("0\n1\n2\n3\n4\n5\n6\n7\n8\n");
+    const Blocklist blocklist(file.path);
+    provopts options;
+    options.blocklist = &blocklist;
+    std::ostringstream output;
+    std::ostringstream errors;
+    pipelinereport report;
+
+    SECTION("Blocked passwords are generated again") {
+        std::stringstream manifest;
+        for (size_t i = 0; i < 100; i++) {
+            manifest << "user" << i << ",pin,1\n";
+        }
+        REQUIRE(runProvisioning(manifest, output, errors, report, options));
+        REQUIRE(report.stages.size() == 5);
+        REQUIRE(report.stages[2].name == "filter");
+        REQUIRE(report.blockedPasswords > 0);
+
+        // only 9 is left
+        std::istringstream lines(output.str());
+        std::string line;
+        size_t count = 0;
+        while (std::getline(lines, line)) {
+            REQUIRE(line.substr(line.find(',')) == ",9");
+            count++;
+        }
+        REQUIRE(count == 100);
+    }
+
+    SECTION("All passwords blocked") {
+        const TemporaryBlocklist allFile("0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n");
+        const Blocklist all(allFile.path);
+        options.blocklist = &all;
+        std::stringstream manifest("user,pin,1\n");
+        REQUIRE_FALSE(runProvisioning(manifest, output, errors, report, options));
+        REQUIRE(report.failedRows == 1);
+        REQUIRE(report.blockedPasswords == BLOCKLIST_MAX_ATTEMPTS);
+        // the row is dropped instead of written without password
+        REQUIRE(output.str().empty());
+    }
+
+    SECTION("Blocked rows are not hashed") {
+        const TemporaryBlocklist allFile("0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n");
+        const Blocklist all(allFile.path);
+        options.blocklist = &all;
+        options.hash = true;
+        options.hashing.opsLimit = crypto_pwhash_OPSLIMIT_MIN;
+        options.hashing.memLimit = crypto_pwhash_MEMLIMIT_MIN;
+        std::stringstream manifest("blocked,pin,1\nkept,default,12\n");
+        REQUIRE_FALSE(runProvisioning(manifest, output, errors, report, options));
+        REQUIRE(report.failedRows == 1);
+        // only the row with a password is hashed and written
+        REQUIRE(errors.str().find("Failed to hash") == std::string::npos);
+        const std::string text = output.str();
+        REQUIRE(text.compare(0, 5, "kept,") == 0);
+        REQUIRE(std::count(text.begin(), text.end(), '\n') == 1);
+    }
+}
+
+/// Tests the function \p writeUniquePasswords with a blocklist
+TEST_CASE("writeUniquePasswords with blocklist", "[Blocklist]") {
+    const TemporaryBlocklist file("aa\n");
+    const Blocklist blocklist(file.path);
+    uniqueopts options;
+    options.blocklist = &blocklist;
+    std::ostringstream errors;
+    uniquerep report;
+
+    FILE* output = tmpfile();
+    REQUIRE(output != nullptr);
+    REQUIRE(writeUniquePasswords(fileno(output), 3, "ab", 2, errors, report, options));
+    rewind(output);
+    char content[16] = {};
+    REQUIRE(fread(content, 1, sizeof(content), output) == 9);
+    fclose(output);
+    std::istringstream lines(content);
+    std::set<std::string> passwords;
+    std::string line;
+    while (std::getline(lines, line)) {
+        passwords.insert(line);
+    }
+    REQUIRE(passwords == std::set<std::string>({ "ab", "ba", "bb" }));
+    REQUIRE(report.generated == 3 + report.duplicates + report.blocked);
+
+    // all passwords of length 1 are blocked
+    const TemporaryBlocklist allFile("a\nb\n");
+    const Blocklist all(allFile.path);
+    options.blocklist = &all;
+    REQUIRE_FALSE(writeUniquePasswords(-1, 1, "ab", 1, errors, report, options));
+    REQUIRE_FALSE(errors.str().empty());
+
+    // the key space holds 10 passwords, but only 9 of them are allowed
+    const TemporaryBlocklist sevenFile("7\n");
+    const Blocklist seven(sevenFile.path);
+    options.blocklist = &seven;
+    errors.str("");
+    REQUIRE_FALSE(writeUniquePasswords(-1, 10, "0123456789", 1, errors, report, options));
+    REQUIRE(errors.str().find("fewer than 10 allowed passwords") != std::string::npos);
+    REQUIRE(report.unique == 9);
+
+    char directory[] = "/tmp/gtkpass-test-XXXXXX";
+    REQUIRE(mkdtemp(directory) != nullptr);
+    options.memoryLimit = 8;
+    options.spillDirectory = directory;
+    errors.str("");
+    REQUIRE_FALSE(writeUniquePasswords(-1, 10, "0123456789", 1, errors, report, options));
+    REQUIRE(errors.str().find("fewer than 10 allowed passwords") != std::string::npos);
+    REQUIRE(report.partitions > 1);
+    REQUIRE(report.unique == 9);
+    REQUIRE(rmdir(directory) == 0);
+}
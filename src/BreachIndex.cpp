@@ -0,0 +1,464 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BreachIndex.cpp
+ * \brief   Implements a memory-mapped index of breached password hashes.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements an offline index of the SHA-1 hashes of breached
+ * passwords.
+ */
+
+#include "BreachIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+/// Header of a breach index file
+struct Header {
+    /// \p BREACH_MAGIC without terminator
+    char magic[8];
+    /// \p BREACH_VERSION
+    uint32_t version;
+    /// number of hash bits selecting a bucket
+    uint32_t prefixBits;
+    /// number of bytes of a record
+    uint32_t recordBytes;
+    /// always 0
+    uint32_t reserved;
+    /// number of records
+    uint64_t count;
+    /// always 0
+    uint64_t padding[4];
+};
+
+static_assert(sizeof(Header) == 64, "unexpected size of the breach index header");
+
+/// Smallest number of prefix bits
+const unsigned int MIN_PREFIX_BITS = 8;
+/// Largest number of prefix bits (2 GiB bucket table)
+const unsigned int MAX_PREFIX_BITS = 28;
+/// Size of the buffer for writing records
+const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+/// Returns \p value rotated left by \p bits bits
+inline uint32_t rotateLeft(uint32_t value, unsigned int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+/// Returns the 32 bit big-endian number at \p bytes
+inline uint32_t loadBigEndian32(const unsigned char* bytes) {
+    return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 |
+        uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+}
+
+/// Processes the 64 byte block \p block of a SHA-1 hash with the state
+/// \p state
+void processSha1Block(uint32_t* state, const unsigned char* block) {
+    uint32_t words[80];
+    for (unsigned int i = 0; i < 16; i++) {
+        words[i] = loadBigEndian32(block + 4 * i);
+    }
+    for (unsigned int i = 16; i < 80; i++) {
+        words[i] = rotateLeft(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    // one loop per round function, so the loops have no branches
+    for (unsigned int i = 0; i < 20; i++) {
+        const uint32_t temp = rotateLeft(a, 5) + ((b & c) | (~b & d)) + e + 0x5a827999 + words[i];
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    for (unsigned int i = 20; i < 40; i++) {
+        const uint32_t temp = rotateLeft(a, 5) + (b ^ c ^ d) + e + 0x6ed9eba1 + words[i];
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    for (unsigned int i = 40; i < 60; i++) {
+        const uint32_t temp = rotateLeft(a, 5) + ((b & c) | (b & d) | (c & d)) + e + 0x8f1bbcdc +
+            words[i];
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    for (unsigned int i = 60; i < 80; i++) {
+        const uint32_t temp = rotateLeft(a, 5) + (b ^ c ^ d) + e + 0xca62c1d6 + words[i];
+        e = d;
+        d = c;
+        c = rotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+/// Returns the first 64 bits of the SHA-1 hash \p digest as a number
+inline uint64_t getKey(const unsigned char* digest) {
+    return uint64_t(loadBigEndian32(digest)) << 32 | loadBigEndian32(digest + 4);
+}
+
+/// Returns the value of a hex digit, or -1 for other characters
+inline int getHexValue(char digit) {
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'f')
+        return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'F')
+        return digit - 'A' + 10;
+    return -1;
+}
+
+/// Parses a line of a breach corpus into the key of its hash. Returns
+/// \p false if the line is no valid hash.
+bool parseCorpusLine(const std::string& line, uint64_t& key) {
+    const size_t digits = 2 * BREACH_SHA1_BYTES;
+    if (line.size() < digits || (line.size() > digits && line[digits] != ':'))
+        return false;
+    key = 0;
+    for (size_t i = 0; i < digits; i++) {
+        const int value = getHexValue(line[i]);
+        if (value < 0)
+            return false;
+        if (i < 16)
+            key = key << 4 | uint64_t(value);
+    }
+    return true;
+}
+
+/// Returns the number of bytes of a record with \p prefixBits prefix bits
+inline unsigned int getRecordBytes(unsigned int prefixBits) {
+    return (64 - prefixBits) / 8;
+}
+
+/// Returns the bits of \p key stored in a record
+inline uint64_t getSuffix(uint64_t key, unsigned int prefixBits,
+    unsigned int recordBytes) {
+    return (key << prefixBits) >> (64 - 8 * recordBytes);
+}
+
+} // end of anonymous namespace
+
+/**
+ * Computes the SHA-1 hash of the \p length bytes at \p data.
+ *
+ * \param data The bytes to hash
+ * \param length The number of bytes
+ * \param digest Receives the hash (\p BREACH_SHA1_BYTES bytes)
+ */
+void getSha1(const char* data, size_t length, unsigned char* digest) {
+    uint32_t state[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t remaining = length;
+    for (; remaining >= 64; bytes += 64, remaining -= 64) {
+        processSha1Block(state, bytes);
+    }
+
+    // pad with a 1 bit, zeros and the length in bits
+    unsigned char block[128] = {0};
+    memcpy(block, bytes, remaining);
+    block[remaining] = 0x80;
+    const size_t blockBytes = remaining < 56 ? 64 : 128;
+    const uint64_t bits = uint64_t(length) * 8;
+    for (unsigned int i = 0; i < 8; i++) {
+        block[blockBytes - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    processSha1Block(state, block);
+    if (blockBytes == 128)
+        processSha1Block(state, block + 64);
+
+    for (unsigned int i = 0; i < 5; i++) {
+        digest[4 * i] = static_cast<unsigned char>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<unsigned char>(state[i]);
+    }
+}
+
+/**
+ * Constructor of \p BreachIndex. Maps the index file \p path into
+ * memory.
+ *
+ * \param path The path of the file
+ * \throws std::runtime_error if the file cannot be mapped or is not a
+ * valid breach index
+ */
+BreachIndex::BreachIndex(const std::string& path) : m_data(nullptr), m_size(0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open breach index \"" + path + "\"!");
+    struct stat status;
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error("Invalid breach index \"" + path + "\"!");
+    }
+    m_size = status.st_size;
+    void* memory = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Failed to map breach index \"" + path + "\"!");
+    m_data = static_cast<const unsigned char*>(memory);
+
+    Header header;
+    memcpy(&header, m_data, sizeof(header));
+    m_prefixBits = header.prefixBits;
+    m_recordBytes = header.recordBytes;
+    m_count = header.count;
+
+    // check every size before using it, so a corrupt file cannot make a
+    // lookup read outside of the mapping; the bucket indices are clamped
+    // on every lookup instead of being checked here
+    const uint64_t available = m_size - sizeof(Header);
+    bool valid = memcmp(header.magic, BREACH_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == BREACH_VERSION &&
+        m_prefixBits >= MIN_PREFIX_BITS && m_prefixBits <= MAX_PREFIX_BITS &&
+        m_recordBytes == getRecordBytes(m_prefixBits);
+    if (valid) {
+        const uint64_t tableBytes = 8 * ((uint64_t(1) << m_prefixBits) + 1);
+        valid = tableBytes <= available &&
+            m_count <= (available - tableBytes) / m_recordBytes &&
+            (m_count * m_recordBytes + 7) / 8 * 8 == available - tableBytes;
+        if (valid) {
+            m_records = m_data + sizeof(Header);
+            m_buckets = reinterpret_cast<const uint64_t*>(m_records + available - tableBytes);
+            valid = m_buckets[0] == 0 && m_buckets[uint64_t(1) << m_prefixBits] == m_count;
+        }
+    }
+    if (!valid) {
+        munmap(memory, m_size);
+        throw std::runtime_error("Invalid breach index \"" + path + "\"!");
+    }
+}
+
+/**
+ * Destructor of \p BreachIndex. Unmaps the file.
+ */
+BreachIndex::~BreachIndex() {
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+/**
+ * Checks whether the SHA-1 hash \p digest is in the index.
+ *
+ * \param digest The hash (\p BREACH_SHA1_BYTES bytes)
+ * \return \p true if the hash is in the index, \p false otherwise
+ */
+bool BreachIndex::containsHash(const unsigned char* digest) const {
+    const uint64_t key = getKey(digest);
+    const uint64_t bucket = key >> (64 - m_prefixBits);
+    const uint64_t high = std::min(m_buckets[bucket + 1], m_count);
+    const uint64_t suffix = getSuffix(key, m_prefixBits, m_recordBytes);
+    const uint64_t position = lowerBound(suffix, std::min(m_buckets[bucket], high), high);
+    return position < high && getRecord(position) == suffix;
+}
+
+/**
+ * Checks whether the \p length characters at \p password are a breached
+ * password.
+ *
+ * \param password The characters to check
+ * \param length The number of characters
+ * \return \p true if the password is in the index, \p false otherwise
+ */
+bool BreachIndex::contains(const char* password, size_t length) const {
+    unsigned char digest[BREACH_SHA1_BYTES];
+    getSha1(password, length, digest);
+    return containsHash(digest);
+}
+
+/**
+ * Checks all \p passwords at once. The hashes are sorted before the
+ * lookups, so the index is read front to back and records shared by
+ * neighbouring queries are read only once.
+ *
+ * \param passwords The passwords to check
+ * \param breached Receives for every password whether it is in the index
+ * \return The number of passwords in the index
+ */
+size_t BreachIndex::containsBatch(const std::vector<std::string>& passwords,
+    std::vector<bool>& breached) const {
+    std::vector<std::pair<uint64_t, size_t>> queries;
+    queries.reserve(passwords.size());
+    unsigned char digest[BREACH_SHA1_BYTES];
+    for (size_t i = 0; i < passwords.size(); i++) {
+        getSha1(passwords[i].data(), passwords[i].size(), digest);
+        queries.emplace_back(getKey(digest), i);
+    }
+    std::sort(queries.begin(), queries.end());
+
+    breached.assign(passwords.size(), false);
+    size_t found = 0;
+    uint64_t previousBucket = 0;
+    uint64_t position = 0;
+    for (const auto& query : queries) {
+        const uint64_t bucket = query.first >> (64 - m_prefixBits);
+        const uint64_t high = std::min(m_buckets[bucket + 1], m_count);
+        // later queries of the same bucket continue where the last one ended
+        const uint64_t low = std::min(bucket == previousBucket ? position : m_buckets[bucket],
+            high);
+        const uint64_t suffix = getSuffix(query.first, m_prefixBits, m_recordBytes);
+        position = lowerBound(suffix, low, high);
+        previousBucket = bucket;
+        if (position < high && getRecord(position) == suffix) {
+            breached[query.second] = true;
+            found++;
+        }
+    }
+    return found;
+}
+
+/**
+ * Returns the number of hashes in the index.
+ *
+ * \return The number of records
+ */
+uint64_t BreachIndex::size() const {
+    return m_count;
+}
+
+/// Returns the position of the first of the records [\p low, \p high)
+/// that is not less than \p suffix, or \p high if there is none
+uint64_t BreachIndex::lowerBound(uint64_t suffix, uint64_t low, uint64_t high) const {
+    while (low < high) {
+        const uint64_t middle = low + (high - low) / 2;
+        if (getRecord(middle) < suffix)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/// Returns the value of the record at \p position
+uint64_t BreachIndex::getRecord(uint64_t position) const {
+    const unsigned char* record = m_records + position * m_recordBytes;
+    uint64_t value = 0;
+    for (unsigned int i = 0; i < m_recordBytes; i++) {
+        value = value << 8 | record[i];
+    }
+    return value;
+}
+
+/**
+ * Reads the sorted SHA-1 hashes of breached passwords from \p corpus, one
+ * per line as 40 hexadecimal digits optionally followed by ":" and a count,
+ * and writes a breach index to \p output. The corpus is read only once and
+ * never held in memory, but \p output must be seekable.
+ *
+ * \param corpus The stream to read the hashes from
+ * \param output The stream to write the index to
+ * \param errors The stream to report errors to
+ * \param prefixBits The number of hash bits selecting a bucket (8 to 28)
+ * \return \p true on success, \p false if a line is invalid, the hashes are
+ * not sorted or writing failed
+ */
+bool buildBreachIndex(std::istream& corpus, std::ostream& output,
+    std::ostream& errors, unsigned int prefixBits) {
+    if (prefixBits < MIN_PREFIX_BITS || prefixBits > MAX_PREFIX_BITS) {
+        errors << "ERROR: Invalid number of prefix bits for a breach index!" << std::endl;
+        return false;
+    }
+    const unsigned int recordBytes = getRecordBytes(prefixBits);
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BREACH_MAGIC, sizeof(header.magic));
+    header.version = BREACH_VERSION;
+    header.prefixBits = prefixBits;
+    header.recordBytes = recordBytes;
+    // the header is written again with the number of records at the end
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // the number of records of every bucket, summed up to the indices of the
+    // first record of every bucket at the end
+    std::vector<uint64_t> buckets((size_t(1) << prefixBits) + 1, 0);
+    std::vector<char> buffer;
+    buffer.reserve(WRITE_BUFFER_SIZE);
+    std::string line;
+    uint64_t lineNumber = 0;
+    uint64_t previous = 0;
+    uint64_t key;
+    while (std::getline(corpus, line)) {
+        lineNumber++;
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty())
+            continue;
+        if (!parseCorpusLine(line, key)) {
+            errors << "ERROR: Invalid hash in line " << lineNumber
+                << " of the breach corpus!" << std::endl;
+            return false;
+        }
+        if (header.count > 0 && key <= previous) {
+            // hashes sharing their first 64 bits share their record
+            if (key == previous)
+                continue;
+            errors << "ERROR: The breach corpus is not sorted by hash (line "
+                << lineNumber << ")!" << std::endl;
+            return false;
+        }
+        previous = key;
+        header.count++;
+        buckets[(key >> (64 - prefixBits)) + 1]++;
+        const uint64_t suffix = getSuffix(key, prefixBits, recordBytes);
+        for (unsigned int i = recordBytes; i-- > 0;) {
+            buffer.push_back(static_cast<char>(suffix >> (8 * i)));
+        }
+        if (buffer.size() + recordBytes > WRITE_BUFFER_SIZE) {
+            output.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    if (corpus.bad()) {
+        errors << "ERROR: Failed to read the breach corpus!" << std::endl;
+        return false;
+    }
+    buffer.resize(buffer.size() + (8 - header.count * recordBytes % 8) % 8, 0);
+    output.write(buffer.data(), buffer.size());
+    for (size_t i = 1; i < buckets.size(); i++) {
+        buckets[i] += buckets[i - 1];
+    }
+    output.write(reinterpret_cast<const char*>(buckets.data()),
+        buckets.size() * sizeof(uint64_t));
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.flush();
+    if (!output) {
+        errors << "ERROR: Failed to write the breach index!" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,182 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BreachIndex.h
+ * \brief   Defines a memory-mapped index of breached password hashes.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines an offline index of the SHA-1 hashes of breached
+ * passwords, built from a sorted corpus like the "Pwned Passwords" list
+ * (one hexadecimal hash per line, optionally followed by ":" and the number
+ * of occurrences). The index is mapped into memory instead of being read.
+ *
+ * Only the first 64 bits of every hash are kept. The top \p prefixBits bits
+ * select a bucket, the next bits are stored in fixed-width records of
+ * (64 - \p prefixBits) / 8 bytes, sorted within every bucket. A table with
+ * the index of the first record of every bucket follows the records. A
+ * lookup reads one entry of the table and runs a binary search over the
+ * few records of the bucket, which usually lie on a single page. With
+ * 20 prefix bits, 60 bits of every hash are kept, so a corpus of one
+ * billion hashes reports about one in a billion other passwords as
+ * breached.
+ *
+ * The file starts with a header of 64 bytes in native byte order: the magic
+ * "GPXBREAC", the format version, the number of prefix bits and the width
+ * of a record (32 bit each), a reserved field (32 bit), the number of
+ * records (64 bit) and 32 reserved bytes. It is followed by the records
+ * (padded to a multiple of 8 bytes) and the 64 bit indices of the first
+ * record of every bucket plus the number of records.
+ */
+
+#ifndef GTKPASS_BREACHINDEX_H
+#define GTKPASS_BREACHINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Magic bytes at the start of a breach index file
+#define BREACH_MAGIC "GPXBREAC"
+/// Version of the breach index file format
+#define BREACH_VERSION 1
+/// Default number of hash bits selecting a bucket (8 MiB bucket table)
+#define BREACH_PREFIX_BITS 20
+/// Number of bytes of a SHA-1 hash
+#define BREACH_SHA1_BYTES 20
+/// Number of passwords of a list checked with one call of
+/// \p BreachIndex::containsBatch()
+#define BREACH_CHECK_BATCH_SIZE 1000000
+
+/**
+ * Computes the SHA-1 hash of the \p length bytes at \p data.
+ *
+ * \param data The bytes to hash
+ * \param length The number of bytes
+ * \param digest Receives the hash (\p BREACH_SHA1_BYTES bytes)
+ */
+void getSha1(const char* data, size_t length, unsigned char* digest);
+
+/**
+ * Index of the SHA-1 hashes of breached passwords mapped into memory from a
+ * file written by \p buildBreachIndex(). Lookups may be run by several
+ * threads at once.
+ */
+class BreachIndex {
+
+public:
+    /**
+     * Constructor of \p BreachIndex. Maps the index file \p path into
+     * memory.
+     *
+     * \param path The path of the file
+     * \throws std::runtime_error if the file cannot be mapped or is not a
+     * valid breach index
+     */
+    explicit BreachIndex(const std::string& path);
+
+    /**
+     * Destructor of \p BreachIndex. Unmaps the file.
+     */
+    ~BreachIndex();
+
+    /**
+     * Checks whether the SHA-1 hash \p digest is in the index.
+     *
+     * \param digest The hash (\p BREACH_SHA1_BYTES bytes)
+     * \return \p true if the hash is in the index, \p false otherwise
+     */
+    bool containsHash(const unsigned char* digest) const;
+
+    /**
+     * Checks whether the \p length characters at \p password are a breached
+     * password.
+     *
+     * \param password The characters to check
+     * \param length The number of characters
+     * \return \p true if the password is in the index, \p false otherwise
+     */
+    bool contains(const char* password, size_t length) const;
+
+    /**
+     * Checks all \p passwords at once. The hashes are sorted before the
+     * lookups, so the index is read front to back and records shared by
+     * neighbouring queries are read only once.
+     *
+     * \param passwords The passwords to check
+     * \param breached Receives for every password whether it is in the index
+     * \return The number of passwords in the index
+     */
+    size_t containsBatch(const std::vector<std::string>& passwords,
+        std::vector<bool>& breached) const;
+
+    /**
+     * Returns the number of hashes in the index.
+     *
+     * \return The number of records
+     */
+    uint64_t size() const;
+
+private:
+    BreachIndex(const BreachIndex&) = delete;
+    BreachIndex& operator=(const BreachIndex&) = delete;
+
+    /// Returns the position of the first of the records [\p low, \p high)
+    /// that is not less than \p suffix, or \p high if there is none
+    uint64_t lowerBound(uint64_t suffix, uint64_t low, uint64_t high) const;
+
+    /// Returns the value of the record at \p position
+    uint64_t getRecord(uint64_t position) const;
+
+    /// the mapped file
+    const unsigned char* m_data;
+    /// the size of the mapped file
+    size_t m_size;
+    /// number of hash bits selecting a bucket
+    unsigned int m_prefixBits;
+    /// number of bytes of a record
+    unsigned int m_recordBytes;
+    /// number of records
+    uint64_t m_count;
+    /// the records
+    const unsigned char* m_records;
+    /// index of the first record of every bucket plus the number of records
+    const uint64_t* m_buckets;
+
+}; // end of class BreachIndex
+
+/**
+ * Reads the sorted SHA-1 hashes of breached passwords from \p corpus, one
+ * per line as 40 hexadecimal digits optionally followed by ":" and a count,
+ * and writes a breach index to \p output. The corpus is read only once and
+ * never held in memory, but \p output must be seekable.
+ *
+ * \param corpus The stream to read the hashes from
+ * \param output The stream to write the index to
+ * \param errors The stream to report errors to
+ * \param prefixBits The number of hash bits selecting a bucket (8 to 28)
+ * \return \p true on success, \p false if a line is invalid, the hashes are
+ * not sorted or writing failed
+ */
+bool buildBreachIndex(std::istream& corpus, std::ostream& output,
+    std::ostream& errors, unsigned int prefixBits = BREACH_PREFIX_BITS);
+
+#endif
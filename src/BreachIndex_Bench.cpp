@@ -0,0 +1,123 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BreachIndex_Bench.cpp
+ * \brief   Benchmarks the files \p BreachIndex.h and \p BreachIndex.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p BreachIndex.h and \p BreachIndex.cpp.
+ */
+
+#include "Benchmark.h"
+#include "BreachIndex.h"
+#include "RandomGenerator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+/// Number of hashes in the breach index
+static const size_t BREACHED_COUNT = 5000000;
+/// Number of queries per measurement
+static const size_t QUERIES = 1000000;
+/// Length of the generated passwords
+static const unsigned int PASSWORD_LENGTH = 12;
+
+/// Writes the time per query of \p elapsed nanoseconds for \p QUERIES
+/// queries with \p hits hits to \p out
+static void printQueries(std::ostream& out, const char* label, uint64_t elapsed,
+    size_t hits) {
+    out << std::left << std::setw(32) << label << std::right << std::fixed
+        << std::setprecision(1) << std::setw(8) << double(elapsed) / QUERIES
+        << " ns/query, " << std::setprecision(1) << 100.0 * hits / QUERIES
+        << " % hits" << std::endl;
+}
+
+/// Measures single and batched lookups in a breach index of five million
+/// hashes with half of the queries breached
+BENCHMARK_CASE(breach_lookup) {
+    genopts options;
+    std::vector<std::string> breached;
+    std::vector<std::string> hashes;
+    unsigned char digest[BREACH_SHA1_BYTES];
+    for (size_t i = 0; i < BREACHED_COUNT; i++) {
+        const std::string password = getRandomString(PASSWORD_LENGTH, options);
+        if (i < QUERIES / 2)
+            breached.push_back(password);
+        getSha1(password.data(), password.size(), digest);
+        std::string hex;
+        for (const unsigned char byte : digest) {
+            hex += "0123456789ABCDEF"[byte >> 4];
+            hex += "0123456789ABCDEF"[byte & 15];
+        }
+        hashes.push_back(hex + ":1\n");
+    }
+    std::sort(hashes.begin(), hashes.end());
+    std::string corpus;
+    for (const auto& line : hashes) {
+        corpus += line;
+    }
+    hashes.clear();
+    hashes.shrink_to_fit();
+
+    char path[] = "/tmp/gtkpass-bench-breach-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        out << "mkstemp() failed" << std::endl;
+        return;
+    }
+    close(fd);
+    {
+        std::istringstream input(corpus);
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        const uint64_t start = getNanoseconds();
+        buildBreachIndex(input, output, out);
+        out << "Building: " << std::fixed << std::setprecision(2)
+            << (getNanoseconds() - start) / 1e9 << " s for "
+            << corpus.size() / (1 << 20) << " MiB of hashes" << std::endl;
+    }
+    const BreachIndex index(path);
+    unlink(path);
+
+    std::vector<std::string> queries(breached);
+    while (queries.size() < QUERIES) {
+        queries.push_back(getRandomString(PASSWORD_LENGTH, options));
+    }
+    std::random_shuffle(queries.begin(), queries.end());
+
+    size_t hits = 0;
+    uint64_t start = getNanoseconds();
+    for (const auto& query : queries) {
+        hits += index.contains(query.data(), query.size());
+    }
+    printQueries(out, "single lookups", getNanoseconds() - start, hits);
+
+    std::vector<bool> results;
+    start = getNanoseconds();
+    hits = index.containsBatch(queries, results);
+    printQueries(out, "batch (sorted)", getNanoseconds() - start, hits);
+
+    start = getNanoseconds();
+    for (const auto& query : queries) {
+        getSha1(query.data(), query.size(), digest);
+    }
+    printQueries(out, "SHA-1 only", getNanoseconds() - start, 0);
+}
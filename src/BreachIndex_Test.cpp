@@ -0,0 +1,209 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    BreachIndex_Test.cpp
+ * \brief   Tests the files \p BreachIndex.h and \p BreachIndex.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p BreachIndex.h and \p BreachIndex.cpp.
+ */
+
+#include "catch.hpp"
+#include "BreachIndex.h"
+#include "RandomGenerator.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+/// Returns the SHA-1 hash of \p str as upper case hex digits
+static std::string getSha1Hex(const std::string& str) {
+    unsigned char digest[BREACH_SHA1_BYTES];
+    getSha1(str.data(), str.size(), digest);
+    std::string hex;
+    for (const unsigned char byte : digest) {
+        hex += "0123456789ABCDEF"[byte >> 4];
+        hex += "0123456789ABCDEF"[byte & 15];
+    }
+    return hex;
+}
+
+/// Temporary breach index file built from a corpus, removed on destruction
+struct TemporaryIndex {
+    /// Creates an empty file
+    TemporaryIndex() {
+        char name[] = "/tmp/gtkpass-breach-XXXXXX";
+        const int fd = mkstemp(name);
+        REQUIRE(fd >= 0);
+        close(fd);
+        path = name;
+    }
+
+    /// Builds an index of the hashes in \p corpus with \p prefixBits prefix
+    /// bits and returns whether building succeeded
+    bool build(const std::string& corpus, unsigned int prefixBits,
+        std::ostringstream& errors) {
+        std::istringstream input(corpus);
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        return buildBreachIndex(input, output, errors, prefixBits);
+    }
+
+    /// Removes the file
+    ~TemporaryIndex() {
+        unlink(path.c_str());
+    }
+
+    /// path of the file
+    std::string path;
+};
+
+/// Tests the function \p getSha1
+TEST_CASE("SHA-1", "[BreachIndex]") {
+    REQUIRE(getSha1Hex("") == "DA39A3EE5E6B4B0D3255BFEF95601890AFD80709");
+    REQUIRE(getSha1Hex("abc") == "A9993E364706816ABA3E25717850C26C9CD0D89D");
+    REQUIRE(getSha1Hex("password") == "5BAA61E4C9B93F3F0682250B6CF8331B7EE68FD8");
+    // 56 bytes need a second block for the padding
+    REQUIRE(getSha1Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+        "84983E441C3BD26EBAAE4AA1F95129E5E54670F1");
+    REQUIRE(getSha1Hex(std::string(1000000, 'a')) ==
+        "34AA973CD4C4DAA4F61EEB2BDBAD27316534016F");
+}
+
+/// Tests the class \p BreachIndex and the function \p buildBreachIndex
+TEST_CASE("BreachIndex", "[BreachIndex]") {
+    genopts options;
+    std::vector<std::string> breached;
+    std::vector<std::string> hashes;
+    // short random passwords repeat now and then, the index stores each once
+    std::set<std::string> unique;
+    while (breached.size() < 20000) {
+        const std::string password = getRandomString(4 + getRandomNumber(13), options);
+        if (!unique.insert(password).second)
+            continue;
+        breached.push_back(password);
+        hashes.push_back(getSha1Hex(password));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    std::string corpus;
+    for (size_t i = 0; i < hashes.size(); i++) {
+        // mix upper and lower case, counts and Windows line endings
+        std::string hash = hashes[i];
+        if (i % 3 == 0)
+            std::transform(hash.begin(), hash.end(), hash.begin(), ::tolower);
+        corpus += hash + (i % 2 ? ":" + std::to_string(i) : "") + (i % 5 ? "\n" : "\r\n");
+    }
+
+    SECTION("Lookups") {
+        for (const unsigned int prefixBits : {8, 13, BREACH_PREFIX_BITS}) {
+            TemporaryIndex file;
+            std::ostringstream errors;
+            REQUIRE(file.build("\n" + corpus.substr(0, 41) + "\n" + corpus, prefixBits, errors));
+            REQUIRE(errors.str().empty());
+            const BreachIndex index(file.path);
+            REQUIRE(index.size() == breached.size());
+
+            bool allFound = true;
+            for (const auto& password : breached) {
+                allFound = allFound && index.contains(password.data(), password.size());
+            }
+            REQUIRE(allFound);
+            size_t falsePositives = 0;
+            std::vector<std::string> queries;
+            for (size_t i = 0; i < 20000; i++) {
+                queries.push_back(getRandomString(18, options));
+                falsePositives += index.contains(queries.back().data(), queries.back().size());
+            }
+            REQUIRE(falsePositives == 0);
+
+            // batches must give the same results as single lookups
+            queries.insert(queries.end(), breached.begin(), breached.begin() + 5000);
+            queries.push_back(breached[0]);
+            std::vector<bool> results;
+            REQUIRE(index.containsBatch(queries, results) == 5001);
+            REQUIRE(results.size() == queries.size());
+            bool same = true;
+            for (size_t i = 0; i < queries.size(); i++) {
+                same = same && results[i] == (i >= 20000);
+            }
+            REQUIRE(same);
+        }
+    }
+
+    SECTION("Empty corpus") {
+        TemporaryIndex file;
+        std::ostringstream errors;
+        REQUIRE(file.build("", 8, errors));
+        const BreachIndex index(file.path);
+        REQUIRE(index.size() == 0);
+        REQUIRE_FALSE(index.contains("password", 8));
+        std::vector<bool> results;
+        REQUIRE(index.containsBatch({"password", ""}, results) == 0);
+        REQUIRE(results == std::vector<bool>({false, false}));
+    }
+
+    SECTION("Invalid corpus") {
+        TemporaryIndex file;
+        std::ostringstream errors;
+        REQUIRE_FALSE(file.build(hashes[1] + "\n" + hashes[0] + "\n", 8, errors));
+        REQUIRE(errors.str().find("not sorted") != std::string::npos);
+        errors.str("");
+        REQUIRE_FALSE(file.build(hashes[0] + "\nnot a hash\n", 8, errors));
+        REQUIRE(errors.str().find("line 2") != std::string::npos);
+        errors.str("");
+        REQUIRE_FALSE(file.build(hashes[0] + "X\n", 8, errors));
+        REQUIRE_FALSE(file.build(hashes[0].substr(0, 39) + "\n", 8, errors));
+        REQUIRE_FALSE(file.build(corpus, 7, errors));
+        REQUIRE_FALSE(file.build(corpus, 29, errors));
+    }
+
+    SECTION("Invalid files") {
+        TemporaryIndex file;
+        std::ostringstream errors;
+        REQUIRE(file.build(corpus, 8, errors));
+        std::string data;
+        {
+            std::ifstream input(file.path, std::ios::binary);
+            std::ostringstream content;
+            content << input.rdbuf();
+            data = content.str();
+        }
+        const auto writeFile = [&](const std::string& content) {
+            std::ofstream output(file.path, std::ios::binary | std::ios::trunc);
+            output << content;
+        };
+
+        writeFile(data.substr(0, data.size() - 8));
+        REQUIRE_THROWS_AS(BreachIndex(file.path), const std::runtime_error&);
+        std::string corrupt = data;
+        corrupt[0] = 'X';
+        writeFile(corrupt);
+        REQUIRE_THROWS_AS(BreachIndex(file.path), const std::runtime_error&);
+        corrupt = data;
+        corrupt[12] = 9;
+        writeFile(corrupt);
+        REQUIRE_THROWS_AS(BreachIndex(file.path), const std::runtime_error&);
+        writeFile("GPXBREAC");
+        REQUIRE_THROWS_AS(BreachIndex(file.path), const std::runtime_error&);
+        REQUIRE_THROWS_AS(BreachIndex("/nonexistent/breach"), const std::runtime_error&);
+    }
+}
@@ -0,0 +1,213 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkDialog.cpp
+ * \brief   Implements a dialog for writing many passwords to a file.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a dialog for writing many passwords to a file.
+ */
+
+#include "BulkDialog.h"
+#include <glibmm/i18n.h>
+
+/**
+ * Constructor of \p BulkDialog. Builds the widgets of the dialog.
+ *
+ * \param parent The window the dialog belongs to
+ */
+BulkDialog::BulkDialog(Gtk::Window& parent) :
+    Gtk::Dialog(_("Bulk Generation"), parent, false), m_options(), m_length(12),
+    m_countLabel(_("Number of passwords:"), Gtk::ALIGN_START),
+    m_fileLabel(_("File:"), Gtk::ALIGN_START), m_chooseFile(_("_Choose…"), true),
+    m_btnGenerate(nullptr), m_btnClose(nullptr),
+    m_job([this]() { m_progress.emit(); }) {
+
+    m_count.set_range(1.0, 1000000000.0);
+    m_count.set_increments(1000.0, 100000.0);
+    m_count.set_digits(0);
+    m_count.set_numeric(true);
+    m_count.set_value(1000.0);
+    m_file.set_hexpand(true);
+    m_file.set_placeholder_text(_("Path of the file to write"));
+    m_progressBar.set_show_text(true);
+    m_progressBar.set_text("");
+
+    m_grid.set_border_width(10);
+    m_grid.set_row_spacing(5);
+    m_grid.set_column_spacing(10);
+    m_grid.attach(m_countLabel, 0, 0, 1, 1);
+    m_grid.attach(m_count, 1, 0, 2, 1);
+    m_grid.attach(m_fileLabel, 0, 1, 1, 1);
+    m_grid.attach(m_file, 1, 1, 1, 1);
+    m_grid.attach(m_chooseFile, 2, 1, 1, 1);
+    m_grid.attach(m_progressBar, 0, 2, 3, 1);
+    get_content_area()->pack_start(m_grid, true, true);
+
+    m_btnClose = add_button(_("_Close"), Gtk::RESPONSE_CLOSE);
+    m_btnGenerate = add_button(_("_Generate"), Gtk::RESPONSE_OK);
+    set_default_response(Gtk::RESPONSE_OK);
+
+    m_chooseFile.signal_clicked().connect(
+        sigc::mem_fun(*this, &BulkDialog::on_chooseFile)
+    );
+    // the job notifies at most once per frame, so millions of passwords do
+    // not flood the main loop
+    m_progress.connect(
+        sigc::mem_fun(*this, &BulkDialog::on_progress)
+    );
+    show_all_children();
+}
+
+/**
+ * Sets the options and the length of the passwords written by the next
+ * job.
+ *
+ * \param options The options for the generation
+ * \param length The number of characters of every password
+ */
+void BulkDialog::setOptions(const genopts& options, unsigned int length) {
+    m_options = options;
+    m_length = length;
+}
+
+/**
+ * Handler for the buttons of the dialog. "Generate" starts a job writing
+ * the passwords to the chosen file, asking first if a typed path names an
+ * existing file; "Cancel" and closing the dialog cancel a running job,
+ * whose partial file is removed; "Close" hides the dialog.
+ *
+ * \param responseId The response of the button
+ */
+void BulkDialog::on_response(int responseId) {
+    if (responseId == Gtk::RESPONSE_OK) {
+        if (m_file.get_text().empty())
+            on_chooseFile();
+        const std::string path = m_file.get_text();
+        if (path.empty())
+            return;
+        // the file chooser already asked for the path it returned
+        bool overwrite = path == m_confirmedPath;
+        if (!overwrite && Glib::file_test(path, Glib::FILE_TEST_EXISTS)) {
+            if (!confirmOverwrite(path))
+                return;
+            overwrite = true;
+        }
+        const uint64_t count = static_cast<uint64_t>(m_count.get_value_as_int());
+        if (!m_job.start(path, count, m_length, m_options, 0, overwrite)) {
+            m_progressBar.set_fraction(0.0);
+            m_progressBar.set_text(_("The passwords could not be written"));
+            return;
+        }
+        updateButtons(true);
+        on_progress();
+        return;
+    }
+
+    if (m_job.getProgress().state == BULK_RUNNING) {
+        m_job.cancel();
+        m_progressBar.set_text(_("Cancelling…"));
+        if (responseId != Gtk::RESPONSE_DELETE_EVENT)
+            return;
+    }
+    hide();
+}
+
+/**
+ * Signal handler for clicking the button choosing the file. Asks for the
+ * file to write the passwords to, confirming to overwrite existing files.
+ */
+void BulkDialog::on_chooseFile() {
+    Gtk::FileChooserDialog chooser(*this, _("Save Passwords"),
+        Gtk::FILE_CHOOSER_ACTION_SAVE);
+    chooser.add_button(_("_Cancel"), Gtk::RESPONSE_CANCEL);
+    chooser.add_button(_("_Save"), Gtk::RESPONSE_ACCEPT);
+    chooser.set_do_overwrite_confirmation(true);
+    if (m_file.get_text().empty())
+        chooser.set_current_name("passwords.txt");
+    else
+        chooser.set_filename(m_file.get_text());
+    if (chooser.run() == Gtk::RESPONSE_ACCEPT) {
+        m_confirmedPath = chooser.get_filename();
+        m_file.set_text(m_confirmedPath);
+    }
+}
+
+/**
+ * Asks whether the existing file \p path should be replaced by the
+ * passwords. The file is only replaced once all passwords are written.
+ *
+ * \param path The path of the file
+ * \return \p true if the file may be replaced, \p false otherwise
+ */
+bool BulkDialog::confirmOverwrite(const std::string& path) {
+    Gtk::MessageDialog dialog(*this,
+        Glib::ustring::compose(_("A file named \"%1\" already exists. Do you want to replace it?"),
+            Glib::filename_display_basename(path)),
+        false, Gtk::MESSAGE_QUESTION, Gtk::BUTTONS_NONE, true);
+    dialog.set_secondary_text(
+        _("The file is replaced once all passwords are written."));
+    dialog.add_button(_("_Cancel"), Gtk::RESPONSE_CANCEL);
+    dialog.add_button(_("_Replace"), Gtk::RESPONSE_ACCEPT);
+    return dialog.run() == Gtk::RESPONSE_ACCEPT;
+}
+
+/**
+ * Signal handler for the progress of the job. Updates the progress bar and,
+ * once the job is over, shows its result and enables the widgets again.
+ */
+void BulkDialog::on_progress() {
+    const bulkprogress progress = m_job.getProgress();
+    m_progressBar.set_fraction(progress.total > 0 ?
+        double(progress.written) / progress.total : 1.0);
+    switch (progress.state) {
+        case BULK_RUNNING:
+            m_progressBar.set_text(Glib::ustring::compose(_("%1 of %2 passwords"),
+                progress.written, progress.total));
+            return;
+        case BULK_FINISHED:
+            m_progressBar.set_text(Glib::ustring::compose(_("%1 passwords written"),
+                progress.total));
+            break;
+        case BULK_CANCELLED:
+            m_progressBar.set_text(_("Cancelled"));
+            break;
+        case BULK_FAILED:
+            m_progressBar.set_text(m_job.getError());
+            break;
+        default:
+            break;
+    }
+    updateButtons(false);
+}
+
+/**
+ * Function for enabling the widgets for the state of the job. While the job
+ * is running, its settings cannot be changed and the close button cancels
+ * it.
+ *
+ * \param running \p true while the job is running
+ */
+void BulkDialog::updateButtons(bool running) {
+    m_count.set_sensitive(!running);
+    m_file.set_sensitive(!running);
+    m_chooseFile.set_sensitive(!running);
+    m_btnGenerate->set_sensitive(!running);
+    m_btnClose->set_label(running ? _("_Cancel") : _("_Close"));
+}
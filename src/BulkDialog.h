@@ -0,0 +1,109 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkDialog.h
+ * \brief   Defines a dialog for writing many passwords to a file.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a dialog that writes a number of passwords with the
+ * options of the window to a file chosen by the user. The passwords are
+ * written by a \p BulkJob on background threads, whose progress reaches
+ * the main loop through a \p Glib::Dispatcher at most once per frame.
+ */
+
+#ifndef GTKPASS_BULKDIALOG_H
+#define GTKPASS_BULKDIALOG_H
+
+#include "BulkJob.h"
+#include "RandomGenerator.h"
+#include <gtkmm.h>
+
+/**
+ * Dialog writing passwords to a file in the background, with a progress
+ * bar and a button cancelling the job.
+ */
+class BulkDialog : public Gtk::Dialog {
+
+public:
+    /**
+     * Constructor of \p BulkDialog.
+     *
+     * \param parent The window the dialog belongs to
+     */
+    explicit BulkDialog(Gtk::Window& parent);
+
+    /**
+     * Sets the options and the length of the passwords written by the next
+     * job.
+     *
+     * \param options The options for the generation
+     * \param length The number of characters of every password
+     */
+    void setOptions(const genopts& options, unsigned int length);
+
+protected:
+    /// Starts or cancels the job, or hides the dialog
+    void on_response(int responseId) override;
+
+private:
+    BulkDialog(const BulkDialog&) = delete;
+    BulkDialog& operator=(const BulkDialog&) = delete;
+
+    /// Signal handler for clicking the button choosing the file
+    void on_chooseFile();
+    /// Signal handler for the progress of the job
+    void on_progress();
+    /// Function for enabling the widgets for the state of the job
+    void updateButtons(bool running);
+    /// Asks whether the existing file \p path should be replaced
+    bool confirmOverwrite(const std::string& path);
+
+    /// Options of the passwords
+    genopts m_options;
+    /// Length of the passwords
+    unsigned int m_length;
+    /// Grid holding the widgets
+    Gtk::Grid m_grid;
+    /// Label of the number of passwords
+    Gtk::Label m_countLabel;
+    /// Spin button for the number of passwords
+    Gtk::SpinButton m_count;
+    /// Label of the file
+    Gtk::Label m_fileLabel;
+    /// Entry holding the path of the file
+    Gtk::Entry m_file;
+    /// Path the file chooser confirmed to overwrite (empty for none)
+    std::string m_confirmedPath;
+    /// Button choosing the file
+    Gtk::Button m_chooseFile;
+    /// Progress bar of the job
+    Gtk::ProgressBar m_progressBar;
+    /// Pointer to the button starting the job
+    Gtk::Button* m_btnGenerate;
+    /// Pointer to the button cancelling the job or closing the dialog
+    Gtk::Button* m_btnClose;
+    /// Dispatcher handing the progress over to the main loop
+    Glib::Dispatcher m_progress;
+    /// The job writing the passwords; declared after \p m_progress, so it is
+    /// destroyed first
+    BulkJob m_job;
+
+}; // end of class BulkDialog
+
+#endif
@@ -0,0 +1,234 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkJob.cpp
+ * \brief   Implements a class writing many passwords to a file in the
+ *          background.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a class writing many passwords to a file in the
+ * background.
+ */
+
+#include "BulkJob.h"
+#include "BulkOutput.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <limits>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// Returns the time of a monotonic clock in milliseconds
+int64_t getMilliseconds() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // end of anonymous namespace
+
+/**
+ * Constructor of \p BulkJob.
+ *
+ * \param notify Function called on a worker thread when the progress
+ * changed, at most every \p BULK_PROGRESS_INTERVAL milliseconds and once
+ * at the end of the job
+ */
+BulkJob::BulkJob(const std::function<void()>& notify) : m_notify(notify),
+    m_state(BULK_IDLE), m_total(0), m_bytes(0), m_lineLength(1), m_cancel(false),
+    m_lastNotify(0) {
+}
+
+/**
+ * Destructor of \p BulkJob. Cancels a running job and waits for it.
+ */
+BulkJob::~BulkJob() {
+    m_cancel = true;
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+/**
+ * Starts writing \p count passwords of \p length characters generated
+ * with \p options to the file \p path, one per line. Unless
+ * \p overwrite is set, the job fails if the file exists. Otherwise the
+ * passwords are written to a new file next to it, which replaces it once
+ * all passwords are written, so a cancelled or failed job leaves an
+ * existing file as it was.
+ *
+ * \param path The path of the file
+ * \param count The number of passwords
+ * \param length The number of characters of every password
+ * \param options The options for the generation
+ * \param threads The number of threads to use (0 for the default)
+ * \param overwrite Whether an existing file may be replaced
+ * \return \p true if the job was started, \p false if a job is running
+ * or the arguments are invalid
+ */
+bool BulkJob::start(const std::string& path, uint64_t count, unsigned int length,
+    const genopts& options, unsigned int threads, bool overwrite) {
+    const uint64_t lineLength = uint64_t(length) + 1;
+    if (path.empty() || length == 0 || getAlphabet(options).empty() ||
+        count > std::numeric_limits<uint64_t>::max() / lineLength)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state == BULK_RUNNING)
+            return false;
+        m_state = BULK_RUNNING;
+        m_total = count;
+        m_lineLength = lineLength;
+        m_error.clear();
+    }
+    // the thread of the last job has finished
+    if (m_thread.joinable())
+        m_thread.join();
+    m_bytes = 0;
+    m_cancel = false;
+    m_lastNotify = getMilliseconds();
+    m_thread = std::thread(&BulkJob::run, this, path, length, options, threads,
+        overwrite);
+    return true;
+}
+
+/**
+ * Cancels the running job without waiting for it. The workers stop after
+ * their current slice and the partial file is removed; the notification
+ * function is called once that is done.
+ */
+void BulkJob::cancel() {
+    m_cancel = true;
+}
+
+/**
+ * Returns the progress of the current or last job.
+ *
+ * \return The progress
+ */
+bulkprogress BulkJob::getProgress() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bulkprogress progress;
+    progress.state = m_state;
+    progress.total = m_total;
+    progress.written = std::min(m_total, m_bytes.load() / m_lineLength);
+    return progress;
+}
+
+/**
+ * Returns the error that made the last job fail.
+ *
+ * \return The error message, empty if the job did not fail
+ */
+std::string BulkJob::getError() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+
+/**
+ * Writes the passwords of a job with \p writeFileParallel() and removes the
+ * file if that fails or is cancelled. Notifies once the job is finished.
+ * The file written is always created by the job: \p path itself, which must
+ * not exist, or with \p overwrite a temporary file next to it, which is
+ * renamed to \p path at the end.
+ *
+ * \param path The path of the file
+ * \param length The number of characters of every password
+ * \param options The options for the generation
+ * \param threads The number of threads to use (0 for the default)
+ * \param overwrite Whether an existing file may be replaced
+ */
+void BulkJob::run(std::string path, unsigned int length, genopts options,
+    unsigned int threads, bool overwrite) {
+    std::ostringstream errors;
+    bool success = false;
+    std::string written = path;
+    int fd;
+    if (overwrite) {
+        written += ".XXXXXX";
+        fd = mkstemp(&written[0]);
+    } else {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0 && errno == EEXIST && !overwrite) {
+        errors << "ERROR: Output file \"" << path << "\" already exists!";
+    } else if (fd < 0) {
+        errors << "ERROR: Failed to open output file \"" << path << "\"!";
+    } else {
+        const std::string& alphabet = getAlphabet(options);
+        const OutputFiller fill = [&](char* buffer, size_t bytes, uint64_t offset) {
+            fillPasswordLines(buffer, bytes, offset, alphabet, length);
+        };
+        // every slice is generated into a buffer that is wiped after
+        // writing, and the workers stop before the next slice once the job
+        // is cancelled
+        fileopts file;
+        file.method = FILE_PWRITE;
+        file.threads = threads;
+        file.cancel = &m_cancel;
+        file.progress = [this](size_t bytes) { addProgress(bytes); };
+        success = writeFileParallel(fd, m_total * m_lineLength, fill, errors, file);
+        if (close(fd) != 0 && success) {
+            errors << "ERROR: Failed to write output file \"" << path << "\"!";
+            success = false;
+        }
+        if (success && overwrite && rename(written.c_str(), path.c_str()) != 0) {
+            errors << "ERROR: Failed to replace output file \"" << path << "\"!";
+            success = false;
+        }
+        if (!success)
+            unlink(written.c_str());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (success) {
+            m_state = BULK_FINISHED;
+        } else if (m_cancel) {
+            m_state = BULK_CANCELLED;
+        } else {
+            m_state = BULK_FAILED;
+            m_error = errors.str();
+            m_error.erase(m_error.find_last_not_of('\n') + 1);
+        }
+    }
+    m_notify();
+}
+
+/**
+ * Adds \p bytes to the progress and calls the notification function if the
+ * last notification is at least \p BULK_PROGRESS_INTERVAL milliseconds old.
+ * Only one of the workers finishing a slice at the same time notifies.
+ *
+ * \param bytes The number of bytes written
+ */
+void BulkJob::addProgress(size_t bytes) {
+    m_bytes += bytes;
+    const int64_t now = getMilliseconds();
+    int64_t last = m_lastNotify.load();
+    if (now - last < BULK_PROGRESS_INTERVAL)
+        return;
+    if (m_lastNotify.compare_exchange_strong(last, now))
+        m_notify();
+}
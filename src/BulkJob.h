@@ -0,0 +1,186 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkJob.h
+ * \brief   Defines a class writing many passwords to a file in the
+ *          background.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a class that writes thousands or millions of passwords
+ * to a file on background threads, e.g. for the bulk generation dialog of
+ * the window. The file is written in parallel with \p writeFileParallel(),
+ * every slice generated into its own buffer, which is wiped after it was
+ * written.
+ *
+ * The progress is reported by a notification function like the one of
+ * \p AsyncGenerator. It is called at most once every
+ * \p BULK_PROGRESS_INTERVAL milliseconds, about once per frame, so millions
+ * of passwords do not flood the GTK main loop with events. A cancelled or
+ * failed job removes the partial file; it never removes or truncates a file
+ * it did not create.
+ */
+
+#ifndef GTKPASS_BULKJOB_H
+#define GTKPASS_BULKJOB_H
+
+#include "RandomGenerator.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// Minimum time between two progress notifications in milliseconds (one
+/// frame at 60 Hz)
+#define BULK_PROGRESS_INTERVAL 16
+
+/**
+ * \typedef bulkstate
+ * \brief Defines the states of a \p BulkJob.
+ */
+typedef enum bulkjobstate {
+    /// no job was started
+    BULK_IDLE,
+    /// the passwords are being written
+    BULK_RUNNING,
+    /// all passwords were written
+    BULK_FINISHED,
+    /// the job was cancelled and the file it created removed
+    BULK_CANCELLED,
+    /// writing failed and the file it created was removed
+    BULK_FAILED
+} bulkstate;
+
+/**
+ * \typedef bulkprogress
+ * \brief Defines a struct holding the progress of a \p BulkJob.
+ */
+typedef struct bulkjobprogress {
+    /// Initializes the progress of a job that was not started
+    bulkjobprogress() : state(BULK_IDLE), written(0), total(0) {}
+    /// state of the job
+    bulkstate state;
+    /// number of passwords written
+    uint64_t written;
+    /// number of passwords to write
+    uint64_t total;
+} bulkprogress;
+
+/**
+ * Writes passwords to a file on background threads. Jobs are started,
+ * cancelled and queried on one thread, usually the GTK main loop; the
+ * workers call a notification function whenever the progress should be
+ * shown, which must hand it over to that thread, e.g. with a
+ * \p Glib::Dispatcher.
+ */
+class BulkJob {
+
+public:
+    /**
+     * Constructor of \p BulkJob.
+     *
+     * \param notify Function called on a worker thread when the progress
+     * changed, at most every \p BULK_PROGRESS_INTERVAL milliseconds and once
+     * at the end of the job
+     */
+    explicit BulkJob(const std::function<void()>& notify);
+
+    /**
+     * Destructor of \p BulkJob. Cancels a running job and waits for it.
+     */
+    ~BulkJob();
+
+    /**
+     * Starts writing \p count passwords of \p length characters generated
+     * with \p options to the file \p path, one per line. Unless
+     * \p overwrite is set, the job fails if the file exists. Otherwise the
+     * passwords are written to a new file next to it, which replaces it once
+     * all passwords are written, so a cancelled or failed job leaves an
+     * existing file as it was.
+     *
+     * \param path The path of the file
+     * \param count The number of passwords
+     * \param length The number of characters of every password
+     * \param options The options for the generation
+     * \param threads The number of threads to use (0 for the default)
+     * \param overwrite Whether an existing file may be replaced
+     * \return \p true if the job was started, \p false if a job is running
+     * or the arguments are invalid
+     */
+    bool start(const std::string& path, uint64_t count, unsigned int length,
+        const genopts& options, unsigned int threads = 0, bool overwrite = false);
+
+    /**
+     * Cancels the running job without waiting for it. The workers stop after
+     * their current slice and the partial file is removed; the notification
+     * function is called once that is done.
+     */
+    void cancel();
+
+    /**
+     * Returns the progress of the current or last job.
+     *
+     * \return The progress
+     */
+    bulkprogress getProgress() const;
+
+    /**
+     * Returns the error that made the last job fail.
+     *
+     * \return The error message, empty if the job did not fail
+     */
+    std::string getError() const;
+
+private:
+    BulkJob(const BulkJob&) = delete;
+    BulkJob& operator=(const BulkJob&) = delete;
+
+    /// Writes the passwords of a job and removes the file it created if that
+    /// fails
+    void run(std::string path, unsigned int length, genopts options,
+        unsigned int threads, bool overwrite);
+    /// Adds \p bytes to the progress and notifies if the last notification
+    /// is old enough
+    void addProgress(size_t bytes);
+
+    /// function called when the progress changed
+    std::function<void()> m_notify;
+    /// protects the members below, except the atomic ones
+    mutable std::mutex m_mutex;
+    /// state of the current or last job
+    bulkstate m_state;
+    /// number of passwords of the current or last job
+    uint64_t m_total;
+    /// error that made the last job fail
+    std::string m_error;
+    /// number of bytes written by the current or last job
+    std::atomic<uint64_t> m_bytes;
+    /// number of bytes per password including the line break
+    uint64_t m_lineLength;
+    /// flag stopping the workers
+    std::atomic<bool> m_cancel;
+    /// time of the last notification in milliseconds of a monotonic clock
+    std::atomic<int64_t> m_lastNotify;
+    /// the thread running the job
+    std::thread m_thread;
+
+}; // end of class BulkJob
+
+#endif
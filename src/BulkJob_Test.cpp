@@ -0,0 +1,184 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    BulkJob_Test.cpp
+ * \brief   Tests the files \p BulkJob.h and \p BulkJob.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p BulkJob.h and \p BulkJob.cpp.
+ */
+
+#include "catch.hpp"
+#include "BulkJob.h"
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unistd.h>
+
+/// Records the notifications of a \p BulkJob like a dispatcher
+struct Notifications {
+    Notifications() : count(0) {}
+
+    /// Called by the workers; remembers the state of \p job
+    void notify(const BulkJob& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        count++;
+        last = job.getProgress();
+        arrived.notify_all();
+    }
+
+    /// Waits until the job is no longer running and returns its progress
+    bulkprogress waitForEnd() {
+        std::unique_lock<std::mutex> lock(mutex);
+        arrived.wait(lock, [&]() { return count > 0 && last.state != BULK_RUNNING; });
+        return last;
+    }
+
+    /// protects the members below
+    std::mutex mutex;
+    /// signals new notifications
+    std::condition_variable arrived;
+    /// number of notifications
+    unsigned int count;
+    /// progress at the last notification
+    bulkprogress last;
+};
+
+/// Returns a path for a temporary output file that does not exist
+static std::string getTemporaryPath() {
+    char path[] = "/tmp/gtkpass-bulk-XXXXXX";
+    const int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    unlink(path);
+    return path;
+}
+
+/// Tests the class \p BulkJob
+TEST_CASE("BulkJob", "[BulkJob]") {
+    typedef std::chrono::steady_clock clock;
+    Notifications notifications;
+    BulkJob* pointer = nullptr;
+    BulkJob job([&]() { notifications.notify(*pointer); });
+    pointer = &job;
+    genopts options;
+    const std::string path = getTemporaryPath();
+    REQUIRE(job.getProgress().state == BULK_IDLE);
+
+    SECTION("Invalid arguments") {
+        REQUIRE_FALSE(job.start("", 10, 12, options));
+        REQUIRE_FALSE(job.start(path, 10, 0, options));
+        genopts none;
+        none.bIncludeLettersLower = false;
+        none.bIncludeLettersUpper = false;
+        none.bIncludeNumbers = false;
+        REQUIRE_FALSE(job.start(path, 10, 12, none));
+        REQUIRE(job.getProgress().state == BULK_IDLE);
+    }
+
+    SECTION("Finished") {
+        const uint64_t count = 2000000;
+        const clock::time_point start = clock::now();
+        REQUIRE(job.start(path, count, 15, options, 4));
+        // a second job cannot be started while the first one is running
+        REQUIRE_FALSE(job.start(path, 1, 15, options));
+        const bulkprogress progress = notifications.waitForEnd();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            clock::now() - start).count();
+        REQUIRE(progress.state == BULK_FINISHED);
+        REQUIRE(progress.written == count);
+        REQUIRE(progress.total == count);
+        REQUIRE(job.getError().empty());
+        // notifications are throttled to one per interval plus the last one
+        INFO(notifications.count << " notifications in " << elapsed << " ms");
+        REQUIRE(notifications.count <= elapsed / BULK_PROGRESS_INTERVAL + 2);
+
+        std::ifstream file(path);
+        std::string line;
+        uint64_t lines = 0;
+        bool valid = true;
+        while (std::getline(file, line)) {
+            valid = valid && line.size() == 15 &&
+                line.find_first_not_of(getAlphabet(options)) == std::string::npos;
+            lines++;
+        }
+        REQUIRE(valid);
+        REQUIRE(lines == count);
+        unlink(path.c_str());
+
+        // the job can be started again
+        notifications.count = 0;
+        REQUIRE(job.start(path, 10, 5, options));
+        REQUIRE(notifications.waitForEnd().written == 10);
+        unlink(path.c_str());
+    }
+
+    SECTION("Cancelled") {
+        // 256 MiB, far more than written before the cancellation
+        REQUIRE(job.start(path, 1 << 24, 15, options, 2));
+        const clock::time_point start = clock::now();
+        job.cancel();
+        const bulkprogress progress = notifications.waitForEnd();
+        REQUIRE(clock::now() - start < std::chrono::seconds(1));
+        REQUIRE(progress.state == BULK_CANCELLED);
+        REQUIRE(progress.written < progress.total);
+        REQUIRE(job.getError().empty());
+        // the partial file is removed
+        REQUIRE(access(path.c_str(), F_OK) != 0);
+    }
+
+    SECTION("Failed") {
+        REQUIRE(job.start("/nonexistent/gtkpass/bulk.txt", 10, 12, options));
+        const bulkprogress progress = notifications.waitForEnd();
+        REQUIRE(progress.state == BULK_FAILED);
+        REQUIRE_FALSE(job.getError().empty());
+    }
+
+    SECTION("Existing file") {
+        std::ofstream(path) << "keep\n";
+        const auto readFile = [&]() {
+            std::ifstream file(path);
+            return std::string(std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+        };
+
+        // without overwrite the file is neither changed nor removed
+        REQUIRE(job.start(path, 10, 12, options));
+        REQUIRE(notifications.waitForEnd().state == BULK_FAILED);
+        REQUIRE(job.getError().find("already exists") != std::string::npos);
+        REQUIRE(readFile() == "keep\n");
+
+        // a cancelled replacement leaves it as it was
+        notifications.count = 0;
+        REQUIRE(job.start(path, 1 << 24, 15, options, 2, true));
+        job.cancel();
+        REQUIRE(notifications.waitForEnd().state == BULK_CANCELLED);
+        REQUIRE(readFile() == "keep\n");
+
+        // a finished replacement replaces it
+        notifications.count = 0;
+        REQUIRE(job.start(path, 10, 12, options, 0, true));
+        REQUIRE(notifications.waitForEnd().state == BULK_FINISHED);
+        REQUIRE(readFile().size() == 10 * 13);
+        unlink(path.c_str());
+    }
+}
@@ -0,0 +1,399 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkOutput.cpp
+ * \brief   Implements functions for writing large amounts of generated data
+ *          to a file descriptor.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for writing large amounts of generated data
+ * to a file descriptor.
+ */
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "BulkOutput.h"
+#include "Scheduler.h"
+#include "Statistics.h"
+#include "sodium.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+/// Reports the failure of \p call with the current \p errno to \p errors
+bool reportError(std::ostream& errors, const char* call) {
+    errors << "ERROR: " << call << " failed: " << strerror(errno) << std::endl;
+    return false;
+}
+
+/**
+ * Writes \p totalBytes bytes produced by \p fill to \p fd with large
+ * \p write() calls from a single reused buffer.
+ */
+bool writeBuffered(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors) {
+    std::string buffer(std::min<uint64_t>(totalBytes, OUTPUT_BUFFER_SIZE), '\0');
+    bool success = true;
+    for (uint64_t offset = 0; success && offset < totalBytes;) {
+        const size_t length = std::min<uint64_t>(totalBytes - offset, buffer.size());
+        fill(&buffer[0], length, offset);
+        for (size_t written = 0; written < length;) {
+            const ssize_t result = write(fd, &buffer[written], length - written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0) {
+                success = reportError(errors, "write()");
+                break;
+            }
+            written += result;
+        }
+        offset += length;
+    }
+    sodium_memzero(&buffer[0], buffer.size());
+    return success;
+}
+
+#ifdef HAVE_VMSPLICE
+
+/**
+ * Writes \p totalBytes bytes produced by \p fill to the pipe \p fd by
+ * gifting two alternating page aligned buffers of the size of the pipe with
+ * \p vmsplice(). Returns \p false without writing anything if the pipe size
+ * cannot be determined.
+ */
+bool writeSpliced(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors) {
+    // a buffer may only be refilled after the reader consumed it, which is
+    // guaranteed once the other buffer fits completely into the pipe
+    if (fcntl(fd, F_SETPIPE_SZ, OUTPUT_PIPE_SIZE) < 0 && errno != EPERM)
+        return reportError(errors, "fcntl(F_SETPIPE_SZ)");
+    const int pipeSize = fcntl(fd, F_GETPIPE_SZ);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pipeSize <= 0 || pageSize <= 0 || pipeSize % pageSize != 0)
+        return reportError(errors, "fcntl(F_GETPIPE_SZ)");
+
+    // the pages may still be referenced by the pipe after the last call, so
+    // they are unmapped rather than returned to the heap
+    const size_t bufferSize = pipeSize;
+    void* memory = mmap(nullptr, 2 * bufferSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return reportError(errors, "mmap()");
+    char* const buffers[] = {
+        static_cast<char*>(memory),
+        static_cast<char*>(memory) + bufferSize
+    };
+
+    bool success = true;
+    size_t current = 0;
+    for (uint64_t offset = 0; success && offset < totalBytes; current ^= 1) {
+        const size_t length = std::min<uint64_t>(totalBytes - offset, bufferSize);
+        fill(buffers[current], length, offset);
+        struct iovec iov = { buffers[current], length };
+        while (iov.iov_len > 0) {
+            const ssize_t result = vmsplice(fd, &iov, 1, SPLICE_F_GIFT);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0) {
+                success = reportError(errors, "vmsplice()");
+                break;
+            }
+            iov.iov_base = static_cast<char*>(iov.iov_base) + result;
+            iov.iov_len -= result;
+        }
+        offset += length;
+    }
+    munmap(memory, 2 * bufferSize);
+    return success;
+}
+
+#endif
+
+/// Returns whether writing the file with \p options was cancelled
+bool isCancelled(const fileopts& options) {
+    return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+/**
+ * Sets the size of the regular file \p fd to \p totalBytes bytes and
+ * reserves the blocks on the disk, so writing cannot run out of space.
+ * Falls back to a sparse file if the file system cannot preallocate.
+ */
+bool allocateFile(int fd, uint64_t totalBytes, std::ostream& errors) {
+    if (ftruncate(fd, 0) != 0)
+        return reportError(errors, "ftruncate()");
+    if (totalBytes == 0)
+        return true;
+#ifdef HAVE_FALLOCATE
+    if (fallocate(fd, 0, 0, totalBytes) == 0)
+        return true;
+    if (errno != EOPNOTSUPP)
+        return reportError(errors, "fallocate()");
+#endif
+    if (ftruncate(fd, totalBytes) != 0)
+        return reportError(errors, "ftruncate()");
+    return true;
+}
+
+/**
+ * Writes the slices of the file \p fd by generating them into a shared
+ * mapping of the file.
+ */
+bool writeMapped(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, const fileopts& options, size_t sliceCount) {
+    void* memory = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+        return reportError(errors, "mmap()");
+    char* const base = static_cast<char*>(memory);
+    if (options.advice != MADV_NORMAL && madvise(memory, totalBytes, options.advice) != 0)
+        reportError(errors, "madvise()");
+
+    std::atomic<bool> failed(false);
+    runParallel(sliceCount, options.threads, [&](size_t slice) {
+        if (isCancelled(options))
+            return;
+        const uint64_t offset = uint64_t(slice) * FILE_SLICE_SIZE;
+        const size_t length = std::min<uint64_t>(totalBytes - offset, FILE_SLICE_SIZE);
+        fill(base + offset, length, offset);
+        if (options.sync != FILE_SYNC_NONE &&
+            msync(base + offset, length, MS_ASYNC) != 0 && !failed.exchange(true))
+            reportError(errors, "msync()");
+        if (options.progress)
+            options.progress(length);
+    });
+
+    bool success = !failed && !isCancelled(options);
+    if (success && options.sync == FILE_SYNC_FULL && msync(memory, totalBytes, MS_SYNC) != 0)
+        success = reportError(errors, "msync()");
+    if (munmap(memory, totalBytes) != 0 && success)
+        success = reportError(errors, "munmap()");
+    return success;
+}
+
+/**
+ * Writes the slices of the file \p fd by generating every slice into a
+ * buffer and writing it with \p pwrite() at its offset.
+ */
+bool writePositioned(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, const fileopts& options, size_t sliceCount) {
+    std::atomic<bool> failed(false);
+    runParallel(sliceCount, options.threads, [&](size_t slice) {
+        if (isCancelled(options))
+            return;
+        const uint64_t offset = uint64_t(slice) * FILE_SLICE_SIZE;
+        const size_t length = std::min<uint64_t>(totalBytes - offset, FILE_SLICE_SIZE);
+        std::unique_ptr<char[]> buffer(new char[length]);
+        fill(buffer.get(), length, offset);
+        for (size_t written = 0; written < length && !failed;) {
+            const ssize_t result = pwrite(fd, buffer.get() + written,
+                length - written, offset + written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0) {
+                if (!failed.exchange(true))
+                    reportError(errors, "pwrite()");
+                break;
+            }
+            written += result;
+        }
+        sodium_memzero(buffer.get(), length);
+        if (options.progress && !failed)
+            options.progress(length);
+    });
+
+    if (failed || isCancelled(options))
+        return false;
+    if (options.sync == FILE_SYNC_FULL && fdatasync(fd) != 0)
+        return reportError(errors, "fdatasync()");
+    return true;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Returns the method \p OUTPUT_AUTO chooses for the file descriptor \p fd:
+ * \p OUTPUT_VMSPLICE for pipes if \p vmsplice() is available, otherwise
+ * \p OUTPUT_WRITE.
+ *
+ * \param fd The file descriptor to write to
+ * \return The method to use for \p fd
+ */
+outmethod getOutputMethod(int fd) {
+#ifdef HAVE_VMSPLICE
+    struct stat status;
+    if (fstat(fd, &status) == 0 && S_ISFIFO(status.st_mode))
+        return OUTPUT_VMSPLICE;
+#else
+    (void) fd;
+#endif
+    return OUTPUT_WRITE;
+}
+
+/**
+ * Writes \p totalBytes bytes produced by \p fill to the file descriptor
+ * \p fd with the method \p method.
+ *
+ * \param fd The file descriptor to write to
+ * \param totalBytes The number of bytes to write
+ * \param fill Function producing the bytes
+ * \param errors The stream to report errors to
+ * \param method The method to write with
+ * \return \p true on success, \p false if writing failed
+ */
+bool writeOutput(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, outmethod method) {
+    if (method == OUTPUT_AUTO)
+        method = getOutputMethod(fd);
+#ifdef HAVE_VMSPLICE
+    if (method == OUTPUT_VMSPLICE)
+        return writeSpliced(fd, totalBytes, fill, errors);
+#endif
+    return writeBuffered(fd, totalBytes, fill, errors);
+}
+
+/**
+ * Preallocates the regular file \p fd to \p totalBytes bytes and writes
+ * \p totalBytes bytes produced by \p fill to it on several threads in
+ * parallel, one slice of \p FILE_SLICE_SIZE bytes at a time. \p fill must
+ * be safe to call from several threads at once. If \p options.cancel is
+ * set, the slices not started yet are skipped and \p false is returned
+ * without reporting an error.
+ *
+ * \param fd The file descriptor of the file (opened for reading and writing
+ * for \p FILE_MMAP)
+ * \param totalBytes The number of bytes to write
+ * \param fill Function producing the bytes at a given offset
+ * \param errors The stream to report errors to
+ * \param options The options for writing the file
+ * \return \p true on success, \p false if writing failed
+ */
+bool writeFileParallel(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, const fileopts& options) {
+    if (!allocateFile(fd, totalBytes, errors))
+        return false;
+    if (totalBytes == 0)
+        return true;
+    const size_t sliceCount = (totalBytes + FILE_SLICE_SIZE - 1) / FILE_SLICE_SIZE;
+    if (options.method == FILE_PWRITE)
+        return writePositioned(fd, totalBytes, fill, errors, options, sliceCount);
+    return writeMapped(fd, totalBytes, fill, errors, options, sliceCount);
+}
+
+/**
+ * Looks up the file output method named \p name ("mmap" or "pwrite").
+ *
+ * \param name The name of the method
+ * \param method Receives the method
+ * \return \p true if \p name is a known method, \p false otherwise
+ */
+bool parseFileMethod(const std::string& name, filemethod& method) {
+    if (name == "mmap")
+        method = FILE_MMAP;
+    else if (name == "pwrite")
+        method = FILE_PWRITE;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Looks up the \p madvise() advice named \p name ("normal", "sequential",
+ * "random" or "willneed").
+ *
+ * \param name The name of the advice
+ * \param advice Receives the advice
+ * \return \p true if \p name is a known advice, \p false otherwise
+ */
+bool parseFileAdvice(const std::string& name, int& advice) {
+    if (name == "normal")
+        advice = MADV_NORMAL;
+    else if (name == "sequential")
+        advice = MADV_SEQUENTIAL;
+    else if (name == "random")
+        advice = MADV_RANDOM;
+    else if (name == "willneed")
+        advice = MADV_WILLNEED;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Looks up the synchronization named \p name ("none", "async" or "full").
+ *
+ * \param name The name of the synchronization
+ * \param sync Receives the synchronization
+ * \return \p true if \p name is a known synchronization, \p false otherwise
+ */
+bool parseFileSync(const std::string& name, filesync& sync) {
+    if (name == "none")
+        sync = FILE_SYNC_NONE;
+    else if (name == "async")
+        sync = FILE_SYNC_ASYNC;
+    else if (name == "full")
+        sync = FILE_SYNC_FULL;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Fills \p length bytes at \p buffer with the part starting at byte
+ * \p offset of an output consisting of random passwords of
+ * \p passwordLength characters from \p alphabet, each followed by a line
+ * break. As the position of every line break follows from \p offset, any
+ * part of the output can be generated independently.
+ *
+ * \param buffer The buffer to fill
+ * \param length The number of bytes to fill
+ * \param offset The offset of the buffer in the output
+ * \param alphabet The alphabet of the passwords (must not be empty)
+ * \param passwordLength The number of characters of every password
+ */
+void fillPasswordLines(char* buffer, size_t length, uint64_t offset,
+    const std::string& alphabet, unsigned int passwordLength) {
+    size_t column = offset % (uint64_t(passwordLength) + 1);
+    size_t lines = 0;
+    char* const end = buffer + length;
+    while (buffer < end) {
+        if (column == passwordLength) {
+            *buffer++ = '\n';
+            column = 0;
+            lines++;
+            continue;
+        }
+        const size_t run = std::min<size_t>(end - buffer, passwordLength - column);
+        fillRandomChars(buffer, run, alphabet);
+        buffer += run;
+        column += run;
+    }
+    statsRecordBatch(lines, length - lines);
+}
@@ -0,0 +1,220 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    BulkOutput.h
+ * \brief   Defines functions for writing large amounts of generated data to
+ *          a file descriptor.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for writing large amounts of generated data,
+ * e.g. millions of passwords, to a file descriptor. If the descriptor is a
+ * pipe, the data is generated into two page aligned buffers of the size of
+ * the pipe, which are alternately handed over to the pipe with
+ * \p vmsplice(SPLICE_F_GIFT) instead of being copied by \p write(). Once the
+ * second buffer fits into the pipe, the reader has consumed the first one,
+ * so it can be refilled while the reader processes the second one. Other
+ * descriptors (files and terminals) get large \p write() calls.
+ *
+ * As the size of the output is known up front, regular files can also be
+ * preallocated and written in parallel: every worker thread generates its
+ * slices of the output straight into a shared mapping of the file, or into
+ * its own buffer written with \p pwrite() at the offset of the slice. The
+ * workers need neither an intermediate buffer nor a lock for ordering.
+ */
+
+#ifndef GTKPASS_BULKOUTPUT_H
+#define GTKPASS_BULKOUTPUT_H
+
+#include "RandomGenerator.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <sys/mman.h>
+
+/// Size of the buffer of the \p write() method (1 MiB)
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+/// Pipe size requested for the \p vmsplice() method (1 MiB, the default
+/// maximum for unprivileged processes)
+#define OUTPUT_PIPE_SIZE (1024 * 1024)
+
+/**
+ * \typedef outmethod
+ * \brief Defines the methods for writing data to a file descriptor.
+ */
+typedef enum outputmethod {
+    /// \p vmsplice() for pipes, \p write() for everything else
+    OUTPUT_AUTO,
+    /// large \p write() calls from a reused buffer
+    OUTPUT_WRITE,
+    /// page aligned double buffers gifted to a pipe with \p vmsplice()
+    OUTPUT_VMSPLICE
+} outmethod;
+
+/// Size of the slices of a file written in parallel (4 MiB, a multiple of
+/// the page size)
+#define FILE_SLICE_SIZE (4 * 1024 * 1024)
+
+/**
+ * \typedef filemethod
+ * \brief Defines the methods for writing a regular file in parallel.
+ */
+typedef enum fileoutputmethod {
+    /// generate into a shared mapping of the file
+    FILE_MMAP,
+    /// generate into a buffer per slice and write it with \p pwrite()
+    FILE_PWRITE
+} filemethod;
+
+/**
+ * \typedef filesync
+ * \brief Defines when the data of a file written in parallel is flushed to
+ * the disk.
+ */
+typedef enum filesynchronization {
+    /// leave flushing to the kernel
+    FILE_SYNC_NONE,
+    /// start writing back every slice as soon as it is generated
+    FILE_SYNC_ASYNC,
+    /// additionally wait until all data is on the disk before returning
+    FILE_SYNC_FULL
+} filesync;
+
+/**
+ * \typedef fileopts
+ * \brief Defines a struct holding the options for writing a file in
+ * parallel.
+ */
+typedef struct fileoutputoptions {
+    /// Initializes the options for writing a mapping with the default
+    /// number of threads, without flushing and without cancellation
+    fileoutputoptions() : method(FILE_MMAP), threads(0),
+        advice(MADV_NORMAL), sync(FILE_SYNC_NONE), cancel(nullptr), progress() {}
+    /// method for writing the file
+    filemethod method;
+    /// number of worker threads (0 for the default)
+    unsigned int threads;
+    /// advice passed to \p madvise() for the mapping
+    int advice;
+    /// when to flush the data to the disk
+    filesync sync;
+    /// flag stopping the workers before the next slice once it is set
+    /// (\p nullptr for none)
+    const std::atomic<bool>* cancel;
+    /// function called by the workers with the number of bytes of every
+    /// slice written (empty for none)
+    std::function<void(size_t bytes)> progress;
+} fileopts;
+
+/**
+ * Function filling \p length bytes at \p buffer with the output starting at
+ * byte \p offset of the output.
+ */
+typedef std::function<void(char* buffer, size_t length, uint64_t offset)> OutputFiller;
+
+/**
+ * Returns the method \p OUTPUT_AUTO chooses for the file descriptor \p fd:
+ * \p OUTPUT_VMSPLICE for pipes if \p vmsplice() is available, otherwise
+ * \p OUTPUT_WRITE.
+ *
+ * \param fd The file descriptor to write to
+ * \return The method to use for \p fd
+ */
+outmethod getOutputMethod(int fd);
+
+/**
+ * Writes \p totalBytes bytes produced by \p fill to the file descriptor
+ * \p fd with the method \p method.
+ *
+ * \param fd The file descriptor to write to
+ * \param totalBytes The number of bytes to write
+ * \param fill Function producing the bytes
+ * \param errors The stream to report errors to
+ * \param method The method to write with
+ * \return \p true on success, \p false if writing failed
+ */
+bool writeOutput(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, outmethod method = OUTPUT_AUTO);
+
+/**
+ * Preallocates the regular file \p fd to \p totalBytes bytes and writes
+ * \p totalBytes bytes produced by \p fill to it on several threads in
+ * parallel, one slice of \p FILE_SLICE_SIZE bytes at a time. \p fill must
+ * be safe to call from several threads at once. If \p options.cancel is
+ * set, the slices not started yet are skipped and \p false is returned
+ * without reporting an error.
+ *
+ * \param fd The file descriptor of the file (opened for reading and writing
+ * for \p FILE_MMAP)
+ * \param totalBytes The number of bytes to write
+ * \param fill Function producing the bytes at a given offset
+ * \param errors The stream to report errors to
+ * \param options The options for writing the file
+ * \return \p true on success, \p false if writing failed
+ */
+bool writeFileParallel(int fd, uint64_t totalBytes, const OutputFiller& fill,
+    std::ostream& errors, const fileopts& options = fileopts());
+
+/**
+ * Looks up the file output method named \p name ("mmap" or "pwrite").
+ *
+ * \param name The name of the method
+ * \param method Receives the method
+ * \return \p true if \p name is a known method, \p false otherwise
+ */
+bool parseFileMethod(const std::string& name, filemethod& method);
+
+/**
+ * Looks up the \p madvise() advice named \p name ("normal", "sequential",
+ * "random" or "willneed").
+ *
+ * \param name The name of the advice
+ * \param advice Receives the advice
+ * \return \p true if \p name is a known advice, \p false otherwise
+ */
+bool parseFileAdvice(const std::string& name, int& advice);
+
+/**
+ * Looks up the synchronization named \p name ("none", "async" or "full").
+ *
+ * \param name The name of the synchronization
+ * \param sync Receives the synchronization
+ * \return \p true if \p name is a known synchronization, \p false otherwise
+ */
+bool parseFileSync(const std::string& name, filesync& sync);
+
+/**
+ * Fills \p length bytes at \p buffer with the part starting at byte
+ * \p offset of an output consisting of random passwords of
+ * \p passwordLength characters from \p alphabet, each followed by a line
+ * break. As the position of every line break follows from \p offset, any
+ * part of the output can be generated independently.
+ *
+ * \param buffer The buffer to fill
+ * \param length The number of bytes to fill
+ * \param offset The offset of the buffer in the output
+ * \param alphabet The alphabet of the passwords (must not be empty)
+ * \param passwordLength The number of characters of every password
+ */
+void fillPasswordLines(char* buffer, size_t length, uint64_t offset,
+    const std::string& alphabet, unsigned int passwordLength);
+
+#endif
@@ -0,0 +1,150 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    BulkOutput_Bench.cpp
+ * \brief   Benchmarks the files \p BulkOutput.h and \p BulkOutput.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p BulkOutput.h and \p BulkOutput.cpp.
+ */
+
+#include "Benchmark.h"
+#include "BulkOutput.h"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+/// Number of bytes transferred per measurement (4 GiB)
+static const uint64_t PIPE_BYTES = 4ULL << 30;
+/// Number of bytes of passwords generated per measurement (1 GiB)
+static const uint64_t PASSWORD_BYTES = 1ULL << 30;
+
+/// Sizes of the files written by the benchmark \p file_output (1, 4 and
+/// 10 GiB)
+static const uint64_t FILE_BYTES[] = { 1ULL << 30, 4ULL << 30, 10ULL << 30 };
+
+/**
+ * Writes \p totalBytes produced by \p fill into a pipe with \p method while
+ * another thread reads them, and writes the throughput to \p out.
+ */
+static void measurePipe(std::ostream& out, const char* label, outmethod method,
+    uint64_t totalBytes, const OutputFiller& fill) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        out << "pipe() failed" << std::endl;
+        return;
+    }
+    std::thread reader([&]() {
+        static char buffer[OUTPUT_PIPE_SIZE];
+        while (read(fds[0], buffer, sizeof(buffer)) > 0) {}
+        close(fds[0]);
+    });
+
+    const uint64_t start = getNanoseconds();
+    const bool success = writeOutput(fds[1], totalBytes, fill, out, method);
+    close(fds[1]);
+    reader.join();
+    const uint64_t elapsed = getNanoseconds() - start;
+
+    out << std::left << std::setw(24) << label << std::right
+        << std::setw(8) << std::fixed << std::setprecision(2)
+        << double(totalBytes) / elapsed << " GB/s"
+        << (success ? "" : " (failed)") << std::endl;
+}
+
+/// Compares write() and vmsplice() into a pipe, once with a constant
+/// buffer to measure the transfer alone and once generating 16 character
+/// passwords
+BENCHMARK_CASE(pipe_output) {
+    const OutputFiller constant = [](char* buffer, size_t length, uint64_t) {
+        memset(buffer, 'x', length);
+    };
+    genopts options;
+    const std::string& alphabet = getAlphabet(options);
+    const OutputFiller passwords = [&](char* buffer, size_t length, uint64_t offset) {
+        fillPasswordLines(buffer, length, offset, alphabet, 16);
+    };
+
+    measurePipe(out, "write, constant", OUTPUT_WRITE, PIPE_BYTES, constant);
+    measurePipe(out, "vmsplice, constant", OUTPUT_VMSPLICE, PIPE_BYTES, constant);
+    measurePipe(out, "write, passwords", OUTPUT_WRITE, PASSWORD_BYTES, passwords);
+    measurePipe(out, "vmsplice, passwords", OUTPUT_VMSPLICE, PASSWORD_BYTES, passwords);
+}
+
+/**
+ * Writes \p totalBytes produced by \p fill into the file \p path, either
+ * single-threaded with \p writeOutput() (if \p options is \p nullptr) or
+ * in parallel with \p writeFileParallel(), and writes the throughput to
+ * \p out. The time includes flushing the file to disk.
+ */
+static void measureFile(std::ostream& out, const std::string& path,
+    const char* label, const fileopts* options, uint64_t totalBytes,
+    const OutputFiller& fill) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        out << "open() failed" << std::endl;
+        return;
+    }
+
+    const uint64_t start = getNanoseconds();
+    bool success;
+    if (options == nullptr)
+        success = writeOutput(fd, totalBytes, fill, out, OUTPUT_WRITE) && fdatasync(fd) == 0;
+    else
+        success = writeFileParallel(fd, totalBytes, fill, out, *options);
+    const uint64_t elapsed = getNanoseconds() - start;
+    close(fd);
+    unlink(path.c_str());
+
+    out << std::left << std::setw(24) << label << std::right
+        << std::setw(4) << (totalBytes >> 30) << " GiB"
+        << std::setw(8) << std::fixed << std::setprecision(2)
+        << double(totalBytes) / elapsed << " GB/s"
+        << (success ? "" : " (failed)") << std::endl;
+}
+
+/// Compares single-threaded buffered writing of 16 character passwords
+/// with generating them in parallel into a preallocated file with mmap()
+/// and pwrite(). The file is created in \p $TMPDIR (default: /var/tmp), so
+/// it should be a real disk with at least 10 GiB of free space.
+BENCHMARK_CASE(file_output) {
+    genopts options;
+    const std::string& alphabet = getAlphabet(options);
+    const OutputFiller passwords = [&](char* buffer, size_t length, uint64_t offset) {
+        fillPasswordLines(buffer, length, offset, alphabet, 16);
+    };
+    const char* directory = getenv("TMPDIR");
+    const std::string path = std::string(directory != nullptr ? directory : "/var/tmp")
+        + "/gtkpass-bench.out";
+
+    fileopts mapped;
+    mapped.sync = FILE_SYNC_FULL;
+    fileopts positioned = mapped;
+    positioned.method = FILE_PWRITE;
+    for (const uint64_t size : FILE_BYTES) {
+        measureFile(out, path, "write, 1 thread", nullptr, size, passwords);
+        measureFile(out, path, "mmap, parallel", &mapped, size, passwords);
+        measureFile(out, path, "pwrite, parallel", &positioned, size, passwords);
+    }
+}
@@ -0,0 +1,254 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    BulkOutput_Test.cpp
+ * \brief   Tests the files \p BulkOutput.h and \p BulkOutput.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p BulkOutput.h and \p BulkOutput.cpp.
+ */
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "catch.hpp"
+#include "BulkOutput.h"
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+/// Returns the byte at \p offset of the test pattern
+static char patternByte(uint64_t offset) {
+    return static_cast<char>('a' + offset * 7 % 26);
+}
+
+/// Fills \p buffer with the test pattern starting at \p offset
+static void fillPattern(char* buffer, size_t length, uint64_t offset) {
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = patternByte(offset + i);
+    }
+}
+
+/// Writes \p totalBytes of the test pattern into a pipe with \p method and
+/// returns whether the reader received them correctly
+static bool throughPipe(uint64_t totalBytes, outmethod method) {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    bool received = true;
+    uint64_t receivedBytes = 0;
+    std::thread reader([&]() {
+        char buffer[4096];
+        ssize_t result;
+        while ((result = read(fds[0], buffer, sizeof(buffer))) > 0) {
+            for (ssize_t i = 0; i < result; i++) {
+                received = received && buffer[i] == patternByte(receivedBytes + i);
+            }
+            receivedBytes += result;
+        }
+        close(fds[0]);
+    });
+    std::ostringstream errors;
+    const bool written = writeOutput(fds[1], totalBytes, fillPattern, errors, method);
+    close(fds[1]);
+    reader.join();
+    return written && errors.str().empty() && received && receivedBytes == totalBytes;
+}
+
+/// Tests the function \p writeOutput of \p BulkOutput
+TEST_CASE("writeOutput", "[BulkOutput]") {
+    SECTION("Method for pipes and files") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+#ifdef HAVE_VMSPLICE
+        REQUIRE(getOutputMethod(fds[1]) == OUTPUT_VMSPLICE);
+#endif
+        close(fds[0]);
+        close(fds[1]);
+
+        FILE* file = tmpfile();
+        REQUIRE(file != nullptr);
+        REQUIRE(getOutputMethod(fileno(file)) == OUTPUT_WRITE);
+        fclose(file);
+    }
+
+    SECTION("Pipe") {
+        const uint64_t sizes[] = { 0, 1, OUTPUT_BUFFER_SIZE + 4097, 5 * OUTPUT_PIPE_SIZE };
+        for (const uint64_t size : sizes) {
+            REQUIRE(throughPipe(size, OUTPUT_WRITE));
+            REQUIRE(throughPipe(size, OUTPUT_AUTO));
+        }
+    }
+
+    SECTION("File") {
+        FILE* file = tmpfile();
+        REQUIRE(file != nullptr);
+        std::ostringstream errors;
+        const uint64_t size = 2 * OUTPUT_BUFFER_SIZE + 3;
+        REQUIRE(writeOutput(fileno(file), size, fillPattern, errors));
+        rewind(file);
+        std::string content(size + 1, '\0');
+        REQUIRE(fread(&content[0], 1, content.size(), file) == size);
+        content.resize(size);
+        std::string expected(size, '\0');
+        fillPattern(&expected[0], size, 0);
+        REQUIRE(content == expected);
+        fclose(file);
+    }
+}
+
+/// Writes \p totalBytes of the test pattern into a temporary file with
+/// \p options and returns whether the file contains them afterwards
+static bool throughFile(uint64_t totalBytes, const fileopts& options) {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    // start with a larger file to check that it is truncated
+    REQUIRE(fwrite("leftover", 1, 8, file) == 8);
+    REQUIRE(fflush(file) == 0);
+    std::ostringstream errors;
+    const bool written = writeFileParallel(fileno(file), totalBytes,
+        fillPattern, errors, options);
+    rewind(file);
+    std::string content(totalBytes + 1, '\0');
+    const size_t size = fread(&content[0], 1, content.size(), file);
+    fclose(file);
+    content.resize(size);
+    std::string expected(totalBytes, '\0');
+    fillPattern(&expected[0], totalBytes, 0);
+    return written && errors.str().empty() && content == expected;
+}
+
+/// Tests the function \p writeFileParallel of \p BulkOutput
+TEST_CASE("writeFileParallel", "[BulkOutput]") {
+    const uint64_t sizes[] = { 0, 1, FILE_SLICE_SIZE, 3 * FILE_SLICE_SIZE + 4099 };
+    const filemethod methods[] = { FILE_MMAP, FILE_PWRITE };
+    const filesync syncs[] = { FILE_SYNC_NONE, FILE_SYNC_ASYNC, FILE_SYNC_FULL };
+    for (const filemethod method : methods) {
+        for (const filesync sync : syncs) {
+            fileopts options;
+            options.method = method;
+            options.sync = sync;
+            options.threads = 3;
+            options.advice = MADV_SEQUENTIAL;
+            for (const uint64_t size : sizes) {
+                REQUIRE(throughFile(size, options));
+            }
+        }
+    }
+
+    SECTION("Not a regular file") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        std::ostringstream errors;
+        REQUIRE_FALSE(writeFileParallel(fds[1], 10, fillPattern, errors));
+        REQUIRE_FALSE(errors.str().empty());
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+/// Tests the progress reports and the cancellation of \p writeFileParallel
+/// of \p BulkOutput
+TEST_CASE("writeFileParallel progress", "[BulkOutput]") {
+    const uint64_t totalBytes = 5 * FILE_SLICE_SIZE + 17;
+    for (const filemethod method : { FILE_MMAP, FILE_PWRITE }) {
+        fileopts options;
+        options.method = method;
+        options.threads = 3;
+        std::atomic<bool> cancel(false);
+        options.cancel = &cancel;
+        std::atomic<uint64_t> written(0);
+        std::atomic<size_t> slices(0);
+        options.progress = [&](size_t bytes) { written += bytes; slices++; };
+        REQUIRE(throughFile(totalBytes, options));
+        REQUIRE(written == totalBytes);
+        REQUIRE(slices == 6);
+
+        // cancels after the second slice
+        written = 0;
+        slices = 0;
+        options.progress = [&](size_t bytes) {
+            written += bytes;
+            if (++slices == 2)
+                cancel = true;
+        };
+        FILE* file = tmpfile();
+        REQUIRE(file != nullptr);
+        std::ostringstream errors;
+        REQUIRE_FALSE(writeFileParallel(fileno(file), totalBytes, fillPattern,
+            errors, options));
+        fclose(file);
+        REQUIRE(errors.str().empty());
+        // the slices started before the cancellation are finished
+        REQUIRE(slices >= 2);
+        REQUIRE(slices <= 2 + options.threads);
+    }
+}
+
+/// Tests the functions \p parseFileMethod, \p parseFileAdvice and
+/// \p parseFileSync of \p BulkOutput
+TEST_CASE("parseFileOptions", "[BulkOutput]") {
+    filemethod method = FILE_MMAP;
+    REQUIRE(parseFileMethod("pwrite", method));
+    REQUIRE(method == FILE_PWRITE);
+    REQUIRE(parseFileMethod("mmap", method));
+    REQUIRE(method == FILE_MMAP);
+    REQUIRE_FALSE(parseFileMethod("write", method));
+
+    int advice = MADV_NORMAL;
+    REQUIRE(parseFileAdvice("sequential", advice));
+    REQUIRE(advice == MADV_SEQUENTIAL);
+    REQUIRE(parseFileAdvice("willneed", advice));
+    REQUIRE(advice == MADV_WILLNEED);
+    REQUIRE_FALSE(parseFileAdvice("dontneed", advice));
+
+    filesync sync = FILE_SYNC_NONE;
+    REQUIRE(parseFileSync("full", sync));
+    REQUIRE(sync == FILE_SYNC_FULL);
+    REQUIRE(parseFileSync("async", sync));
+    REQUIRE(sync == FILE_SYNC_ASYNC);
+    REQUIRE_FALSE(parseFileSync("", sync));
+}
+
+/// Tests the function \p fillPasswordLines of \p BulkOutput
+TEST_CASE("fillPasswordLines", "[BulkOutput]") {
+    const std::string alphabet = "ab";
+    const unsigned int length = 5;
+    const size_t total = 10 * (length + 1);
+
+    // generating the output in pieces of any size at any offset puts the
+    // line breaks at the same positions as generating it at once
+    const size_t pieces[] = { 1, 4, 6, 7, total };
+    for (const size_t piece : pieces) {
+        std::string output(total, '\0');
+        for (size_t offset = 0; offset < total; offset += piece) {
+            const size_t bytes = std::min(piece, total - offset);
+            fillPasswordLines(&output[offset], bytes, offset, alphabet, length);
+        }
+        for (size_t i = 0; i < total; i++) {
+            if (i % (length + 1) == length)
+                REQUIRE(output[i] == '\n');
+            else
+                REQUIRE(alphabet.find(output[i]) != std::string::npos);
+        }
+    }
+}
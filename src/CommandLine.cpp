@@ -0,0 +1,492 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    CommandLine.cpp
+ * \brief   Implements the non-interactive modes of \p GtkPass.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements the non-interactive modes of \p GtkPass.
+ */
+
+#include "CommandLine.h"
+#include "Audit.h"
+#include "BreachIndex.h"
+#include "BulkOutput.h"
+#include "Export.h"
+#include "Policy.h"
+#include "Provisioning.h"
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Opens the file \p path for reading into \p file, or returns standard input
+ * if \p path is "-".
+ *
+ * \param path The path of the file
+ * \param description Description of the file for error messages
+ * \param file The stream to open the file with
+ * \return The stream to read from, or \p nullptr if the file cannot be opened
+ */
+static std::istream* openInput(const std::string& path, const char* description,
+    std::ifstream& file) {
+    if (path == "-")
+        return &std::cin;
+    file.open(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR: Failed to open " << description << " \"" << path
+            << "\"!" << std::endl;
+        return nullptr;
+    }
+    return &file;
+}
+
+/**
+ * Opens the file \p path for writing into \p file, or returns standard
+ * output if \p path is empty or "-".
+ *
+ * \param path The path of the file
+ * \param file The stream to open the file with
+ * \return The stream to write to, or \p nullptr if the file cannot be opened
+ */
+static std::ostream* openOutput(const std::string& path, std::ofstream& file) {
+    if (path.empty() || path == "-")
+        return &std::cout;
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "ERROR: Failed to open output file \"" << path << "\"!"
+            << std::endl;
+        return nullptr;
+    }
+    return &file;
+}
+
+/**
+ * Reads an export key from the file \p path into \p key.
+ *
+ * \param path The path of the key file
+ * \param key Receives the key (\p EXPORT_KEY_BYTES bytes)
+ * \return \p true on success, \p false if the file is no valid key file
+ */
+static bool readKeyFile(const std::string& path, unsigned char* key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(key), EXPORT_KEY_BYTES) ||
+        file.peek() != std::ifstream::traits_type::eof()) {
+        std::cerr << "ERROR: \"" << path << "\" is no valid key file!" << std::endl;
+        sodium_memzero(key, EXPORT_KEY_BYTES);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Maps the blocklist \p path into \p blocklist unless \p path is empty.
+ *
+ * \param path The path of the blocklist file
+ * \param blocklist Receives the blocklist
+ * \return \p true on success, \p false if the file is no valid blocklist
+ */
+static bool loadBlocklist(const std::string& path,
+    std::unique_ptr<Blocklist>& blocklist) {
+    if (path.empty())
+        return true;
+    try {
+        blocklist.reset(new Blocklist(path));
+    } catch (const std::runtime_error& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Builds a blocklist of the banned strings in \p options.buildBlocklist and
+ * writes it to \p options.output.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runBuildBlocklist(const cmdopts& options) {
+    std::ifstream wordsFile;
+    std::istream* words = openInput(options.buildBlocklist, "word list", wordsFile);
+    if (!words)
+        return 1;
+    std::ofstream outputFile;
+    std::ostream* output = openOutput(options.output, outputFile);
+    if (!output)
+        return 1;
+    return buildBlocklist(*words, *output, std::cerr) ? 0 : 1;
+}
+
+/**
+ * Creates a new export key and writes it to the new file
+ * \p options.generateKey, readable by the owner only.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runGenerateKey(const cmdopts& options) {
+    const int fd = open(options.generateKey.c_str(),
+        O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        std::cerr << "ERROR: Failed to create key file \"" << options.generateKey
+            << "\" (it must not exist yet)!" << std::endl;
+        return 1;
+    }
+    unsigned char key[EXPORT_KEY_BYTES];
+    generateExportKey(key);
+    const bool written = write(fd, key, sizeof(key)) == ssize_t(sizeof(key));
+    sodium_memzero(key, sizeof(key));
+    if (close(fd) != 0 || !written) {
+        std::cerr << "ERROR: Failed to write key file \"" << options.generateKey
+            << "\"!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Decrypts the export \p options.decrypt and writes the plaintext to
+ * \p options.output, or only verifies the export \p options.verify.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runDecrypt(const cmdopts& options) {
+    const bool verifyOnly = options.decrypt.empty();
+    const std::string& path = verifyOnly ? options.verify : options.decrypt;
+    if (options.keyFile.empty()) {
+        std::cerr << "ERROR: No key file given (--key)!" << std::endl;
+        return 1;
+    }
+
+    std::ifstream inputFile;
+    std::istream* input = openInput(path, "export", inputFile);
+    if (!input)
+        return 1;
+    std::ofstream outputFile;
+    std::ostream* output = nullptr;
+    if (!verifyOnly) {
+        output = openOutput(options.output, outputFile);
+        if (!output)
+            return 1;
+    }
+
+    unsigned char key[EXPORT_KEY_BYTES];
+    if (!readKeyFile(options.keyFile, key))
+        return 1;
+    const bool success = decryptExport(*input, output, key, std::cerr);
+    sodium_memzero(key, sizeof(key));
+    return success ? 0 : 1;
+}
+
+/**
+ * Provisions passwords for the manifest \p options.manifest and writes them
+ * to \p options.output, encrypted if \p options.keyFile is given.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runManifest(const cmdopts& options) {
+    std::ifstream manifestFile;
+    std::istream* manifest = openInput(options.manifest, "manifest", manifestFile);
+    if (!manifest)
+        return 1;
+    std::ofstream outputFile;
+    std::ostream* output = openOutput(options.output, outputFile);
+    if (!output)
+        return 1;
+
+    provopts provisioning = options.provisioning;
+    provisioning.hashing.threads = options.threads;
+    std::unique_ptr<Blocklist> blocklist;
+    if (!loadBlocklist(options.blocklist, blocklist))
+        return 1;
+    provisioning.blocklist = blocklist.get();
+    if (provisioning.hash && !checkHashOptions(provisioning.hashing)) {
+        std::cerr << "ERROR: Invalid limits for hashing (ops "
+            << crypto_pwhash_OPSLIMIT_MIN << " to " << crypto_pwhash_OPSLIMIT_MAX
+            << ", memory " << crypto_pwhash_MEMLIMIT_MIN << " to "
+            << crypto_pwhash_MEMLIMIT_MAX << " bytes)!" << std::endl;
+        return 1;
+    }
+
+    pipelinereport report;
+    bool success;
+    if (options.keyFile.empty()) {
+        success = runProvisioning(*manifest, *output, std::cerr, report,
+            provisioning);
+    } else {
+        unsigned char key[EXPORT_KEY_BYTES];
+        if (!readKeyFile(options.keyFile, key))
+            return 1;
+        ExportStreamBuf buffer(*output, key, options.threads);
+        sodium_memzero(key, sizeof(key));
+        std::ostream encrypted(&buffer);
+        success = runProvisioning(*manifest, encrypted, std::cerr, report,
+            provisioning);
+        success = buffer.finish() && success;
+    }
+    printPipelineReport(std::cerr, report);
+    return success ? 0 : 1;
+}
+
+/**
+ * Generates \p options.count passwords of the policy \p options.policy and
+ * the length \p options.length, one per line, and writes them to
+ * \p options.output. Pipes are fed with \p vmsplice().
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runCount(const cmdopts& options) {
+    genopts generation;
+    const std::string policy = options.policy.empty() ? "default" : options.policy;
+    if (!parsePolicy(policy, generation)) {
+        std::cerr << "ERROR: Unknown policy \"" << policy << "\"!" << std::endl;
+        return 1;
+    }
+    if (options.length == 0) {
+        std::cerr << "ERROR: Invalid password length " << options.length
+            << "!" << std::endl;
+        return 1;
+    }
+    const uint64_t lineLength = uint64_t(options.length) + 1;
+    if (options.count > std::numeric_limits<uint64_t>::max() / lineLength) {
+        std::cerr << "ERROR: Invalid count " << options.count << ", the output of "
+            << options.length << " characters per password exceeds 2^64 bytes!" << std::endl;
+        return 1;
+    }
+    // lines of non-unique batches are split across buffers, so only complete
+    // passwords of unique batches can be checked
+    if (!options.blocklist.empty() && !options.unique) {
+        std::cerr << "ERROR: --blocklist requires --manifest or --unique!" << std::endl;
+        return 1;
+    }
+    std::unique_ptr<Blocklist> blocklist;
+    if (!loadBlocklist(options.blocklist, blocklist))
+        return 1;
+
+    int fd = STDOUT_FILENO;
+    const bool toStdout = options.output.empty() || options.output == "-";
+    if (!toStdout) {
+        fd = open(options.output.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+            S_IRUSR | S_IWUSR);
+        if (fd < 0) {
+            std::cerr << "ERROR: Failed to open output file \"" << options.output
+                << "\"!" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::string& alphabet = getAlphabet(generation);
+    const unsigned int length = options.length;
+    const OutputFiller fill = [&](char* buffer, size_t bytes, uint64_t offset) {
+        fillPasswordLines(buffer, bytes, offset, alphabet, length);
+    };
+    // unique passwords are written once all duplicates are replaced, other
+    // passwords are filled into regular files by all threads in parallel and
+    // written sequentially to everything else
+    struct stat status;
+    bool success;
+    if (options.unique) {
+        uniqueopts uniqueness = options.uniqueness;
+        uniqueness.threads = options.threads;
+        uniqueness.blocklist = blocklist.get();
+        uniquerep report;
+        success = writeUniquePasswords(fd, options.count, alphabet, length,
+            std::cerr, report, uniqueness);
+        if (success)
+            printUniqueReport(std::cerr, report);
+    } else if (!toStdout && fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+        fileopts file = options.file;
+        file.threads = options.threads;
+        success = writeFileParallel(fd, options.count * lineLength, fill,
+            std::cerr, file);
+    } else {
+        success = writeOutput(fd, options.count * lineLength, fill, std::cerr);
+    }
+    if (!toStdout && close(fd) != 0) {
+        std::cerr << "ERROR: Failed to write output file \"" << options.output
+            << "\"!" << std::endl;
+        success = false;
+    }
+    return success ? 0 : 1;
+}
+
+/**
+ * Builds a breach index of the sorted hashes in \p options.buildBreachIndex
+ * and writes it to the file \p options.output.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runBuildBreachIndex(const cmdopts& options) {
+    if (options.output.empty() || options.output == "-") {
+        std::cerr << "ERROR: --build-breach-index requires --output!" << std::endl;
+        return 1;
+    }
+    std::ifstream corpusFile;
+    std::istream* corpus = openInput(options.buildBreachIndex, "breach corpus", corpusFile);
+    if (!corpus)
+        return 1;
+    std::ofstream outputFile;
+    if (!openOutput(options.output, outputFile))
+        return 1;
+    return buildBreachIndex(*corpus, outputFile, std::cerr) ? 0 : 1;
+}
+
+/**
+ * Checks the passwords in \p options.checkBreached, one per line, against
+ * the breach index \p options.breachIndex in batches of
+ * \p BREACH_CHECK_BATCH_SIZE and writes the breached ones to
+ * \p options.output.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runCheckBreached(const cmdopts& options) {
+    if (options.breachIndex.empty()) {
+        std::cerr << "ERROR: --check-breached requires --breach-index!" << std::endl;
+        return 1;
+    }
+    std::unique_ptr<BreachIndex> index;
+    try {
+        index.reset(new BreachIndex(options.breachIndex));
+    } catch (const std::runtime_error& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    std::ifstream passwordsFile;
+    std::istream* input = openInput(options.checkBreached, "password list", passwordsFile);
+    if (!input)
+        return 1;
+    std::ofstream outputFile;
+    std::ostream* output = openOutput(options.output, outputFile);
+    if (!output)
+        return 1;
+
+    std::vector<std::string> passwords;
+    std::vector<bool> breached;
+    uint64_t checked = 0;
+    uint64_t found = 0;
+    std::string line;
+    while (*input) {
+        passwords.clear();
+        while (passwords.size() < BREACH_CHECK_BATCH_SIZE && std::getline(*input, line)) {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            passwords.push_back(line);
+        }
+        found += index->containsBatch(passwords, breached);
+        checked += passwords.size();
+        for (size_t i = 0; i < passwords.size(); i++) {
+            if (breached[i])
+                *output << passwords[i] << "\n";
+        }
+    }
+    output->flush();
+    if (input->bad() || !*output) {
+        std::cerr << "ERROR: Failed to check the passwords!" << std::endl;
+        return 1;
+    }
+    std::cerr << found << " of " << checked << " passwords found in the breach index"
+        << std::endl;
+    return 0;
+}
+
+/**
+ * Audits the passwords in \p options.audit, one per line, and writes the
+ * report to \p options.output. With \p options.policy the passwords are
+ * also checked against the policy and \p options.length as minimum length.
+ *
+ * \param options The command line options
+ * \return Exit status of the program
+ */
+static int runAudit(const cmdopts& options) {
+    auditopts audit;
+    audit.threads = options.threads;
+    if (!options.policy.empty()) {
+        if (!parsePolicy(options.policy, audit.policy)) {
+            std::cerr << "ERROR: Unknown policy \"" << options.policy << "\"!" << std::endl;
+            return 1;
+        }
+        audit.checkPolicy = true;
+        audit.minLength = options.length;
+    }
+    int fd = STDIN_FILENO;
+    if (options.audit != "-") {
+        fd = open(options.audit.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "ERROR: Failed to open password list \"" << options.audit
+                << "\"!" << std::endl;
+            return 1;
+        }
+    }
+    auditrep report;
+    const bool success = auditFile(fd, std::cerr, report, audit);
+    if (fd != STDIN_FILENO)
+        close(fd);
+    if (!success)
+        return 1;
+    std::ofstream outputFile;
+    std::ostream* output = openOutput(options.output, outputFile);
+    if (!output)
+        return 1;
+    printAuditReport(*output, report, audit);
+    output->flush();
+    if (!*output) {
+        std::cerr << "ERROR: Failed to write the audit report!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Runs the non-interactive mode selected by \p options. Results are written
+ * to the output file, reports and errors to standard error.
+ *
+ * \param options The command line options
+ * \return -1 if no non-interactive mode was selected and the GUI should be
+ * started, otherwise the exit status of the program
+ */
+int runCommandLine(const cmdopts& options) {
+    if (!options.generateKey.empty())
+        return runGenerateKey(options);
+    if (!options.buildBlocklist.empty())
+        return runBuildBlocklist(options);
+    if (!options.buildBreachIndex.empty())
+        return runBuildBreachIndex(options);
+    if (!options.checkBreached.empty())
+        return runCheckBreached(options);
+    if (!options.audit.empty())
+        return runAudit(options);
+    if (!options.decrypt.empty() || !options.verify.empty())
+        return runDecrypt(options);
+    if (!options.manifest.empty())
+        return runManifest(options);
+    if (options.count > 0)
+        return runCount(options);
+    return -1;
+}
@@ -0,0 +1,106 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    CommandLine.h
+ * \brief   Defines the non-interactive modes of \p GtkPass.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines the non-interactive modes of \p GtkPass that run from the
+ * command line without showing a window.
+ */
+
+#ifndef GTKPASS_COMMANDLINE_H
+#define GTKPASS_COMMANDLINE_H
+
+#include "BulkOutput.h"
+#include "Provisioning.h"
+#include "Uniqueness.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * \typedef cmdopts
+ * \brief Defines a struct holding the command line options of the
+ * non-interactive modes.
+ */
+typedef struct cmdoptions {
+    /// Initializes the struct for starting the GUI
+    cmdoptions() : threads(0), count(0), length(12), unique(false) {}
+    /// path of the manifest to provision passwords for (empty if none, "-"
+    /// for standard input)
+    std::string manifest;
+    /// path of the output file (empty or "-" for standard output)
+    std::string output;
+    /// options for provisioning passwords (except the threads)
+    provopts provisioning;
+    /// path of the key file for encrypting the output or decrypting an
+    /// export (empty for plaintext output)
+    std::string keyFile;
+    /// path of the export to decrypt (empty if none, "-" for standard input)
+    std::string decrypt;
+    /// path of the export to verify (empty if none, "-" for standard input)
+    std::string verify;
+    /// path of the key file to create (empty if none)
+    std::string generateKey;
+    /// maximum number of threads for hashing, encryption and writing files
+    /// (0 for the number of hardware threads)
+    unsigned int threads;
+    /// number of passwords to generate without manifest (0 if none)
+    uint64_t count;
+    /// policy of the passwords generated without manifest (empty for the
+    /// default policy)
+    std::string policy;
+    /// length of the passwords generated without manifest
+    unsigned int length;
+    /// options for writing the passwords generated without manifest to a
+    /// regular file (except the threads)
+    fileopts file;
+    /// whether every password generated without manifest must be unique
+    bool unique;
+    /// options for generating unique passwords (except the threads)
+    uniqueopts uniqueness;
+    /// path of the blocklist of passwords to generate again (empty if none)
+    std::string blocklist;
+    /// path of the list of banned strings to build a blocklist from (empty
+    /// if none, "-" for standard input)
+    std::string buildBlocklist;
+    /// path of the index of breached passwords (empty if none)
+    std::string breachIndex;
+    /// path of the sorted corpus of breached password hashes to build a breach
+    /// index from (empty if none, "-" for standard input)
+    std::string buildBreachIndex;
+    /// path of the list of passwords to check against the breach index (empty
+    /// if none, "-" for standard input)
+    std::string checkBreached;
+    /// path of the list of passwords to audit against the character classes
+    /// (empty if none, "-" for standard input)
+    std::string audit;
+} cmdopts;
+
+/**
+ * Runs the non-interactive mode selected by \p options. Results are written
+ * to the output file, reports and errors to standard error.
+ *
+ * \param options The command line options
+ * \return -1 if no non-interactive mode was selected and the GUI should be
+ * started, otherwise the exit status of the program
+ */
+int runCommandLine(const cmdopts& options);
+
+#endif
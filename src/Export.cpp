@@ -0,0 +1,526 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Export.cpp
+ * \brief   Implements functions and classes for encrypted exports of
+ *          generated passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions and classes for writing and reading
+ * encrypted exports.
+ */
+
+#include "Export.h"
+#include "Scheduler.h"
+#include "SpscQueue.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Magic bytes at the beginning of an export
+const char EXPORT_MAGIC[] = "GTKPASSX";
+/// Magic bytes at the end of an export
+const char INDEX_MAGIC[] = "GPXINDEX";
+/// Number of magic bytes
+const size_t MAGIC_BYTES = 8;
+/// Version of the container format
+const uint32_t EXPORT_VERSION = 1;
+/// Largest chunk size accepted when decrypting (64 MiB)
+const uint32_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+/// Number of bytes of the associated data of a chunk
+const size_t AD_BYTES = MAGIC_BYTES + 8;
+
+/// Number of bytes a chunk grows by encryption
+const size_t CHUNK_OVERHEAD = crypto_secretstream_xchacha20poly1305_ABYTES;
+/// Number of bytes of the header of a stream
+const size_t STREAM_HEADER_BYTES = crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+/// Tag of all chunks but the last one of a stream
+const unsigned char TAG_MESSAGE = crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+/// Tag of the last chunk of a stream
+const unsigned char TAG_FINAL = crypto_secretstream_xchacha20poly1305_TAG_FINAL;
+
+typedef crypto_secretstream_xchacha20poly1305_state StreamState;
+
+/// A chunk of an export, either plaintext or ciphertext
+struct Chunk {
+    Chunk() : tag(TAG_MESSAGE), valid(true) {}
+    /// the bytes of the chunk
+    std::vector<unsigned char> data;
+    /// the secretstream tag of the chunk
+    unsigned char tag;
+    /// whether the chunk was decrypted successfully
+    bool valid;
+};
+
+typedef std::unique_ptr<Chunk> ChunkPtr;
+typedef SpscQueue<ChunkPtr> ChunkQueue;
+
+/// Writes \p value to \p out as 4 bytes in little endian byte order
+void writeUint32(std::ostream& out, uint32_t value) {
+    unsigned char bytes[4];
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+/// Writes \p value to \p out as 8 bytes in little endian byte order
+void writeUint64(std::ostream& out, uint64_t value) {
+    writeUint32(out, static_cast<uint32_t>(value));
+    writeUint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+/// Reads 4 bytes in little endian byte order from \p in into \p value
+bool readUint32(std::istream& in, uint32_t& value) {
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        return false;
+    value = 0;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+/// Reads 8 bytes in little endian byte order from \p in into \p value
+bool readUint64(std::istream& in, uint64_t& value) {
+    uint32_t low, high;
+    if (!readUint32(in, low) || !readUint32(in, high))
+        return false;
+    value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+}
+
+/// Reads \p MAGIC_BYTES bytes from \p in and compares them with \p magic
+bool readMagic(std::istream& in, const char* magic) {
+    char bytes[MAGIC_BYTES];
+    return in.read(bytes, MAGIC_BYTES) && memcmp(bytes, magic, MAGIC_BYTES) == 0;
+}
+
+/// Writes the associated data of the chunks of stream \p stream of
+/// \p streams streams to \p ad
+void makeAssociatedData(unsigned char ad[AD_BYTES], uint32_t stream,
+    uint32_t streams) {
+    memcpy(ad, EXPORT_MAGIC, MAGIC_BYTES);
+    for (size_t i = 0; i < 4; i++) {
+        ad[MAGIC_BYTES + i] = static_cast<unsigned char>(stream >> (8 * i));
+        ad[MAGIC_BYTES + 4 + i] = static_cast<unsigned char>(streams >> (8 * i));
+    }
+}
+
+/**
+ * Worker threads processing the chunks of an export. Chunk \p i is processed
+ * by worker \p i modulo the number of workers, and a collector thread hands
+ * the processed chunks to a sink in their original order.
+ */
+class ChunkWorkers {
+
+public:
+    /// Function processing a chunk on the worker with the given index
+    typedef std::function<void(unsigned int, Chunk&)> Process;
+    /// Function consuming a processed chunk on the collector thread
+    typedef std::function<void(Chunk&)> Sink;
+
+    /**
+     * Starts \p count workers running \p process and the collector thread
+     * running \p sink.
+     */
+    ChunkWorkers(unsigned int count, const Process& process, const Sink& sink)
+        : m_next(0), m_finished(false) {
+        for (unsigned int w = 0; w < count; w++) {
+            m_inputs.emplace_back(new ChunkQueue(EXPORT_QUEUE_CHUNKS));
+            m_outputs.emplace_back(new ChunkQueue(EXPORT_QUEUE_CHUNKS));
+        }
+        for (unsigned int w = 0; w < count; w++) {
+            m_threads.emplace_back([this, w, process]() {
+                ChunkPtr chunk;
+                while (m_inputs[w]->pop(chunk)) {
+                    process(w, *chunk);
+                    m_outputs[w]->push(std::move(chunk));
+                }
+                m_outputs[w]->close();
+            });
+        }
+        m_threads.emplace_back([this, sink]() {
+            ChunkPtr chunk;
+            for (size_t w = 0; m_outputs[w]->pop(chunk); w = (w + 1) % m_outputs.size()) {
+                sink(*chunk);
+            }
+        });
+    }
+
+    /// Waits for all chunks to be processed
+    ~ChunkWorkers() {
+        finish();
+    }
+
+    /// Hands \p chunk over to the next worker. Waits while its queue is full.
+    void submit(ChunkPtr chunk) {
+        m_inputs[m_next]->push(std::move(chunk));
+        m_next = (m_next + 1) % m_inputs.size();
+    }
+
+    /// Waits until all submitted chunks are processed and consumed
+    void finish() {
+        if (m_finished)
+            return;
+        m_finished = true;
+        for (auto& input : m_inputs) {
+            input->close();
+        }
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+private:
+    ChunkWorkers(const ChunkWorkers&) = delete;
+    ChunkWorkers& operator=(const ChunkWorkers&) = delete;
+
+    /// Queues of chunks to process, one per worker
+    std::vector<std::unique_ptr<ChunkQueue>> m_inputs;
+    /// Queues of processed chunks, one per worker
+    std::vector<std::unique_ptr<ChunkQueue>> m_outputs;
+    /// The worker threads followed by the collector thread
+    std::vector<std::thread> m_threads;
+    /// Index of the worker receiving the next chunk
+    size_t m_next;
+    /// Whether \p finish() was called
+    bool m_finished;
+
+}; // end of class ChunkWorkers
+
+/// Creates a new chunk with room for \p EXPORT_CHUNK_SIZE bytes
+ChunkPtr newChunk() {
+    ChunkPtr chunk(new Chunk());
+    chunk->data.resize(EXPORT_CHUNK_SIZE);
+    return chunk;
+}
+
+} // end of anonymous namespace
+
+/// State of an \p ExportStreamBuf
+struct ExportStreamBuf::State {
+    State(std::ostream& out) : output(out), offset(0), finished(false) {}
+    /// the stream to write the export to
+    std::ostream& output;
+    /// the secretstream states, one per worker
+    std::vector<StreamState> streams;
+    /// the workers encrypting the chunks
+    std::unique_ptr<ChunkWorkers> workers;
+    /// the chunk currently being filled
+    ChunkPtr current;
+    /// offsets of all records written so far
+    std::vector<uint64_t> offsets;
+    /// offset of the next record
+    uint64_t offset;
+    /// whether the export was finished
+    bool finished;
+};
+
+/**
+ * Constructor of \p ExportStreamBuf. Writes the header of the export to
+ * \p output and starts the worker threads.
+ *
+ * \param output The stream to write the export to
+ * \param key The key to encrypt with (\p EXPORT_KEY_BYTES bytes)
+ * \param workers The number of worker threads and streams (0 for the
+ * default, at most \p EXPORT_MAX_STREAMS)
+ */
+ExportStreamBuf::ExportStreamBuf(std::ostream& output, const unsigned char* key,
+    unsigned int workers) : m_state(new State(output)) {
+    if (workers == 0)
+        workers = getDefaultThreadCount();
+    if (workers > EXPORT_MAX_STREAMS)
+        workers = EXPORT_MAX_STREAMS;
+
+    State& state = *m_state;
+    output.write(EXPORT_MAGIC, MAGIC_BYTES);
+    writeUint32(output, EXPORT_VERSION);
+    writeUint32(output, EXPORT_CHUNK_SIZE);
+    writeUint32(output, workers);
+    state.streams.resize(workers);
+    for (auto& stream : state.streams) {
+        unsigned char header[STREAM_HEADER_BYTES];
+        crypto_secretstream_xchacha20poly1305_init_push(&stream, header, key);
+        output.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    state.offset = MAGIC_BYTES + 3 * 4 + workers * STREAM_HEADER_BYTES;
+
+    state.workers.reset(new ChunkWorkers(workers,
+        [&state](unsigned int w, Chunk& chunk) {
+            unsigned char ad[AD_BYTES];
+            makeAssociatedData(ad, w, state.streams.size());
+            std::vector<unsigned char> cipher(chunk.data.size() + CHUNK_OVERHEAD);
+            crypto_secretstream_xchacha20poly1305_push(&state.streams[w],
+                cipher.data(), nullptr, chunk.data.data(), chunk.data.size(),
+                ad, sizeof(ad), chunk.tag);
+            sodium_memzero(chunk.data.data(), chunk.data.size());
+            chunk.data.swap(cipher);
+        },
+        [&state](Chunk& chunk) {
+            writeUint32(state.output, chunk.data.size());
+            state.output.write(reinterpret_cast<const char*>(chunk.data.data()),
+                chunk.data.size());
+            state.offsets.push_back(state.offset);
+            state.offset += 4 + chunk.data.size();
+        }
+    ));
+
+    state.current = newChunk();
+    char* buffer = reinterpret_cast<char*>(state.current->data.data());
+    setp(buffer, buffer + EXPORT_CHUNK_SIZE);
+}
+
+/**
+ * Destructor of \p ExportStreamBuf. Finishes the export if \p finish()
+ * was not called.
+ */
+ExportStreamBuf::~ExportStreamBuf() {
+    finish();
+}
+
+/**
+ * Encrypts the remaining data, ends all streams and writes the index and
+ * the trailer. Nothing must be written afterwards.
+ *
+ * \return \p true if the export was written successfully
+ */
+bool ExportStreamBuf::finish() {
+    State& state = *m_state;
+    if (!state.finished) {
+        state.finished = true;
+        if (pptr() > pbase())
+            submitChunk();
+        setp(nullptr, nullptr);
+
+        // every stream ends with an empty final chunk, so truncation is
+        // detected no matter how many chunks a stream has
+        for (size_t i = 0; i < state.streams.size(); i++) {
+            ChunkPtr chunk(new Chunk());
+            chunk->tag = TAG_FINAL;
+            state.workers->submit(std::move(chunk));
+        }
+        state.workers->finish();
+        sodium_memzero(state.streams.data(), state.streams.size() * sizeof(StreamState));
+
+        writeUint32(state.output, 0);
+        writeUint64(state.output, state.offsets.size());
+        for (const uint64_t offset : state.offsets) {
+            writeUint64(state.output, offset);
+        }
+        writeUint64(state.output, state.offset + 4);
+        state.output.write(INDEX_MAGIC, MAGIC_BYTES);
+        state.output.flush();
+    }
+    return static_cast<bool>(state.output);
+}
+
+/**
+ * Called when the current chunk is full. Hands it over to its worker and
+ * stores \p ch in a new chunk.
+ *
+ * \param ch The character that did not fit into the chunk
+ * \return \p ch, or \p traits_type::eof() if the export is finished
+ */
+ExportStreamBuf::int_type ExportStreamBuf::overflow(int_type ch) {
+    if (m_state->finished)
+        return traits_type::eof();
+    submitChunk();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+/**
+ * Hands the current chunk over to its worker and starts a new one.
+ */
+void ExportStreamBuf::submitChunk() {
+    State& state = *m_state;
+    state.current->data.resize(pptr() - pbase());
+    state.workers->submit(std::move(state.current));
+    state.current = newChunk();
+    char* buffer = reinterpret_cast<char*>(state.current->data.data());
+    setp(buffer, buffer + EXPORT_CHUNK_SIZE);
+}
+
+/**
+ * Creates a new random export key.
+ *
+ * \param key Receives the key (\p EXPORT_KEY_BYTES bytes)
+ */
+void generateExportKey(unsigned char* key) {
+    crypto_secretstream_xchacha20poly1305_keygen(key);
+}
+
+/**
+ * Decrypts the export read from \p input and writes the plaintext to
+ * \p output. Every stream of the export is decrypted by its own thread,
+ * so decryption runs as parallel as encryption did. Every chunk is
+ * authenticated before it is written, but an export that was truncated or
+ * tampered with is only detected when the affected chunk is reached, so the
+ * plaintext must be discarded if this function fails.
+ *
+ * \param input The stream to read the export from
+ * \param output The stream to write the plaintext to or \p nullptr to only
+ * verify the export
+ * \param key The key to decrypt with (\p EXPORT_KEY_BYTES bytes)
+ * \param errors The stream to report errors to
+ * \return \p true if the export is complete and authentic
+ */
+bool decryptExport(std::istream& input, std::ostream* output,
+    const unsigned char* key, std::ostream& errors) {
+    uint32_t version, chunkSize, streamCount;
+    if (!readMagic(input, EXPORT_MAGIC) || !readUint32(input, version) ||
+        !readUint32(input, chunkSize) || !readUint32(input, streamCount)) {
+        errors << "ERROR: Not an export of GtkPass!" << std::endl;
+        return false;
+    }
+    if (version != EXPORT_VERSION || chunkSize == 0 ||
+        chunkSize > MAX_CHUNK_SIZE || streamCount == 0 ||
+        streamCount > EXPORT_MAX_STREAMS) {
+        errors << "ERROR: Unsupported export (version " << version << ", "
+            << streamCount << " streams)!" << std::endl;
+        return false;
+    }
+
+    std::vector<StreamState> streams(streamCount);
+    for (auto& stream : streams) {
+        unsigned char header[STREAM_HEADER_BYTES];
+        if (!input.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            crypto_secretstream_xchacha20poly1305_init_pull(&stream, header, key) != 0) {
+            errors << "ERROR: Invalid header of export!" << std::endl;
+            return false;
+        }
+    }
+
+    // written by the worker of the stream only, read after all workers ended
+    std::vector<unsigned char> ended(streamCount, 0);
+    bool authentic = true;
+    uint64_t record = 0;
+
+    ChunkWorkers workers(streamCount,
+        [&](unsigned int w, Chunk& chunk) {
+            // nothing may follow the final chunk or a forged chunk
+            if (ended[w] || chunk.data.size() < CHUNK_OVERHEAD) {
+                chunk.valid = false;
+                return;
+            }
+            unsigned char ad[AD_BYTES];
+            makeAssociatedData(ad, w, streamCount);
+            std::vector<unsigned char> plain(chunk.data.size() - CHUNK_OVERHEAD);
+            if (crypto_secretstream_xchacha20poly1305_pull(&streams[w],
+                plain.data(), nullptr, &chunk.tag, chunk.data.data(),
+                chunk.data.size(), ad, sizeof(ad)) != 0 ||
+                (chunk.tag != TAG_MESSAGE && chunk.tag != TAG_FINAL)) {
+                chunk.valid = false;
+                ended[w] = 2;
+                return;
+            }
+            if (chunk.tag == TAG_FINAL)
+                ended[w] = 1;
+            chunk.data.swap(plain);
+        },
+        [&](Chunk& chunk) {
+            if (!chunk.valid) {
+                if (authentic) {
+                    errors << "ERROR: Chunk " << record
+                        << " of export is not authentic (wrong key?)!" << std::endl;
+                }
+                authentic = false;
+            } else if (authentic && output) {
+                output->write(reinterpret_cast<const char*>(chunk.data.data()),
+                    chunk.data.size());
+            }
+            sodium_memzero(chunk.data.data(), chunk.data.size());
+            record++;
+        }
+    );
+
+    // the calling thread reads the records and remembers their offsets
+    bool complete = true;
+    std::vector<uint64_t> offsets;
+    uint64_t offset = MAGIC_BYTES + 3 * 4 + streamCount * STREAM_HEADER_BYTES;
+    uint32_t length;
+    while (true) {
+        if (!readUint32(input, length)) {
+            complete = false;
+            break;
+        }
+        if (length == 0)
+            break;
+        if (length > uint64_t(chunkSize) + CHUNK_OVERHEAD) {
+            complete = false;
+            break;
+        }
+        ChunkPtr chunk(new Chunk());
+        chunk->data.resize(length);
+        if (!input.read(reinterpret_cast<char*>(chunk->data.data()), length)) {
+            complete = false;
+            break;
+        }
+        offsets.push_back(offset);
+        offset += 4 + length;
+        workers.submit(std::move(chunk));
+    }
+    workers.finish();
+    sodium_memzero(streams.data(), streams.size() * sizeof(StreamState));
+
+    for (const unsigned char state : ended) {
+        complete = complete && state == 1;
+    }
+    if (authentic && !complete) {
+        errors << "ERROR: Export is truncated!" << std::endl;
+    }
+
+    // the index must match the records actually read
+    bool indexValid = complete;
+    uint64_t count = 0;
+    if (indexValid && readUint64(input, count) && count == offsets.size()) {
+        uint64_t value;
+        for (const uint64_t expected : offsets) {
+            if (!readUint64(input, value) || value != expected) {
+                indexValid = false;
+                break;
+            }
+        }
+        indexValid = indexValid && readUint64(input, value) &&
+            value == offset + 4 && readMagic(input, INDEX_MAGIC);
+    } else {
+        indexValid = false;
+    }
+    if (authentic && complete && !indexValid) {
+        errors << "ERROR: Index of export is corrupt!" << std::endl;
+    }
+
+    bool written = true;
+    if (output) {
+        output->flush();
+        written = static_cast<bool>(*output);
+        if (!written)
+            errors << "ERROR: Failed to write decrypted export!" << std::endl;
+    }
+    return authentic && complete && indexValid && written;
+}
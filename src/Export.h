@@ -0,0 +1,139 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Export.h
+ * \brief   Defines functions and classes for encrypted exports of generated
+ *          passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions and classes for writing and reading encrypted
+ * exports. An export splits the plaintext into chunks of
+ * \p EXPORT_CHUNK_SIZE bytes and encrypts them with libsodium's
+ * \p crypto_secretstream_xchacha20poly1305. Chunk \p i belongs to the
+ * independent stream \p i modulo the number of streams, so every stream is
+ * encrypted by its own worker thread and the workers never wait for each
+ * other. The container looks like this (all numbers little endian):
+ *
+ *     header:  "GTKPASSX", version (u32), chunk size (u32),
+ *              number of streams n (u32), n secretstream headers
+ *     records: length (u32) and ciphertext of every chunk, followed by one
+ *              empty chunk tagged FINAL per stream, terminated by length 0
+ *     index:   number of records (u64), offset of every record (u64)
+ *     trailer: offset of the index (u64), "GPXINDEX"
+ *
+ * Every chunk is authenticated together with the number of its stream and
+ * the number of streams, so chunks can neither be modified, reordered,
+ * dropped nor moved to another stream without the decryption failing. The
+ * index allows seeking to a chunk without reading the records before it.
+ */
+
+#ifndef GTKPASS_EXPORT_H
+#define GTKPASS_EXPORT_H
+
+#include "sodium.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+
+/// Number of plaintext bytes per chunk
+#define EXPORT_CHUNK_SIZE 65536
+/// Number of chunks queued per worker thread
+#define EXPORT_QUEUE_CHUNKS 4
+/// Maximum number of streams (and worker threads) of an export
+#define EXPORT_MAX_STREAMS 256
+/// Number of bytes of an export key
+#define EXPORT_KEY_BYTES crypto_secretstream_xchacha20poly1305_KEYBYTES
+
+/**
+ * Stream buffer encrypting everything written to it into an export written
+ * to an output stream. Memory usage is bounded by the number of workers
+ * times \p EXPORT_QUEUE_CHUNKS chunks, no matter how much is written.
+ */
+class ExportStreamBuf : public std::streambuf {
+
+public:
+    /**
+     * Constructor of \p ExportStreamBuf. Writes the header of the export to
+     * \p output and starts the worker threads.
+     *
+     * \param output The stream to write the export to
+     * \param key The key to encrypt with (\p EXPORT_KEY_BYTES bytes)
+     * \param workers The number of worker threads and streams (0 for the
+     * default, at most \p EXPORT_MAX_STREAMS)
+     */
+    ExportStreamBuf(std::ostream& output, const unsigned char* key,
+        unsigned int workers = 0);
+
+    /**
+     * Destructor of \p ExportStreamBuf. Finishes the export if \p finish()
+     * was not called.
+     */
+    ~ExportStreamBuf();
+
+    /**
+     * Encrypts the remaining data, ends all streams and writes the index and
+     * the trailer. Nothing must be written afterwards.
+     *
+     * \return \p true if the export was written successfully
+     */
+    bool finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+private:
+    ExportStreamBuf(const ExportStreamBuf&) = delete;
+    ExportStreamBuf& operator=(const ExportStreamBuf&) = delete;
+
+    /// Hands the current chunk over to its worker and starts a new one
+    void submitChunk();
+
+    struct State;
+    /// Worker threads, queues and the chunk being filled
+    std::unique_ptr<State> m_state;
+
+}; // end of class ExportStreamBuf
+
+/**
+ * Creates a new random export key.
+ *
+ * \param key Receives the key (\p EXPORT_KEY_BYTES bytes)
+ */
+void generateExportKey(unsigned char* key);
+
+/**
+ * Decrypts the export read from \p input and writes the plaintext to
+ * \p output. Every stream of the export is decrypted by its own thread,
+ * so decryption runs as parallel as encryption did. Every chunk is
+ * authenticated before it is written, but an export that was truncated or
+ * tampered with is only detected when the affected chunk is reached, so the
+ * plaintext must be discarded if this function fails.
+ *
+ * \param input The stream to read the export from
+ * \param output The stream to write the plaintext to or \p nullptr to only
+ * verify the export
+ * \param key The key to decrypt with (\p EXPORT_KEY_BYTES bytes)
+ * \param errors The stream to report errors to
+ * \return \p true if the export is complete and authentic
+ */
+bool decryptExport(std::istream& input, std::ostream* output,
+    const unsigned char* key, std::ostream& errors);
+
+#endif
@@ -0,0 +1,95 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Export_Bench.cpp
+ * \brief   Benchmarks the files \p Export.h and \p Export.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Export.h and \p Export.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Export.h"
+#include <iomanip>
+#include <sstream>
+
+/// Number of plaintext bytes encrypted per measurement (256 MiB)
+static const size_t EXPORT_BYTES = 256UL * 1024 * 1024;
+
+/// Stream buffer discarding everything written to it
+class NullStreamBuf : public std::streambuf {
+
+protected:
+    int_type overflow(int_type ch) override {
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+
+}; // end of class NullStreamBuf
+
+/// Writes the throughput of \p bytes bytes in \p nanoseconds to \p out
+static void printThroughput(std::ostream& out, const char* label,
+    unsigned int workers, size_t bytes, uint64_t nanoseconds) {
+    out << std::left << std::setw(8) << label << std::right
+        << std::setw(4) << workers << " workers: "
+        << std::setw(8) << std::fixed << std::setprecision(1)
+        << bytes * 1000.0 / nanoseconds << " MB/s" << std::endl;
+}
+
+/// Measures the throughput of encrypting 256 MiB into an export and of
+/// decrypting a 64 MiB export with 1, 2, 4 and 8 workers
+BENCHMARK_CASE(encrypted_export) {
+    unsigned char key[EXPORT_KEY_BYTES];
+    generateExportKey(key);
+    const std::string line(63, 'x');
+    const unsigned int workerCounts[] = { 1, 2, 4, 8 };
+
+    for (const unsigned int workers : workerCounts) {
+        NullStreamBuf null;
+        std::ostream output(&null);
+        const uint64_t start = getNanoseconds();
+        ExportStreamBuf buffer(output, key, workers);
+        std::ostream stream(&buffer);
+        for (size_t written = 0; written < EXPORT_BYTES; written += line.size() + 1) {
+            stream << line << '\n';
+        }
+        buffer.finish();
+        printThroughput(out, "encrypt", workers, EXPORT_BYTES, getNanoseconds() - start);
+    }
+
+    for (const unsigned int workers : workerCounts) {
+        std::ostringstream exported;
+        {
+            ExportStreamBuf buffer(exported, key, workers);
+            std::ostream stream(&buffer);
+            for (size_t written = 0; written < EXPORT_BYTES / 4; written += line.size() + 1) {
+                stream << line << '\n';
+            }
+        }
+        std::istringstream input(exported.str());
+        std::ostringstream errors;
+        const uint64_t start = getNanoseconds();
+        decryptExport(input, nullptr, key, errors);
+        printThroughput(out, "decrypt", workers, EXPORT_BYTES / 4, getNanoseconds() - start);
+    }
+}
@@ -0,0 +1,122 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Export_Test.cpp
+ * \brief   Tests the files \p Export.h and \p Export.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Export.h and \p Export.cpp.
+ */
+
+#include "catch.hpp"
+#include "Export.h"
+#include "RandomGenerator.h"
+#include <sstream>
+
+/// Encrypts \p plaintext with \p key on \p workers threads and returns the
+/// export
+static std::string encrypt(const std::string& plaintext,
+    const unsigned char* key, unsigned int workers) {
+    std::ostringstream output;
+    ExportStreamBuf buffer(output, key, workers);
+    std::ostream stream(&buffer);
+    stream << plaintext;
+    REQUIRE(buffer.finish());
+    return output.str();
+}
+
+/// Decrypts \p exported with \p key and stores the plaintext in \p plaintext
+static bool decrypt(const std::string& exported, const unsigned char* key,
+    std::string& plaintext) {
+    std::istringstream input(exported);
+    std::ostringstream output;
+    std::ostringstream errors;
+    const bool success = decryptExport(input, &output, key, errors);
+    plaintext = output.str();
+    REQUIRE(success == errors.str().empty());
+    return success;
+}
+
+/// Tests writing and reading exports of \p Export
+TEST_CASE("ExportStreamBuf and decryptExport", "[Export]") {
+    unsigned char key[EXPORT_KEY_BYTES];
+    generateExportKey(key);
+
+    SECTION("Round trip") {
+        genopts options;
+        const size_t sizes[] = { 0, 1, EXPORT_CHUNK_SIZE - 1, EXPORT_CHUNK_SIZE,
+            3 * EXPORT_CHUNK_SIZE + 5 };
+        const unsigned int workerCounts[] = { 1, 3 };
+        for (const size_t size : sizes) {
+            const std::string plaintext = getRandomString(size, options);
+            for (const unsigned int workers : workerCounts) {
+                const std::string exported = encrypt(plaintext, key, workers);
+                // the plaintext must not leak into the export
+                if (size > 16)
+                    REQUIRE(exported.find(plaintext.substr(0, 16)) == std::string::npos);
+                std::string decrypted;
+                REQUIRE(decrypt(exported, key, decrypted));
+                REQUIRE(decrypted == plaintext);
+
+                std::istringstream input(exported);
+                std::ostringstream errors;
+                REQUIRE(decryptExport(input, nullptr, key, errors));
+            }
+        }
+    }
+
+    SECTION("Wrong key") {
+        const std::string exported = encrypt("secret", key, 2);
+        unsigned char otherKey[EXPORT_KEY_BYTES];
+        generateExportKey(otherKey);
+        std::string decrypted;
+        REQUIRE_FALSE(decrypt(exported, otherKey, decrypted));
+        REQUIRE(decrypted.empty());
+    }
+
+    SECTION("Tampering") {
+        genopts options;
+        const std::string plaintext = getRandomString(4 * EXPORT_CHUNK_SIZE, options);
+        const std::string exported = encrypt(plaintext, key, 2);
+        std::string decrypted;
+
+        // modified ciphertext
+        std::string modified = exported;
+        modified[exported.size() / 2] ^= 1;
+        REQUIRE_FALSE(decrypt(modified, key, decrypted));
+
+        // truncated before the final chunks
+        REQUIRE_FALSE(decrypt(exported.substr(0, exported.size() / 2), key, decrypted));
+
+        // truncated index
+        REQUIRE_FALSE(decrypt(exported.substr(0, exported.size() - 1), key, decrypted));
+
+        // swapped chunks of the same size in different streams
+        const size_t header = 8 + 3 * 4 + 2 * crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+        const size_t record = 4 + EXPORT_CHUNK_SIZE + crypto_secretstream_xchacha20poly1305_ABYTES;
+        std::string swapped = exported;
+        swapped.replace(header, record, exported, header + record, record);
+        swapped.replace(header + record, record, exported, header, record);
+        REQUIRE_FALSE(decrypt(swapped, key, decrypted));
+
+        // not an export at all
+        REQUIRE_FALSE(decrypt("GTKPASS", key, decrypted));
+    }
+}
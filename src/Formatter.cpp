@@ -0,0 +1,329 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Formatter.cpp
+ * \brief   Implements functions for formatting generated passwords as CSV,
+ *          JSON Lines or shell words.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for formatting generated passwords as CSV,
+ * JSON Lines or shell words.
+ */
+
+#include "Formatter.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+namespace {
+
+/// Number of bytes checked at once by the vectorized scan
+const size_t SCAN_BLOCK_SIZE = 16;
+/// Maximum number of distinct special bytes of a scan set
+const size_t MAX_SPECIAL_BYTES = 4;
+
+/**
+ * Set of bytes that need special treatment in a field: up to
+ * \p MAX_SPECIAL_BYTES distinct bytes, optionally all control characters.
+ * The set is kept both as a lookup table and in a form the vectorized scan
+ * can compare 16 bytes against at once.
+ */
+struct ScanSet {
+    ScanSet(const char* bytes, bool controls) : count(strlen(bytes)),
+        controls(controls), special() {
+        memcpy(this->bytes, bytes, count);
+        for (size_t i = 0; i < count; i++) {
+            special[static_cast<unsigned char>(bytes[i])] = true;
+        }
+        for (size_t c = 0; controls && c < 0x20; c++) {
+            special[c] = true;
+        }
+    }
+    /// the special bytes
+    char bytes[MAX_SPECIAL_BYTES];
+    /// number of special bytes
+    size_t count;
+    /// whether all bytes below 0x20 are special
+    bool controls;
+    /// lookup table: whether a byte is special
+    bool special[256];
+};
+
+/**
+ * Table of the replacements of the special bytes of a format. Bytes without
+ * replacement are copied.
+ */
+struct EscapeTable {
+    EscapeTable() : text(), length() {}
+    /// Sets the replacement of \p byte to \p replacement
+    void set(unsigned char byte, const char* replacement) {
+        text[byte] = replacement;
+        length[byte] = strlen(replacement);
+    }
+    /// the replacement of every byte or \p nullptr
+    const char* text[256];
+    /// the number of bytes of every replacement
+    size_t length[256];
+};
+
+/// Bytes that force a CSV field to be quoted
+const ScanSet CSV_QUOTE_SET(",\"\r\n", false);
+/// Bytes that are escaped inside a quoted CSV field
+const ScanSet CSV_ESCAPE_SET("\"", false);
+/// Bytes that are escaped inside a JSON string
+const ScanSet JSON_ESCAPE_SET("\"\\", true);
+/// Bytes that are escaped inside a single quoted shell word
+const ScanSet SHELL_ESCAPE_SET("'", false);
+
+/// Storage for the \p \\u00XX escapes of the control characters in JSON
+char jsonControlEscapes[0x20][8];
+
+/// Returns the replacements inside a quoted CSV field
+EscapeTable makeCsvTable() {
+    EscapeTable table;
+    table.set('"', "\"\"");
+    return table;
+}
+
+/// Returns the replacements inside a JSON string
+EscapeTable makeJsonTable() {
+    EscapeTable table;
+    for (unsigned int c = 0; c < 0x20; c++) {
+        snprintf(jsonControlEscapes[c], sizeof(jsonControlEscapes[c]), "\\u%04x", c);
+        table.set(c, jsonControlEscapes[c]);
+    }
+    table.set('\b', "\\b");
+    table.set('\f', "\\f");
+    table.set('\n', "\\n");
+    table.set('\r', "\\r");
+    table.set('\t', "\\t");
+    table.set('"', "\\\"");
+    table.set('\\', "\\\\");
+    return table;
+}
+
+/// Returns the replacements inside a single quoted shell word: the quote is
+/// closed, an escaped quote follows and the quote is opened again
+EscapeTable makeShellTable() {
+    EscapeTable table;
+    table.set('\'', "'\\''");
+    return table;
+}
+
+const EscapeTable CSV_TABLE = makeCsvTable();
+const EscapeTable JSON_TABLE = makeJsonTable();
+const EscapeTable SHELL_TABLE = makeShellTable();
+
+/**
+ * Returns the index of the first byte of \p data that is in \p set, or
+ * \p length if there is none.
+ */
+size_t findSpecial(const char* data, size_t length, const ScanSet& set) {
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i needles[MAX_SPECIAL_BYTES];
+    for (size_t b = 0; b < set.count; b++) {
+        needles[b] = _mm_set1_epi8(set.bytes[b]);
+    }
+    const __m128i maxControl = _mm_set1_epi8(0x1f);
+    for (; i + SCAN_BLOCK_SIZE <= length; i += SCAN_BLOCK_SIZE) {
+        const __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_setzero_si128();
+        for (size_t b = 0; b < set.count; b++) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[b]));
+        }
+        if (set.controls) {
+            // unsigned byte <= 0x1f iff min(byte, 0x1f) == byte
+            hits = _mm_or_si128(hits,
+                _mm_cmpeq_epi8(_mm_min_epu8(block, maxControl), block));
+        }
+        const int mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < length; i++) {
+        if (set.special[static_cast<unsigned char>(data[i])])
+            return i;
+    }
+    return length;
+}
+
+/**
+ * Appends \p data to \p buffer, replacing all bytes of \p set by their
+ * replacement in \p table. Runs of bytes without replacement are copied at
+ * once.
+ */
+void appendEscaped(std::string& buffer, const char* data, size_t length,
+    const ScanSet& set, const EscapeTable& table) {
+    while (length > 0) {
+        const size_t run = findSpecial(data, length, set);
+        buffer.append(data, run);
+        if (run == length)
+            break;
+        const unsigned char special = static_cast<unsigned char>(data[run]);
+        buffer.append(table.text[special], table.length[special]);
+        data += run + 1;
+        length -= run + 1;
+    }
+}
+
+} // end of anonymous namespace
+
+/**
+ * Looks up the output format named \p name ("csv", "jsonl" or "shell").
+ *
+ * \param name The name of the format
+ * \param format Receives the format
+ * \return \p true if \p name is a known format, \p false otherwise
+ */
+bool parseOutputFormat(const std::string& name, outformat& format) {
+    if (name == "csv")
+        format = FORMAT_CSV;
+    else if (name == "jsonl")
+        format = FORMAT_JSONL;
+    else if (name == "shell")
+        format = FORMAT_SHELL;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Returns the name of the output format \p format.
+ *
+ * \param format The format
+ * \return Name of the format
+ */
+const char* getOutputFormatName(outformat format) {
+    switch (format) {
+        case FORMAT_JSONL:
+            return "jsonl";
+        case FORMAT_SHELL:
+            return "shell";
+        default:
+            return "csv";
+    }
+}
+
+/**
+ * Appends the field \p data of \p length bytes to \p buffer, quoted and
+ * escaped as required by \p format.
+ *
+ * \param buffer The buffer to append to
+ * \param format The output format
+ * \param data The bytes of the field
+ * \param length The number of bytes of the field
+ */
+void appendField(std::string& buffer, outformat format, const char* data,
+    size_t length) {
+    switch (format) {
+        case FORMAT_JSONL:
+            buffer += '"';
+            appendEscaped(buffer, data, length, JSON_ESCAPE_SET, JSON_TABLE);
+            buffer += '"';
+            break;
+        case FORMAT_SHELL:
+            buffer += '\'';
+            appendEscaped(buffer, data, length, SHELL_ESCAPE_SET, SHELL_TABLE);
+            buffer += '\'';
+            break;
+        default:
+            // CSV fields are only quoted if they contain separators, quotes,
+            // line breaks or leading or trailing spaces
+            if (findSpecial(data, length, CSV_QUOTE_SET) == length &&
+                (length == 0 || (data[0] != ' ' && data[length - 1] != ' '))) {
+                buffer.append(data, length);
+            } else {
+                buffer += '"';
+                appendEscaped(buffer, data, length, CSV_ESCAPE_SET, CSV_TABLE);
+                buffer += '"';
+            }
+            break;
+    }
+}
+
+/**
+ * Appends a record of an account, its password and optionally the hash of
+ * the password as one line to \p buffer:
+ *
+ *     csv:    account,password,hash
+ *     jsonl:  {"account":"...","password":"...","hash":"..."}
+ *     shell:  'account' 'password' 'hash'
+ *
+ * \param buffer The buffer to append to
+ * \param format The output format
+ * \param account The account id
+ * \param password The password
+ * \param hash The encoded hash of the password or an empty string to omit it
+ */
+void appendRecord(std::string& buffer, outformat format,
+    const std::string& account, const std::string& password,
+    const std::string& hash) {
+    if (format == FORMAT_JSONL) {
+        buffer += "{\"account\":";
+        appendField(buffer, format, account.data(), account.size());
+        buffer += ",\"password\":";
+        appendField(buffer, format, password.data(), password.size());
+        if (!hash.empty()) {
+            buffer += ",\"hash\":";
+            appendField(buffer, format, hash.data(), hash.size());
+        }
+        buffer += "}\n";
+        return;
+    }
+
+    const char separator = format == FORMAT_SHELL ? ' ' : ',';
+    appendField(buffer, format, account.data(), account.size());
+    buffer += separator;
+    appendField(buffer, format, password.data(), password.size());
+    if (!hash.empty()) {
+        buffer += separator;
+        appendField(buffer, format, hash.data(), hash.size());
+    }
+    buffer += '\n';
+}
+
+/**
+ * Returns an upper bound of the bytes \p appendRecord() appends for fields of
+ * \p fieldBytes bytes in total, so a buffer can be reserved for a whole
+ * batch of records at once and never grows (leaving copies of passwords
+ * behind in freed memory).
+ *
+ * \param format The output format
+ * \param fieldBytes The number of bytes of all fields of the record
+ * \return Maximum number of bytes of the record
+ */
+size_t getRecordSize(outformat format, size_t fieldBytes) {
+    switch (format) {
+        case FORMAT_JSONL:
+            // every byte may be a control character escaped as \u00XX
+            return 6 * fieldBytes + sizeof("{\"account\":\"\",\"password\":\"\",\"hash\":\"\"}\n");
+        case FORMAT_SHELL:
+            // every character may be a quote replaced by 4 characters
+            return 4 * fieldBytes + sizeof("'' '' ''\n");
+        default:
+            // every character may be a doubled quote
+            return 2 * fieldBytes + sizeof("\"\",\"\",\"\"\n");
+    }
+}
@@ -0,0 +1,110 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Formatter.h
+ * \brief   Defines functions for formatting generated passwords as CSV, JSON
+ *          Lines or shell words.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for formatting records of generated passwords
+ * in one of the output formats. The functions append to a caller provided
+ * buffer, so a buffer reused for many records needs no allocation per record.
+ * Characters that need escaping are found with a lookup table per format,
+ * checking 16 bytes at once with SSE2 where available.
+ */
+
+#ifndef GTKPASS_FORMATTER_H
+#define GTKPASS_FORMATTER_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * \typedef outformat
+ * \brief Defines the output formats for generated passwords.
+ */
+typedef enum outputformat {
+    /// comma separated values as in RFC 4180, quoted where needed
+    FORMAT_CSV,
+    /// one JSON object per line
+    FORMAT_JSONL,
+    /// single quoted words separated by spaces, safe for POSIX shells
+    FORMAT_SHELL
+} outformat;
+
+/**
+ * Looks up the output format named \p name ("csv", "jsonl" or "shell").
+ *
+ * \param name The name of the format
+ * \param format Receives the format
+ * \return \p true if \p name is a known format, \p false otherwise
+ */
+bool parseOutputFormat(const std::string& name, outformat& format);
+
+/**
+ * Returns the name of the output format \p format.
+ *
+ * \param format The format
+ * \return Name of the format
+ */
+const char* getOutputFormatName(outformat format);
+
+/**
+ * Appends the field \p data of \p length bytes to \p buffer, quoted and
+ * escaped as required by \p format.
+ *
+ * \param buffer The buffer to append to
+ * \param format The output format
+ * \param data The bytes of the field
+ * \param length The number of bytes of the field
+ */
+void appendField(std::string& buffer, outformat format, const char* data,
+    size_t length);
+
+/**
+ * Appends a record of an account, its password and optionally the hash of
+ * the password as one line to \p buffer:
+ *
+ *     csv:    account,password,hash
+ *     jsonl:  {"account":"...","password":"...","hash":"..."}
+ *     shell:  'account' 'password' 'hash'
+ *
+ * \param buffer The buffer to append to
+ * \param format The output format
+ * \param account The account id
+ * \param password The password
+ * \param hash The encoded hash of the password or an empty string to omit it
+ */
+void appendRecord(std::string& buffer, outformat format,
+    const std::string& account, const std::string& password,
+    const std::string& hash);
+
+/**
+ * Returns an upper bound of the bytes \p appendRecord() appends for fields of
+ * \p fieldBytes bytes in total, so a buffer can be reserved for a whole
+ * batch of records at once and never grows (leaving copies of passwords
+ * behind in freed memory).
+ *
+ * \param format The output format
+ * \param fieldBytes The number of bytes of all fields of the record
+ * \return Maximum number of bytes of the record
+ */
+size_t getRecordSize(outformat format, size_t fieldBytes);
+
+#endif
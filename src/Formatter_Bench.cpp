@@ -0,0 +1,84 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Formatter_Bench.cpp
+ * \brief   Benchmarks the files \p Formatter.h and \p Formatter.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Formatter.h and \p Formatter.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Formatter.h"
+#include "RandomGenerator.h"
+#include <iomanip>
+#include <vector>
+
+/// Number of distinct records formatted per measurement
+static const size_t RECORD_COUNT = 4096;
+/// Number of times all records are formatted
+static const size_t ROUNDS = 250;
+
+/**
+ * Formats 4096 records of a 20 character password from all character sets
+ * 250 times into a reused buffer and writes the throughput to \p out.
+ */
+static void measureFormat(std::ostream& out, outformat format) {
+    genopts options;
+    options.bIncludeSpecial = true;
+    std::vector<std::string> accounts;
+    std::vector<std::string> passwords;
+    for (size_t i = 0; i < RECORD_COUNT; i++) {
+        accounts.push_back("user" + std::to_string(i) + "@example.com");
+        passwords.push_back(getRandomString(20, options));
+    }
+
+    std::string buffer;
+    size_t bytes = 0;
+    const uint64_t start = getNanoseconds();
+    for (size_t round = 0; round < ROUNDS; round++) {
+        buffer.clear();
+        for (size_t i = 0; i < RECORD_COUNT; i++) {
+            appendRecord(buffer, format, accounts[i], passwords[i], "");
+        }
+        bytes += buffer.size();
+    }
+    const uint64_t elapsed = getNanoseconds() - start;
+
+    out << std::left << std::setw(6) << getOutputFormatName(format) << std::right
+        << std::setw(8) << std::fixed << std::setprecision(1)
+        << double(elapsed) / (RECORD_COUNT * ROUNDS) << " ns/record  "
+        << std::setw(8) << bytes * 1000.0 / elapsed << " MB/s" << std::endl;
+}
+
+/// Measures formatting records as CSV
+BENCHMARK_CASE(format_csv) {
+    measureFormat(out, FORMAT_CSV);
+}
+
+/// Measures formatting records as JSON Lines
+BENCHMARK_CASE(format_jsonl) {
+    measureFormat(out, FORMAT_JSONL);
+}
+
+/// Measures formatting records as shell words
+BENCHMARK_CASE(format_shell) {
+    measureFormat(out, FORMAT_SHELL);
+}
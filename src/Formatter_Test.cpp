@@ -0,0 +1,167 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Formatter_Test.cpp
+ * \brief   Tests the files \p Formatter.h and \p Formatter.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Formatter.h and \p Formatter.cpp.
+ */
+
+#include "catch.hpp"
+#include "Formatter.h"
+#include "RandomGenerator.h"
+
+/// Returns \p field formatted as single field in \p format
+static std::string format(outformat format, const std::string& field) {
+    std::string buffer;
+    appendField(buffer, format, field.data(), field.size());
+    return buffer;
+}
+
+/// Escapes \p field for \p format one character at a time, as reference for
+/// the table-driven and vectorized implementation
+static std::string formatReference(outformat format, const std::string& field) {
+    std::string result;
+    if (format == FORMAT_SHELL) {
+        result += '\'';
+        for (const char c : field) {
+            result += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        return result + '\'';
+    }
+    if (format == FORMAT_JSONL) {
+        result += '"';
+        for (const char c : field) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result + '"';
+    }
+    if (field.find_first_of(",\"\r\n") == std::string::npos &&
+        (field.empty() || (field[0] != ' ' && field[field.size() - 1] != ' ')))
+        return field;
+    result += '"';
+    for (const char c : field) {
+        if (c == '"')
+            result += '"';
+        result += c;
+    }
+    return result + '"';
+}
+
+/// Tests the functions \p parseOutputFormat and \p getOutputFormatName of
+/// \p Formatter
+TEST_CASE("parseOutputFormat", "[Formatter]") {
+    const outformat formats[] = { FORMAT_CSV, FORMAT_JSONL, FORMAT_SHELL };
+    for (const outformat expected : formats) {
+        outformat parsed = FORMAT_CSV;
+        REQUIRE(parseOutputFormat(getOutputFormatName(expected), parsed));
+        REQUIRE(parsed == expected);
+    }
+    outformat parsed;
+    REQUIRE_FALSE(parseOutputFormat("json", parsed));
+    REQUIRE_FALSE(parseOutputFormat("", parsed));
+}
+
+/// Tests the function \p appendField of \p Formatter
+TEST_CASE("appendField", "[Formatter]") {
+    SECTION("CSV") {
+        REQUIRE(format(FORMAT_CSV, "abc") == "abc");
+        REQUIRE(format(FORMAT_CSV, "") == "");
+        REQUIRE(format(FORMAT_CSV, "a,b") == "\"a,b\"");
+        REQUIRE(format(FORMAT_CSV, "say \"hi\"") == "\"say \"\"hi\"\"\"");
+        REQUIRE(format(FORMAT_CSV, " a") == "\" a\"");
+        REQUIRE(format(FORMAT_CSV, "a\nb") == "\"a\nb\"");
+        REQUIRE(format(FORMAT_CSV, "$`\\'") == "$`\\'");
+    }
+
+    SECTION("JSON") {
+        REQUIRE(format(FORMAT_JSONL, "abc") == "\"abc\"");
+        REQUIRE(format(FORMAT_JSONL, "a\"b\\c") == "\"a\\\"b\\\\c\"");
+        REQUIRE(format(FORMAT_JSONL, "\n\t\x01") == "\"\\n\\t\\u0001\"");
+        REQUIRE(format(FORMAT_JSONL, "$`'/") == "\"$`'/\"");
+    }
+
+    SECTION("Shell") {
+        REQUIRE(format(FORMAT_SHELL, "abc") == "'abc'");
+        REQUIRE(format(FORMAT_SHELL, "") == "''");
+        REQUIRE(format(FORMAT_SHELL, "it's") == "'it'\\''s'");
+        REQUIRE(format(FORMAT_SHELL, "$(rm)`x`\\\"") == "'$(rm)`x`\\\"'");
+    }
+
+    SECTION("Every position of the vectorized scan") {
+        // special characters at every offset of fields longer than a block
+        const outformat formats[] = { FORMAT_CSV, FORMAT_JSONL, FORMAT_SHELL };
+        const std::string specials = "\"\\',$`";
+        for (const outformat f : formats) {
+            for (size_t length = 1; length < 40; length++) {
+                for (size_t pos = 0; pos < length; pos++) {
+                    for (const char special : specials) {
+                        std::string field(length, 'x');
+                        field[pos] = special;
+                        REQUIRE(format(f, field) == formatReference(f, field));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Random passwords") {
+        genopts options;
+        options.bIncludeSpecial = true;
+        options.bIncludeSpace = true;
+        const outformat formats[] = { FORMAT_CSV, FORMAT_JSONL, FORMAT_SHELL };
+        for (size_t i = 0; i < 200; i++) {
+            const std::string password = getRandomString(i, options);
+            for (const outformat f : formats) {
+                REQUIRE(format(f, password) == formatReference(f, password));
+            }
+        }
+    }
+}
+
+/// Tests the functions \p appendRecord and \p getRecordSize of \p Formatter
+TEST_CASE("appendRecord", "[Formatter]") {
+    std::string buffer;
+    appendRecord(buffer, FORMAT_CSV, "john", "p\"w", "");
+    appendRecord(buffer, FORMAT_JSONL, "john", "p\"w", "$argon2id$x");
+    appendRecord(buffer, FORMAT_SHELL, "john", "p'w", "h");
+    REQUIRE(buffer ==
+        "john,\"p\"\"w\"\n"
+        "{\"account\":\"john\",\"password\":\"p\\\"w\",\"hash\":\"$argon2id$x\"}\n"
+        "'john' 'p'\\''w' 'h'\n");
+
+    // the size is an upper bound for fields consisting of quotes only
+    const outformat formats[] = { FORMAT_CSV, FORMAT_JSONL, FORMAT_SHELL };
+    for (const outformat f : formats) {
+        const std::string quotes(20, f == FORMAT_SHELL ? '\'' : '"');
+        std::string record;
+        appendRecord(record, f, quotes, quotes, quotes);
+        REQUIRE(record.size() <= getRecordSize(f, 3 * quotes.size()));
+    }
+
+    // account ids may hold control characters, which JSON escapes as \u00XX
+    const std::string controls(20, '\x01');
+    std::string record;
+    appendRecord(record, FORMAT_JSONL, controls, controls, controls);
+    REQUIRE(record.size() <= getRecordSize(FORMAT_JSONL, 3 * controls.size()));
+}
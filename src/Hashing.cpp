@@ -0,0 +1,81 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Hashing.cpp
+ * \brief   Implements functions for hashing passwords with Argon2id.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for hashing passwords with Argon2id.
+ */
+
+#include "Hashing.h"
+#include "Scheduler.h"
+
+/**
+ * Returns the number of hashes to compute in parallel for \p options: the
+ * number of threads, limited by the number of hashes fitting into the memory
+ * budget, but at least 1.
+ *
+ * \param options The options for hashing
+ * \return Number of worker threads for hashing
+ */
+unsigned int getHashWorkerCount(const hashopts& options) {
+    unsigned int workers = options.threads > 0 ? options.threads : getDefaultThreadCount();
+    if (options.memLimit > 0) {
+        const size_t fitting = options.memoryBudget / options.memLimit;
+        if (fitting < workers)
+            workers = static_cast<unsigned int>(fitting);
+    }
+    return workers > 0 ? workers : 1;
+}
+
+/**
+ * Checks whether the limits in \p options are within the minimum and maximum
+ * limits of libsodium.
+ *
+ * \param options The options to check
+ * \return \p true if the options are valid, \p false otherwise
+ */
+bool checkHashOptions(const hashopts& options) {
+    return options.opsLimit >= crypto_pwhash_OPSLIMIT_MIN &&
+        options.opsLimit <= crypto_pwhash_OPSLIMIT_MAX &&
+        options.memLimit >= crypto_pwhash_MEMLIMIT_MIN &&
+        options.memLimit <= crypto_pwhash_MEMLIMIT_MAX;
+}
+
+/**
+ * Hashes \p password with Argon2id and the limits in \p options and writes
+ * the encoded hash (including algorithm, limits and salt) to \p hash.
+ *
+ * \param password The password to hash
+ * \param options The options for hashing
+ * \param hash Receives the encoded hash
+ * \return \p true on success, \p false if the memory could not be allocated
+ */
+bool hashPassword(const std::string& password, const hashopts& options,
+    std::string& hash) {
+    char encoded[crypto_pwhash_STRBYTES];
+    if (crypto_pwhash_str(encoded, password.data(), password.size(),
+        options.opsLimit, options.memLimit) != 0) {
+        hash.clear();
+        return false;
+    }
+    hash = encoded;
+    return true;
+}
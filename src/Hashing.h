@@ -0,0 +1,90 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Hashing.h
+ * \brief   Defines functions for hashing passwords with Argon2id.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for hashing passwords with Argon2id by using
+ * libsodium's \p crypto_pwhash_str(). Every hash needs as much memory as its
+ * memory limit, so the number of hashes computed in parallel is bounded by a
+ * memory budget.
+ */
+
+#ifndef GTKPASS_HASHING_H
+#define GTKPASS_HASHING_H
+
+#include "sodium.h"
+#include <string>
+
+/// Default memory budget for all parallel hashes together (1 GiB)
+#define HASH_DEFAULT_MEMORY_BUDGET (1024UL * 1024UL * 1024UL)
+
+/**
+ * \typedef hashopts
+ * \brief Defines a struct holding options for hashing passwords.
+ */
+typedef struct hashoptions {
+    /// Initializes the struct with libsodium's interactive limits, the
+    /// default memory budget and the default number of threads
+    hashoptions() : opsLimit(crypto_pwhash_OPSLIMIT_INTERACTIVE),
+        memLimit(crypto_pwhash_MEMLIMIT_INTERACTIVE),
+        memoryBudget(HASH_DEFAULT_MEMORY_BUDGET), threads(0) {}
+    /// number of passes of Argon2id
+    unsigned long long opsLimit;
+    /// memory used by a single hash in bytes
+    size_t memLimit;
+    /// memory all parallel hashes may use together in bytes
+    size_t memoryBudget;
+    /// maximum number of threads (0 for the number of hardware threads)
+    unsigned int threads;
+} hashopts;
+
+/**
+ * Returns the number of hashes to compute in parallel for \p options: the
+ * number of threads, limited by the number of hashes fitting into the memory
+ * budget, but at least 1.
+ *
+ * \param options The options for hashing
+ * \return Number of worker threads for hashing
+ */
+unsigned int getHashWorkerCount(const hashopts& options);
+
+/**
+ * Checks whether the limits in \p options are within the minimum and maximum
+ * limits of libsodium.
+ *
+ * \param options The options to check
+ * \return \p true if the options are valid, \p false otherwise
+ */
+bool checkHashOptions(const hashopts& options);
+
+/**
+ * Hashes \p password with Argon2id and the limits in \p options and writes
+ * the encoded hash (including algorithm, limits and salt) to \p hash.
+ *
+ * \param password The password to hash
+ * \param options The options for hashing
+ * \param hash Receives the encoded hash
+ * \return \p true on success, \p false if the memory could not be allocated
+ */
+bool hashPassword(const std::string& password, const hashopts& options,
+    std::string& hash);
+
+#endif
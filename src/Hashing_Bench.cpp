@@ -0,0 +1,63 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Hashing_Bench.cpp
+ * \brief   Benchmarks the files \p Hashing.h and \p Hashing.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Hashing.h and \p Hashing.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Hashing.h"
+#include "Scheduler.h"
+#include <iomanip>
+
+/// Number of passwords hashed per measurement
+static const size_t HASHES_PER_RUN = 32;
+
+/// Measures the hashes per second with libsodium's interactive limits for
+/// memory budgets of 64 MiB, 256 MiB and 1 GiB and 1, 2, 4 and 8 threads
+BENCHMARK_CASE(hashing) {
+    const size_t budgets[] = { 64UL << 20, 256UL << 20, 1024UL << 20 };
+    const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+    const std::string password = "correct horse battery staple";
+
+    for (const size_t budget : budgets) {
+        for (const unsigned int threads : threadCounts) {
+            hashopts options;
+            options.memoryBudget = budget;
+            options.threads = threads;
+            const unsigned int workers = getHashWorkerCount(options);
+
+            const uint64_t start = getNanoseconds();
+            runParallel(HASHES_PER_RUN, workers, [&](size_t) {
+                std::string hash;
+                hashPassword(password, options, hash);
+            });
+            const uint64_t elapsed = getNanoseconds() - start;
+
+            out << std::setw(5) << (budget >> 20) << " MiB budget, "
+                << threads << " threads (" << workers << " workers): "
+                << std::setw(8) << std::fixed << std::setprecision(1)
+                << HASHES_PER_RUN * 1e9 / elapsed << " hashes/s" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Hashing_Test.cpp
+ * \brief   Tests the files \p Hashing.h and \p Hashing.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Hashing.h and \p Hashing.cpp.
+ */
+
+#include "catch.hpp"
+#include "Hashing.h"
+#include "Provisioning.h"
+#include <sstream>
+
+/// Returns options with the minimal limits, so the tests run fast
+static hashopts getFastOptions() {
+    hashopts options;
+    options.opsLimit = crypto_pwhash_OPSLIMIT_MIN;
+    options.memLimit = crypto_pwhash_MEMLIMIT_MIN;
+    return options;
+}
+
+/// Tests the function \p getHashWorkerCount of \p Hashing
+TEST_CASE("getHashWorkerCount", "[Hashing]") {
+    hashopts options;
+    options.memLimit = 64 << 20;
+    options.threads = 8;
+
+    options.memoryBudget = 1024 << 20;
+    REQUIRE(getHashWorkerCount(options) == 8);
+    options.memoryBudget = 256 << 20;
+    REQUIRE(getHashWorkerCount(options) == 4);
+    options.memoryBudget = 100 << 20;
+    REQUIRE(getHashWorkerCount(options) == 1);
+    // a single hash always runs, even if it exceeds the budget
+    options.memoryBudget = 1 << 20;
+    REQUIRE(getHashWorkerCount(options) == 1);
+
+    options.threads = 0;
+    options.memoryBudget = 1024 << 20;
+    REQUIRE(getHashWorkerCount(options) >= 1);
+}
+
+/// Tests the function \p checkHashOptions of \p Hashing
+TEST_CASE("checkHashOptions", "[Hashing]") {
+    REQUIRE(checkHashOptions(hashopts()));
+    hashopts options = getFastOptions();
+    REQUIRE(checkHashOptions(options));
+    options.opsLimit = 0;
+    REQUIRE_FALSE(checkHashOptions(options));
+    options.opsLimit = crypto_pwhash_OPSLIMIT_MAX + 1ULL;
+    REQUIRE_FALSE(checkHashOptions(options));
+    options = getFastOptions();
+    options.memLimit = 0;
+    REQUIRE_FALSE(checkHashOptions(options));
+    options.memLimit = size_t(crypto_pwhash_MEMLIMIT_MAX) + 1;
+    REQUIRE_FALSE(checkHashOptions(options));
+}
+
+/// Tests the function \p hashPassword of \p Hashing
+TEST_CASE("hashPassword", "[Hashing]") {
+    const hashopts options = getFastOptions();
+    std::string hash;
+    REQUIRE(hashPassword("secret", options, hash));
+    REQUIRE(hash.compare(0, 10, "$argon2id$") == 0);
+    REQUIRE(crypto_pwhash_str_verify(hash.c_str(), "secret", 6) == 0);
+    REQUIRE(crypto_pwhash_str_verify(hash.c_str(), "Secret", 6) != 0);
+
+    // every hash has its own salt
+    std::string other;
+    REQUIRE(hashPassword("secret", options, other));
+    REQUIRE(hash != other);
+}
+
+/// Tests the function \p runProvisioning of \p Provisioning with hashing
+TEST_CASE("runProvisioning with hashing", "[Hashing]") {
+    std::ostringstream output;
+    std::ostringstream errors;
+    pipelinereport report;
+    provopts options;
+    options.hash = true;
+    options.hashing = getFastOptions();
+    options.hashing.threads = 4;
+
+    std::stringstream manifest;
+    const size_t rows = PIPELINE_BATCH_ROWS + 3;
+    for (size_t i = 0; i < rows; i++) {
+        manifest << "user" << i << ",alnum,12\n";
+    }
+
+    REQUIRE(runProvisioning(manifest, output, errors, report, options));
+    REQUIRE(errors.str().empty());
+    REQUIRE(report.failedRows == 0);
+    REQUIRE(report.stages.size() == 5);
+    REQUIRE(report.stages[2].name == "hash");
+    REQUIRE(report.stages[2].rows == rows);
+
+    std::istringstream lines(output.str());
+    std::string line;
+    size_t i = 0;
+    while (std::getline(lines, line)) {
+        const std::string prefix = "user" + std::to_string(i) + ",";
+        REQUIRE(line.compare(0, prefix.size(), prefix) == 0);
+        const size_t comma = line.find(',', prefix.size());
+        REQUIRE(comma == prefix.size() + 12);
+        const std::string password = line.substr(prefix.size(), 12);
+        // the encoded hash contains commas, so it is quoted
+        REQUIRE(line[comma + 1] == '"');
+        REQUIRE(line[line.size() - 1] == '"');
+        const std::string hash = line.substr(comma + 2, line.size() - comma - 3);
+        REQUIRE(crypto_pwhash_str_verify(hash.c_str(), password.data(),
+            password.size()) == 0);
+        i++;
+    }
+    REQUIRE(i == rows);
+}
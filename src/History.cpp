@@ -0,0 +1,294 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    History.cpp
+ * \brief   Implements classes storing and searching the generated passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements classes storing and searching the passwords generated
+ * in a session.
+ */
+
+#include "History.h"
+#include "sodium.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+/**
+ * Constructor of \p PasswordHistory. Creates an empty history.
+ */
+PasswordHistory::PasswordHistory() : m_arena(nullptr), m_capacity(0),
+    m_offsets(1, 0) {
+}
+
+/**
+ * Destructor of \p PasswordHistory. Wipes and frees the arena.
+ */
+PasswordHistory::~PasswordHistory() {
+    sodium_free(m_arena);
+}
+
+/**
+ * Appends \p password to the history.
+ *
+ * \param password The password
+ * \return \p true if the password was added, \p false if the history
+ * holds 4 GiB of passwords or memory is exhausted
+ */
+bool PasswordHistory::add(const std::string& password) {
+    return add(password.data(), password.size());
+}
+
+/**
+ * Appends the \p length characters at \p password to the history.
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ * \return \p true if the password was added, \p false if the history
+ * holds 4 GiB of passwords or memory is exhausted
+ */
+bool PasswordHistory::add(const char* password, size_t length) {
+    const size_t used = m_offsets.back();
+    const size_t limit = std::numeric_limits<uint32_t>::max();
+    if (length > limit - used)
+        return false;
+    if (used + length > m_capacity) {
+        // sodium_free() wipes the old arena
+        const size_t capacity = std::min(limit, std::max<size_t>(
+            std::max<size_t>(HISTORY_INITIAL_CAPACITY, 2 * m_capacity),
+            used + length));
+        char* arena = static_cast<char*>(sodium_malloc(capacity));
+        if (!arena)
+            return false;
+        if (used > 0)
+            memcpy(arena, m_arena, used);
+        sodium_free(m_arena);
+        m_arena = arena;
+        m_capacity = capacity;
+    }
+    if (length > 0)
+        memcpy(m_arena + used, password, length);
+    m_offsets.push_back(static_cast<uint32_t>(used + length));
+    return true;
+}
+
+/**
+ * Wipes all passwords of the history.
+ */
+void PasswordHistory::clear() {
+    if (m_arena)
+        sodium_memzero(m_arena, m_offsets.back());
+    m_offsets.assign(1, 0);
+}
+
+/**
+ * Returns the number of passwords in the history.
+ *
+ * \return The number of passwords
+ */
+size_t PasswordHistory::size() const {
+    return m_offsets.size() - 1;
+}
+
+/**
+ * Returns the password with the index \p index.
+ *
+ * \param index The index of the password, 0 for the first password
+ * \return A copy of the password
+ */
+std::string PasswordHistory::get(size_t index) const {
+    return std::string(m_arena + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+}
+
+/**
+ * Returns the first character of all passwords, stored back to back.
+ *
+ * \return Pointer to the arena
+ */
+const char* PasswordHistory::data() const {
+    return m_arena;
+}
+
+/**
+ * Returns the position of the password with the index \p index in the
+ * arena. The position of the password after the last one is the number
+ * of bytes used by all passwords.
+ *
+ * \param index The index of the password, from 0 to \p size()
+ * \return The position of its first character
+ */
+size_t PasswordHistory::getOffset(size_t index) const {
+    return m_offsets[index];
+}
+
+/**
+ * Returns the index of the password holding the character at the
+ * position \p position of the arena.
+ *
+ * \param position The position of the character
+ * \return The index of the password
+ */
+size_t PasswordHistory::findEntry(size_t position) const {
+    // the last password starting at or before the position; empty passwords
+    // start where the next one starts
+    const auto next = std::upper_bound(m_offsets.begin(), m_offsets.end(),
+        static_cast<uint32_t>(position));
+    return static_cast<size_t>(next - m_offsets.begin()) - 1;
+}
+
+/**
+ * Constructor of \p HistorySearch. Creates a search without search
+ * string that has not seen any password yet.
+ */
+HistorySearch::HistorySearch() : m_searched(0) {
+}
+
+/**
+ * Searches for the passwords of \p history containing \p needle.
+ *
+ * \param history The history to search
+ * \param needle The search string (empty for all passwords)
+ */
+void HistorySearch::setNeedle(const PasswordHistory& history, const std::string& needle) {
+    if (needle == m_needle) {
+        update(history);
+        return;
+    }
+
+    // a search string refined before, e.g. when deleting the characters
+    // typed last, gets its result back
+    for (size_t i = m_previous.size(); i-- > 0;) {
+        if (m_previous[i].needle != needle)
+            continue;
+        m_needle.swap(m_previous[i].needle);
+        m_matches.swap(m_previous[i].matches);
+        m_searched = m_previous[i].searched;
+        m_previous.erase(m_previous.begin() + i, m_previous.end());
+        update(history);
+        return;
+    }
+
+    const bool refine = !m_needle.empty() && needle.find(m_needle) != std::string::npos;
+    if (refine)
+        m_previous.push_back(Result(m_needle, m_matches, m_searched));
+    else
+        m_previous.clear();
+    m_needle = needle;
+    if (m_needle.empty()) {
+        m_matches.clear();
+        m_searched = history.size();
+        return;
+    }
+    if (!refine) {
+        m_matches.clear();
+        scan(history, 0);
+        return;
+    }
+
+    // every password containing the new search string contains the old one
+    const char* arena = history.data();
+    auto kept = m_matches.begin();
+    for (const uint32_t entry : m_matches) {
+        const size_t begin = history.getOffset(entry);
+        if (memmem(arena + begin, history.getOffset(entry + 1) - begin,
+            m_needle.data(), m_needle.size()))
+            *kept++ = entry;
+    }
+    m_matches.erase(kept, m_matches.end());
+    update(history);
+}
+
+/**
+ * Searches the passwords added to \p history since the last search. If the
+ * history was cleared in the meantime, it is searched again completely.
+ *
+ * \param history The history to search
+ * \return The number of passwords added to the result
+ */
+size_t HistorySearch::update(const PasswordHistory& history) {
+    if (history.size() < m_searched) {
+        m_matches.clear();
+        m_searched = 0;
+    }
+    const size_t before = size();
+    if (m_needle.empty())
+        m_searched = history.size();
+    else
+        scan(history, m_searched);
+    return size() - before;
+}
+
+/**
+ * Returns the number of passwords found.
+ *
+ * \return The number of passwords found
+ */
+size_t HistorySearch::size() const {
+    return m_needle.empty() ? m_searched : m_matches.size();
+}
+
+/**
+ * Returns the index in the history of the password found at position
+ * \p row of the result.
+ *
+ * \param row The position in the result, from 0 to \p size() - 1
+ * \return The index of the password
+ */
+size_t HistorySearch::getEntry(size_t row) const {
+    return m_needle.empty() ? row : m_matches[row];
+}
+
+/**
+ * Returns the search string.
+ *
+ * \return The search string
+ */
+const std::string& HistorySearch::getNeedle() const {
+    return m_needle;
+}
+
+/**
+ * Appends the passwords from \p first on containing the search string to
+ * the result. A single \p memmem() runs over all passwords; an occurrence
+ * reaching into the next password means that no later occurrence fits
+ * into the password either, so the search goes on with the next one.
+ *
+ * \param history The history to search
+ * \param first The index of the first password to search
+ */
+void HistorySearch::scan(const PasswordHistory& history, size_t first) {
+    const char* arena = history.data();
+    const size_t count = history.size();
+    const size_t end = history.getOffset(count);
+    size_t entry = first;
+    while (entry < count) {
+        const size_t begin = history.getOffset(entry);
+        const char* found = static_cast<const char*>(memmem(arena + begin,
+            end - begin, m_needle.data(), m_needle.size()));
+        if (!found)
+            break;
+        const size_t position = static_cast<size_t>(found - arena);
+        entry = history.findEntry(position);
+        if (position + m_needle.size() <= history.getOffset(entry + 1))
+            m_matches.push_back(static_cast<uint32_t>(entry));
+        entry++;
+    }
+    m_searched = count;
+}
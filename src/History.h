@@ -0,0 +1,230 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    History.h
+ * \brief   Defines classes storing and searching the generated passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines classes storing and searching the passwords generated
+ * in a session. The passwords are stored back to back in a single arena
+ * allocated with \p sodium_malloc(), so the history is locked into RAM and
+ * wiped when it grows or is freed, and an array of offsets marks where every
+ * password starts. A million passwords of 16 characters need 20 MB of
+ * characters and offsets, while a \p std::vector of \p std::string needs
+ * more than 60 MB.
+ *
+ * A search runs \p memmem() over the whole arena instead of over every
+ * password, and refines the previous result while the user types: if the
+ * new search string contains the old one, only the passwords found before
+ * are checked again. The results refined are kept, so deleting the
+ * characters typed last restores them without searching.
+ */
+
+#ifndef GTKPASS_HISTORY_H
+#define GTKPASS_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Initial size of the arena of \p PasswordHistory in bytes
+#define HISTORY_INITIAL_CAPACITY 4096
+
+/**
+ * Passwords generated in a session, stored back to back in a single arena
+ * of locked memory that is wiped when it grows or is freed.
+ */
+class PasswordHistory {
+
+public:
+    /**
+     * Constructor of \p PasswordHistory. Creates an empty history.
+     */
+    PasswordHistory();
+
+    /**
+     * Destructor of \p PasswordHistory. Wipes and frees the arena.
+     */
+    ~PasswordHistory();
+
+    /**
+     * Appends \p password to the history.
+     *
+     * \param password The password
+     * \return \p true if the password was added, \p false if the history
+     * holds 4 GiB of passwords or memory is exhausted
+     */
+    bool add(const std::string& password);
+
+    /**
+     * Appends the \p length characters at \p password to the history.
+     *
+     * \param password The characters of the password
+     * \param length The number of characters
+     * \return \p true if the password was added, \p false if the history
+     * holds 4 GiB of passwords or memory is exhausted
+     */
+    bool add(const char* password, size_t length);
+
+    /**
+     * Wipes all passwords of the history.
+     */
+    void clear();
+
+    /**
+     * Returns the number of passwords in the history.
+     *
+     * \return The number of passwords
+     */
+    size_t size() const;
+
+    /**
+     * Returns the password with the index \p index.
+     *
+     * \param index The index of the password, 0 for the first password
+     * \return A copy of the password
+     */
+    std::string get(size_t index) const;
+
+    /**
+     * Returns the first character of all passwords, stored back to back.
+     *
+     * \return Pointer to the arena
+     */
+    const char* data() const;
+
+    /**
+     * Returns the position of the password with the index \p index in the
+     * arena. The position of the password after the last one is the number
+     * of bytes used by all passwords.
+     *
+     * \param index The index of the password, from 0 to \p size()
+     * \return The position of its first character
+     */
+    size_t getOffset(size_t index) const;
+
+    /**
+     * Returns the index of the password holding the character at the
+     * position \p position of the arena.
+     *
+     * \param position The position of the character
+     * \return The index of the password
+     */
+    size_t findEntry(size_t position) const;
+
+private:
+    PasswordHistory(const PasswordHistory&) = delete;
+    PasswordHistory& operator=(const PasswordHistory&) = delete;
+
+    /// the passwords, allocated with \p sodium_malloc()
+    char* m_arena;
+    /// size of the arena in bytes
+    size_t m_capacity;
+    /// position of the first character of every password, followed by the
+    /// number of bytes used
+    std::vector<uint32_t> m_offsets;
+
+}; // end of class PasswordHistory
+
+/**
+ * Search for the passwords of a \p PasswordHistory containing a string. The
+ * result is updated incrementally: passwords added to the history are only
+ * searched once, and a search string containing the previous one only checks
+ * the passwords found before. Without search string, all passwords match.
+ */
+class HistorySearch {
+
+public:
+    /**
+     * Constructor of \p HistorySearch. Creates a search without search
+     * string that has not seen any password yet.
+     */
+    HistorySearch();
+
+    /**
+     * Searches for the passwords of \p history containing \p needle.
+     *
+     * \param history The history to search
+     * \param needle The search string (empty for all passwords)
+     */
+    void setNeedle(const PasswordHistory& history, const std::string& needle);
+
+    /**
+     * Searches the passwords added to \p history since the last search. If the
+     * history was cleared in the meantime, it is searched again completely.
+     *
+     * \param history The history to search
+     * \return The number of passwords added to the result
+     */
+    size_t update(const PasswordHistory& history);
+
+    /**
+     * Returns the number of passwords found.
+     *
+     * \return The number of passwords found
+     */
+    size_t size() const;
+
+    /**
+     * Returns the index in the history of the password found at position
+     * \p row of the result.
+     *
+     * \param row The position in the result, from 0 to \p size() - 1
+     * \return The index of the password
+     */
+    size_t getEntry(size_t row) const;
+
+    /**
+     * Returns the search string.
+     *
+     * \return The search string
+     */
+    const std::string& getNeedle() const;
+
+private:
+    /// Result of a search string
+    struct Result {
+        /// Initializes the result with the given values
+        Result(const std::string& needle, const std::vector<uint32_t>& matches,
+            size_t searched) : needle(needle), matches(matches), searched(searched) {}
+        /// the search string
+        std::string needle;
+        /// the indices of the passwords found
+        std::vector<uint32_t> matches;
+        /// number of passwords searched
+        size_t searched;
+    };
+
+    /// Appends the passwords from \p first on containing the search string
+    void scan(const PasswordHistory& history, size_t first);
+
+    /// the search string
+    std::string m_needle;
+    /// the indices of the passwords found, unused without search string
+    std::vector<uint32_t> m_matches;
+    /// number of passwords searched
+    size_t m_searched;
+    /// the results of the search strings refined by the current one, the
+    /// last one refined last
+    std::vector<Result> m_previous;
+
+}; // end of class HistorySearch
+
+#endif
@@ -0,0 +1,408 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    HistoryModel.cpp
+ * \brief   Implements a tree model showing the password history.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a tree model showing the password history.
+ */
+
+#include "HistoryModel.h"
+#include "sodium.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Constructor of \p HistoryModel. Use \p create() instead.
+ *
+ * \param history The history to show
+ */
+HistoryModel::HistoryModel(const PasswordHistory& history) :
+    Glib::ObjectBase(typeid(HistoryModel)), Glib::Object(), m_history(history),
+    m_search(), m_rowCount(0), m_columns(), m_stamp(1), m_visible(false) {
+    m_search.update(m_history);
+    m_rowCount = m_search.size();
+}
+
+/**
+ * Creates a model of the passwords in \p history, which must outlive
+ * the model.
+ *
+ * \param history The history to show
+ * \return \p Glib::RefPtr to the new model
+ */
+Glib::RefPtr<HistoryModel> HistoryModel::create(const PasswordHistory& history) {
+    return Glib::RefPtr<HistoryModel>(new HistoryModel(history));
+}
+
+/**
+ * Returns the columns of the model.
+ *
+ * \return The columns
+ */
+const HistoryModel::Columns& HistoryModel::getColumns() const {
+    return m_columns;
+}
+
+/**
+ * Shows the passwords added to the history since the last call, if they
+ * contain the search string, and emits a \p row_inserted signal for
+ * every new row.
+ */
+void HistoryModel::update() {
+    const size_t before = m_search.size();
+    m_search.update(m_history);
+    for (size_t row = before; row < m_search.size(); row++) {
+        m_rowCount++;
+        iterator iter;
+        setRow(iter, row);
+        Path path;
+        path.push_back(static_cast<int>(row));
+        row_inserted(path, iter);
+    }
+}
+
+/**
+ * Shows the passwords containing \p needle. If at most
+ * \p HISTORY_MAX_ROW_CHANGES rows are removed and added, a \p row_deleted or
+ * \p row_inserted signal is emitted for each of them. Otherwise no signal is
+ * emitted and views have to be detached from the model and attached again
+ * right away.
+ *
+ * Both results list the passwords in the order of the history, so merging
+ * them finds the changed rows. The removed rows are reported back to front
+ * and the added rows front to back, so every signal names the position of
+ * the row in the list the views know at that moment.
+ *
+ * \param needle The search string (empty for all passwords)
+ * \return \p true if the views were told about the changed rows, \p false
+ * if they have to be attached again
+ */
+bool HistoryModel::setNeedle(const std::string& needle) {
+    // the passwords shown before; without search string all of them
+    const bool all = m_search.getNeedle().empty();
+    const size_t before = m_search.size();
+    std::vector<uint32_t> previous;
+    if (!all) {
+        previous.reserve(before);
+        for (size_t row = 0; row < before; row++) {
+            previous.push_back(static_cast<uint32_t>(m_search.getEntry(row)));
+        }
+    }
+    m_search.setNeedle(m_history, needle);
+    // iterators of the old rows are invalid
+    m_stamp++;
+
+    const size_t after = m_search.size();
+    std::vector<size_t> removed;
+    std::vector<size_t> added;
+    bool small = std::max(before, after) - std::min(before, after) <= HISTORY_MAX_ROW_CHANGES;
+    size_t i = 0;
+    size_t j = 0;
+    while (small && (i < before || j < after)) {
+        const size_t old = i < before ? (all ? i : previous[i]) : SIZE_MAX;
+        const size_t now = j < after ? m_search.getEntry(j) : SIZE_MAX;
+        if (old == now) {
+            i++;
+            j++;
+        } else if (old < now) {
+            removed.push_back(i++);
+        } else {
+            added.push_back(j++);
+        }
+        small = removed.size() + added.size() <= HISTORY_MAX_ROW_CHANGES;
+    }
+    if (!small) {
+        m_rowCount = after;
+        return false;
+    }
+
+    for (auto row = removed.rbegin(); row != removed.rend(); ++row) {
+        m_rowCount--;
+        Path path;
+        path.push_back(static_cast<int>(*row));
+        row_deleted(path);
+    }
+    for (const size_t row : added) {
+        m_rowCount++;
+        iterator iter;
+        setRow(iter, row);
+        Path path;
+        path.push_back(static_cast<int>(row));
+        row_inserted(path, iter);
+    }
+    return true;
+}
+
+/**
+ * Shows the passwords as text or as bullets. Views have to be redrawn.
+ *
+ * \param visible \p true to show the passwords as text
+ */
+void HistoryModel::setVisibility(bool visible) {
+    m_visible = visible;
+}
+
+/**
+ * Returns the index in the history of the password in the row of
+ * \p iter.
+ *
+ * \param iter The row
+ * \param entry Receives the index of the password
+ * \return \p true if \p iter is a valid row, \p false otherwise
+ */
+bool HistoryModel::getEntry(const iterator& iter, size_t& entry) const {
+    size_t row;
+    if (!getRow(iter, row))
+        return false;
+    entry = m_search.getEntry(row);
+    return true;
+}
+
+/**
+ * Returns the flags of the model: a flat list whose iterators stay valid
+ * while passwords are added.
+ *
+ * \return The flags
+ */
+Gtk::TreeModelFlags HistoryModel::get_flags_vfunc() const {
+    return Gtk::TREE_MODEL_LIST_ONLY | Gtk::TREE_MODEL_ITERS_PERSIST;
+}
+
+/**
+ * Returns the number of columns.
+ *
+ * \return The number of columns
+ */
+int HistoryModel::get_n_columns_vfunc() const {
+    return static_cast<int>(m_columns.size());
+}
+
+/**
+ * Returns the type of the column \p index.
+ *
+ * \param index The index of the column
+ * \return The type of the column
+ */
+GType HistoryModel::get_column_type_vfunc(int index) const {
+    return m_columns.types()[index];
+}
+
+/**
+ * Reads the value of the column \p column of the row \p iter from the
+ * history into \p value. Hidden passwords are shown as a bullet per
+ * character. Only the first \p HISTORY_DISPLAY_LENGTH characters are shown,
+ * followed by an ellipsis if the password is longer.
+ *
+ * \param iter The row
+ * \param column The index of the column
+ * \param value Receives the value
+ */
+void HistoryModel::get_value_vfunc(const iterator& iter, int column,
+    Glib::ValueBase& value) const {
+    size_t entry;
+    if (!getEntry(iter, entry))
+        return;
+    if (column == m_columns.number.index()) {
+        Glib::Value<unsigned int> number;
+        number.init(Glib::Value<unsigned int>::value_type());
+        number.set(static_cast<unsigned int>(entry + 1));
+        value.init(Glib::Value<unsigned int>::value_type());
+        value = number;
+    } else if (column == m_columns.password.index()) {
+        Glib::Value<Glib::ustring> password;
+        password.init(Glib::Value<Glib::ustring>::value_type());
+        const size_t offset = m_history.getOffset(entry);
+        const size_t length = m_history.getOffset(entry + 1) - offset;
+        const size_t shown = std::min<size_t>(length, HISTORY_DISPLAY_LENGTH);
+        if (m_visible) {
+            std::string text(m_history.data() + offset, shown);
+            if (shown < length)
+                text += "\u2026";
+            password.set(text);
+            sodium_memzero(&text[0], text.size());
+        } else {
+            Glib::ustring bullets(shown, gunichar(0x25CF));
+            if (shown < length)
+                bullets += gunichar(0x2026);
+            password.set(bullets);
+        }
+        value.init(Glib::Value<Glib::ustring>::value_type());
+        value = password;
+    }
+}
+
+/**
+ * Moves to the row after \p iter.
+ *
+ * \param iter The row
+ * \param iter_next Receives the next row
+ * \return \p true if there is a next row, \p false otherwise
+ */
+bool HistoryModel::iter_next_vfunc(const iterator& iter, iterator& iter_next) const {
+    size_t row;
+    if (!getRow(iter, row))
+        return setRow(iter_next, m_rowCount);
+    return setRow(iter_next, row + 1);
+}
+
+/**
+ * Returns the first child of \p parent, which only exists for the root of
+ * the list.
+ *
+ * \param parent The parent row
+ * \param iter Receives the first child
+ * \return \p false, as rows have no children
+ */
+bool HistoryModel::iter_children_vfunc(const iterator& parent, iterator& iter) const {
+    (void) parent;
+    return setRow(iter, m_rowCount);
+}
+
+/**
+ * Returns whether \p iter has children.
+ *
+ * \param iter The row
+ * \return \p false, as rows have no children
+ */
+bool HistoryModel::iter_has_child_vfunc(const iterator& iter) const {
+    (void) iter;
+    return false;
+}
+
+/**
+ * Returns the number of children of \p iter.
+ *
+ * \param iter The row
+ * \return 0, as rows have no children
+ */
+int HistoryModel::iter_n_children_vfunc(const iterator& iter) const {
+    (void) iter;
+    return 0;
+}
+
+/**
+ * Returns the number of rows.
+ *
+ * \return The number of passwords found
+ */
+int HistoryModel::iter_n_root_children_vfunc() const {
+    return static_cast<int>(m_rowCount);
+}
+
+/**
+ * Returns the child \p n of \p parent.
+ *
+ * \param parent The parent row
+ * \param n The index of the child
+ * \param iter Receives the child
+ * \return \p false, as rows have no children
+ */
+bool HistoryModel::iter_nth_child_vfunc(const iterator& parent, int n, iterator& iter) const {
+    (void) parent;
+    (void) n;
+    return setRow(iter, m_rowCount);
+}
+
+/**
+ * Returns the row \p n.
+ *
+ * \param n The index of the row
+ * \param iter Receives the row
+ * \return \p true if there is such a row, \p false otherwise
+ */
+bool HistoryModel::iter_nth_root_child_vfunc(int n, iterator& iter) const {
+    return setRow(iter, n < 0 ? m_rowCount : static_cast<size_t>(n));
+}
+
+/**
+ * Returns the parent of \p child.
+ *
+ * \param child The row
+ * \param iter Receives the parent
+ * \return \p false, as all rows are at the top level
+ */
+bool HistoryModel::iter_parent_vfunc(const iterator& child, iterator& iter) const {
+    (void) child;
+    return setRow(iter, m_rowCount);
+}
+
+/**
+ * Returns the path of the row \p iter.
+ *
+ * \param iter The row
+ * \return The path of the row, empty if \p iter is invalid
+ */
+Gtk::TreeModel::Path HistoryModel::get_path_vfunc(const iterator& iter) const {
+    Path path;
+    size_t row;
+    if (getRow(iter, row))
+        path.push_back(static_cast<int>(row));
+    return path;
+}
+
+/**
+ * Returns the row of the path \p path.
+ *
+ * \param path The path
+ * \param iter Receives the row
+ * \return \p true if there is such a row, \p false otherwise
+ */
+bool HistoryModel::get_iter_vfunc(const Path& path, iterator& iter) const {
+    if (path.size() != 1 || path[0] < 0)
+        return setRow(iter, m_rowCount);
+    return setRow(iter, static_cast<size_t>(path[0]));
+}
+
+/**
+ * Makes \p iter point to the row \p row, or invalidates it if there is no
+ * such row. The row is stored in the iterator itself, so no memory is
+ * needed per row.
+ *
+ * \param iter The iterator
+ * \param row The row
+ * \return \p true if there is such a row, \p false otherwise
+ */
+bool HistoryModel::setRow(iterator& iter, size_t row) const {
+    if (row >= m_rowCount) {
+        iter.set_stamp(0);
+        iter.gobj()->user_data = nullptr;
+        return false;
+    }
+    iter.set_stamp(m_stamp);
+    iter.gobj()->user_data = GSIZE_TO_POINTER(row);
+    return true;
+}
+
+/**
+ * Returns the row \p iter points to.
+ *
+ * \param iter The iterator
+ * \param row Receives the row
+ * \return \p true if \p iter points to a current row, \p false otherwise
+ */
+bool HistoryModel::getRow(const iterator& iter, size_t& row) const {
+    if (iter.get_stamp() != m_stamp)
+        return false;
+    row = GPOINTER_TO_SIZE(iter.gobj()->user_data);
+    // while rows are reported, the views may know rows that were removed
+    return row < m_rowCount && row < m_search.size();
+}
@@ -0,0 +1,170 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    HistoryModel.h
+ * \brief   Defines a tree model showing the password history.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a \p Gtk::TreeModel presenting the result of a
+ * \p HistorySearch over a \p PasswordHistory as a flat list. The model does
+ * not copy any password: a row only consists of its position, which is
+ * stored in the tree iterator, and the cells are read from the history when
+ * a \p Gtk::TreeView in fixed height mode draws the visible rows.
+ */
+
+#ifndef GTKPASS_HISTORYMODEL_H
+#define GTKPASS_HISTORYMODEL_H
+
+#include "History.h"
+#include <gtkmm.h>
+
+/// Number of characters of a password shown in a row; longer passwords are
+/// cut off, so a key of a megabyte does not have to be laid out
+#define HISTORY_DISPLAY_LENGTH 256
+
+/// Maximum number of rows removed and added by a new search string that are
+/// reported to the views one by one; beyond that, attaching the model again
+/// is faster
+#define HISTORY_MAX_ROW_CHANGES 4096
+
+/**
+ * List model of the passwords of a \p PasswordHistory found by a search,
+ * with a column for the number of the password and one for the password.
+ */
+class HistoryModel : public Glib::Object, public Gtk::TreeModel {
+
+public:
+    /// The columns of the model
+    struct Columns : public Gtk::TreeModelColumnRecord {
+        /// Adds the columns to the record
+        Columns() {
+            add(number);
+            add(password);
+        }
+        /// number of the password, 1 for the first password
+        Gtk::TreeModelColumn<unsigned int> number;
+        /// the password, or bullets if the passwords are hidden
+        Gtk::TreeModelColumn<Glib::ustring> password;
+    };
+
+    /**
+     * Creates a model of the passwords in \p history, which must outlive
+     * the model.
+     *
+     * \param history The history to show
+     * \return \p Glib::RefPtr to the new model
+     */
+    static Glib::RefPtr<HistoryModel> create(const PasswordHistory& history);
+
+    /**
+     * Returns the columns of the model.
+     *
+     * \return The columns
+     */
+    const Columns& getColumns() const;
+
+    /**
+     * Shows the passwords added to the history since the last call, if they
+     * contain the search string, and emits a \p row_inserted signal for
+     * every new row.
+     */
+    void update();
+
+    /**
+     * Shows the passwords containing \p needle. If at most
+     * \p HISTORY_MAX_ROW_CHANGES rows are removed and added, a
+     * \p row_deleted or \p row_inserted signal is emitted for each of them.
+     * Otherwise no signal is emitted and views have to be detached from the
+     * model and attached again right away.
+     *
+     * \param needle The search string (empty for all passwords)
+     * \return \p true if the views were told about the changed rows,
+     * \p false if they have to be attached again
+     */
+    bool setNeedle(const std::string& needle);
+
+    /**
+     * Shows the passwords as text or as bullets. Views have to be redrawn.
+     *
+     * \param visible \p true to show the passwords as text
+     */
+    void setVisibility(bool visible);
+
+    /**
+     * Returns the index in the history of the password in the row of
+     * \p iter.
+     *
+     * \param iter The row
+     * \param entry Receives the index of the password
+     * \return \p true if \p iter is a valid row, \p false otherwise
+     */
+    bool getEntry(const iterator& iter, size_t& entry) const;
+
+protected:
+    /**
+     * Constructor of \p HistoryModel. Use \p create() instead.
+     *
+     * \param history The history to show
+     */
+    explicit HistoryModel(const PasswordHistory& history);
+
+    Gtk::TreeModelFlags get_flags_vfunc() const override;
+    int get_n_columns_vfunc() const override;
+    GType get_column_type_vfunc(int index) const override;
+    void get_value_vfunc(const iterator& iter, int column,
+        Glib::ValueBase& value) const override;
+    bool iter_next_vfunc(const iterator& iter, iterator& iter_next) const override;
+    bool iter_children_vfunc(const iterator& parent, iterator& iter) const override;
+    bool iter_has_child_vfunc(const iterator& iter) const override;
+    int iter_n_children_vfunc(const iterator& iter) const override;
+    int iter_n_root_children_vfunc() const override;
+    bool iter_nth_child_vfunc(const iterator& parent, int n, iterator& iter) const override;
+    bool iter_nth_root_child_vfunc(int n, iterator& iter) const override;
+    bool iter_parent_vfunc(const iterator& child, iterator& iter) const override;
+    Path get_path_vfunc(const iterator& iter) const override;
+    bool get_iter_vfunc(const Path& path, iterator& iter) const override;
+
+private:
+    HistoryModel(const HistoryModel&) = delete;
+    HistoryModel& operator=(const HistoryModel&) = delete;
+
+    /// Makes \p iter point to the row \p row, or invalidates it if there is
+    /// no such row
+    bool setRow(iterator& iter, size_t row) const;
+    /// Returns the row of \p iter, or \p false if it is invalid
+    bool getRow(const iterator& iter, size_t& row) const;
+
+    /// the history shown
+    const PasswordHistory& m_history;
+    /// the rows shown
+    HistorySearch m_search;
+    /// number of rows the views know of, which differs from the rows found
+    /// while the changed rows are reported
+    size_t m_rowCount;
+    /// the columns
+    Columns m_columns;
+    /// identifies the iterators of the current rows; changed whenever all
+    /// rows change
+    int m_stamp;
+    /// whether the passwords are shown as text
+    bool m_visible;
+
+}; // end of class HistoryModel
+
+#endif
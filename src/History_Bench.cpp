@@ -0,0 +1,88 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    History_Bench.cpp
+ * \brief   Benchmarks the files \p History.h and \p History.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p History.h and \p History.cpp.
+ */
+
+#include "Benchmark.h"
+#include "History.h"
+#include "BatchGenerator.h"
+#include <iomanip>
+
+/// Number of passwords in the history
+static const size_t HISTORY_PASSWORDS = 1000000;
+/// Length of the passwords in the history
+static const unsigned int HISTORY_LENGTH = 16;
+
+/// Writes the time of \p label in \p nanoseconds and the number of passwords
+/// found to \p out
+static void printSearch(std::ostream& out, const std::string& label,
+    uint64_t nanoseconds, size_t found) {
+    out << std::left << std::setw(24) << label << std::right << std::fixed
+        << std::setprecision(3) << std::setw(10) << nanoseconds / 1e6 << " ms  "
+        << std::setw(8) << found << " found" << std::endl;
+}
+
+/// Fills a history with a million passwords and measures the search after
+/// every keystroke of typing and deleting a search string
+BENCHMARK_CASE(history_search) {
+    genopts options;
+    const std::vector<std::string> passwords = generateBatch(
+        std::vector<genjob>(1, genjob(options, HISTORY_LENGTH, HISTORY_PASSWORDS)));
+
+    PasswordHistory history;
+    uint64_t start = getNanoseconds();
+    for (const auto& password : passwords) {
+        history.add(password);
+    }
+    const uint64_t adding = getNanoseconds() - start;
+    out << "added " << HISTORY_PASSWORDS << " passwords in " << std::fixed
+        << std::setprecision(1) << adding / 1e6 << " ms, "
+        << history.getOffset(history.size()) / 1048576.0 << " MiB of characters"
+        << std::endl;
+
+    // typing a part of a password and deleting it again
+    const std::string typed = passwords[HISTORY_PASSWORDS / 2].substr(3, 5);
+    std::vector<std::string> needles;
+    for (size_t i = 1; i <= typed.size(); i++) {
+        needles.push_back(typed.substr(0, i));
+    }
+    for (size_t i = typed.size() - 1; i > 0; i--) {
+        needles.push_back(typed.substr(0, i));
+    }
+    needles.push_back("");
+
+    HistorySearch search;
+    search.update(history);
+    for (const auto& needle : needles) {
+        start = getNanoseconds();
+        search.setNeedle(history, needle);
+        printSearch(out, "\"" + needle + "\"", getNanoseconds() - start, search.size());
+    }
+
+    search.setNeedle(history, typed.substr(0, 2));
+    history.add(typed);
+    start = getNanoseconds();
+    search.update(history);
+    printSearch(out, "one password added", getNanoseconds() - start, search.size());
+}
@@ -0,0 +1,170 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    History_Test.cpp
+ * \brief   Tests the files \p History.h and \p History.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p History.h and \p History.cpp.
+ */
+
+#include "catch.hpp"
+#include "History.h"
+#include "RandomGenerator.h"
+
+/// Returns the indices of the passwords found by \p search
+static std::vector<size_t> getEntries(const HistorySearch& search) {
+    std::vector<size_t> entries;
+    for (size_t row = 0; row < search.size(); row++) {
+        entries.push_back(search.getEntry(row));
+    }
+    return entries;
+}
+
+/// Returns the indices of the passwords of \p history containing \p needle,
+/// found by comparing every password
+static std::vector<size_t> findNaive(const PasswordHistory& history,
+    const std::string& needle) {
+    std::vector<size_t> entries;
+    for (size_t i = 0; i < history.size(); i++) {
+        if (history.get(i).find(needle) != std::string::npos)
+            entries.push_back(i);
+    }
+    return entries;
+}
+
+/// Tests the class \p PasswordHistory
+TEST_CASE("PasswordHistory", "[History]") {
+    PasswordHistory history;
+    REQUIRE(history.size() == 0);
+    REQUIRE(history.getOffset(0) == 0);
+
+    const std::vector<std::string> passwords = {"abc", "", "de", "fghij"};
+    for (const auto& password : passwords) {
+        REQUIRE(history.add(password));
+    }
+    REQUIRE(history.size() == 4);
+    for (size_t i = 0; i < passwords.size(); i++) {
+        REQUIRE(history.get(i) == passwords[i]);
+    }
+    REQUIRE(std::string(history.data(), history.getOffset(4)) == "abcdefghij");
+    REQUIRE(history.findEntry(0) == 0);
+    REQUIRE(history.findEntry(2) == 0);
+    REQUIRE(history.findEntry(3) == 2);
+    REQUIRE(history.findEntry(5) == 3);
+    REQUIRE(history.findEntry(9) == 3);
+
+    SECTION("Growing") {
+        // the arena is moved several times
+        std::vector<std::string> added;
+        genopts options;
+        for (size_t i = 0; i < 2000; i++) {
+            added.push_back(getRandomString(1 + i % 40, options));
+            REQUIRE(history.add(added.back()));
+        }
+        REQUIRE(history.size() == 2004);
+        for (size_t i = 0; i < added.size(); i++) {
+            REQUIRE(history.get(4 + i) == added[i]);
+        }
+    }
+
+    SECTION("Clear") {
+        history.clear();
+        REQUIRE(history.size() == 0);
+        REQUIRE(history.add("xyz"));
+        REQUIRE(history.get(0) == "xyz");
+    }
+}
+
+/// Tests the class \p HistorySearch
+TEST_CASE("HistorySearch", "[History]") {
+    PasswordHistory history;
+    for (const char* password : {"abc", "", "cde", "abcd", "bcab", "xbc", "ab"}) {
+        history.add(password);
+    }
+    HistorySearch search;
+    REQUIRE(search.size() == 0);
+    REQUIRE(search.update(history) == 7);
+    REQUIRE(getEntries(search) == std::vector<size_t>({0, 1, 2, 3, 4, 5, 6}));
+
+    SECTION("No match across passwords") {
+        // "abc" + "" + "cde" contains "cc" and "abccde" only across passwords
+        search.setNeedle(history, "cc");
+        REQUIRE(search.size() == 0);
+        search.setNeedle(history, "abccde");
+        REQUIRE(search.size() == 0);
+        search.setNeedle(history, "bca");
+        REQUIRE(getEntries(search) == std::vector<size_t>({4}));
+    }
+
+    SECTION("Typing and deleting") {
+        for (const std::string needle : {"b", "bc", "abc", "abcd", "abc", "c", ""}) {
+            search.setNeedle(history, needle);
+            REQUIRE(search.getNeedle() == needle);
+            REQUIRE(getEntries(search) == findNaive(history, needle));
+        }
+    }
+
+    SECTION("Added passwords") {
+        search.setNeedle(history, "bc");
+        REQUIRE(search.size() == 4);
+        history.add("zzz");
+        history.add("zbcz");
+        REQUIRE(search.update(history) == 1);
+        REQUIRE(search.getEntry(search.size() - 1) == 8);
+        search.setNeedle(history, "bcz");
+        REQUIRE(getEntries(search) == std::vector<size_t>({8}));
+    }
+
+    SECTION("Deleting after adding passwords") {
+        search.setNeedle(history, "b");
+        search.setNeedle(history, "bc");
+        search.setNeedle(history, "bca");
+        history.add("bxb");
+        history.add("bcb");
+        search.setNeedle(history, "bc");
+        REQUIRE(getEntries(search) == findNaive(history, "bc"));
+        search.setNeedle(history, "b");
+        REQUIRE(getEntries(search) == findNaive(history, "b"));
+        search.setNeedle(history, "bcb");
+        REQUIRE(getEntries(search) == std::vector<size_t>({8}));
+    }
+
+    SECTION("Cleared history") {
+        search.setNeedle(history, "a");
+        history.clear();
+        history.add("a");
+        REQUIRE(search.update(history) == 1);
+        REQUIRE(getEntries(search) == std::vector<size_t>({0}));
+    }
+
+    SECTION("Random passwords") {
+        genopts options;
+        options.bIncludeLettersUpper = false;
+        options.bIncludeNumbers = false;
+        for (size_t i = 0; i < 5000; i++) {
+            history.add(getRandomString(1 + i % 12, options));
+        }
+        for (const std::string needle : {"e", "ex", "exa", "q", "qu", "z", "zz"}) {
+            search.setNeedle(history, needle);
+            REQUIRE(getEntries(search) == findNaive(history, needle));
+        }
+    }
+}
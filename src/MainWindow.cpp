@@ -25,9 +25,54 @@
  */
 
 #include "MainWindow.h"
+#include "Probes.h"
+#include "SecureEntryBuffer.h"
+#include "Startup.h"
+#include <algorithm>
 #include <stdexcept>
 #include <cstring>
 #include <cmath>
+#include <glibmm/i18n.h>
+
+namespace {
+
+/**
+ * Adds the style sheet of \p GtkPass to the default screen. It is parsed and
+ * added only once, as every provider added to the screen is consulted for
+ * every widget until the end of the process.
+ */
+void addStyleSheet() {
+    static Glib::RefPtr<Gtk::CssProvider> css;
+    if (css)
+        return;
+    css = Gtk::CssProvider::create();
+    css->load_from_resource("/org/darth-revan/gtkpass/style.css");
+    Gtk::StyleContext::add_provider_for_screen(Gdk::Screen::get_default(), css,
+        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+}
+
+/**
+ * Returns the ranked word lists of the strength estimator. They are read from
+ * the resources once and shared by the estimators of all windows.
+ *
+ * \return The dictionaries
+ */
+const std::vector<std::shared_ptr<const Dictionary>>& getDictionaries() {
+    static std::vector<std::shared_ptr<const Dictionary>> dictionaries;
+    if (!dictionaries.empty())
+        return dictionaries;
+    for (const char* name : {"passwords", "english", "names"}) {
+        const auto words = Gio::Resource::lookup_data_global(
+            std::string("/org/darth-revan/gtkpass/dictionaries/") + name + ".txt");
+        gsize size = 0;
+        const char* data = static_cast<const char*>(words->get_data(size));
+        dictionaries.push_back(std::make_shared<const Dictionary>(name,
+            std::string(data, size)));
+    }
+    return dictionaries;
+}
+
+} // end of anonymous namespace
 
 /**
  * Constructor of \p GtkPassWindow. Initializes member variables and loads
@@ -45,10 +90,13 @@ GtkPassWindow::GtkPassWindow(
     m_optionIncludeDash(nullptr), m_optionIncludeSpace(nullptr),
     m_optionAvoidSimilar(nullptr),
     m_passwordLength(nullptr), m_passwordEntropy(nullptr),
-    m_entropyLevel(nullptr), m_passwordEntry(nullptr),
+    m_entropyLevel(nullptr), m_passwordEntry(nullptr), m_strengthValue(nullptr),
     m_btnShowPassword(nullptr), m_btnGeneratePassword(nullptr),
-    m_css(Gtk::CssProvider::create()), m_styleCtx(this->get_style_context()),
-    m_screen(Gdk::Screen::get_default()) {
+    m_longPasswordBox(nullptr), m_longPasswordView(nullptr),
+    m_longPasswordLabel(nullptr), m_btnCopyPassword(nullptr), m_historySearch(nullptr), m_historyView(nullptr), m_history(),
+    m_historyModel(HistoryModel::create(m_history)), m_breachIndex(nullptr), m_level(0), m_generator([this]() { m_generated.emit(); }),
+    m_longPassword(), m_dictionariesLoaded(false), m_afterPaint(0),
+    m_afterPaintClock(nullptr) {
 
     // store the length of the alphabet strings locally. This is just for
     // convenience and to increase performance. Here we calculate the length
@@ -121,6 +169,13 @@ GtkPassWindow::GtkPassWindow(
     if (!m_passwordEntry) {
         throw std::runtime_error("No \"entryPassword\" object in ui file!");
     }
+    // the text of the password field is kept in locked memory
+    m_passwordEntry->set_buffer(createSecureEntryBuffer());
+
+    m_refBuilder->get_widget("strengthValue", m_strengthValue);
+    if (!m_strengthValue) {
+        throw std::runtime_error("No \"strengthValue\" object in ui file!");
+    }
 
     m_refBuilder->get_widget("btnShowPassword", m_btnShowPassword);
     if (!m_btnShowPassword) {
@@ -132,6 +187,39 @@ GtkPassWindow::GtkPassWindow(
         throw std::runtime_error("No \"btnGeneratePassword\" object in ui file!");
     }
 
+    m_refBuilder->get_widget("longPasswordBox", m_longPasswordBox);
+    if (!m_longPasswordBox) {
+        throw std::runtime_error("No \"longPasswordBox\" object in ui file!");
+    }
+
+    m_refBuilder->get_widget("longPasswordView", m_longPasswordView);
+    if (!m_longPasswordView) {
+        throw std::runtime_error("No \"longPasswordView\" object in ui file!");
+    }
+
+    m_refBuilder->get_widget("longPasswordLabel", m_longPasswordLabel);
+    if (!m_longPasswordLabel) {
+        throw std::runtime_error("No \"longPasswordLabel\" object in ui file!");
+    }
+
+    m_refBuilder->get_widget("btnCopyPassword", m_btnCopyPassword);
+    if (!m_btnCopyPassword) {
+        throw std::runtime_error("No \"btnCopyPassword\" object in ui file!");
+    }
+
+    m_refBuilder->get_widget("historySearch", m_historySearch);
+    if (!m_historySearch) {
+        throw std::runtime_error("No \"historySearch\" object in ui file!");
+    }
+
+    m_refBuilder->get_widget("historyView", m_historyView);
+    if (!m_historyView) {
+        throw std::runtime_error("No \"historyView\" object in ui file!");
+    }
+
+    // the colors of the entropy levels are parsed once for all windows and
+    // selected by a style class of the level bar
+    addStyleSheet();
 
     // set the default options
     m_optionIncludeLowerCase->set_active(m_options.bIncludeLettersLower);
@@ -167,7 +255,8 @@ GtkPassWindow::GtkPassWindow(
 
     // initialization of password length spinbutton
     m_passwordLengthAdjustment = Gtk::Adjustment::create(
-        12.0, /* value */ 1.0, /* lower bound */ 100.0, /* upper bound */
+        12.0, /* value */ 1.0, /* lower bound */
+        MAX_PASSWORD_LENGTH, /* upper bound */
         1.0 /* step increment */
     );
     m_passwordLength->set_adjustment(m_passwordLengthAdjustment);
@@ -180,11 +269,77 @@ GtkPassWindow::GtkPassWindow(
     m_btnGeneratePassword->signal_clicked().connect(
         sigc::mem_fun(*this, &GtkPassWindow::generatePassword)
     );
+    // passwords are generated on a worker thread and handed over here
+    m_generated.connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_passwordGenerated)
+    );
     // add signal handler for clicking the toggle button
     m_btnShowPassword->signal_clicked().connect(
         sigc::mem_fun(*this, &GtkPassWindow::on_clickToggleButton)
     );
+    // add signal handler for changing the password
+    m_passwordEntry->signal_changed().connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_passwordChanged)
+    );
+    // add signal handler for copying a long password
+    m_btnCopyPassword->signal_clicked().connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_copyPassword)
+    );
+
+    // the columns of the history have a fixed size, so in fixed height mode
+    // the tree view only measures the rows it draws, even for millions of
+    // passwords
+    const HistoryModel::Columns& columns = m_historyModel->getColumns();
+    Gtk::TreeViewColumn* number = Gtk::manage(
+        new Gtk::TreeViewColumn(_("No."), columns.number));
+    number->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+    number->set_fixed_width(70);
+    m_historyView->append_column(*number);
+    Gtk::TreeViewColumn* password = Gtk::manage(
+        new Gtk::TreeViewColumn(_("Password"), columns.password));
+    password->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+    password->set_fixed_width(200);
+    password->set_expand(true);
+    Gtk::CellRendererText* renderer =
+        dynamic_cast<Gtk::CellRendererText*>(password->get_first_cell());
+    if (renderer) {
+        renderer->property_family() = "monospace";
+        renderer->property_ellipsize() = Pango::ELLIPSIZE_END;
+    }
+    m_historyView->append_column(*password);
+    m_historyView->set_fixed_height_mode(true);
+    m_historyView->set_model(m_historyModel);
+    m_historySearch->signal_search_changed().connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_historySearchChanged)
+    );
+    m_historyView->signal_row_activated().connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_historyRowActivated)
+    );
+    // the bulk generation dialog is opened from the application menu
+    add_action("bulk", sigc::mem_fun(*this, &GtkPassWindow::on_actionBulk));
+    // the dictionaries and the pool of passwords are not needed for the
+    // first frame
+    m_firstDraw = signal_draw().connect(
+        sigc::mem_fun(*this, &GtkPassWindow::on_firstDraw), false
+    );
     updateEntropy();
+    updateStrength();
+}
+
+/**
+ * Destructor of \p GtkPassWindow. Disconnects the handlers waiting for the
+ * first frame, which would otherwise be called with a dangling pointer if
+ * the window is destroyed before it was painted, and detaches the model of
+ * the history from the tree view, which outlives the history.
+ */
+GtkPassWindow::~GtkPassWindow() {
+    m_firstDraw.disconnect();
+    if (m_afterPaint != 0) {
+        g_signal_handler_disconnect(m_afterPaintClock, m_afterPaint);
+        g_object_unref(m_afterPaintClock);
+    }
+    m_historyView->unset_model();
+    m_strength.clear();
 }
 
 /**
@@ -199,18 +354,43 @@ GtkPassWindow::GtkPassWindow(
  */
 GtkPassWindow* GtkPassWindow::create() {
     auto refBuilder = Gtk::Builder::create_from_resource("/org/darth-revan/gtkpass/window.ui");
+    markStartup("builder");
     GtkPassWindow* window = nullptr;
     refBuilder->get_widget_derived("applicationWindow", window);
     if (!window) {
         throw std::runtime_error("No \"applicationWindow\" object in resource!");
     }
+    markStartup("window");
     return window;
 }
 
+/**
+ * Sets the index of breached passwords the contents of the password field
+ * are checked against whenever they change. The index must outlive the
+ * window.
+ *
+ * \param index Pointer to the index, or \p nullptr to disable the check
+ */
+void GtkPassWindow::setBreachIndex(const BreachIndex* index) {
+    m_breachIndex = index;
+    on_passwordChanged();
+}
+
+/**
+ * Returns the signal emitted once the first frame of the window was painted,
+ * e.g. for measuring the startup.
+ *
+ * \return The signal
+ */
+sigc::signal<void>& GtkPassWindow::signal_firstFrame() {
+    return m_firstFrame;
+}
+
 /**
  * Signal handler for changing the state of one of the checkboxes. Updates the
- * state of the member variable \p m_options. It also disables the generate
- * button if no options are chosen.
+ * state of the member variable \p m_options and refills the pool of
+ * prefetched passwords. It also disables the generate button if no options
+ * are chosen.
  */
 void GtkPassWindow::on_check() {
     m_options.bIncludeLettersLower = m_optionIncludeLowerCase->get_active();
@@ -231,17 +411,50 @@ void GtkPassWindow::on_check() {
         m_btnGeneratePassword->set_sensitive(false);
     }
 
+    // passwords prefetched or being generated with the old options are
+    // replaced
+    m_generator.prefetch(static_cast<uint32_t>(m_passwordLength->get_value()), m_options);
+    if (m_generator.isBusy()) {
+        if (m_btnGeneratePassword->get_sensitive())
+            generatePassword();
+        else
+            m_generator.cancel();
+    }
     updateEntropy();
 }
 
 /**
- * Signal handler for clicking the generate button. Generates a password
- * with the user's options and writes it into the password text field.
+ * Signal handler for clicking the generate button. Shows a prefetched
+ * password with the user's options right away, or requests one from the
+ * worker thread if the pool is empty; clicks while it is generated are
+ * merged into that request.
  */
 void GtkPassWindow::generatePassword() {
-    m_passwordEntry->set_text(
-        getRandomString(static_cast<uint32_t>(m_passwordLength->get_value()), m_options)
-    );
+    GTKPASS_PROBE(generate_password_entry);
+    const bool prefetched = m_generator.takePrefetched(
+        [this](const char* password, size_t length) {
+            // a password still being generated would replace this one
+            m_generator.cancel();
+            showPassword(password, length);
+        });
+    if (prefetched) {
+        GTKPASS_PROBE(generate_password_return);
+        return;
+    }
+    m_generator.request(static_cast<uint32_t>(m_passwordLength->get_value()), m_options);
+}
+
+/**
+ * Signal handler for a password generated by the worker thread. Writes the
+ * password into the password text field.
+ */
+void GtkPassWindow::on_passwordGenerated() {
+    const bool ready = m_generator.takePassword(
+        [this](const char* password, size_t length) {
+            showPassword(password, length);
+        });
+    if (ready)
+        GTKPASS_PROBE(generate_password_return);
 }
 
 /**
@@ -250,6 +463,9 @@ void GtkPassWindow::generatePassword() {
  */
 void GtkPassWindow::on_clickToggleButton() {
     m_passwordEntry->set_visibility(m_btnShowPassword->get_active());
+    updateLongPassword();
+    m_historyModel->setVisibility(m_btnShowPassword->get_active());
+    m_historyView->queue_draw();
 }
 
 /**
@@ -259,7 +475,8 @@ void GtkPassWindow::on_clickToggleButton() {
 void GtkPassWindow::updateEntropy() {
     double entropy {0};
     unsigned long value {};
-    std::string cssData;
+    int level {};
+    GTKPASS_PROBE(update_entropy_entry);
 
     // add length of alphabet strings
     if (m_options.bIncludeLettersLower)
@@ -282,10 +499,10 @@ void GtkPassWindow::updateEntropy() {
     // set character count in ui
     m_characterCount->set_text(std::to_string(static_cast<int>(entropy)));
 
-    // calculate entropy: entropy = log2(pow(numberOfChars, length))
+    // calculate entropy: entropy = log2(pow(numberOfChars, length)), in the
+    // log domain, as the power overflows for long passwords
     if (entropy > 0) {
-        entropy = std::pow(entropy, m_passwordLength->get_value());
-        entropy = std::ceil(std::log2(entropy));
+        entropy = std::ceil(m_passwordLength->get_value() * std::log2(entropy));
         value = static_cast<unsigned long>(entropy);
         m_passwordEntropy->set_text("~ " + std::to_string(value) + " Bit");
     } else {
@@ -295,31 +512,332 @@ void GtkPassWindow::updateEntropy() {
 
     // set the password quality level
     if (value < 64) {
-        m_entropyLevel->set_value(1.0);
-        cssData = m_cssLvl1;
+        level = 1;
     } else if (value >= 64 && value < 80) {
-        m_entropyLevel->set_value(2.0);
-        cssData = m_cssLvl2;
+        level = 2;
     } else if (value >= 80 && value < 96) {
-        m_entropyLevel->set_value(3.0);
-        cssData = m_cssLvl3;
+        level = 3;
     } else if (value >= 96 && value < 112) {
-        m_entropyLevel->set_value(4.0);
-        cssData = m_cssLvl4;
+        level = 4;
     } else {
-        m_entropyLevel->set_value(5.0);
-        cssData = m_cssLvl5;
+        level = 5;
     }
 
-    // update the color of the level bar by applying css style
-    m_css->load_from_data(cssData);
-    m_styleCtx->add_provider_for_screen(m_screen, m_css, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    // update the color of the level bar by switching its style class; only
+    // a change of the level makes GTK+ recompute the style
+    if (level != m_level) {
+        auto context = m_entropyLevel->get_style_context();
+        if (m_level > 0)
+            context->remove_class("entropy-level-" + std::to_string(m_level));
+        context->add_class("entropy-level-" + std::to_string(level));
+        m_entropyLevel->set_value(level);
+        m_level = level;
+    }
+    GTKPASS_PROBE1(update_entropy_return, value);
 }
 
 /**
  * Signal handler for changing the length value of the password. Updates the
- * entropy.
+ * entropy, refills the pool of prefetched passwords and replaces a password
+ * being generated with the old length.
  */
 void GtkPassWindow::on_lengthChanged() {
+    m_generator.prefetch(static_cast<uint32_t>(m_passwordLength->get_value()), m_options);
+    if (m_generator.isBusy())
+        generatePassword();
     updateEntropy();
 }
+
+/**
+ * Estimates the strength of the password in the entry field and updates the
+ * label displaying it. The tooltip of the label lists the patterns found in
+ * the password.
+ */
+void GtkPassWindow::updateStrength() {
+    static const char* const SCORES[] = {
+        N_("very weak"), N_("weak"), N_("fair"), N_("strong"), N_("very strong")
+    };
+    // the text in the locked memory of the buffer, not a copy
+    const char* text = gtk_entry_get_text(m_passwordEntry->gobj());
+    if (*text == '\0') {
+        // the estimator would keep the last password until the next one
+        m_strength.clear();
+        m_strengthValue->set_text(_("No password"));
+        m_strengthValue->set_tooltip_text("");
+        return;
+    }
+    loadDictionaries();
+    const strengthest& estimate = m_strength.update(text, strlen(text));
+    const unsigned long bits = static_cast<unsigned long>(
+        std::ceil(estimate.log10Guesses * std::log2(10.0)));
+    m_strengthValue->set_text("~ " + std::to_string(bits) + " Bit (" +
+        _(SCORES[estimate.score]) + ")");
+
+    Glib::ustring patterns;
+    for (const auto& match : estimate.sequence) {
+        Glib::ustring pattern;
+        switch (match.type) {
+            case PATTERN_DICTIONARY:
+                pattern = Glib::ustring::compose(_("word from the list \"%1\" (rank %2)"),
+                    m_strength.getDictionary(match.dictionary).getName(), match.rank);
+                if (match.reversed)
+                    pattern += _(", reversed");
+                if (match.l33t)
+                    pattern += _(", with substitutions");
+                break;
+            case PATTERN_SPATIAL:
+                pattern = _("keyboard walk");
+                break;
+            case PATTERN_REPEAT:
+                pattern = _("repetition");
+                break;
+            case PATTERN_SEQUENCE:
+                pattern = _("sequence");
+                break;
+            case PATTERN_DATE:
+                pattern = _("date");
+                break;
+            default:
+                pattern = _("random characters");
+                break;
+        }
+        patterns += (patterns.empty() ? "" : "\n") + pattern;
+    }
+    m_strengthValue->set_tooltip_text(patterns);
+}
+
+/**
+ * Signal handler for changing the contents of the password field. Updates
+ * the estimated strength and looks the password up in the index of breached
+ * passwords, if there is one, and shows a warning icon in the password field
+ * if it was found.
+ */
+void GtkPassWindow::on_passwordChanged() {
+    // a password typed into the field replaces the long password
+    if (!m_longPassword.empty() && m_passwordEntry->get_text_length() > 0)
+        clearLongPassword();
+    updateStrength();
+    if (!m_breachIndex)
+        return;
+    const char* password = gtk_entry_get_text(m_passwordEntry->gobj());
+    if (*password != '\0' && m_breachIndex->contains(password, strlen(password))) {
+        m_passwordEntry->set_icon_from_icon_name("dialog-warning-symbolic",
+            Gtk::ENTRY_ICON_SECONDARY);
+        m_passwordEntry->set_icon_tooltip_text(
+            _("This password appears in a data breach. Do not use it!"),
+            Gtk::ENTRY_ICON_SECONDARY);
+    } else {
+        m_passwordEntry->unset_icon(Gtk::ENTRY_ICON_SECONDARY);
+    }
+}
+
+/**
+ * Signal handler for drawing the window for the first time. Waits for the end
+ * of the frame being painted with a handler of the "after-paint" signal of
+ * the frame clock of the window.
+ *
+ * \param context The cairo context to draw on
+ * \return \p false to continue drawing
+ */
+bool GtkPassWindow::on_firstDraw(const Cairo::RefPtr<Cairo::Context>& context) {
+    (void) context;
+    m_firstDraw.disconnect();
+    GdkFrameClock* clock = gtk_widget_get_frame_clock(GTK_WIDGET(gobj()));
+    if (clock) {
+        // the clock may be replaced when the window is unrealized, so the
+        // destructor disconnects from this one
+        m_afterPaintClock = GDK_FRAME_CLOCK(g_object_ref(clock));
+        m_afterPaint = g_signal_connect(clock, "after-paint",
+            G_CALLBACK(&GtkPassWindow::on_firstFramePainted), this);
+    } else {
+        on_firstFramePainted(nullptr, this);
+    }
+    return false;
+}
+
+/**
+ * Signal handler for the end of the first frame of the window. Emits the
+ * signal returned by \p signal_firstFrame() and schedules the work that was
+ * left out of the first frame for when the main loop is idle.
+ *
+ * \param clock The frame clock of the window (\p nullptr for none)
+ * \param window Pointer to the \p GtkPassWindow
+ */
+void GtkPassWindow::on_firstFramePainted(GdkFrameClock* clock, gpointer window) {
+    GtkPassWindow* self = static_cast<GtkPassWindow*>(window);
+    if (clock) {
+        g_signal_handler_disconnect(clock, self->m_afterPaint);
+        g_object_unref(self->m_afterPaintClock);
+    }
+    self->m_afterPaint = 0;
+    self->m_afterPaintClock = nullptr;
+    Glib::signal_idle().connect(
+        sigc::mem_fun(*self, &GtkPassWindow::on_idleAfterFirstFrame),
+        Glib::PRIORITY_LOW
+    );
+    self->m_firstFrame.emit();
+}
+
+/**
+ * Idle handler doing the work not needed for the first frame: loads the
+ * dictionaries of the strength estimator and starts filling the pool of
+ * prefetched passwords.
+ *
+ * \return \p false to run only once
+ */
+bool GtkPassWindow::on_idleAfterFirstFrame() {
+    loadDictionaries();
+    m_generator.prefetch(static_cast<uint32_t>(m_passwordLength->get_value()), m_options);
+    return false;
+}
+
+/**
+ * Function for adding the ranked word lists shared by all windows to the
+ * strength estimator. Does nothing if they were added before, so a password
+ * typed before the main loop was idle adds them right away.
+ */
+void GtkPassWindow::loadDictionaries() {
+    if (m_dictionariesLoaded)
+        return;
+    m_dictionariesLoaded = true;
+    for (const auto& dictionary : getDictionaries()) {
+        m_strength.addDictionary(dictionary);
+    }
+}
+
+/**
+ * Function for showing a generated password in the password field and adding
+ * it to the history. The characters are copied into the locked memory of
+ * both without any copy in between.
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ */
+void GtkPassWindow::showPassword(const char* password, size_t length) {
+    displayPassword(password, length);
+    if (m_history.add(password, length))
+        m_historyModel->update();
+}
+
+/**
+ * Signal handler for changing the search string of the history. Shows the
+ * passwords containing it; a longer search string only searches the
+ * passwords found before. The search entry only emits the signal after a
+ * short pause in typing. The model tells the view about the rows that
+ * changed; only if there are too many of them the model is attached again.
+ */
+void GtkPassWindow::on_historySearchChanged() {
+    if (!m_historyModel->setNeedle(m_historySearch->get_text().raw())) {
+        m_historyView->unset_model();
+        m_historyView->set_model(m_historyModel);
+    }
+}
+
+/**
+ * Signal handler for activating a password in the history. Shows it in the
+ * password field again.
+ *
+ * \param path The path of the row
+ * \param column The column activated
+ */
+void GtkPassWindow::on_historyRowActivated(const Gtk::TreeModel::Path& path,
+    Gtk::TreeViewColumn* column) {
+    (void) column;
+    size_t entry;
+    if (!m_historyModel->getEntry(m_historyModel->get_iter(path), entry))
+        return;
+    const size_t offset = m_history.getOffset(entry);
+    displayPassword(m_history.data() + offset, m_history.getOffset(entry + 1) - offset);
+}
+
+/**
+ * Handler for the action "win.bulk". Opens the dialog writing many passwords
+ * with the options and the length of the window to a file; it is created
+ * the first time.
+ */
+void GtkPassWindow::on_actionBulk() {
+    if (!m_bulkDialog)
+        m_bulkDialog.reset(new BulkDialog(*this));
+    m_bulkDialog->setOptions(m_options,
+        static_cast<unsigned int>(m_passwordLength->get_value()));
+    m_bulkDialog->present();
+}
+
+/**
+ * Function for showing a password in the password field or, if it has more
+ * than \p LONG_PASSWORD_LENGTH characters, in the long password view. The
+ * layout of the password field is computed for the whole text whenever it
+ * changes, which takes too long for keys of many kilobytes. Both keep the
+ * password in locked memory.
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ */
+void GtkPassWindow::displayPassword(const char* password, size_t length) {
+    if (length <= LONG_PASSWORD_LENGTH) {
+        clearLongPassword();
+        setSecureEntryText(m_passwordEntry->get_buffer(), password, length);
+        return;
+    }
+    m_passwordEntry->set_text("");
+    m_longPassword.assign(password, length);
+    updateLongPassword();
+    // the strength estimator looks for patterns in typed passwords
+    m_strengthValue->set_text(_("Not estimated for long passwords"));
+    m_strengthValue->set_tooltip_text("");
+}
+
+/**
+ * Function for filling the long password view with \p m_longPassword, in
+ * lines of \p LONG_PASSWORD_LINE characters, if the password is shown.
+ * The text view lays out the visible lines first and the others when the
+ * main loop is idle, so even a password of a megabyte is shown at once.
+ * Hides the view if there is no long password.
+ */
+void GtkPassWindow::updateLongPassword() {
+    Glib::RefPtr<Gtk::TextBuffer> buffer = m_longPasswordView->get_buffer();
+    if (m_longPassword.empty()) {
+        buffer->set_text("");
+        m_longPasswordBox->hide();
+        return;
+    }
+    const size_t length = m_longPassword.bytes();
+    if (m_btnShowPassword->get_active()) {
+        std::string lines;
+        lines.reserve(length + length / LONG_PASSWORD_LINE);
+        for (size_t offset = 0; offset < length; offset += LONG_PASSWORD_LINE) {
+            if (offset > 0)
+                lines += '\n';
+            lines.append(m_longPassword.data() + offset,
+                std::min<size_t>(LONG_PASSWORD_LINE, length - offset));
+        }
+        buffer->set_text(lines.data(), lines.data() + lines.size());
+        sodium_memzero(&lines[0], lines.size());
+        m_longPasswordLabel->set_text(Glib::ustring::compose(_("%1 characters"), length));
+    } else {
+        buffer->set_text("");
+        m_longPasswordLabel->set_text(Glib::ustring::compose(
+            _("%1 characters, hidden"), length));
+    }
+    m_longPasswordBox->show();
+}
+
+/**
+ * Function for wiping the long password and hiding its view.
+ */
+void GtkPassWindow::clearLongPassword() {
+    if (m_longPassword.empty())
+        return;
+    m_longPassword.clear();
+    updateLongPassword();
+}
+
+/**
+ * Signal handler for clicking the button copying the long password. Copies
+ * the whole password to the clipboard at once, whether it is shown or not.
+ */
+void GtkPassWindow::on_copyPassword() {
+    if (!m_longPassword.empty())
+        gtk_clipboard_set_text(Gtk::Clipboard::get()->gobj(), m_longPassword.data(),
+            static_cast<gint>(m_longPassword.bytes()));
+}
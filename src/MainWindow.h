@@ -27,16 +27,35 @@
 #ifndef GTKPASS_MAINWINDOW_H
 #define GTKPASS_MAINWINDOW_H
 
+#include "AsyncGenerator.h"
+#include "BreachIndex.h"
+#include "BulkDialog.h"
+#include "History.h"
+#include "HistoryModel.h"
 #include "RandomGenerator.h"
+#include "SecureText.h"
+#include "Strength.h"
 #include <gtkmm.h>
+#include <memory>
 #include <vector>
 
+/// Maximum length of the passwords generated in the window (1 MiB)
+#define MAX_PASSWORD_LENGTH 1048576
+/// Passwords longer than this are shown in the long password view instead of
+/// the password field
+#define LONG_PASSWORD_LENGTH 256
+/// Number of characters per line of the long password view
+#define LONG_PASSWORD_LINE 64
+
 class GtkPassWindow : public Gtk::ApplicationWindow {
 
 public:
     GtkPassWindow(BaseObjectType* cobject,
         const Glib::RefPtr<Gtk::Builder>& builder);
+    virtual ~GtkPassWindow();
     static GtkPassWindow* create();
+    void setBreachIndex(const BreachIndex* index);
+    sigc::signal<void>& signal_firstFrame();
 
 private:
     /// \p Glib::RefPtr to a \p Gtk::Builder for GUI construction
@@ -76,58 +95,111 @@ private:
     /// Pointer to the entropy level bar
     Gtk::LevelBar* m_entropyLevel;
 
-    /// Pointer to the entry field holding the password
+    /// Pointer to the entry field holding the password in a buffer of
+    /// locked memory
     Gtk::Entry* m_passwordEntry;
+    /// Pointer to the label displaying the estimated strength of the password
+    Gtk::Label* m_strengthValue;
     /// Pointer to the toggle button for showing and hiding the password
     Gtk::ToggleButton* m_btnShowPassword;
     /// Pointer to the button for generating the password
     Gtk::Button* m_btnGeneratePassword;
-
-    /// Intelligent Pointer to a \p Gtk::CssProvider
-    Glib::RefPtr<Gtk::CssProvider> m_css;
-    /// Intelligent Pointer to the style context
-    Glib::RefPtr<Gtk::StyleContext> m_styleCtx;
-    /// Intelligent Pointer to the default screen
-    Glib::RefPtr<Gdk::Screen> m_screen;
-
-    /// String storing the CSS data for red level bar
-    const std::string m_cssLvl1 = ".level-bar.fill-block.level-high {"
-        "    border-color: red;"
-        "    background-color: red;"
-        "}";
-    /// String storing the CSS data for orange level bar
-    const std::string m_cssLvl2 = ".level-bar.fill-block.level-high {"
-        "    border-color: orange;"
-        "    background-color: orange;"
-        "}";
-    /// String storing the CSS data for yellow level bar
-    const std::string m_cssLvl3 = ".level-bar.fill-block.level-high {"
-        "    border-color: yellow;"
-        "    background-color: yellow;"
-        "}";
-    /// String storing the CSS data for yellow green level bar
-    const std::string m_cssLvl4 = ".level-bar.fill-block.level-high {"
-        "    border-color: yellowgreen;"
-        "    background-color: yellowgreen;"
-        "}";
-    /// String storing the CSS data for green level bar
-    const std::string m_cssLvl5 = ".level-bar.fill-block.level-high {"
-        "    border-color: green;"
-        "    background-color: green;"
-        "}";
+    /// Pointer to the box holding the long password view
+    Gtk::Box* m_longPasswordBox;
+    /// Pointer to the view showing long passwords in lines
+    Gtk::TextView* m_longPasswordView;
+    /// Pointer to the label displaying the length of the long password
+    Gtk::Label* m_longPasswordLabel;
+    /// Pointer to the button copying the long password
+    Gtk::Button* m_btnCopyPassword;
+    /// Pointer to the search entry filtering the history
+    Gtk::SearchEntry* m_historySearch;
+    /// Pointer to the tree view showing the history
+    Gtk::TreeView* m_historyView;
+
+    /// The passwords generated in this window
+    PasswordHistory m_history;
+    /// Model showing \p m_history in \p m_historyView; declared after
+    /// \p m_history, so it is destroyed first
+    Glib::RefPtr<HistoryModel> m_historyModel;
+
+    /// Index of breached passwords to check the password against (\p nullptr
+    /// for none)
+    const BreachIndex* m_breachIndex;
+    /// Estimator for the strength of the password in the entry field
+    StrengthEstimator m_strength;
+    /// Entropy level shown by the level bar, from 1 to 5 (0 before the
+    /// first update)
+    int m_level;
+    /// Dispatcher handing generated passwords over to the main loop
+    Glib::Dispatcher m_generated;
+    /// Generator of the passwords on a worker thread; declared after
+    /// \p m_generated, so it is destroyed first
+    AsyncGenerator m_generator;
+    /// The password shown in the long password view (empty for none)
+    SecureText m_longPassword;
+    /// Whether the dictionaries of \p m_strength were loaded
+    bool m_dictionariesLoaded;
+    /// Connection of \p on_firstDraw(), disconnected by the first draw
+    sigc::connection m_firstDraw;
+    /// ID of the handler of the "after-paint" signal of the frame clock
+    /// waiting for the end of the first frame (0 for none)
+    gulong m_afterPaint;
+    /// The frame clock \p m_afterPaint is connected to, referenced while
+    /// connected (\p nullptr for none)
+    GdkFrameClock* m_afterPaintClock;
+    /// Signal emitted when the first frame of the window was painted
+    sigc::signal<void> m_firstFrame;
+    /// Dialog writing many passwords to a file, created when it is opened
+    std::unique_ptr<BulkDialog> m_bulkDialog;
 
     /// Signal handler for checking the check boxes
     void on_check();
     /// Signal handler for clicking the generate button
     void generatePassword();
+    /// Signal handler for a password generated by the worker thread
+    void on_passwordGenerated();
     /// Signal handler for clicking the show password button
     void on_clickToggleButton();
     /// Signal handler for changing the password length
     void on_lengthChanged();
+    /// Signal handler for changing the contents of the password field
+    void on_passwordChanged();
+    /// Signal handler for clicking the button copying the long password
+    void on_copyPassword();
+    /// Signal handler for changing the search string of the history
+    void on_historySearchChanged();
+    /// Handler for the action opening the bulk generation dialog
+    void on_actionBulk();
+    /// Signal handler for activating a password in the history
+    void on_historyRowActivated(const Gtk::TreeModel::Path& path,
+        Gtk::TreeViewColumn* column);
+    /// Signal handler for drawing the window for the first time
+    bool on_firstDraw(const Cairo::RefPtr<Cairo::Context>& context);
+    /// Signal handler for the end of the first frame of the window
+    static void on_firstFramePainted(GdkFrameClock* clock, gpointer window);
+    /// Idle handler doing the work not needed for the first frame
+    bool on_idleAfterFirstFrame();
+    /// Function for loading the dictionaries of the strength estimator
+    void loadDictionaries();
+    /// Function for showing a generated password and adding it to the
+    /// history
+    void showPassword(const char* password, size_t length);
+    /// Function for showing a password in the password field or, if it is
+    /// long, in the long password view
+    void displayPassword(const char* password, size_t length);
+    /// Function for filling the long password view with \p m_longPassword
+    /// or hiding it
+    void updateLongPassword();
+    /// Function for wiping the long password and hiding its view
+    void clearLongPassword();
 
     /// Function for calculating the possible password entropy and updating the
     /// widgets displaying it
     void updateEntropy();
+    /// Function for estimating the strength of the password in the entry
+    /// field and updating the label displaying it
+    void updateStrength();
 
 }; // End of class GtkPassWindow
 
@@ -0,0 +1,456 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    MainWindow_Bench.cpp
+ * \brief   Benchmarks the files \p MainWindow.h and \p MainWindow.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p MainWindow.h and \p MainWindow.cpp. The window is
+ * driven programmatically like a user would: the widgets are found by their
+ * IDs in \p window.ui and clicked or changed, and the frame clock of the
+ * window reports when the result is painted.
+ */
+
+#include "Benchmark.h"
+#include "MainWindow.h"
+#include "HistoryModel.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <memory>
+
+/// Number of times the password length is scrolled from 1 to 100 and back
+static const size_t SCROLL_ROUNDS = 5;
+/// Number of windows created for measuring the startup
+static const size_t STARTUP_WINDOWS = 20;
+/// Number of rounds of interactions with every kind of widget
+static const size_t INTERACTION_ROUNDS = 50;
+/// Number of passwords in the history scrolled through
+static const size_t HISTORY_ENTRIES = 1000000;
+/// Number of pages the history is scrolled down
+static const size_t HISTORY_PAGES = 500;
+/// Time to wait for the frame showing the result of an interaction in
+/// milliseconds
+static const unsigned int FRAME_TIMEOUT = 1000;
+
+/// Handles all pending events of the main loop
+static void processEvents() {
+    while (Gtk::Main::events_pending()) {
+        Gtk::Main::iteration(false);
+    }
+}
+
+/// Calls \p visit for \p widget and all widgets inside it
+static void visitWidgets(Gtk::Widget* widget, const std::function<void(Gtk::Widget*)>& visit) {
+    visit(widget);
+    Gtk::Container* container = dynamic_cast<Gtk::Container*>(widget);
+    if (!container)
+        return;
+    for (Gtk::Widget* child : container->get_children()) {
+        visitWidgets(child, visit);
+    }
+}
+
+/// Returns the widget of type \p T with the ID \p id in \p window.ui
+template <typename T>
+static T* findWidget(Gtk::Window& window, const char* id) {
+    T* found = nullptr;
+    visitWidgets(&window, [&](Gtk::Widget* widget) {
+        const char* name = gtk_buildable_get_name(GTK_BUILDABLE(widget->gobj()));
+        if (!found && name && std::string(name) == id)
+            found = dynamic_cast<T*>(widget);
+    });
+    return found;
+}
+
+/// Writes the median, the 95th and the 99th percentile of \p samples in
+/// nanoseconds to \p out and records them as \p metric
+static void printPercentiles(std::ostream& out, const std::string& label,
+    const std::string& metric, std::vector<uint64_t>& samples) {
+    out << std::left << std::setw(28) << label << std::right;
+    if (samples.empty()) {
+        out << "no samples" << std::endl;
+        return;
+    }
+    out << std::fixed << std::setprecision(1);
+    for (const double percentile : {50.0, 95.0, 99.0}) {
+        const double value = getPercentile(samples, percentile) / 1000.0;
+        const std::string name = "p" + std::to_string(static_cast<int>(percentile));
+        out << "  " << name << " " << std::setw(9) << value << " us";
+        recordResult(metric + "_" + name + "_us", value);
+    }
+    out << std::endl;
+}
+
+/**
+ * Records the frames painted by the frame clock of a window: how long every
+ * frame took from its start to the end of painting, and how long it took
+ * from an interaction to the end of the first frame showing its result.
+ */
+struct FrameRecorder {
+    FrameRecorder() : painted(0), start(0), armed(false) {}
+
+    /// number of frames painted
+    uint64_t painted;
+    /// monotonic time of the interaction in microseconds
+    gint64 start;
+    /// whether the next frame shows the result of the interaction
+    bool armed;
+    /// time from the start of every frame to the end of painting in
+    /// nanoseconds
+    std::vector<uint64_t> frames;
+    /// time from every interaction to the end of the first frame showing
+    /// its result in nanoseconds
+    std::vector<uint64_t> latencies;
+};
+
+/// Handler of the "after-paint" signal of the frame clock
+static void onAfterPaint(GdkFrameClock* clock, gpointer data) {
+    FrameRecorder* recorder = static_cast<FrameRecorder*>(data);
+    const gint64 now = g_get_monotonic_time();
+    GdkFrameTimings* timings = gdk_frame_clock_get_current_timings(clock);
+    const gint64 frameTime = timings ? gdk_frame_timings_get_frame_time(timings) :
+        gdk_frame_clock_get_frame_time(clock);
+    recorder->frames.push_back(static_cast<uint64_t>(now - frameTime) * 1000);
+    if (recorder->armed) {
+        recorder->latencies.push_back(static_cast<uint64_t>(now - recorder->start) * 1000);
+        recorder->armed = false;
+    }
+    recorder->painted++;
+}
+
+/// Runs the main loop until \p done returns \p true, at most
+/// \p FRAME_TIMEOUT milliseconds
+static bool runUntil(const std::function<bool()>& done) {
+    bool expired = false;
+    sigc::connection timeout = Glib::signal_timeout().connect([&expired]() {
+        expired = true;
+        return false;
+    }, FRAME_TIMEOUT);
+    while (!done() && !expired) {
+        Gtk::Main::iteration(true);
+    }
+    timeout.disconnect();
+    return !expired;
+}
+
+/// Measures the time of changing the password length while scrolling over
+/// the spin button, once for the signal handlers and once including the
+/// events processed afterwards, and counts the style recalculations of all
+/// widgets of the window
+BENCHMARK_CASE(entropy_scroll) {
+    std::unique_ptr<GtkPassWindow> window(GtkPassWindow::create());
+    window->show();
+    processEvents();
+    Gtk::SpinButton* length = findWidget<Gtk::SpinButton>(*window, "passwordLength");
+    if (!length) {
+        out << "No spin button in the window" << std::endl;
+        return;
+    }
+
+    // every widget emits "style-updated" after GTK+ recomputed its style
+    uint64_t styleUpdates = 0;
+    std::vector<sigc::connection> connections;
+    visitWidgets(window.get(), [&](Gtk::Widget* widget) {
+        connections.push_back(widget->signal_style_updated().connect(
+            [&styleUpdates]() { styleUpdates++; }));
+    });
+
+    std::vector<uint64_t> handlers;
+    std::vector<uint64_t> ticks;
+    for (size_t round = 0; round < SCROLL_ROUNDS; round++) {
+        for (int step = 0; step < 198; step++) {
+            const int value = step < 99 ? 2 + step : 198 - step;
+            const uint64_t start = getNanoseconds();
+            length->set_value(value);
+            const uint64_t handled = getNanoseconds();
+            processEvents();
+            handlers.push_back(handled - start);
+            ticks.push_back(getNanoseconds() - start);
+        }
+    }
+    for (auto& connection : connections) {
+        connection.disconnect();
+    }
+
+    printPercentiles(out, "on_lengthChanged()", "handler", handlers);
+    printPercentiles(out, "including events", "events", ticks);
+    out << "style recalculations: " << std::setprecision(2)
+        << double(styleUpdates) / ticks.size() << " per length change ("
+        << styleUpdates << " in " << ticks.size() << " changes)" << std::endl;
+    recordResult("style_updates_per_change", double(styleUpdates) / ticks.size());
+}
+
+/// Creates windows and measures the time for parsing \p window.ui and
+/// constructing the window and the time until its first frame was painted
+BENCHMARK_CASE(startup) {
+    std::vector<uint64_t> creates, firstFrames;
+    for (size_t i = 0; i < STARTUP_WINDOWS; i++) {
+        const uint64_t start = getNanoseconds();
+        std::unique_ptr<GtkPassWindow> window(GtkPassWindow::create());
+        creates.push_back(getNanoseconds() - start);
+        bool painted = false;
+        window->signal_firstFrame().connect([&painted]() { painted = true; });
+        window->show();
+        if (runUntil([&painted]() { return painted; }))
+            firstFrames.push_back(getNanoseconds() - start);
+        // the work left out of the first frame
+        processEvents();
+    }
+    printPercentiles(out, "create()", "create", creates);
+    printPercentiles(out, "first frame", "first_frame", firstFrames);
+}
+
+/// Toggles the check boxes, changes the password length and clicks
+/// "Generate" and measures the time in the signal handlers and until the
+/// frame clock painted the result
+BENCHMARK_CASE(interaction) {
+    std::unique_ptr<GtkPassWindow> window(GtkPassWindow::create());
+    window->show();
+    FrameRecorder recorder;
+    GdkFrameClock* clock = gdk_window_get_frame_clock(window->get_window()->gobj());
+    const gulong handler = g_signal_connect(clock, "after-paint",
+        G_CALLBACK(onAfterPaint), &recorder);
+    if (!runUntil([&]() { return recorder.painted > 0; })) {
+        out << "The window was never painted" << std::endl;
+        g_signal_handler_disconnect(clock, handler);
+        return;
+    }
+
+    std::vector<Gtk::CheckButton*> options;
+    for (const char* id : {"optionIncludeLowerCase", "optionIncludeUpperCase",
+        "optionIncludeNumeric", "optionIncludeSpecial", "optionIncludeDash",
+        "optionIncludeSpace", "optionAvoidSimilarChars"}) {
+        options.push_back(findWidget<Gtk::CheckButton>(*window, id));
+    }
+    Gtk::SpinButton* length = findWidget<Gtk::SpinButton>(*window, "passwordLength");
+    Gtk::Button* generate = findWidget<Gtk::Button>(*window, "btnGeneratePassword");
+    Gtk::Entry* password = findWidget<Gtk::Entry>(*window, "entryPassword");
+    if (std::find(options.begin(), options.end(), nullptr) != options.end() ||
+        !length || !generate || !password) {
+        out << "Missing widgets in the window" << std::endl;
+        g_signal_handler_disconnect(clock, handler);
+        return;
+    }
+    bool changed = false;
+    sigc::connection passwordChanged = password->signal_changed().connect(
+        [&changed]() { changed = true; });
+
+    // runs the interaction, then waits for the password to change if
+    // required and for the next frame
+    size_t missed = 0;
+    const auto interact = [&](const std::function<void()>& action, bool waitForPassword,
+        std::vector<uint64_t>& handlers, std::vector<uint64_t>& latencies) {
+        const size_t painted = recorder.latencies.size();
+        changed = false;
+        recorder.start = g_get_monotonic_time();
+        action();
+        handlers.push_back(static_cast<uint64_t>(g_get_monotonic_time() - recorder.start) * 1000);
+        if (!waitForPassword || runUntil([&]() { return changed; })) {
+            recorder.armed = true;
+            if (runUntil([&]() { return recorder.latencies.size() > painted; })) {
+                latencies.push_back(recorder.latencies.back());
+                return;
+            }
+        }
+        recorder.armed = false;
+        missed++;
+    };
+
+    std::vector<uint64_t> toggleHandlers, toggleLatencies;
+    std::vector<uint64_t> lengthHandlers, lengthLatencies;
+    std::vector<uint64_t> generateHandlers, generateLatencies;
+    for (size_t round = 0; round < INTERACTION_ROUNDS; round++) {
+        for (Gtk::CheckButton* option : options) {
+            // on and off again, so the other options stay as they are
+            for (int click = 0; click < 2; click++) {
+                interact([option]() { option->clicked(); }, false,
+                    toggleHandlers, toggleLatencies);
+            }
+        }
+        const int value = 1 + static_cast<int>(getRandomNumber(100));
+        interact([length, value]() { length->set_value(value); }, false,
+            lengthHandlers, lengthLatencies);
+        interact([generate]() { generate->clicked(); }, true,
+            generateHandlers, generateLatencies);
+    }
+    passwordChanged.disconnect();
+    g_signal_handler_disconnect(clock, handler);
+
+    printPercentiles(out, "toggle option, handler", "toggle_handler", toggleHandlers);
+    printPercentiles(out, "toggle option, painted", "toggle_paint", toggleLatencies);
+    printPercentiles(out, "change length, handler", "length_handler", lengthHandlers);
+    printPercentiles(out, "change length, painted", "length_paint", lengthLatencies);
+    printPercentiles(out, "generate, handler", "generate_handler", generateHandlers);
+    printPercentiles(out, "generate, painted", "generate_paint", generateLatencies);
+    printPercentiles(out, "frame start to painted", "frame", recorder.frames);
+    out << "interactions without a frame: " << missed << std::endl;
+    recordResult("missed_frames", missed);
+}
+
+/// Scrolls page by page through a tree view in fixed height mode showing a
+/// history of a million passwords, and measures the time of attaching the
+/// model, of every scrolled frame and of searching the history while typing
+BENCHMARK_CASE(history_scroll) {
+    PasswordHistory history;
+    genopts options;
+    for (size_t i = 0; i < HISTORY_ENTRIES; i++) {
+        std::string password = getRandomString(16, options);
+        history.add(password);
+    }
+    Glib::RefPtr<HistoryModel> model = HistoryModel::create(history);
+
+    Gtk::Window window;
+    window.set_default_size(400, 300);
+    Gtk::ScrolledWindow scroll;
+    Gtk::TreeView view;
+    const HistoryModel::Columns& columns = model->getColumns();
+    for (int i = 0; i < 2; i++) {
+        Gtk::TreeViewColumn* column = i == 0 ?
+            Gtk::manage(new Gtk::TreeViewColumn("No.", columns.number)) :
+            Gtk::manage(new Gtk::TreeViewColumn("Password", columns.password));
+        column->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+        column->set_fixed_width(i == 0 ? 70 : 200);
+        view.append_column(*column);
+    }
+    view.set_fixed_height_mode(true);
+    scroll.add(view);
+    window.add(scroll);
+    window.show_all();
+    processEvents();
+
+    FrameRecorder recorder;
+    GdkFrameClock* clock = gdk_window_get_frame_clock(window.get_window()->gobj());
+    const gulong handler = g_signal_connect(clock, "after-paint",
+        G_CALLBACK(onAfterPaint), &recorder);
+
+    uint64_t start = getNanoseconds();
+    view.set_model(model);
+    processEvents();
+    out << "attaching " << history.size() << " passwords: " << std::fixed
+        << std::setprecision(1) << (getNanoseconds() - start) / 1e6 << " ms" << std::endl;
+    recordResult("attach_ms", (getNanoseconds() - start) / 1e6);
+
+    Glib::RefPtr<Gtk::Adjustment> adjustment = scroll.get_vadjustment();
+    std::vector<uint64_t> pages;
+    size_t missed = 0;
+    for (size_t page = 0; page < HISTORY_PAGES; page++) {
+        const size_t painted = recorder.latencies.size();
+        recorder.start = g_get_monotonic_time();
+        recorder.armed = true;
+        adjustment->set_value(adjustment->get_value() + adjustment->get_page_size());
+        if (runUntil([&]() { return recorder.latencies.size() > painted; }))
+            pages.push_back(recorder.latencies.back());
+        else
+            missed++;
+        recorder.armed = false;
+    }
+    printPercentiles(out, "page down, painted", "page_paint", pages);
+
+    // typing a search string, then deleting it again, handled like the
+    // window does: the model reports small changes row by row and is only
+    // attached again for large ones
+    std::vector<uint64_t> searches;
+    std::vector<uint64_t> searchLatencies;
+    size_t reattached = 0;
+    const std::string needle = "aB3x";
+    for (size_t i = 1; i <= 2 * needle.size(); i++) {
+        const size_t length = i <= needle.size() ? i : 2 * needle.size() - i;
+        const size_t painted = recorder.latencies.size();
+        recorder.start = g_get_monotonic_time();
+        recorder.armed = true;
+        start = getNanoseconds();
+        if (!model->setNeedle(needle.substr(0, length))) {
+            view.unset_model();
+            view.set_model(model);
+            reattached++;
+        }
+        searches.push_back(getNanoseconds() - start);
+        if (runUntil([&]() { return recorder.latencies.size() > painted; }))
+            searchLatencies.push_back(recorder.latencies.back());
+        else
+            missed++;
+        recorder.armed = false;
+    }
+    printPercentiles(out, "search keystroke, handler", "search", searches);
+    printPercentiles(out, "search keystroke, painted", "search_paint", searchLatencies);
+    out << "searches attaching the model again: " << reattached << " of "
+        << searches.size() << std::endl;
+    recordResult("search_reattached", reattached);
+    g_signal_handler_disconnect(clock, handler);
+    view.unset_model();
+    out << "pages and searches without a frame: " << missed << std::endl;
+    recordResult("missed_frames", missed);
+}
+
+/// Generates passwords of 4 KiB, 64 KiB and 1 MiB with the password shown
+/// and measures the time from the click on "Generate" until the long
+/// password view was painted, and the longest frame while the text view
+/// lays out the remaining lines afterwards
+BENCHMARK_CASE(long_password) {
+    std::unique_ptr<GtkPassWindow> window(GtkPassWindow::create());
+    window->show();
+    FrameRecorder recorder;
+    GdkFrameClock* clock = gdk_window_get_frame_clock(window->get_window()->gobj());
+    const gulong handler = g_signal_connect(clock, "after-paint",
+        G_CALLBACK(onAfterPaint), &recorder);
+    Gtk::SpinButton* length = findWidget<Gtk::SpinButton>(*window, "passwordLength");
+    Gtk::Button* generate = findWidget<Gtk::Button>(*window, "btnGeneratePassword");
+    Gtk::ToggleButton* show = findWidget<Gtk::ToggleButton>(*window, "btnShowPassword");
+    Gtk::TextView* view = findWidget<Gtk::TextView>(*window, "longPasswordView");
+    if (!runUntil([&]() { return recorder.painted > 0; }) ||
+        !length || !generate || !show || !view) {
+        out << "Missing widgets in the window" << std::endl;
+        g_signal_handler_disconnect(clock, handler);
+        return;
+    }
+    show->set_active(true);
+    bool changed = false;
+    sigc::connection bufferChanged = view->get_buffer()->signal_changed().connect(
+        [&changed]() { changed = true; });
+
+    for (const int characters : {4096, 65536, MAX_PASSWORD_LENGTH}) {
+        length->set_value(characters);
+        processEvents();
+        std::vector<uint64_t> latencies, frames;
+        for (size_t i = 0; i < 10; i++) {
+            const size_t painted = recorder.latencies.size();
+            changed = false;
+            recorder.start = g_get_monotonic_time();
+            generate->clicked();
+            if (!runUntil([&]() { return changed; }))
+                continue;
+            recorder.armed = true;
+            if (runUntil([&]() { return recorder.latencies.size() > painted; }))
+                latencies.push_back(recorder.latencies.back());
+            recorder.armed = false;
+            // the frames while the remaining lines are laid out
+            const size_t first = recorder.frames.size();
+            const gint64 end = g_get_monotonic_time() + 200000;
+            runUntil([&]() { return g_get_monotonic_time() >= end; });
+            frames.insert(frames.end(), recorder.frames.begin() + first,
+                recorder.frames.end());
+        }
+        const std::string name = std::to_string(characters);
+        printPercentiles(out, name + " chars, painted", "paint_" + name, latencies);
+        printPercentiles(out, name + " chars, later frames", "frame_" + name, frames);
+    }
+    bufferChanged.disconnect();
+    g_signal_handler_disconnect(clock, handler);
+}
@@ -0,0 +1,224 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    MainWindow_Test.cpp
+ * \brief   Tests the files \p MainWindow.h and \p MainWindow.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p MainWindow.h and \p MainWindow.cpp. The tests need a
+ * display and are run by \p gui_test.sh.
+ */
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "catch.hpp"
+#include "AsyncGenerator.h"
+#include "MainWindow.h"
+#include "Memory.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+
+/// Number of windows opened and closed
+static const size_t WINDOWS = 100;
+/// Number of windows opened before measuring, so the caches of GTK are
+/// filled
+static const size_t WARMUP_WINDOWS = 10;
+/// Maximum growth of the resident set size after opening and closing
+/// \p WINDOWS windows in bytes
+static const uint64_t MAX_RSS_GROWTH = 8 << 20;
+/// Maximum growth of the heap in use after opening and closing \p WINDOWS
+/// windows in bytes, a fraction of a single window per window
+static const uint64_t MAX_HEAP_GROWTH = 2 << 20;
+/// Time to wait for the first frame of a window in milliseconds
+static const unsigned int FRAME_TIMEOUT = 5000;
+/// Length of the password generated while the main loop is measured (10 MiB)
+static const uint32_t LONG_PASSWORD_LENGTH = 10 << 20;
+/// Number of frames a window draws before the main loop is measured
+static const size_t WARMUP_FRAMES = 3;
+/// Interval of the timeout measuring the iterations of the main loop in
+/// milliseconds
+static const unsigned int TICK_INTERVAL = 1;
+/// Maximum time between two iterations of the main loop while a long
+/// password is generated in milliseconds
+static const int64_t MAX_ITERATION_GAP = 50;
+/// Maximum time between two frames of a window while a long password is
+/// generated in milliseconds
+static const int64_t MAX_FRAME_GAP = 100;
+/// Time to wait for a long password in milliseconds
+static const unsigned int GENERATE_TIMEOUT = 30000;
+
+/// Frames of a window counted by \p onTick()
+struct FrameGaps {
+    /// Initializes the struct without any frame
+    FrameGaps() : frames(0), last(0), longest(0), quitAfter(0) {}
+    /// number of frames
+    size_t frames;
+    /// frame time of the last frame in microseconds
+    gint64 last;
+    /// longest time between two frames in microseconds
+    gint64 longest;
+    /// number of frames after which \p loop is quit (0 for never)
+    size_t quitAfter;
+    /// main loop to quit
+    Glib::RefPtr<Glib::MainLoop> loop;
+};
+
+/// Tick callback of a window recording the time since the last frame in the
+/// \p FrameGaps at \p data
+static gboolean onTick(GtkWidget*, GdkFrameClock* clock, gpointer data) {
+    FrameGaps* gaps = static_cast<FrameGaps*>(data);
+    const gint64 now = gdk_frame_clock_get_frame_time(clock);
+    if (gaps->frames > 0)
+        gaps->longest = std::max(gaps->longest, now - gaps->last);
+    gaps->last = now;
+    gaps->frames++;
+    if (gaps->quitAfter != 0 && gaps->frames >= gaps->quitAfter)
+        gaps->loop->quit();
+    return G_SOURCE_CONTINUE;
+}
+
+/// Handles all pending events of the main loop
+static void processEvents() {
+    while (Gtk::Main::events_pending()) {
+        Gtk::Main::iteration(false);
+    }
+}
+
+/// Opens a window, waits for its first frame and the work done after it
+/// and closes the window again
+static bool openAndClose() {
+    std::unique_ptr<GtkPassWindow> window(GtkPassWindow::create());
+    bool painted = false;
+    bool expired = false;
+    window->signal_firstFrame().connect([&painted]() { painted = true; });
+    sigc::connection timeout = Glib::signal_timeout().connect([&expired]() {
+        expired = true;
+        return false;
+    }, FRAME_TIMEOUT);
+    window->show();
+    while (!painted && !expired) {
+        Gtk::Main::iteration(true);
+    }
+    timeout.disconnect();
+    processEvents();
+    window->hide();
+    window.reset();
+    processEvents();
+    return painted;
+}
+
+/// Tests that opening and closing windows does not leak memory
+TEST_CASE("GtkPassWindow memory", "[MainWindow]") {
+    for (size_t i = 0; i < WARMUP_WINDOWS; i++) {
+        REQUIRE(openAndClose());
+    }
+    const size_t toplevels = Gtk::Window::list_toplevels().size();
+    const memusage before = getMemoryUsage();
+    for (size_t i = 0; i < WINDOWS; i++) {
+        REQUIRE(openAndClose());
+    }
+    const memusage after = getMemoryUsage();
+    INFO("RSS " << before.rss << " -> " << after.rss << " bytes, heap in use "
+        << before.heapInUse << " -> " << after.heapInUse << " bytes");
+
+    REQUIRE(Gtk::Window::list_toplevels().size() == toplevels);
+    REQUIRE(after.rss < before.rss + MAX_RSS_GROWTH);
+#ifdef HAVE_MALLINFO2
+    REQUIRE(after.heapInUse < before.heapInUse + MAX_HEAP_GROWTH);
+#endif
+}
+
+/// Tests that the main loop keeps running and a window keeps drawing frames
+/// while \p AsyncGenerator generates a long password and hands it over with
+/// a \p Glib::Dispatcher, like the window does
+TEST_CASE("AsyncGenerator main loop latency", "[MainWindow]") {
+    typedef std::chrono::steady_clock Clock;
+    Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create();
+    Glib::Dispatcher generated;
+    AsyncGenerator generator([&generated]() { generated.emit(); });
+    Gtk::Window window;
+    FrameGaps gaps;
+    gaps.loop = loop;
+    const guint tick = gtk_widget_add_tick_callback(GTK_WIDGET(window.gobj()),
+        &onTick, &gaps, nullptr);
+
+    bool expired = false;
+    sigc::connection timeout = Glib::signal_timeout().connect([&expired]() {
+        expired = true;
+        return false;
+    }, FRAME_TIMEOUT);
+    window.show();
+    while (gaps.frames < WARMUP_FRAMES && !expired) {
+        Gtk::Main::iteration(true);
+    }
+    timeout.disconnect();
+    REQUIRE(gaps.frames >= WARMUP_FRAMES);
+
+    // every iteration of the main loop runs the timeout, so the longest time
+    // between two runs is the longest iteration
+    bool generating = true;
+    Clock::time_point last = Clock::now();
+    Clock::duration longestIteration(0);
+    sigc::connection ticks = Glib::signal_timeout().connect([&]() {
+        const Clock::time_point now = Clock::now();
+        if (generating)
+            longestIteration = std::max(longestIteration, now - last);
+        last = now;
+        return true;
+    }, TICK_INTERVAL);
+    // the password is taken on the main loop, which quits after the next
+    // frame, so the frame drawn after taking the password is measured, too
+    std::string password;
+    sigc::connection handover = generated.connect([&]() {
+        if (!generator.takePassword(password))
+            return;
+        generating = false;
+        gaps.quitAfter = gaps.frames + 1;
+    });
+    timeout = Glib::signal_timeout().connect([&expired, &loop]() {
+        expired = true;
+        loop->quit();
+        return false;
+    }, GENERATE_TIMEOUT);
+    gaps.frames = 0;
+    gaps.longest = 0;
+    generator.request(LONG_PASSWORD_LENGTH, genopts());
+    loop->run();
+
+    timeout.disconnect();
+    handover.disconnect();
+    ticks.disconnect();
+    gtk_widget_remove_tick_callback(GTK_WIDGET(window.gobj()), tick);
+    window.hide();
+    processEvents();
+    const int64_t iteration = std::chrono::duration_cast<
+        std::chrono::milliseconds>(longestIteration).count();
+    INFO("longest iteration " << iteration << " ms, longest frame gap "
+        << gaps.longest / 1000 << " ms in " << gaps.frames << " frames");
+
+    REQUIRE_FALSE(expired);
+    REQUIRE(password.size() == LONG_PASSWORD_LENGTH);
+    REQUIRE(iteration < MAX_ITERATION_GAP);
+    REQUIRE(gaps.longest < MAX_FRAME_GAP * 1000);
+}
@@ -0,0 +1,137 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Memory.cpp
+ * \brief   Implements functions for reporting the memory usage of the process.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for reporting the memory usage of the
+ * process.
+ */
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "Memory.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#ifdef HAVE_MALLINFO2
+#   include <malloc.h>
+#endif
+
+namespace {
+
+/// A line of \p /proc/self/smaps_rollup or \p /proc/self/status holding a
+/// size in kB
+struct MemoryField {
+    /// the name of the field including the colon
+    const char* name;
+    /// the member of \p memusage receiving the size
+    uint64_t memusage::*size;
+};
+
+/// The fields read from \p /proc/self/smaps_rollup and, for older kernels,
+/// from \p /proc/self/status
+const MemoryField FIELDS[] = {
+    {"Rss:", &memusage::rss},
+    {"Pss:", &memusage::pss},
+    {"Anonymous:", &memusage::anonymous},
+    {"Swap:", &memusage::swap},
+    {"VmRSS:", &memusage::rss},
+    {"RssAnon:", &memusage::anonymous},
+    {"VmSwap:", &memusage::swap}
+};
+
+/// Writes \p bytes in MiB to \p out
+void printMiB(std::ostream& out, const char* label, uint64_t bytes) {
+    out << std::left << std::setw(23) << label << std::right << std::fixed
+        << std::setprecision(1) << std::setw(9) << bytes / 1048576.0 << " MiB"
+        << std::endl;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Reads the sizes of the memory usage from the contents of
+ * \p /proc/self/smaps_rollup or \p /proc/self/status in \p in into
+ * \p usage. The heap statistics are left unchanged.
+ *
+ * \param in The stream to read from
+ * \param usage Receives the sizes
+ * \return \p true if the resident set size was found, \p false otherwise
+ */
+bool parseMemoryUsage(std::istream& in, memusage& usage) {
+    bool found = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name, unit;
+        uint64_t size;
+        if (!(fields >> name >> size >> unit) || unit != "kB")
+            continue;
+        for (const MemoryField& field : FIELDS) {
+            if (name != field.name)
+                continue;
+            usage.*field.size = size * 1024;
+            found = found || field.size == &memusage::rss;
+        }
+    }
+    return found;
+}
+
+/**
+ * Returns the current memory usage of the process.
+ *
+ * \return The memory usage; sizes that are not available are 0
+ */
+memusage getMemoryUsage() {
+    memusage usage;
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    if (!rollup || !parseMemoryUsage(rollup, usage)) {
+        std::ifstream status("/proc/self/status");
+        parseMemoryUsage(status, usage);
+    }
+#ifdef HAVE_MALLINFO2
+    const struct mallinfo2 heap = mallinfo2();
+    usage.heapInUse = heap.uordblks + heap.hblkhd;
+    usage.heapTotal = heap.arena + heap.hblkhd;
+#endif
+    return usage;
+}
+
+/**
+ * Writes the memory usage in \p usage to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param usage The memory usage to print
+ */
+void printMemoryUsage(std::ostream& out, const memusage& usage) {
+    printMiB(out, "Resident set size:", usage.rss);
+    if (usage.pss > 0)
+        printMiB(out, "Proportional set size:", usage.pss);
+    printMiB(out, "Anonymous memory:", usage.anonymous);
+    printMiB(out, "Swapped out:", usage.swap);
+    if (usage.heapTotal > 0) {
+        printMiB(out, "Heap in use:", usage.heapInUse);
+        printMiB(out, "Heap from the system:", usage.heapTotal);
+    }
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Memory.h
+ * \brief   Defines functions for reporting the memory usage of the process.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for reporting the memory usage of the process.
+ * The resident and proportional set sizes come from
+ * \p /proc/self/smaps_rollup, or from \p /proc/self/status on kernels older
+ * than 4.14, which do not report the proportional set size. The heap
+ * statistics of \p malloc() include the allocations of GLib and GTK, as
+ * GLib allocates with \p malloc() since version 2.46.
+ */
+
+#ifndef GTKPASS_MEMORY_H
+#define GTKPASS_MEMORY_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+/**
+ * \typedef memusage
+ * \brief Defines a struct holding the memory usage of the process.
+ */
+typedef struct memoryusage {
+    /// Initializes all sizes with 0
+    memoryusage() : rss(0), pss(0), anonymous(0), swap(0), heapInUse(0),
+        heapTotal(0) {}
+    /// resident set size in bytes
+    uint64_t rss;
+    /// proportional set size in bytes, counting pages shared with other
+    /// processes in parts (0 if unknown)
+    uint64_t pss;
+    /// resident anonymous memory in bytes
+    uint64_t anonymous;
+    /// swapped out memory in bytes
+    uint64_t swap;
+    /// bytes allocated with \p malloc() and not freed yet (0 if unknown)
+    uint64_t heapInUse;
+    /// bytes \p malloc() obtained from the system (0 if unknown)
+    uint64_t heapTotal;
+} memusage;
+
+/**
+ * Reads the sizes of the memory usage from the contents of
+ * \p /proc/self/smaps_rollup or \p /proc/self/status in \p in into
+ * \p usage. The heap statistics are left unchanged.
+ *
+ * \param in The stream to read from
+ * \param usage Receives the sizes
+ * \return \p true if the resident set size was found, \p false otherwise
+ */
+bool parseMemoryUsage(std::istream& in, memusage& usage);
+
+/**
+ * Returns the current memory usage of the process.
+ *
+ * \return The memory usage; sizes that are not available are 0
+ */
+memusage getMemoryUsage();
+
+/**
+ * Writes the memory usage in \p usage to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param usage The memory usage to print
+ */
+void printMemoryUsage(std::ostream& out, const memusage& usage);
+
+#endif
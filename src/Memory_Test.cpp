@@ -0,0 +1,99 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Memory_Test.cpp
+ * \brief   Tests the files \p Memory.h and \p Memory.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Memory.h and \p Memory.cpp.
+ */
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "catch.hpp"
+#include "Memory.h"
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+/// Tests the function \p parseMemoryUsage of \p Memory
+TEST_CASE("parseMemoryUsage", "[Memory]") {
+    memusage usage;
+
+    SECTION("smaps_rollup") {
+        std::istringstream in(
+            "56545ff13000-7ffd46427000 ---p 00000000 00:00 0          [rollup]\n"
+            "Rss:                1436 kB\n"
+            "Pss:                 628 kB\n"
+            "Pss_Anon:            100 kB\n"
+            "Shared_Clean:       1296 kB\n"
+            "Anonymous:           100 kB\n"
+            "Swap:                  2 kB\n");
+        REQUIRE(parseMemoryUsage(in, usage));
+        REQUIRE(usage.rss == 1436 * 1024);
+        REQUIRE(usage.pss == 628 * 1024);
+        REQUIRE(usage.anonymous == 100 * 1024);
+        REQUIRE(usage.swap == 2 * 1024);
+    }
+
+    SECTION("status") {
+        std::istringstream in(
+            "Name:\tGtkPass\n"
+            "VmPeak:\t  250000 kB\n"
+            "VmRSS:\t   40000 kB\n"
+            "RssAnon:\t   12000 kB\n"
+            "VmSwap:\t       0 kB\n"
+            "Threads:\t2\n");
+        REQUIRE(parseMemoryUsage(in, usage));
+        REQUIRE(usage.rss == 40000 * 1024);
+        REQUIRE(usage.pss == 0);
+        REQUIRE(usage.anonymous == 12000 * 1024);
+    }
+
+    SECTION("No resident set size") {
+        std::istringstream in("Name:\tGtkPass\nThreads:\t2\n");
+        REQUIRE(parseMemoryUsage(in, usage) == false);
+        REQUIRE(usage.rss == 0);
+    }
+}
+
+/// Tests the function \p getMemoryUsage of \p Memory
+TEST_CASE("getMemoryUsage", "[Memory]") {
+    const memusage before = getMemoryUsage();
+    REQUIRE(before.rss > 0);
+
+    // touched pages are resident, though the block may reuse pages that
+    // were resident before
+    const size_t size = 16 << 20;
+    std::unique_ptr<char[]> block(new char[size]);
+    memset(block.get(), 1, size);
+    const memusage after = getMemoryUsage();
+    REQUIRE(after.rss >= size);
+    REQUIRE(after.anonymous >= size);
+#ifdef HAVE_MALLINFO2
+    REQUIRE(after.heapInUse >= before.heapInUse + size);
+#endif
+
+    std::ostringstream out;
+    printMemoryUsage(out, after);
+    REQUIRE(out.str().find("Resident set size:") != std::string::npos);
+}
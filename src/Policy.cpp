@@ -0,0 +1,129 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Policy.cpp
+ * \brief   Implements functions for translating policy names into options for
+ *          generating random strings.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for translating policy names into options
+ * for generating random strings.
+ */
+
+#include "Policy.h"
+
+namespace {
+
+/// Name and bitmask of a predefined policy or a character class
+struct PolicyName {
+    const char* name;
+    unsigned int mask;
+};
+
+/// The predefined policies
+const PolicyName PREDEFINED[] = {
+    {"default", GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER | GENOPTS_NUMBERS},
+    {"alnum", GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER | GENOPTS_NUMBERS},
+    {"alpha", GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER},
+    {"lower", GENOPTS_LETTERS_LOWER},
+    {"upper", GENOPTS_LETTERS_UPPER},
+    {"pin", GENOPTS_NUMBERS},
+    {"readable", GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER |
+        GENOPTS_NUMBERS | GENOPTS_AVOID_SIMILAR},
+    {"full", GENOPTS_LETTERS_LOWER | GENOPTS_LETTERS_UPPER | GENOPTS_NUMBERS |
+        GENOPTS_DASH | GENOPTS_SPECIAL}
+};
+
+/// The character classes and flags a policy can be composed of
+const PolicyName CLASSES[] = {
+    {"lower", GENOPTS_LETTERS_LOWER},
+    {"upper", GENOPTS_LETTERS_UPPER},
+    {"numbers", GENOPTS_NUMBERS},
+    {"space", GENOPTS_SPACE},
+    {"dash", GENOPTS_DASH},
+    {"special", GENOPTS_SPECIAL},
+    {"nosimilar", GENOPTS_AVOID_SIMILAR}
+};
+
+} // end of anonymous namespace
+
+/**
+ * Translates the policy \p name into options for generating random strings.
+ * See \p Policy.h for the known policies.
+ *
+ * \param name The name of the policy
+ * \param options Receives the options of the policy
+ * \return \p true if \p name is a valid policy, \p false otherwise
+ */
+bool parsePolicy(const std::string& name, genopts& options) {
+    for (const auto& policy : PREDEFINED) {
+        if (name == policy.name) {
+            options = getOptionsFromMask(policy.mask);
+            return true;
+        }
+    }
+
+    unsigned int mask = 0;
+    size_t start = 0;
+    while (start <= name.length()) {
+        size_t end = name.find('+', start);
+        if (end == std::string::npos)
+            end = name.length();
+        const std::string token = name.substr(start, end - start);
+
+        bool known = false;
+        for (const auto& cls : CLASSES) {
+            if (token == cls.name) {
+                mask |= cls.mask;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+        start = end + 1;
+    }
+
+    // a policy consisting of "nosimilar" only has no characters
+    if ((mask & ~GENOPTS_AVOID_SIMILAR) == 0)
+        return false;
+
+    options = getOptionsFromMask(mask);
+    return true;
+}
+
+/**
+ * Returns the name of the policy matching \p options as list of character
+ * classes joined by \p '+'. Passing the name to \p parsePolicy() yields
+ * \p options again.
+ *
+ * \param options The options to get the policy name for
+ * \return Name of the policy
+ */
+std::string getPolicyName(const genopts& options) {
+    const unsigned int mask = getOptionsMask(options);
+    std::string name;
+    for (const auto& cls : CLASSES) {
+        if (mask & cls.mask) {
+            if (!name.empty())
+                name += '+';
+            name += cls.name;
+        }
+    }
+    return name;
+}
@@ -0,0 +1,69 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Policy.h
+ * \brief   Defines functions for translating policy names into options for
+ *          generating random strings.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for translating policy names into options for
+ * generating random strings. A policy is either one of the predefined names
+ * (see \p parsePolicy()) or a list of character classes joined by \p '+',
+ * e.g. \p "lower+numbers+nosimilar".
+ */
+
+#ifndef GTKPASS_POLICY_H
+#define GTKPASS_POLICY_H
+
+#include "RandomGenerator.h"
+#include <string>
+
+/**
+ * Translates the policy \p name into options for generating random strings.
+ * The following predefined policies are known:
+ * \li \p default: lower case and upper case letters and numbers
+ * \li \p alnum: same as \p default
+ * \li \p alpha: lower case and upper case letters
+ * \li \p lower: lower case letters
+ * \li \p upper: upper case letters
+ * \li \p pin: numbers
+ * \li \p readable: same as \p default, avoiding similar characters
+ * \li \p full: letters, numbers, dash and special characters
+ *
+ * Otherwise \p name must be a list of the character classes \p lower,
+ * \p upper, \p numbers, \p space, \p dash and \p special joined by \p '+'.
+ * The flag \p nosimilar may be added to avoid similar characters.
+ *
+ * \param name The name of the policy
+ * \param options Receives the options of the policy
+ * \return \p true if \p name is a valid policy, \p false otherwise
+ */
+bool parsePolicy(const std::string& name, genopts& options);
+
+/**
+ * Returns the name of the policy matching \p options as list of character
+ * classes joined by \p '+'. Passing the name to \p parsePolicy() yields
+ * \p options again.
+ *
+ * \param options The options to get the policy name for
+ * \return Name of the policy
+ */
+std::string getPolicyName(const genopts& options);
+
+#endif
@@ -0,0 +1,75 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Policy_Test.cpp
+ * \brief   Tests the files \p Policy.h and \p Policy.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Policy.h and \p Policy.cpp.
+ */
+
+
+#include "catch.hpp"
+#include "Policy.h"
+
+/// Tests the function \p parsePolicy of \p Policy
+TEST_CASE("parsePolicy", "[Policy]") {
+    genopts options;
+
+    SECTION("Predefined policies") {
+        REQUIRE(parsePolicy("default", options));
+        REQUIRE(getOptionsMask(options) == getOptionsMask(genopts()));
+
+        REQUIRE(parsePolicy("pin", options));
+        REQUIRE(getOptionsMask(options) == GENOPTS_NUMBERS);
+
+        REQUIRE(parsePolicy("readable", options));
+        REQUIRE(options.bAvoidSimilarChars == true);
+    }
+
+    SECTION("Composed policies") {
+        REQUIRE(parsePolicy("lower+numbers+nosimilar", options));
+        REQUIRE(getOptionsMask(options) == (GENOPTS_LETTERS_LOWER |
+            GENOPTS_NUMBERS | GENOPTS_AVOID_SIMILAR));
+
+        REQUIRE(parsePolicy("special", options));
+        REQUIRE(getOptionsMask(options) == GENOPTS_SPECIAL);
+    }
+
+    SECTION("Invalid policies") {
+        REQUIRE_FALSE(parsePolicy("", options));
+        REQUIRE_FALSE(parsePolicy("unknown", options));
+        REQUIRE_FALSE(parsePolicy("lower+", options));
+        REQUIRE_FALSE(parsePolicy("lower++upper", options));
+        REQUIRE_FALSE(parsePolicy("nosimilar", options));
+    }
+}
+
+/// Tests the function \p getPolicyName of \p Policy
+TEST_CASE("getPolicyName", "[Policy]") {
+    genopts options;
+    REQUIRE(getPolicyName(options) == "lower+upper+numbers");
+
+    for (unsigned int mask = 1; mask < GENOPTS_COMBINATIONS; mask++) {
+        if ((mask & ~GENOPTS_AVOID_SIMILAR) == 0)
+            continue;
+        REQUIRE(parsePolicy(getPolicyName(getOptionsFromMask(mask)), options));
+        REQUIRE(getOptionsMask(options) == mask);
+    }
+}
@@ -0,0 +1,52 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Probes.h
+ * \brief   Defines macros for USDT static tracepoints of \p GtkPass.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines macros for firing USDT static tracepoints of the provider
+ * \p gtkpass. If the project is configured with \p --enable-usdt and the
+ * header \p sys/sdt.h is available, each probe compiles to a single \p nop
+ * instruction plus an ELF note that tools like \p bpftrace or \p perf can
+ * attach to. Otherwise the macros expand to nothing.
+ */
+
+#ifndef GTKPASS_PROBES_H
+#define GTKPASS_PROBES_H
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#ifdef ENABLE_USDT
+#   include <sys/sdt.h>
+/// Fires the probe \p name without arguments
+#   define GTKPASS_PROBE(name) DTRACE_PROBE(gtkpass, name)
+/// Fires the probe \p name with one argument
+#   define GTKPASS_PROBE1(name, a1) DTRACE_PROBE1(gtkpass, name, a1)
+/// Fires the probe \p name with two arguments
+#   define GTKPASS_PROBE2(name, a1, a2) DTRACE_PROBE2(gtkpass, name, a1, a2)
+#else
+#   define GTKPASS_PROBE(name) do {} while (0)
+#   define GTKPASS_PROBE1(name, a1) do {} while (0)
+#   define GTKPASS_PROBE2(name, a1, a2) do {} while (0)
+#endif
+
+#endif
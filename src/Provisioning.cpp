@@ -0,0 +1,413 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Provisioning.cpp
+ * \brief   Implements the pipeline for provisioning passwords from a
+ *          manifest.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements the pipeline for provisioning passwords from a
+ * manifest.
+ */
+
+#include "Provisioning.h"
+#include "Policy.h"
+#include "Scheduler.h"
+#include "SpscQueue.h"
+#include "Statistics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace {
+
+/// Maximum length of a password in the manifest
+const unsigned long MAX_LENGTH = 1048576;
+
+/// A single account of the manifest
+struct Row {
+    /// Initializes a row without password
+    Row() : length(0), skipped(false) {}
+
+    /// id of the account
+    std::string account;
+    /// options for generating the password
+    genopts options;
+    /// length of the password
+    unsigned int length;
+    /// the generated password
+    std::string password;
+    /// the encoded hash of the password (empty if not hashed)
+    std::string hash;
+    /// whether no password could be generated, so the row is neither
+    /// hashed nor written
+    bool skipped;
+};
+
+/// A batch of rows passed between the stages
+struct Batch {
+    /// the rows of the batch
+    std::vector<Row> rows;
+    /// the formatted output of all rows
+    std::string text;
+};
+
+/// Queue of batches between two stages
+typedef SpscQueue<std::unique_ptr<Batch>> BatchQueue;
+
+/// Returns the current time of a monotonic clock in nanoseconds
+uint64_t now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Overwrites the contents of \p str with zeros
+void wipe(std::string& str) {
+    if (!str.empty())
+        sodium_memzero(&str[0], str.size());
+}
+
+/**
+ * Parses the manifest line \p line into \p row.
+ *
+ * \param line The line without line break
+ * \param row Receives the account, options and length
+ * \param policy Name of the policy parsed last, updated on change
+ * \param options Options of the policy parsed last, updated on change
+ * \param numeric Set to \p false if the length column is not a number
+ * \return \p true if the line is valid, \p false otherwise
+ */
+bool parseLine(const std::string& line, Row& row, std::string& policy,
+    genopts& options, bool& numeric) {
+    // the account id may contain commas, so split at the last two commas
+    const size_t lengthSep = line.rfind(',');
+    if (lengthSep == std::string::npos || lengthSep == 0)
+        return false;
+    const size_t policySep = line.rfind(',', lengthSep - 1);
+    if (policySep == std::string::npos || policySep == 0)
+        return false;
+
+    const std::string lengthStr = line.substr(lengthSep + 1);
+    char* end = nullptr;
+    const unsigned long length = std::strtoul(lengthStr.c_str(), &end, 10);
+    numeric = !lengthStr.empty() && *end == '\0';
+    if (!numeric || length == 0 || length > MAX_LENGTH)
+        return false;
+
+    const std::string name = line.substr(policySep + 1, lengthSep - policySep - 1);
+    if (name != policy) {
+        genopts parsed;
+        if (!parsePolicy(name, parsed))
+            return false;
+        policy = name;
+        options = parsed;
+    }
+
+    row.account = line.substr(0, policySep);
+    row.options = options;
+    row.length = static_cast<unsigned int>(length);
+    return true;
+}
+
+/**
+ * Runs the stage \p process on every batch from \p input and pushes it to
+ * \p output. Only the time spent in \p process counts as busy time.
+ */
+template <typename Function>
+void runStage(BatchQueue& input, BatchQueue* output, pipelinestage& stats,
+    Function process) {
+    std::unique_ptr<Batch> batch;
+    while (input.pop(batch)) {
+        const uint64_t start = now();
+        process(*batch);
+        stats.busyNanoseconds += now() - start;
+        stats.rows += batch->rows.size();
+        if (output)
+            output->push(std::move(batch));
+    }
+    if (output)
+        output->close();
+}
+
+/// Copies the statistics of \p queue into the report entry \p stats
+void reportQueue(const BatchQueue& queue, pipelinequeue& stats) {
+    stats.capacity = queue.capacity();
+    stats.averageOccupancy = queue.averageOccupancy();
+    stats.maximumOccupancy = queue.maximumOccupancy();
+}
+
+} // end of anonymous namespace
+
+/**
+ * Reads the manifest from \p manifest and writes a password for every
+ * account to \p output in the format \p options.format. If
+ * \p options.hash is set, every password is also hashed with Argon2id and
+ * the hash is written as third field. If \p options.blocklist is set,
+ * passwords on the blocklist are generated again. Lines that cannot be
+ * parsed are reported to \p errors and skipped.
+ *
+ * \param manifest The stream to read the manifest from
+ * \param output The stream to write the passwords to
+ * \param errors The stream to report invalid lines to
+ * \param report Receives the statistics of the run
+ * \param options The options of the run
+ * \return \p true if all lines were processed, \p false if lines were
+ * skipped, hashing failed or writing failed
+ */
+bool runProvisioning(std::istream& manifest, std::ostream& output,
+    std::ostream& errors, pipelinereport& report, const provopts& options) {
+    const uint64_t start = now();
+    report = pipelinereport();
+    bool writeFailed = false;
+    std::atomic<uint64_t> hashFailures(0);
+    uint64_t blockedRows = 0;
+    std::unique_ptr<WorkerPool> hashPool;
+
+    // the stages following the parse stage in pipeline order
+    std::vector<std::pair<std::string, std::function<void(Batch&)>>> stages;
+
+    stages.emplace_back("generate", [](Batch& batch) {
+        size_t characters = 0;
+        for (auto& row : batch.rows) {
+            const std::string& alpha = getAlphabet(row.options);
+            row.password.resize(row.length);
+            fillRandomChars(&row.password[0], row.length, alpha);
+            characters += row.length;
+        }
+        statsRecordBatch(batch.rows.size(), characters);
+    });
+
+    if (options.blocklist) {
+        // a candidate is blocked at most a few times, unless the policy and
+        // length allow hardly any password that is not on the blocklist
+        const Blocklist& blocklist = *options.blocklist;
+        stages.emplace_back("filter", [&](Batch& batch) {
+            for (auto& row : batch.rows) {
+                const std::string& alpha = getAlphabet(row.options);
+                unsigned int attempts = 0;
+                while (blocklist.contains(row.password.data(), row.password.size())) {
+                    report.blockedPasswords++;
+                    if (++attempts == BLOCKLIST_MAX_ATTEMPTS) {
+                        wipe(row.password);
+                        row.password.clear();
+                        row.skipped = true;
+                        blockedRows++;
+                        break;
+                    }
+                    fillRandomChars(&row.password[0], row.length, alpha);
+                }
+            }
+        });
+    }
+
+    if (options.hash) {
+        // hashing is orders of magnitude slower than generating, so the rows
+        // of a batch are hashed in parallel, as many as fit into the budget;
+        // the threads are started once for the whole run, not per batch
+        hashPool.reset(new WorkerPool(getHashWorkerCount(options.hashing)));
+        stages.emplace_back("hash", [&](Batch& batch) {
+            // skipped rows would cost a whole hash each
+            std::vector<size_t> hashed;
+            hashed.reserve(batch.rows.size());
+            for (size_t i = 0; i < batch.rows.size(); i++) {
+                if (!batch.rows[i].skipped)
+                    hashed.push_back(i);
+            }
+            hashPool->run(hashed.size(), [&](size_t i) {
+                Row& row = batch.rows[hashed[i]];
+                if (!hashPassword(row.password, options.hashing, row.hash))
+                    hashFailures++;
+            });
+        });
+    }
+
+    const outformat format = options.format;
+    stages.emplace_back("format", [format](Batch& batch) {
+        // reserve the whole batch at once, so the text is never reallocated
+        size_t size = 0;
+        for (const auto& row : batch.rows) {
+            if (row.skipped)
+                continue;
+            size += getRecordSize(format,
+                row.account.size() + row.password.size() + row.hash.size());
+        }
+        batch.text.clear();
+        batch.text.reserve(size);
+        for (auto& row : batch.rows) {
+            if (row.skipped)
+                continue;
+            appendRecord(batch.text, format, row.account, row.password, row.hash);
+            wipe(row.password);
+        }
+    });
+
+    stages.emplace_back("write", [&](Batch& batch) {
+        if (!writeFailed) {
+            output.write(batch.text.data(), batch.text.size());
+            writeFailed = !output;
+        }
+        wipe(batch.text);
+    });
+
+    // one queue in front of every stage but the parse stage; the queues are
+    // cache line aligned, so they live on the stack instead of the heap
+    BatchQueue queue0(PIPELINE_QUEUE_BATCHES);
+    BatchQueue queue1(PIPELINE_QUEUE_BATCHES);
+    BatchQueue queue2(PIPELINE_QUEUE_BATCHES);
+    BatchQueue queue3(PIPELINE_QUEUE_BATCHES);
+    BatchQueue queue4(PIPELINE_QUEUE_BATCHES);
+    BatchQueue* const allQueues[] = { &queue0, &queue1, &queue2, &queue3, &queue4 };
+    const std::vector<BatchQueue*> queues(allQueues, allQueues + stages.size());
+
+    report.stages.emplace_back("parse");
+    for (const auto& stage : stages) {
+        report.queues.emplace_back(report.stages.back().name + " -> " + stage.first);
+        report.stages.emplace_back(stage.first);
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < stages.size(); i++) {
+        threads.emplace_back([&, i]() {
+            BatchQueue* next = i + 1 < queues.size() ? queues[i + 1] : nullptr;
+            runStage(*queues[i], next, report.stages[i + 1], stages[i].second);
+        });
+    }
+
+    // the calling thread parses the manifest
+    BatchQueue& toGenerate = *queues.front();
+    std::string line;
+    std::string policy;
+    genopts policyOptions;
+    uint64_t lineNumber = 0;
+    bool firstLine = true;
+    std::unique_ptr<Batch> batch(new Batch());
+    uint64_t parseStart = now();
+
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        Row row;
+        bool numeric = true;
+        if (parseLine(line, row, policy, policyOptions, numeric)) {
+            batch->rows.push_back(std::move(row));
+        } else if (!(firstLine && !numeric)) {
+            errors << "Manifest line " << lineNumber << ": invalid row \""
+                << line << "\"" << std::endl;
+            report.rejectedRows++;
+        }
+        firstLine = false;
+
+        if (batch->rows.size() == PIPELINE_BATCH_ROWS) {
+            report.stages[0].rows += batch->rows.size();
+            report.stages[0].busyNanoseconds += now() - parseStart;
+            toGenerate.push(std::move(batch));
+            batch.reset(new Batch());
+            parseStart = now();
+        }
+    }
+    if (!batch->rows.empty()) {
+        report.stages[0].rows += batch->rows.size();
+        report.stages[0].busyNanoseconds += now() - parseStart;
+        toGenerate.push(std::move(batch));
+    }
+    toGenerate.close();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    output.flush();
+    writeFailed = writeFailed || !output;
+
+    for (size_t i = 0; i < queues.size(); i++) {
+        reportQueue(*queues[i], report.queues[i]);
+    }
+    report.failedRows = hashFailures.load() + blockedRows;
+    report.elapsedNanoseconds = now() - start;
+
+    if (hashFailures > 0) {
+        errors << "Failed to hash " << hashFailures.load()
+            << " passwords (out of memory?)" << std::endl;
+    }
+    if (blockedRows > 0) {
+        errors << "Failed to generate " << blockedRows
+            << " passwords not on the blocklist" << std::endl;
+    }
+    return report.rejectedRows == 0 && report.failedRows == 0 && !writeFailed;
+}
+
+/**
+ * Writes the statistics in \p report to \p out in a human readable form. The
+ * stage with the highest busy time is the bottleneck of the pipeline.
+ *
+ * \param out The stream to write to
+ * \param report The statistics to print
+ */
+void printPipelineReport(std::ostream& out, const pipelinereport& report) {
+    const double elapsed = report.elapsedNanoseconds / 1e9;
+    size_t bottleneck = 0;
+
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(12) << "Stage" << std::right
+        << std::setw(10) << "Rows" << std::setw(12) << "Busy (s)"
+        << std::setw(15) << "Rows/s (busy)" << std::setw(14) << "Utilization"
+        << std::endl;
+    for (size_t i = 0; i < report.stages.size(); i++) {
+        const pipelinestage& stage = report.stages[i];
+        const double busy = stage.busyNanoseconds / 1e9;
+        if (stage.busyNanoseconds > report.stages[bottleneck].busyNanoseconds)
+            bottleneck = i;
+        out << std::left << std::setw(12) << stage.name << std::right
+            << std::setw(10) << stage.rows
+            << std::setw(12) << std::setprecision(3) << busy
+            << std::setw(15) << std::setprecision(0)
+            << (busy > 0 ? stage.rows / busy : 0.0)
+            << std::setw(12) << std::setprecision(1)
+            << (elapsed > 0 ? 100.0 * busy / elapsed : 0.0) << " %" << std::endl;
+    }
+
+    out << std::left << std::setw(20) << "Queue" << std::right
+        << std::setw(10) << "Capacity" << std::setw(16) << "Avg. occupancy"
+        << std::setw(16) << "Max. occupancy" << std::endl;
+    for (const auto& queue : report.queues) {
+        out << std::left << std::setw(20) << queue.name << std::right
+            << std::setw(10) << queue.capacity
+            << std::setw(16) << std::setprecision(1) << queue.averageOccupancy
+            << std::setw(16) << queue.maximumOccupancy << std::endl;
+    }
+
+    out << std::setprecision(3) << "Elapsed: " << elapsed << " s";
+    if (!report.stages.empty())
+        out << ", bottleneck: " << report.stages[bottleneck].name;
+    out << ", rejected rows: " << report.rejectedRows;
+    if (report.failedRows > 0)
+        out << ", failed rows: " << report.failedRows;
+    if (report.blockedPasswords > 0)
+        out << ", blocked passwords: " << report.blockedPasswords;
+    out << std::endl;
+}
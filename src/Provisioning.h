@@ -0,0 +1,166 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Provisioning.h
+ * \brief   Defines the pipeline for provisioning passwords from a manifest.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines the pipeline for provisioning passwords from a manifest.
+ * A manifest is a CSV file with one account per line:
+ *
+ *     account id,policy name,length
+ *
+ * Empty lines and lines starting with \p '#' are ignored, as is a first line
+ * whose length column is not a number (a header). See \p parsePolicy() for
+ * the policy names. For every account the pipeline writes one record of the
+ * account id, the password and optionally the hash of the password to the
+ * output, as CSV by default (see \p appendRecord() for all formats).
+ *
+ * Reading, generating, hashing, formatting and writing run in stages on their
+ * own threads, connected by bounded queues of batches of rows. So the stages
+ * overlap and the memory needed does not depend on the size of the manifest.
+ * The hash stage additionally hashes the rows of a batch in parallel. An
+ * optional filter stage between generating and hashing generates passwords
+ * found on a blocklist again; rows that only get blocked passwords are
+ * skipped by the following stages.
+ */
+
+#ifndef GTKPASS_PROVISIONING_H
+#define GTKPASS_PROVISIONING_H
+
+#include "Blocklist.h"
+#include "Formatter.h"
+#include "Hashing.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Maximum number of rows in a batch passed between the stages
+#define PIPELINE_BATCH_ROWS 256
+/// Number of batches each queue between two stages can hold
+#define PIPELINE_QUEUE_BATCHES 16
+
+/**
+ * \typedef pipestage
+ * \brief Defines a struct holding the statistics of a pipeline stage.
+ */
+typedef struct pipelinestage {
+    /// Initializes the statistics of the stage \p name with 0
+    explicit pipelinestage(const std::string& name) : name(name), rows(0),
+        busyNanoseconds(0) {}
+    /// name of the stage
+    std::string name;
+    /// number of rows processed
+    uint64_t rows;
+    /// time spent processing rows (without waiting for other stages)
+    uint64_t busyNanoseconds;
+} pipestage;
+
+/**
+ * \typedef pipequeue
+ * \brief Defines a struct holding the statistics of a queue between two
+ * pipeline stages.
+ */
+typedef struct pipelinequeue {
+    /// Initializes the statistics of the queue \p name with 0
+    explicit pipelinequeue(const std::string& name) : name(name), capacity(0),
+        averageOccupancy(0.0), maximumOccupancy(0) {}
+    /// name of the queue
+    std::string name;
+    /// number of batches the queue can hold
+    size_t capacity;
+    /// average number of batches in the queue
+    double averageOccupancy;
+    /// maximum number of batches in the queue
+    size_t maximumOccupancy;
+} pipequeue;
+
+/**
+ * \typedef pipereport
+ * \brief Defines a struct holding the statistics of a pipeline run.
+ */
+typedef struct pipelinereport {
+    /// Initializes an empty report
+    pipelinereport() : rejectedRows(0), failedRows(0), blockedPasswords(0),
+        elapsedNanoseconds(0) {}
+    /// statistics of all stages in pipeline order
+    std::vector<pipestage> stages;
+    /// statistics of all queues in pipeline order
+    std::vector<pipequeue> queues;
+    /// number of manifest lines that could not be parsed
+    uint64_t rejectedRows;
+    /// number of rows whose password could not be hashed or only consisted
+    /// of blocked passwords
+    uint64_t failedRows;
+    /// number of generated passwords found on the blocklist
+    uint64_t blockedPasswords;
+    /// wall clock time of the whole run
+    uint64_t elapsedNanoseconds;
+} pipereport;
+
+/**
+ * \typedef provopts
+ * \brief Defines a struct holding the options of a provisioning run.
+ */
+typedef struct provisioningoptions {
+    /// Initializes the options for CSV output without hashes
+    provisioningoptions() : hash(false), format(FORMAT_CSV), blocklist(nullptr) {}
+    /// whether to hash the passwords
+    bool hash;
+    /// options for hashing the passwords
+    hashopts hashing;
+    /// format of the output
+    outformat format;
+    /// blocklist of passwords to generate again (\p nullptr for none)
+    const Blocklist* blocklist;
+} provopts;
+
+/**
+ * Reads the manifest from \p manifest and writes a password for every
+ * account to \p output in the format \p options.format. If
+ * \p options.hash is set, every password is also hashed with Argon2id and
+ * the hash is written as third field. If \p options.blocklist is set,
+ * passwords on the blocklist are generated again. Lines that cannot be
+ * parsed are reported to \p errors and skipped.
+ *
+ * \param manifest The stream to read the manifest from
+ * \param output The stream to write the passwords to
+ * \param errors The stream to report invalid lines to
+ * \param report Receives the statistics of the run
+ * \param options The options of the run
+ * \return \p true if all lines were processed, \p false if lines were
+ * skipped, hashing failed or writing failed
+ */
+bool runProvisioning(std::istream& manifest, std::ostream& output,
+    std::ostream& errors, pipereport& report,
+    const provopts& options = provopts());
+
+/**
+ * Writes the statistics in \p report to \p out in a human readable form. The
+ * stage with the highest busy time is the bottleneck of the pipeline.
+ *
+ * \param out The stream to write to
+ * \param report The statistics to print
+ */
+void printPipelineReport(std::ostream& out, const pipereport& report);
+
+#endif
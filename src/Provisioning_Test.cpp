@@ -0,0 +1,87 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Provisioning_Test.cpp
+ * \brief   Tests the files \p Provisioning.h and \p Provisioning.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Provisioning.h and \p Provisioning.cpp.
+ */
+
+
+#include "catch.hpp"
+#include "Provisioning.h"
+#include "RandomGenerator.h"
+#include <sstream>
+
+/// Tests the function \p runProvisioning of \p Provisioning
+TEST_CASE("runProvisioning", "[Provisioning]") {
+    std::ostringstream output;
+    std::ostringstream errors;
+    pipelinereport report;
+
+    SECTION("Valid manifest") {
+        std::stringstream manifest;
+        manifest << "account,policy,length\r\n"
+            << "# comment\n"
+            << "\n";
+        // more rows than fit into a single batch
+        const size_t rows = 3 * PIPELINE_BATCH_ROWS + 7;
+        for (size_t i = 0; i < rows; i++) {
+            manifest << "user" << i << ",pin," << (i % 20 + 1) << "\n";
+        }
+
+        REQUIRE(runProvisioning(manifest, output, errors, report));
+        REQUIRE(errors.str().empty());
+        REQUIRE(report.rejectedRows == 0);
+        REQUIRE(report.stages.size() == 4);
+        for (const auto& stage : report.stages) {
+            REQUIRE(stage.rows == rows);
+        }
+
+        // the output keeps the order of the manifest
+        std::istringstream lines(output.str());
+        std::string line;
+        size_t i = 0;
+        while (std::getline(lines, line)) {
+            const std::string prefix = "user" + std::to_string(i) + ",";
+            REQUIRE(line.compare(0, prefix.size(), prefix) == 0);
+            const std::string password = line.substr(prefix.size());
+            REQUIRE(password.length() == i % 20 + 1);
+            REQUIRE(password.find_first_not_of(ALPHA_NUMBERS) == std::string::npos);
+            i++;
+        }
+        REQUIRE(i == rows);
+    }
+
+    SECTION("Quoting") {
+        std::istringstream manifest("Doe, \"John\",special,4\n");
+        REQUIRE(runProvisioning(manifest, output, errors, report));
+        const std::string prefix = "\"Doe, \"\"John\"\"\",";
+        REQUIRE(output.str().compare(0, prefix.size(), prefix) == 0);
+    }
+
+    SECTION("Invalid rows") {
+        std::istringstream manifest("a,pin,8\nb,unknown,8\nc,pin,0\nd,pin,x\ne\nf,pin,8\n");
+        REQUIRE_FALSE(runProvisioning(manifest, output, errors, report));
+        REQUIRE(report.rejectedRows == 4);
+        REQUIRE(report.stages[0].rows == 2);
+        REQUIRE(errors.str().find("line 2") != std::string::npos);
+    }
+}
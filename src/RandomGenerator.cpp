@@ -27,12 +27,127 @@
  */
 
 #include "RandomGenerator.h"
+#include "Probes.h"
+#include "Statistics.h"
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
 
 /**
- * Generates a random unsigned integer with sodium and returns it as
- * \p uint32_t.
+ * Per-thread state of the generator. Holds a block of random bytes fetched
+ * from libsodium at once, so generating short strings does not need a call
+ * into libsodium for every single character and concurrent threads do not
+ * share any mutable state.
+ */
+struct GeneratorContext {
+    GeneratorContext() : position(RANDOM_BLOCK_SIZE) {}
+    ~GeneratorContext() { sodium_memzero(block, sizeof(block)); }
+
+    /// Buffered random bytes
+    unsigned char block[RANDOM_BLOCK_SIZE];
+    /// Offset of the next unused byte in \p block
+    size_t position;
+};
+
+/// Returns the generator context of the calling thread
+GeneratorContext& getContext() {
+    static thread_local GeneratorContext context;
+    return context;
+}
+
+/**
+ * Takes the next random number from the buffered block in \p context and
+ * refills the block if it is exhausted.
+ *
+ * \param context The generator context of the calling thread
+ * \return Random number between 0 and 0xFFFFFFFF
+ */
+inline uint32_t nextRandomNumber(GeneratorContext& context) {
+    if (context.position + sizeof(uint32_t) > RANDOM_BLOCK_SIZE) {
+        GTKPASS_PROBE1(rng_refill, RANDOM_BLOCK_SIZE);
+        statsRecordRefill();
+        randombytes_buf(context.block, RANDOM_BLOCK_SIZE);
+        context.position = 0;
+    }
+    uint32_t value;
+    std::memcpy(&value, context.block + context.position, sizeof(value));
+    context.position += sizeof(value);
+    return value;
+}
+
+/**
+ * Returns a uniformly distributed random number between 0 and \p bound - 1.
+ * Numbers from the incomplete last interval of the 32 bit range are rejected
+ * and drawn again, so no number is more likely than another one (no modulo
+ * bias).
+ *
+ * \param context The generator context of the calling thread
+ * \param bound The number of possible values (must not be 0)
+ * \param draws Incremented by the number of random numbers drawn
+ * \return Random number between 0 and \p bound - 1
+ */
+inline uint32_t nextRandomIndex(GeneratorContext& context, const uint32_t bound,
+    size_t& draws) {
+    const uint32_t min = (1U + ~bound) % bound;
+    uint32_t value = nextRandomNumber(context);
+    draws++;
+    while (value < min) {
+        GTKPASS_PROBE1(rejection_retry, bound);
+        statsRecordRetry();
+        value = nextRandomNumber(context);
+        draws++;
+    }
+    return value % bound;
+}
+
+/**
+ * Table of the alphabets for all combinations of the options in \p genopts,
+ * indexed by \p getOptionsMask(). It is built once and only read afterwards,
+ * so all threads can share it.
+ */
+struct AlphabetTable {
+    AlphabetTable();
+    std::string alphabets[GENOPTS_COMBINATIONS];
+};
+
+/**
+ * Builds the alphabets for all combinations of options.
+ */
+AlphabetTable::AlphabetTable() {
+    for (unsigned int mask = 0; mask < GENOPTS_COMBINATIONS; mask++) {
+        std::stringstream alphabet;
+
+        // include alphabet characters based on options
+        if (mask & GENOPTS_LETTERS_LOWER)
+            alphabet << ALPHA_LETTERS_LOWER;
+        if (mask & GENOPTS_LETTERS_UPPER)
+            alphabet << ALPHA_LETTERS_UPPER;
+        if (mask & GENOPTS_NUMBERS)
+            alphabet << ALPHA_NUMBERS;
+        if (mask & GENOPTS_SPACE)
+            alphabet << ALPHA_SPACE;
+        if (mask & GENOPTS_DASH)
+            alphabet << ALPHA_DASH;
+        if (mask & GENOPTS_SPECIAL)
+            alphabet << ALPHA_SPECIAL;
+
+        // get the alphabet string
+        alphabets[mask] = alphabet.str();
+
+        // remove characters from alphabet when avoiding similar
+        if (mask & GENOPTS_AVOID_SIMILAR)
+            removeFromString(alphabets[mask], ALPHA_SIMILAR);
+    }
+}
+
+} // end of anonymous namespace
+
+/**
+ * Generates a random unsigned integer from the calling thread's block of
+ * random bytes fetched with sodium and returns it as \p uint32_t.
  * The optional parameter \p upperBound can be used to set the upper bound for
  * generated numbers. If \p upperBound is 0 the bound will be ignored.
  *
@@ -41,59 +156,127 @@
  * \p upperBound is 0)
  */
 uint32_t getRandomNumber(uint32_t upperBound) {
+    GeneratorContext& context = getContext();
+    size_t draws = 1;
+    uint32_t value;
     if (upperBound == 0) {
-        return randombytes_random();
+        value = nextRandomNumber(context);
     } else {
-        return randombytes_uniform(upperBound);
+        draws = 0;
+        value = nextRandomIndex(context, upperBound, draws);
     }
+    statsRecordBytes(draws * sizeof(uint32_t));
+    return value;
 }
 
 /**
- * Generates a random string by using a random number returned by
- * \p getRandomNumber(). The string will contain \p length characters and will
- * meet the requirements in \p options.
+ * Returns a bitmask with one bit set for every option enabled in \p options.
+ * The bits are defined by the \p GENOPTS_* constants.
  *
- * \param length The number of characters in the string
- * \param options The options for generating the string
- * \return Random string
+ * \param options The options to get the bitmask for
+ * \return Bitmask between 0 and \p GENOPTS_COMBINATIONS - 1
  */
-std::string getRandomString(const unsigned int length, const genopts& options){
-    std::stringstream alphabet;
-    if (length <= 0)
-        return "";
-
-    // include alphabet characters based on options
+unsigned int getOptionsMask(const genopts& options) {
+    unsigned int mask = 0;
     if (options.bIncludeLettersLower)
-        alphabet << ALPHA_LETTERS_LOWER;
+        mask |= GENOPTS_LETTERS_LOWER;
     if (options.bIncludeLettersUpper)
-        alphabet << ALPHA_LETTERS_UPPER;
+        mask |= GENOPTS_LETTERS_UPPER;
     if (options.bIncludeNumbers)
-        alphabet << ALPHA_NUMBERS;
+        mask |= GENOPTS_NUMBERS;
     if (options.bIncludeSpace)
-        alphabet << ALPHA_SPACE;
+        mask |= GENOPTS_SPACE;
     if (options.bIncludeDash)
-        alphabet << ALPHA_DASH;
+        mask |= GENOPTS_DASH;
     if (options.bIncludeSpecial)
-        alphabet << ALPHA_SPECIAL;
+        mask |= GENOPTS_SPECIAL;
+    if (options.bAvoidSimilarChars)
+        mask |= GENOPTS_AVOID_SIMILAR;
+    return mask;
+}
 
-    // get the alphabet string
-    std::string alpha = alphabet.str();
+/**
+ * Returns the options matching the bitmask \p mask. This is the inverse of
+ * \p getOptionsMask().
+ *
+ * \param mask Bitmask of \p GENOPTS_* constants
+ * \return The options
+ */
+genopts getOptionsFromMask(unsigned int mask) {
+    genopts options;
+    options.bIncludeLettersLower = (mask & GENOPTS_LETTERS_LOWER) != 0;
+    options.bIncludeLettersUpper = (mask & GENOPTS_LETTERS_UPPER) != 0;
+    options.bIncludeNumbers = (mask & GENOPTS_NUMBERS) != 0;
+    options.bIncludeSpace = (mask & GENOPTS_SPACE) != 0;
+    options.bIncludeDash = (mask & GENOPTS_DASH) != 0;
+    options.bIncludeSpecial = (mask & GENOPTS_SPECIAL) != 0;
+    options.bAvoidSimilarChars = (mask & GENOPTS_AVOID_SIMILAR) != 0;
+    return options;
+}
 
-    // remove characters from alphabet when avoiding similar
-    if (options.bAvoidSimilarChars)
-        removeFromString(alpha, ALPHA_SIMILAR);
+/**
+ * Returns the alphabet of all characters a string generated with \p options
+ * may consist of. The alphabets for all combinations of options are built
+ * once and shared by all threads, so the returned reference stays valid for
+ * the lifetime of the program.
+ *
+ * \param options The options to get the alphabet for
+ * \return Constant reference to the alphabet
+ */
+const std::string& getAlphabet(const genopts& options) {
+    static const AlphabetTable table;
+    return table.alphabets[getOptionsMask(options)];
+}
 
-    if (alpha.length() <= 0)
-        return "";
+/**
+ * Fills \p buffer with \p length characters chosen randomly from
+ * \p alphabet. The buffer is not terminated with a null character.
+ *
+ * \param buffer The buffer to write to (at least \p length bytes)
+ * \param length The number of characters to write
+ * \param alphabet The characters to choose from (must not be empty)
+ */
+void fillRandomChars(char* buffer, const size_t length,
+    const std::string& alphabet) {
+    GeneratorContext& context = getContext();
+    const uint32_t alphaLength = static_cast<uint32_t>(alphabet.length());
+    const char* alpha = alphabet.data();
+    size_t draws = 0;
 
-    std::stringstream randomString;
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = alpha[nextRandomIndex(context, alphaLength, draws)];
+    }
+    statsRecordBytes(draws * sizeof(uint32_t));
+}
 
-    // generate the random string
-    for (unsigned int i = 0; i < length; i++) {
-        randomString << alpha[getRandomNumber() % (alpha.length() - 1)];
+/**
+ * Generates a random string by using random numbers from the calling thread's
+ * block of buffered random bytes. The string will contain \p length
+ * characters and will meet the requirements in \p options.
+ *
+ * \param length The number of characters in the string
+ * \param options The options for generating the string
+ * \return Random string
+ */
+std::string getRandomString(const unsigned int length, const genopts& options){
+    const auto start = std::chrono::steady_clock::now();
+    GTKPASS_PROBE1(random_string_entry, length);
+
+    const std::string& alpha = getAlphabet(options);
+    if (length <= 0 || alpha.length() <= 0) {
+        GTKPASS_PROBE2(random_string_return, length, 0);
+        return "";
     }
 
-    return randomString.str();
+    // generate the random string
+    std::string result(length, '\0');
+    fillRandomChars(&result[0], length, alpha);
+
+    statsRecordString(length, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    GTKPASS_PROBE2(random_string_return, length, alpha.length());
+    return result;
 }
 
 /**
@@ -47,6 +47,26 @@
 /// Defines all characters to optionally avoid because of similarity
 #define ALPHA_SIMILAR "0O1l|I"
 
+/// Bit of \p bIncludeLettersLower in the bitmask of a \p genopts
+#define GENOPTS_LETTERS_LOWER 0x01
+/// Bit of \p bIncludeLettersUpper in the bitmask of a \p genopts
+#define GENOPTS_LETTERS_UPPER 0x02
+/// Bit of \p bIncludeNumbers in the bitmask of a \p genopts
+#define GENOPTS_NUMBERS 0x04
+/// Bit of \p bIncludeSpace in the bitmask of a \p genopts
+#define GENOPTS_SPACE 0x08
+/// Bit of \p bIncludeDash in the bitmask of a \p genopts
+#define GENOPTS_DASH 0x10
+/// Bit of \p bIncludeSpecial in the bitmask of a \p genopts
+#define GENOPTS_SPECIAL 0x20
+/// Bit of \p bAvoidSimilarChars in the bitmask of a \p genopts
+#define GENOPTS_AVOID_SIMILAR 0x40
+/// Number of different bitmasks of a \p genopts
+#define GENOPTS_COMBINATIONS 0x80
+
+/// Number of random bytes every thread fetches from libsodium at once
+#define RANDOM_BLOCK_SIZE 512
+
 /**
  * \typedef genopts
  * \brief Defines a struct holding options for generating random strings.
@@ -79,8 +99,8 @@ typedef struct options {
 } genopts;
 
 /**
- * Generates a random unsigned integer with sodium and returns it as
- * \p uint32_t.
+ * Generates a random unsigned integer from the calling thread's block of
+ * random bytes fetched with sodium and returns it as \p uint32_t.
  * The optional parameter \p upperBound can be used to set the upper bound for
  * generated numbers. If \p upperBound is 0 the bound will be ignored.
  *
@@ -91,9 +111,49 @@ typedef struct options {
 uint32_t getRandomNumber(uint32_t upperBound = 0);
 
 /**
- * Generates a random string by using a random number returned by
- * \p getRandomNumber(). The string will contain \p length characters and will
- * meet the requirements in \p options.
+ * Returns a bitmask with one bit set for every option enabled in \p options.
+ * The bits are defined by the \p GENOPTS_* constants.
+ *
+ * \param options The options to get the bitmask for
+ * \return Bitmask between 0 and \p GENOPTS_COMBINATIONS - 1
+ */
+unsigned int getOptionsMask(const genopts& options);
+
+/**
+ * Returns the options matching the bitmask \p mask. This is the inverse of
+ * \p getOptionsMask().
+ *
+ * \param mask Bitmask of \p GENOPTS_* constants
+ * \return The options
+ */
+genopts getOptionsFromMask(unsigned int mask);
+
+/**
+ * Returns the alphabet of all characters a string generated with \p options
+ * may consist of. The alphabets for all combinations of options are built
+ * once and shared by all threads, so the returned reference stays valid for
+ * the lifetime of the program.
+ *
+ * \param options The options to get the alphabet for
+ * \return Constant reference to the alphabet
+ */
+const std::string& getAlphabet(const genopts& options);
+
+/**
+ * Fills \p buffer with \p length characters chosen randomly from
+ * \p alphabet. The buffer is not terminated with a null character.
+ *
+ * \param buffer The buffer to write to (at least \p length bytes)
+ * \param length The number of characters to write
+ * \param alphabet The characters to choose from (must not be empty)
+ */
+void fillRandomChars(char* buffer, const size_t length,
+    const std::string& alphabet);
+
+/**
+ * Generates a random string by using random numbers from the calling thread's
+ * block of buffered random bytes. The string will contain \p length
+ * characters and will meet the requirements in \p options.
  *
  * \param length The number of characters in the string
  * \param options The options for generating the string
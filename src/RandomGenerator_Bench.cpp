@@ -0,0 +1,112 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    RandomGenerator_Bench.cpp
+ * \brief   Benchmarks the files \p RandomGenerator.h and
+ *          \p RandomGenerator.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p RandomGenerator.h and \p RandomGenerator.cpp.
+ */
+
+#include "Benchmark.h"
+#include "RandomGenerator.h"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+/// Number of calls every thread makes per measurement
+static const size_t CALLS_PER_THREAD = 10000;
+/// Length of the generated strings
+static const unsigned int STRING_LENGTH = 16;
+
+/**
+ * Generates a random string the way \p getRandomString() did before it used
+ * per-thread state: the alphabet is built on every call and every character
+ * needs a call into libsodium. Serves as baseline for the comparison.
+ */
+static std::string getRandomStringUnbuffered(const unsigned int length,
+    const genopts& options) {
+    std::stringstream alphabet;
+    if (options.bIncludeLettersLower)
+        alphabet << ALPHA_LETTERS_LOWER;
+    if (options.bIncludeLettersUpper)
+        alphabet << ALPHA_LETTERS_UPPER;
+    if (options.bIncludeNumbers)
+        alphabet << ALPHA_NUMBERS;
+    std::string alpha = alphabet.str();
+
+    std::string result(length, '\0');
+    for (unsigned int i = 0; i < length; i++) {
+        result[i] = alpha[randombytes_uniform(static_cast<uint32_t>(alpha.length()))];
+    }
+    return result;
+}
+
+/**
+ * Calls \p generate from \p threadCount threads at once and writes the
+ * throughput and the median and 99th percentile latency per call to \p out.
+ */
+template <typename Function>
+static void measureContention(std::ostream& out, const char* label,
+    size_t threadCount, Function generate) {
+    std::vector<std::vector<uint64_t>> latencies(threadCount);
+    std::vector<std::thread> threads;
+    genopts options;
+
+    const uint64_t start = getNanoseconds();
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<uint64_t>& samples = latencies[t];
+            samples.reserve(CALLS_PER_THREAD);
+            for (size_t i = 0; i < CALLS_PER_THREAD; i++) {
+                const uint64_t before = getNanoseconds();
+                generate(STRING_LENGTH, options);
+                samples.push_back(getNanoseconds() - before);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const uint64_t elapsed = getNanoseconds() - start;
+
+    std::vector<uint64_t> all;
+    for (const auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    const double callsPerSecond = all.size() * 1e9 / elapsed;
+    const uint64_t p50 = getPercentile(all, 50.0);
+    const uint64_t p99 = getPercentile(all, 99.0);
+
+    out << std::left << std::setw(12) << label << std::right
+        << std::setw(4) << threadCount << " threads: "
+        << std::setw(12) << static_cast<uint64_t>(callsPerSecond) << " calls/s"
+        << "  p50 " << std::setw(7) << p50 << " ns"
+        << "  p99 " << std::setw(7) << p99 << " ns" << std::endl;
+}
+
+/// Measures the latency of concurrent calls of \p getRandomString()
+BENCHMARK_CASE(contention) {
+    const size_t threadCounts[] = {1, 8, 32, 64};
+    for (const size_t threadCount : threadCounts) {
+        measureContention(out, "unbuffered", threadCount, getRandomStringUnbuffered);
+        measureContention(out, "per-thread", threadCount, getRandomString);
+    }
+}
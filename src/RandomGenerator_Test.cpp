@@ -93,6 +93,65 @@ TEST_CASE("getRandomString", "[RandomGenerator]") {
             REQUIRE(randString.find_first_of(ALPHA_SPACE) == std::string::npos);
         }
     }
+
+    SECTION("Every character reachable") {
+        options.bIncludeLettersLower = false;
+        options.bIncludeLettersUpper = false;
+        options.bIncludeNumbers = false;
+        options.bIncludeDash = true;
+        options.bIncludeSpace = true;
+        randString = getRandomString(200, options);
+        REQUIRE(randString.find_first_of(ALPHA_DASH) != std::string::npos);
+        REQUIRE(randString.find_first_of(ALPHA_SPACE) != std::string::npos);
+    }
+}
+
+/// Tests the functions \p getOptionsMask and \p getAlphabet of
+/// \p RandomGenerator
+TEST_CASE("getAlphabet", "[RandomGenerator]") {
+    genopts options;
+
+    SECTION("Default options") {
+        REQUIRE(getOptionsMask(options) == (GENOPTS_LETTERS_LOWER |
+            GENOPTS_LETTERS_UPPER | GENOPTS_NUMBERS));
+        REQUIRE(getAlphabet(options) ==
+            ALPHA_LETTERS_LOWER ALPHA_LETTERS_UPPER ALPHA_NUMBERS);
+    }
+
+    SECTION("All options") {
+        options.bIncludeSpace = true;
+        options.bIncludeDash = true;
+        options.bIncludeSpecial = true;
+        options.bAvoidSimilarChars = true;
+        REQUIRE(getOptionsMask(options) == GENOPTS_COMBINATIONS - 1);
+        REQUIRE(getOptionsMask(getOptionsFromMask(GENOPTS_COMBINATIONS - 1)) ==
+            GENOPTS_COMBINATIONS - 1);
+
+        const std::string& alpha = getAlphabet(options);
+        REQUIRE(alpha.find_first_of(ALPHA_SIMILAR) == std::string::npos);
+        REQUIRE(alpha.find_first_of(ALPHA_SPECIAL) != std::string::npos);
+        REQUIRE(alpha.find_first_of(ALPHA_DASH) != std::string::npos);
+    }
+
+    SECTION("No options") {
+        options.bIncludeLettersLower = false;
+        options.bIncludeLettersUpper = false;
+        options.bIncludeNumbers = false;
+        REQUIRE(getOptionsMask(options) == 0);
+        REQUIRE(getAlphabet(options).empty());
+    }
+}
+
+/// Tests the function \p fillRandomChars of \p RandomGenerator
+TEST_CASE("fillRandomChars", "[RandomGenerator]") {
+    // longer than a block of random bytes to cover refilling
+    const size_t length = 2 * RANDOM_BLOCK_SIZE;
+    std::string buffer(length + 1, '#');
+
+    fillRandomChars(&buffer[0], length, ALPHA_NUMBERS);
+    REQUIRE(buffer[length] == '#');
+    REQUIRE(buffer.substr(0, length).find_first_not_of(ALPHA_NUMBERS) ==
+        std::string::npos);
 }
 
 /// Test case for the function \p removeFromString
@@ -0,0 +1,294 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Scheduler.cpp
+ * \brief   Implements a work-stealing scheduler for running independent tasks
+ *          in parallel.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a work-stealing scheduler for running independent
+ * tasks in parallel and a pool of threads running it.
+ */
+
+#include "Scheduler.h"
+#include <deque>
+
+/// Deque of task indices owned by one worker
+struct WorkerQueue {
+    /// protects \p tasks
+    std::mutex mutex;
+    /// the indices of the tasks left
+    std::deque<size_t> tasks;
+};
+
+namespace {
+
+/**
+ * Takes the next task from the front of the worker's own deque.
+ *
+ * \param queue The deque of the calling worker
+ * \param task Receives the index of the task
+ * \return \p true if a task was taken, \p false if the deque is empty
+ */
+bool popTask(WorkerQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+/**
+ * Steals the last task from the back of another worker's deque.
+ *
+ * \param queue The deque to steal from
+ * \param task Receives the index of the task
+ * \return \p true if a task was stolen, \p false if the deque is empty
+ */
+bool stealTask(WorkerQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+/**
+ * Hands the tasks 0 to \p taskCount - 1 to the \p threadCount workers, every
+ * worker owning a contiguous range of tasks.
+ *
+ * \param queues The deques of the workers
+ * \param threadCount The number of workers
+ * \param taskCount The number of tasks
+ */
+void distributeTasks(WorkerQueue* queues, unsigned int threadCount,
+    size_t taskCount) {
+    for (unsigned int w = 0; w < threadCount; w++) {
+        const size_t first = taskCount * w / threadCount;
+        const size_t last = taskCount * (w + 1) / threadCount;
+        for (size_t i = first; i < last; i++) {
+            queues[w].tasks.push_back(i);
+        }
+    }
+}
+
+/**
+ * Runs tasks as the worker \p self until every deque is empty. The first
+ * exception thrown by a task is stored in \p error, the other tasks still
+ * run.
+ *
+ * \param queues The deques of the workers
+ * \param threadCount The number of workers
+ * \param self The index of the calling worker
+ * \param task Function running the task with the given index
+ * \param errorMutex Protects \p error
+ * \param error Receives the first exception
+ */
+void runWorker(WorkerQueue* queues, unsigned int threadCount, unsigned int self,
+    const std::function<void(size_t)>& task, std::mutex& errorMutex,
+    std::exception_ptr& error) {
+    size_t index;
+    while (true) {
+        bool found = popTask(queues[self], index);
+        // tasks never create new tasks, so once every deque is empty the
+        // worker is done
+        for (unsigned int i = 1; !found && i < threadCount; i++) {
+            found = stealTask(queues[(self + i) % threadCount], index);
+        }
+        if (!found)
+            return;
+
+        try {
+            task(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+}
+
+} // end of anonymous namespace
+
+/**
+ * Returns the number of worker threads to use if the caller does not specify
+ * it: the number of hardware threads, or 1 if that is unknown.
+ *
+ * \return Default number of worker threads
+ */
+unsigned int getDefaultThreadCount() {
+    const unsigned int threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+/**
+ * Runs \p task for every index between 0 and \p taskCount - 1 on
+ * \p threadCount threads and returns when all tasks are finished. The calling
+ * thread is one of the workers. If a task throws an exception, the remaining
+ * tasks are still run and the first exception is rethrown afterwards.
+ *
+ * \param taskCount The number of tasks to run
+ * \param threadCount The number of threads to use (0 for the default)
+ * \param task Function running the task with the given index
+ */
+void runParallel(size_t taskCount, unsigned int threadCount,
+    const std::function<void(size_t)>& task) {
+    if (threadCount == 0)
+        threadCount = getDefaultThreadCount();
+    if (threadCount > taskCount)
+        threadCount = static_cast<unsigned int>(taskCount);
+
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    std::vector<WorkerQueue> queues(threadCount);
+    distributeTasks(queues.data(), threadCount, taskCount);
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto worker = [&](unsigned int self) {
+        runWorker(queues.data(), threadCount, self, task, errorMutex, error);
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int w = 1; w < threadCount; w++) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/**
+ * Constructor of \p WorkerPool. Starts \p threadCount - 1 threads, the
+ * thread calling \p run() is the last worker.
+ *
+ * \param threadCount The number of threads to use (0 for the default)
+ */
+WorkerPool::WorkerPool(unsigned int threadCount) :
+    m_threadCount(threadCount > 0 ? threadCount : getDefaultThreadCount()),
+    m_queues(new WorkerQueue[m_threadCount]), m_generation(0), m_running(0),
+    m_stopping(false), m_task(nullptr) {
+    for (unsigned int w = 1; w < m_threadCount; w++) {
+        m_threads.emplace_back(&WorkerPool::work, this, w);
+    }
+}
+
+/**
+ * Destructor of \p WorkerPool. Stops and joins the threads.
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_started.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Runs \p task for every index between 0 and \p taskCount - 1 on the
+ * threads of the pool and returns when all tasks are finished. If a task
+ * throws an exception, the remaining tasks are still run and the first
+ * exception is rethrown afterwards.
+ *
+ * \param taskCount The number of tasks to run
+ * \param task Function running the task with the given index
+ */
+void WorkerPool::run(size_t taskCount, const std::function<void(size_t)>& task) {
+    if (m_threads.empty() || taskCount <= 1) {
+        for (size_t i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    distributeTasks(m_queues.get(), m_threadCount, taskCount);
+    m_error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_running = static_cast<unsigned int>(m_threads.size());
+        m_generation++;
+    }
+    m_started.notify_all();
+    runWorker(m_queues.get(), m_threadCount, 0, task, m_errorMutex, m_error);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this]() { return m_running == 0; });
+        m_task = nullptr;
+    }
+
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Returns the number of workers including the thread calling \p run().
+ *
+ * \return The number of workers
+ */
+unsigned int WorkerPool::size() const {
+    return m_threadCount;
+}
+
+/**
+ * Main function of the pooled thread that is worker \p self. Waits for a
+ * run, works on it like the other workers and reports when it is done.
+ *
+ * \param self The index of the worker
+ */
+void WorkerPool::work(unsigned int self) {
+    uint64_t generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_started.wait(lock, [&]() {
+                return m_stopping || m_generation != generation;
+            });
+            if (m_stopping)
+                return;
+            generation = m_generation;
+            task = m_task;
+        }
+
+        runWorker(m_queues.get(), m_threadCount, self, *task, m_errorMutex, m_error);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0)
+            m_finished.notify_one();
+    }
+}
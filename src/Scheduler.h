@@ -0,0 +1,143 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Scheduler.h
+ * \brief   Defines a work-stealing scheduler for running independent tasks
+ *          in parallel.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a work-stealing scheduler for running independent tasks
+ * in parallel. Every worker owns a deque of tasks which initially holds a
+ * contiguous range of the tasks. A worker takes tasks from the front of its
+ * own deque and, once it runs dry, steals tasks from the back of the deques
+ * of the other workers. So no worker idles while there is work left, even if
+ * the tasks differ a lot in cost. A \p WorkerPool keeps its threads between
+ * runs for callers running many small sets of tasks.
+ */
+
+#ifndef GTKPASS_SCHEDULER_H
+#define GTKPASS_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerQueue;
+
+/**
+ * Returns the number of worker threads to use if the caller does not specify
+ * it: the number of hardware threads, or 1 if that is unknown.
+ *
+ * \return Default number of worker threads
+ */
+unsigned int getDefaultThreadCount();
+
+/**
+ * Runs \p task for every index between 0 and \p taskCount - 1 on
+ * \p threadCount threads and returns when all tasks are finished. The calling
+ * thread is one of the workers. If a task throws an exception, the remaining
+ * tasks are still run and the first exception is rethrown afterwards.
+ *
+ * \param taskCount The number of tasks to run
+ * \param threadCount The number of threads to use (0 for the default)
+ * \param task Function running the task with the given index
+ */
+void runParallel(size_t taskCount, unsigned int threadCount,
+    const std::function<void(size_t)>& task);
+
+/**
+ * Class running sets of independent tasks in parallel like
+ * \p runParallel(), but on threads started once and kept until the pool is
+ * destroyed. Between runs the threads block, so an idle pool costs no CPU
+ * time. Only one thread at a time may call \p run().
+ */
+class WorkerPool {
+public:
+    /**
+     * Constructor of \p WorkerPool. Starts \p threadCount - 1 threads, the
+     * thread calling \p run() is the last worker.
+     *
+     * \param threadCount The number of threads to use (0 for the default)
+     */
+    explicit WorkerPool(unsigned int threadCount);
+
+    /**
+     * Destructor of \p WorkerPool. Stops and joins the threads.
+     */
+    ~WorkerPool();
+
+    /**
+     * Runs \p task for every index between 0 and \p taskCount - 1 on the
+     * threads of the pool and returns when all tasks are finished. If a task
+     * throws an exception, the remaining tasks are still run and the first
+     * exception is rethrown afterwards.
+     *
+     * \param taskCount The number of tasks to run
+     * \param task Function running the task with the given index
+     */
+    void run(size_t taskCount, const std::function<void(size_t)>& task);
+
+    /**
+     * Returns the number of workers including the thread calling \p run().
+     *
+     * \return The number of workers
+     */
+    unsigned int size() const;
+
+private:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// Main function of the pooled thread that is worker \p self
+    void work(unsigned int self);
+
+    /// number of workers including the thread calling \p run()
+    unsigned int m_threadCount;
+    /// the deques of the workers
+    std::unique_ptr<WorkerQueue[]> m_queues;
+    /// the pooled threads
+    std::vector<std::thread> m_threads;
+    /// protects the fields below
+    std::mutex m_mutex;
+    /// signals a new run or the end of the pool to the threads
+    std::condition_variable m_started;
+    /// signals the end of a run to the thread calling \p run()
+    std::condition_variable m_finished;
+    /// number of the current run, incremented by \p run()
+    uint64_t m_generation;
+    /// number of pooled threads still working on the current run
+    unsigned int m_running;
+    /// set by the destructor to stop the threads
+    bool m_stopping;
+    /// the task of the current run
+    const std::function<void(size_t)>* m_task;
+    /// protects \p m_error
+    std::mutex m_errorMutex;
+    /// the first exception thrown by a task of the current run
+    std::exception_ptr m_error;
+
+}; // end of class WorkerPool
+
+#endif
@@ -0,0 +1,120 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Scheduler_Test.cpp
+ * \brief   Tests the files \p Scheduler.h and \p Scheduler.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Scheduler.h and \p Scheduler.cpp.
+ */
+
+
+#include "catch.hpp"
+#include "Scheduler.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+/// Tests the function \p runParallel of \p Scheduler
+TEST_CASE("runParallel", "[Scheduler]") {
+    const size_t taskCount = 1000;
+
+    SECTION("Every task runs exactly once") {
+        const unsigned int threadCounts[] = {1, 2, 7, 64};
+        for (const unsigned int threadCount : threadCounts) {
+            std::vector<std::atomic<int>> runs(taskCount);
+            for (auto& run : runs) {
+                run.store(0);
+            }
+            runParallel(taskCount, threadCount, [&](size_t i) {
+                runs[i]++;
+            });
+            for (const auto& run : runs) {
+                REQUIRE(run.load() == 1);
+            }
+        }
+    }
+
+    SECTION("Skewed tasks") {
+        // the first worker's range holds all the expensive tasks
+        std::atomic<size_t> sum(0);
+        runParallel(taskCount, 4, [&](size_t i) {
+            size_t local = 0;
+            const size_t work = i < taskCount / 4 ? 10000 : 1;
+            for (size_t j = 0; j < work; j++) {
+                local += j % 3;
+            }
+            sum += local > 0 ? 1 : 0;
+        });
+        REQUIRE(sum.load() == taskCount / 4);
+    }
+
+    SECTION("No tasks") {
+        bool called = false;
+        runParallel(0, 4, [&](size_t) { called = true; });
+        REQUIRE(called == false);
+    }
+
+    SECTION("Exceptions") {
+        std::atomic<size_t> runs(0);
+        REQUIRE_THROWS(runParallel(taskCount, 4, [&](size_t i) {
+            runs++;
+            if (i == 10)
+                throw std::runtime_error("task failed");
+        }));
+        REQUIRE(runs.load() == taskCount);
+    }
+}
+
+/// Tests the class \p WorkerPool of \p Scheduler
+TEST_CASE("WorkerPool", "[Scheduler]") {
+    WorkerPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Many runs on the same threads") {
+        std::vector<std::atomic<int>> runs(100);
+        for (auto& run : runs) {
+            run.store(0);
+        }
+        for (size_t r = 0; r < 1000; r++) {
+            const size_t taskCount = r % runs.size();
+            pool.run(taskCount, [&](size_t i) {
+                runs[i]++;
+            });
+        }
+        // task i runs in every run with more than i tasks
+        for (size_t i = 0; i < runs.size(); i++) {
+            REQUIRE(runs[i].load() == static_cast<int>(10 * (runs.size() - 1 - i)));
+        }
+    }
+
+    SECTION("Exceptions") {
+        std::atomic<size_t> runs(0);
+        REQUIRE_THROWS(pool.run(1000, [&](size_t i) {
+            runs++;
+            if (i == 10)
+                throw std::runtime_error("task failed");
+        }));
+        REQUIRE(runs.load() == 1000);
+        // the pool is still usable afterwards
+        runs = 0;
+        pool.run(1000, [&](size_t) { runs++; });
+        REQUIRE(runs.load() == 1000);
+    }
+}
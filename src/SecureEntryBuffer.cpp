@@ -0,0 +1,158 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SecureEntryBuffer.cpp
+ * \brief   Implements an entry buffer keeping its text in locked memory.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements an entry buffer keeping its text in locked memory.
+ */
+
+#include "SecureEntryBuffer.h"
+#include "SecureText.h"
+#include <iostream>
+#include <new>
+
+namespace {
+
+/// Instance of the GObject type of the buffer
+struct SecureEntryBuffer {
+    /// the instance of \p GtkEntryBuffer
+    GtkEntryBuffer parent;
+    /// the text, created with the instance and deleted when it is finalized
+    SecureText* text;
+};
+
+/// Class of the GObject type of the buffer
+struct SecureEntryBufferClass {
+    /// the class of \p GtkEntryBuffer
+    GtkEntryBufferClass parentClass;
+};
+
+/// The class of \p GtkEntryBuffer, whose \p finalize() is chained up to
+GObjectClass* parentClass = nullptr;
+
+/// Returns the text of \p buffer
+SecureText& getText(GtkEntryBuffer* buffer) {
+    return *reinterpret_cast<SecureEntryBuffer*>(buffer)->text;
+}
+
+/// Returns the text of \p buffer and stores its number of bytes in
+/// \p bytes, if it is not \p nullptr
+const gchar* getTextBytes(GtkEntryBuffer* buffer, gsize* bytes) {
+    const SecureText& text = getText(buffer);
+    if (bytes)
+        *bytes = text.bytes();
+    return text.data();
+}
+
+/// Returns the number of characters of \p buffer
+guint getLength(GtkEntryBuffer* buffer) {
+    return static_cast<guint>(getText(buffer).length());
+}
+
+/// Inserts \p count characters of \p chars at the position \p position,
+/// which \p gtk_entry_buffer_insert_text() limited to the length of the
+/// text, and emits the "inserted-text" signal
+guint insertText(GtkEntryBuffer* buffer, guint position, const gchar* chars,
+    guint count) {
+    try {
+        getText(buffer).insert(position, chars, count);
+    } catch (const std::bad_alloc&) {
+        // exceptions must not pass through GTK
+        std::cerr << "ERROR: Could not allocate locked memory for the password!"
+            << std::endl;
+        return 0;
+    }
+    gtk_entry_buffer_emit_inserted_text(buffer, position, chars, count);
+    return count;
+}
+
+/// Removes \p count characters at the position \p position, wipes them and
+/// emits the "deleted-text" signal
+guint deleteText(GtkEntryBuffer* buffer, guint position, guint count) {
+    count = static_cast<guint>(getText(buffer).erase(position, count));
+    if (count > 0)
+        gtk_entry_buffer_emit_deleted_text(buffer, position, count);
+    return count;
+}
+
+/// Wipes and frees the text of the buffer \p object
+void finalize(GObject* object) {
+    SecureEntryBuffer* buffer = reinterpret_cast<SecureEntryBuffer*>(object);
+    delete buffer->text;
+    buffer->text = nullptr;
+    parentClass->finalize(object);
+}
+
+/// Initializes the instance \p instance of the buffer with an empty text
+void initInstance(GTypeInstance* instance, gpointer klass) {
+    (void) klass;
+    reinterpret_cast<SecureEntryBuffer*>(instance)->text = new SecureText();
+}
+
+/// Overrides the virtual functions of \p GtkEntryBuffer storing the text in
+/// the class \p klass
+void initClass(gpointer klass, gpointer data) {
+    (void) data;
+    parentClass = G_OBJECT_CLASS(g_type_class_peek_parent(klass));
+    G_OBJECT_CLASS(klass)->finalize = &finalize;
+    GtkEntryBufferClass* bufferClass = GTK_ENTRY_BUFFER_CLASS(klass);
+    bufferClass->get_text = &getTextBytes;
+    bufferClass->get_length = &getLength;
+    bufferClass->insert_text = &insertText;
+    bufferClass->delete_text = &deleteText;
+}
+
+/// Returns the GObject type of the buffer, registering it the first time
+GType getSecureEntryBufferType() {
+    static const GType type = g_type_register_static_simple(GTK_TYPE_ENTRY_BUFFER,
+        "GtkPassSecureEntryBuffer", sizeof(SecureEntryBufferClass), &initClass,
+        sizeof(SecureEntryBuffer), &initInstance, static_cast<GTypeFlags>(0));
+    return type;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Creates an entry buffer storing its text in locked memory.
+ *
+ * \return The new buffer
+ */
+Glib::RefPtr<Gtk::EntryBuffer> createSecureEntryBuffer() {
+    // the buffer is not derived from GInitiallyUnowned, so the wrapper takes
+    // over the reference of g_object_new()
+    return Glib::wrap(GTK_ENTRY_BUFFER(g_object_new(getSecureEntryBufferType(), nullptr)));
+}
+
+/**
+ * Replaces the text of \p buffer with the \p bytes bytes of the UTF-8 string
+ * \p text, which need not be terminated with a null character. The
+ * characters are copied straight into the locked memory of a buffer created
+ * with \p createSecureEntryBuffer(), without a \p Glib::ustring in between.
+ *
+ * \param buffer The buffer
+ * \param text The new text
+ * \param bytes The number of bytes of \p text
+ */
+void setSecureEntryText(const Glib::RefPtr<Gtk::EntryBuffer>& buffer,
+    const char* text, size_t bytes) {
+    gtk_entry_buffer_set_text(buffer->gobj(), text,
+        static_cast<gint>(g_utf8_strlen(text, static_cast<gssize>(bytes))));
+}
@@ -0,0 +1,59 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SecureEntryBuffer.h
+ * \brief   Defines an entry buffer keeping its text in locked memory.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions creating and filling a \p GtkEntryBuffer that
+ * stores the text of a \p Gtk::Entry in a \p SecureText instead of memory
+ * allocated with \p g_malloc(). The text is locked into RAM, every character
+ * removed is wiped, and the buffer wipes the rest when it is destroyed.
+ * gtkmm does not wrap the virtual functions of \p GtkEntryBuffer, so the
+ * buffer is a subclass registered with the GObject type system that is
+ * wrapped as a plain \p Gtk::EntryBuffer.
+ */
+
+#ifndef GTKPASS_SECUREENTRYBUFFER_H
+#define GTKPASS_SECUREENTRYBUFFER_H
+
+#include <gtkmm.h>
+#include <cstddef>
+
+/**
+ * Creates an entry buffer storing its text in locked memory.
+ *
+ * \return The new buffer
+ */
+Glib::RefPtr<Gtk::EntryBuffer> createSecureEntryBuffer();
+
+/**
+ * Replaces the text of \p buffer with the \p bytes bytes of the UTF-8 string
+ * \p text, which need not be terminated with a null character. The
+ * characters are copied straight into the locked memory of a buffer created
+ * with \p createSecureEntryBuffer(), without a \p Glib::ustring in between.
+ *
+ * \param buffer The buffer
+ * \param text The new text
+ * \param bytes The number of bytes of \p text
+ */
+void setSecureEntryText(const Glib::RefPtr<Gtk::EntryBuffer>& buffer,
+    const char* text, size_t bytes);
+
+#endif
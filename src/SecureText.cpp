@@ -0,0 +1,242 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SecureText.cpp
+ * \brief   Implements a class storing UTF-8 text in locked memory.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a class storing a password as UTF-8 text in memory
+ * allocated with \p sodium_malloc().
+ */
+
+#include "SecureText.h"
+#include "sodium.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+/// Returns whether \p c is a continuation byte of a UTF-8 character
+bool isContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+/// Returns the number of bytes of the UTF-8 character starting with the
+/// byte \p lead
+size_t getCharBytes(char lead) {
+    const unsigned char c = static_cast<unsigned char>(lead);
+    if (c < 0xC0)
+        return 1;
+    if (c < 0xE0)
+        return 2;
+    return c < 0xF0 ? 3 : 4;
+}
+
+/// Returns the number of bytes of the first \p count characters of the
+/// UTF-8 string \p text
+size_t countBytes(const char* text, size_t count) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += getCharBytes(text[bytes]);
+    }
+    return bytes;
+}
+
+/// Returns the number of characters of the \p bytes bytes of the UTF-8
+/// string \p text
+size_t countChars(const char* text, size_t bytes) {
+    size_t count = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        if (!isContinuation(text[i]))
+            count++;
+    }
+    return count;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Constructor of \p SecureText. Creates an empty text without allocating
+ * memory.
+ */
+SecureText::SecureText() : m_data(nullptr), m_capacity(0), m_bytes(0),
+    m_length(0) {
+}
+
+/**
+ * Destructor of \p SecureText. Wipes and frees the memory.
+ */
+SecureText::~SecureText() {
+    sodium_free(m_data);
+}
+
+/**
+ * Returns the text, terminated with a null character. The pointer is
+ * valid until the text is changed.
+ *
+ * \return Pointer to the first character
+ */
+const char* SecureText::data() const {
+    return m_data ? m_data : "";
+}
+
+/**
+ * Returns the number of bytes of the text without the terminating null
+ * character.
+ *
+ * \return The number of bytes
+ */
+size_t SecureText::bytes() const {
+    return m_bytes;
+}
+
+/**
+ * Returns the number of characters of the text.
+ *
+ * \return The number of characters
+ */
+size_t SecureText::length() const {
+    return m_length;
+}
+
+/**
+ * Returns whether the text is empty.
+ *
+ * \return \p true if there are no characters, \p false otherwise
+ */
+bool SecureText::empty() const {
+    return m_length == 0;
+}
+
+/**
+ * Inserts the first \p count characters of the UTF-8 string \p text
+ * before the character at the position \p position.
+ *
+ * \param position The position in characters, the end of the text if
+ * larger than \p length()
+ * \param text The characters to insert (at least \p count characters)
+ * \param count The number of characters to insert
+ * \throws std::bad_alloc if no memory could be allocated
+ * \return The number of characters inserted
+ */
+size_t SecureText::insert(size_t position, const char* text, size_t count) {
+    if (count == 0)
+        return 0;
+    const size_t bytes = countBytes(text, count);
+    reserve(m_bytes + bytes);
+    const size_t offset = getOffset(std::min(position, m_length));
+    memmove(m_data + offset + bytes, m_data + offset, m_bytes - offset + 1);
+    memcpy(m_data + offset, text, bytes);
+    m_bytes += bytes;
+    m_length += count;
+    return count;
+}
+
+/**
+ * Removes \p count characters starting at the position \p position and
+ * wipes the bytes freed at the end of the text.
+ *
+ * \param position The position in characters
+ * \param count The number of characters to remove, fewer if the text
+ * ends before
+ * \return The number of characters removed
+ */
+size_t SecureText::erase(size_t position, size_t count) {
+    if (position >= m_length || count == 0)
+        return 0;
+    count = std::min(count, m_length - position);
+    const size_t start = getOffset(position);
+    const size_t bytes = countBytes(m_data + start, count);
+    memmove(m_data + start, m_data + start + bytes, m_bytes - start - bytes);
+    // the end of the text still holds the last bytes moved
+    sodium_memzero(m_data + m_bytes - bytes, bytes);
+    m_bytes -= bytes;
+    m_length -= count;
+    return count;
+}
+
+/**
+ * Replaces the text with the \p bytes bytes of the UTF-8 string
+ * \p text.
+ *
+ * \param text The new text
+ * \param bytes The number of bytes of \p text
+ * \throws std::bad_alloc if no memory could be allocated
+ */
+void SecureText::assign(const char* text, size_t bytes) {
+    clear();
+    if (bytes == 0)
+        return;
+    reserve(bytes);
+    memcpy(m_data, text, bytes);
+    m_data[bytes] = '\0';
+    m_bytes = bytes;
+    m_length = countChars(text, bytes);
+}
+
+/**
+ * Wipes all characters of the text. The memory is kept for the next
+ * text.
+ */
+void SecureText::clear() {
+    if (m_data)
+        sodium_memzero(m_data, m_bytes);
+    m_bytes = 0;
+    m_length = 0;
+}
+
+/**
+ * Makes room for \p bytes bytes and the terminating null character. The
+ * memory at least doubles, so inserting characters one at a time copies the
+ * text only a few times; every copy left behind is wiped by
+ * \p sodium_free().
+ *
+ * \param bytes The number of bytes of the text
+ * \throws std::bad_alloc if no memory could be allocated
+ */
+void SecureText::reserve(size_t bytes) {
+    if (m_data && bytes <= m_capacity)
+        return;
+    const size_t capacity = std::max<size_t>(bytes,
+        std::max<size_t>(SECURE_TEXT_INITIAL_CAPACITY, 2 * m_capacity));
+    char* data = static_cast<char*>(sodium_malloc(capacity + 1));
+    if (!data)
+        throw std::bad_alloc();
+    if (m_data)
+        memcpy(data, m_data, m_bytes);
+    data[m_bytes] = '\0';
+    sodium_free(m_data);
+    m_data = data;
+    m_capacity = capacity;
+}
+
+/**
+ * Returns the position in bytes of the character at the position
+ * \p position, which must not be larger than \p length().
+ *
+ * \param position The position in characters
+ * \return The position in bytes
+ */
+size_t SecureText::getOffset(size_t position) const {
+    // passwords are usually ASCII, where both positions are equal
+    if (m_bytes == m_length)
+        return position;
+    return countBytes(m_data, position);
+}
@@ -0,0 +1,149 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SecureText.h
+ * \brief   Defines a class storing UTF-8 text in locked memory.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a class storing a password as UTF-8 text in memory
+ * allocated with \p sodium_malloc(), so it is locked into RAM and surrounded
+ * by guard pages. Unlike a \p std::string, it never leaves a copy behind:
+ * the bytes freed by every change are wiped, and when the text grows, the
+ * old memory is wiped by \p sodium_free(). Positions and counts are given in
+ * characters, like in a \p GtkEntryBuffer, which stores its text in it.
+ */
+
+#ifndef GTKPASS_SECURETEXT_H
+#define GTKPASS_SECURETEXT_H
+
+#include <cstddef>
+
+/// Initial size of the memory of \p SecureText in bytes
+#define SECURE_TEXT_INITIAL_CAPACITY 64
+
+/**
+ * UTF-8 text in locked memory that is wiped whenever characters are removed
+ * and when the text grows or is destroyed.
+ */
+class SecureText {
+
+public:
+    /**
+     * Constructor of \p SecureText. Creates an empty text without allocating
+     * memory.
+     */
+    SecureText();
+
+    /**
+     * Destructor of \p SecureText. Wipes and frees the memory.
+     */
+    ~SecureText();
+
+    /**
+     * Returns the text, terminated with a null character. The pointer is
+     * valid until the text is changed.
+     *
+     * \return Pointer to the first character
+     */
+    const char* data() const;
+
+    /**
+     * Returns the number of bytes of the text without the terminating null
+     * character.
+     *
+     * \return The number of bytes
+     */
+    size_t bytes() const;
+
+    /**
+     * Returns the number of characters of the text.
+     *
+     * \return The number of characters
+     */
+    size_t length() const;
+
+    /**
+     * Returns whether the text is empty.
+     *
+     * \return \p true if there are no characters, \p false otherwise
+     */
+    bool empty() const;
+
+    /**
+     * Inserts the first \p count characters of the UTF-8 string \p text
+     * before the character at the position \p position.
+     *
+     * \param position The position in characters, the end of the text if
+     * larger than \p length()
+     * \param text The characters to insert (at least \p count characters)
+     * \param count The number of characters to insert
+     * \throws std::bad_alloc if no memory could be allocated
+     * \return The number of characters inserted
+     */
+    size_t insert(size_t position, const char* text, size_t count);
+
+    /**
+     * Removes \p count characters starting at the position \p position and
+     * wipes the bytes freed at the end of the text.
+     *
+     * \param position The position in characters
+     * \param count The number of characters to remove, fewer if the text
+     * ends before
+     * \return The number of characters removed
+     */
+    size_t erase(size_t position, size_t count);
+
+    /**
+     * Replaces the text with the \p bytes bytes of the UTF-8 string
+     * \p text.
+     *
+     * \param text The new text
+     * \param bytes The number of bytes of \p text
+     * \throws std::bad_alloc if no memory could be allocated
+     */
+    void assign(const char* text, size_t bytes);
+
+    /**
+     * Wipes all characters of the text. The memory is kept for the next
+     * text.
+     */
+    void clear();
+
+private:
+    SecureText(const SecureText&) = delete;
+    SecureText& operator=(const SecureText&) = delete;
+
+    /// Makes room for \p bytes bytes and the terminating null character
+    void reserve(size_t bytes);
+    /// Returns the position in bytes of the character at \p position
+    size_t getOffset(size_t position) const;
+
+    /// the text, allocated with \p sodium_malloc() (\p nullptr before the
+    /// first character)
+    char* m_data;
+    /// size of the memory in bytes, without the terminating null character
+    size_t m_capacity;
+    /// number of bytes of the text
+    size_t m_bytes;
+    /// number of characters of the text
+    size_t m_length;
+
+}; // end of class SecureText
+
+#endif
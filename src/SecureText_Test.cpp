@@ -0,0 +1,250 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    SecureText_Test.cpp
+ * \brief   Tests the files \p SecureText.h and \p SecureText.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p SecureText.h and \p SecureText.cpp.
+ */
+
+#include "catch.hpp"
+#include "SecureText.h"
+#include "Strength.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Number of characters of the secret
+static const size_t SECRET_LENGTH = 32;
+/// Position of the characters of the secret searched in the memory; only
+/// the middle is searched, so a copy with a wiped start or end still counts
+static const size_t SEARCH_BEGIN = SECRET_LENGTH / 4;
+/// Number of characters of the secret searched in the memory
+static const size_t SEARCH_LENGTH = SECRET_LENGTH / 2;
+/// Mask the secret is stored with in the test, so the test itself holds
+/// no copy of it
+static const unsigned char SECRET_MASK = 0x5A;
+
+/// Returns the number of copies of the secret stored masked in \p masked
+/// in the memory from \p start to \p end, read through the file \p mem
+/// into \p chunk of \p chunkSize bytes. Pages that cannot be read end the
+/// search.
+static size_t countCopies(int mem, unsigned long start, unsigned long end,
+    char* chunk, size_t chunkSize, const std::vector<unsigned char>& masked) {
+    size_t copies = 0;
+    // chunks overlap by one character less than the searched ones, so
+    // copies crossing the end of a chunk are found once, in the next one
+    for (unsigned long address = start; address < end;
+        address += chunkSize - (SEARCH_LENGTH - 1)) {
+        const size_t size = std::min<unsigned long>(chunkSize, end - address);
+        const ssize_t read = pread(mem, chunk, size, static_cast<off_t>(address));
+        if (read < static_cast<ssize_t>(SEARCH_LENGTH))
+            break;
+        for (ssize_t i = 0; i + static_cast<ssize_t>(SEARCH_LENGTH) <= read; i++) {
+            size_t j = 0;
+            while (j < SEARCH_LENGTH && static_cast<unsigned char>(chunk[i + j]) ==
+                (masked[SEARCH_BEGIN + j] ^ SECRET_MASK)) {
+                j++;
+            }
+            if (j == SEARCH_LENGTH)
+                copies++;
+        }
+        if (size < chunkSize)
+            break;
+    }
+    return copies;
+}
+
+/// Returns the number of copies of the secret stored masked in \p masked
+/// in the readable memory of the process. The memory is read through
+/// \p /proc/self/mem, which returns an error instead of raising a signal
+/// for pages that cannot be read. The memory read into is mapped on its own
+/// and skipped, as it holds a copy of every secret found.
+static size_t countCopies(const std::vector<unsigned char>& masked) {
+    FILE* maps = fopen("/proc/self/maps", "r");
+    REQUIRE(maps != nullptr);
+    const int mem = open("/proc/self/mem", O_RDONLY);
+    REQUIRE(mem >= 0);
+    const size_t chunkSize = 1 << 16;
+    void* mapped = mmap(nullptr, chunkSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(mapped != MAP_FAILED);
+    char* chunk = static_cast<char*>(mapped);
+    const unsigned long chunkStart = reinterpret_cast<unsigned long>(chunk);
+
+    size_t copies = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), maps)) {
+        unsigned long start, end;
+        char perms[5];
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, perms) != 3 || perms[0] != 'r')
+            continue;
+        if (strstr(line, "[vvar]") || strstr(line, "[vsyscall]"))
+            continue;
+        // the chunk may have been merged with the mapping next to it
+        if (chunkStart >= start && chunkStart < end) {
+            copies += countCopies(mem, start, chunkStart, chunk, chunkSize, masked);
+            start = chunkStart + chunkSize;
+        }
+        copies += countCopies(mem, start, end, chunk, chunkSize, masked);
+    }
+    munmap(mapped, chunkSize);
+    close(mem);
+    fclose(maps);
+    return copies;
+}
+
+/// Tests the class \p SecureText
+TEST_CASE("SecureText", "[SecureText]") {
+    SecureText text;
+    REQUIRE(text.empty());
+    REQUIRE(text.bytes() == 0);
+    REQUIRE(std::string(text.data()) == "");
+
+    SECTION("Insert and erase") {
+        REQUIRE(text.insert(0, "world", 5) == 5);
+        REQUIRE(text.insert(0, "hello ", 6) == 6);
+        REQUIRE(text.insert(100, "!", 1) == 1);
+        REQUIRE(std::string(text.data()) == "hello world!");
+        REQUIRE(text.erase(5, 6) == 6);
+        REQUIRE(std::string(text.data()) == "hello!");
+        REQUIRE(text.erase(5, 10) == 1);
+        REQUIRE(text.erase(5, 1) == 0);
+        REQUIRE(std::string(text.data()) == "hello");
+        REQUIRE(text.length() == 5);
+    }
+
+    SECTION("UTF-8") {
+        // positions and counts are characters, not bytes
+        text.assign("gr\xC3\xBC\xC3\x9F", 6);
+        REQUIRE(text.length() == 4);
+        REQUIRE(text.bytes() == 6);
+        REQUIRE(text.insert(3, "\xE2\x82\xAC" "abc", 1) == 1);
+        REQUIRE(std::string(text.data()) == "gr\xC3\xBC\xE2\x82\xAC\xC3\x9F");
+        REQUIRE(text.erase(2, 2) == 2);
+        REQUIRE(std::string(text.data()) == "gr\xC3\x9F");
+        REQUIRE(text.length() == 3);
+        REQUIRE(text.bytes() == 4);
+    }
+
+    SECTION("Growth") {
+        std::string expected;
+        for (size_t i = 0; i < 10000; i++) {
+            const char c = static_cast<char>('a' + i % 26);
+            text.insert(i, &c, 1);
+            expected += c;
+        }
+        REQUIRE(std::string(text.data()) == expected);
+        text.clear();
+        REQUIRE(text.empty());
+        REQUIRE(std::string(text.data()) == "");
+        text.assign("abc", 3);
+        REQUIRE(std::string(text.data()) == "abc");
+    }
+}
+
+/// Tests that no copy of a password typed into a \p SecureText remains in
+/// the memory of the process once it is cleared or destroyed
+TEST_CASE("SecureText leaves no copies", "[SecureText]") {
+    std::random_device device;
+    std::vector<unsigned char> masked(SECRET_LENGTH);
+    for (auto& c : masked) {
+        c = static_cast<unsigned char>('a' + device() % 26) ^ SECRET_MASK;
+    }
+    REQUIRE(countCopies(masked) == 0);
+
+    std::unique_ptr<SecureText> text(new SecureText());
+    // typed one character at a time, so the text grows several times;
+    // deleting and typing a character again moves the end of the text
+    for (size_t i = 0; i < SECRET_LENGTH; i++) {
+        const char c = static_cast<char>(masked[i] ^ SECRET_MASK);
+        text->insert(i, &c, 1);
+        if (i == SECRET_LENGTH / 2) {
+            text->erase(0, 1);
+            const char first = static_cast<char>(masked[0] ^ SECRET_MASK);
+            text->insert(0, &first, 1);
+        }
+    }
+    for (size_t i = 0; i < 200; i++) {
+        text->insert(0, "x", 1);
+    }
+    // the scan finds the text itself
+    REQUIRE(countCopies(masked) == 1);
+
+    SECTION("Clear") {
+        text->clear();
+        REQUIRE(countCopies(masked) == 0);
+    }
+
+    SECTION("Erase") {
+        text->erase(0, text->length());
+        REQUIRE(countCopies(masked) == 0);
+    }
+
+    SECTION("Destroy") {
+        text.reset();
+        REQUIRE(countCopies(masked) == 0);
+    }
+}
+
+/// Tests that no copy of a password typed into a \p SecureText and
+/// estimated after every character by a \p StrengthEstimator, as the
+/// password field of the main window does, remains in the memory of the
+/// process once both are cleared. The GTK side of the password field (the
+/// entry widget and its input method) is not covered, as the tests do not
+/// link GTK.
+TEST_CASE("StrengthEstimator leaves no copies", "[SecureText]") {
+    std::random_device device;
+    std::vector<unsigned char> masked(SECRET_LENGTH);
+    for (auto& c : masked) {
+        c = static_cast<unsigned char>('a' + device() % 26) ^ SECRET_MASK;
+    }
+
+    SecureText text;
+    StrengthEstimator estimator;
+    estimator.addDictionary("words", "password\nmonkey\ndragon\n");
+    // typing, deleting the last character and typing it again
+    for (size_t i = 0; i < SECRET_LENGTH; i++) {
+        const char c = static_cast<char>(masked[i] ^ SECRET_MASK);
+        text.insert(i, &c, 1);
+        estimator.update(text.data(), text.bytes());
+        if (i == SECRET_LENGTH - 1) {
+            text.erase(i, 1);
+            estimator.update(text.data(), text.bytes());
+            text.insert(i, &c, 1);
+            estimator.update(text.data(), text.bytes());
+        }
+    }
+    // the scan finds the text and the password of the estimator
+    REQUIRE(countCopies(masked) == 2);
+
+    // deleting the whole password leaves an empty field
+    text.clear();
+    estimator.clear();
+    REQUIRE(countCopies(masked) == 0);
+}
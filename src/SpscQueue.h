@@ -0,0 +1,283 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SpscQueue.h
+ * \brief   Defines a bounded lock-free queue for one producer and one
+ *          consumer thread.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines a bounded lock-free queue for one producer and one
+ * consumer thread. It connects the stages of a pipeline: a full queue makes
+ * the producer wait for the consumer, so a pipeline needs a constant amount
+ * of memory no matter how much data flows through it.
+ *
+ * A thread waiting for the other one first yields for \p SPSC_SPIN_LIMIT
+ * rounds, which covers the short waits of a busy pipeline, and then blocks
+ * on a condition variable, so idle stages do not keep cores busy. The other
+ * thread only takes the lock to wake it up when it announced that it is
+ * blocking.
+ */
+
+#ifndef GTKPASS_SPSCQUEUE_H
+#define GTKPASS_SPSCQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Number of times a thread waiting for the other end of an \p SpscQueue
+/// yields before it blocks
+#define SPSC_SPIN_LIMIT 256
+
+/**
+ * Bounded lock-free ring buffer for exactly one producer and one consumer
+ * thread. Both indices live on their own cache line, so producer and
+ * consumer do not slow each other down by writing to the same line.
+ */
+template <typename T>
+class SpscQueue {
+
+public:
+    /**
+     * Constructor of \p SpscQueue. Creates an empty queue holding at least
+     * \p capacity items.
+     *
+     * \param capacity The minimum number of items the queue can hold
+     */
+    explicit SpscQueue(size_t capacity) : m_head(0), m_tail(0),
+        m_closed(false), m_producerBlocked(false), m_consumerBlocked(false),
+        m_occupancySum(0), m_occupancyMax(0), m_pushes(0) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    /**
+     * Allocates memory for a queue on the heap. The global \p operator new
+     * of C++11 ignores the cache line alignment of the indices.
+     *
+     * \param size The number of bytes to allocate
+     * \return Pointer to the allocated memory
+     */
+    static void* operator new(size_t size) {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, alignof(SpscQueue), size) != 0)
+            throw std::bad_alloc();
+        return memory;
+    }
+
+    /**
+     * Frees memory allocated by \p operator new.
+     *
+     * \param memory Pointer to the memory to free
+     */
+    static void operator delete(void* memory) {
+        free(memory);
+    }
+
+    /**
+     * Appends \p item to the queue. Waits while the queue is full. Must only
+     * be called by the producer.
+     *
+     * \param item The item to append
+     */
+    void push(T&& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        for (size_t spin = 0; tail - head > m_mask && spin < SPSC_SPIN_LIMIT; spin++) {
+            std::this_thread::yield();
+            head = m_head.load(std::memory_order_acquire);
+        }
+        if (tail - head > m_mask) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_producerBlocked.store(true);
+            m_changed.wait(lock, [&]() {
+                head = m_head.load();
+                return tail - head <= m_mask;
+            });
+            m_producerBlocked.store(false, std::memory_order_relaxed);
+        }
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        wake(m_consumerBlocked);
+
+        // sample the occupancy seen by the producer
+        const size_t occupancy = tail + 1 - head;
+        m_occupancySum += occupancy;
+        if (occupancy > m_occupancyMax)
+            m_occupancyMax = occupancy;
+        m_pushes++;
+    }
+
+    /**
+     * Removes the first item of the queue and moves it into \p item. Waits
+     * while the queue is empty and not closed. Must only be called by the
+     * consumer.
+     *
+     * \param item Receives the item
+     * \return \p true if an item was removed, \p false if the queue is closed
+     * and empty
+     */
+    bool pop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        for (size_t spin = 0; m_tail.load(std::memory_order_acquire) == head; spin++) {
+            if (m_closed.load(std::memory_order_acquire) &&
+                m_tail.load(std::memory_order_acquire) == head)
+                return false;
+            if (spin < SPSC_SPIN_LIMIT) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_consumerBlocked.store(true);
+            m_changed.wait(lock, [&]() {
+                return m_tail.load() != head || m_closed.load();
+            });
+            m_consumerBlocked.store(false, std::memory_order_relaxed);
+        }
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        wake(m_producerBlocked);
+        return true;
+    }
+
+    /**
+     * Appends \p item to the queue unless it is full. Must only be called by
+     * the producer.
+     *
+     * \param item The item to append, left unchanged if the queue is full
+     * \return \p true if the item was appended, \p false if the queue is full
+     */
+    bool tryPush(T&& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        if (tail - head > m_mask)
+            return false;
+        push(std::move(item));
+        return true;
+    }
+
+    /**
+     * Removes the first item of the queue and moves it into \p item unless
+     * the queue is empty. Must only be called by the consumer.
+     *
+     * \param item Receives the item
+     * \return \p true if an item was removed, \p false if the queue is empty
+     */
+    bool tryPop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_tail.load(std::memory_order_acquire) == head)
+            return false;
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        wake(m_producerBlocked);
+        return true;
+    }
+
+    /**
+     * Marks the end of the data. The consumer still gets all items in the
+     * queue before \p pop() returns \p false. Must only be called by the
+     * producer.
+     */
+    void close() {
+        m_closed.store(true);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changed.notify_all();
+    }
+
+    /// Returns the number of items in the queue. Exact when called by the
+    /// producer or the consumer while the other one is idle, otherwise a
+    /// snapshot.
+    size_t size() const {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    /// Returns the number of items the queue can hold
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+
+    /// Returns the average number of items in the queue right after a push.
+    /// Must not be called while the producer is running.
+    double averageOccupancy() const {
+        return m_pushes > 0 ? static_cast<double>(m_occupancySum) / m_pushes : 0.0;
+    }
+
+    /// Returns the maximum number of items in the queue right after a push.
+    /// Must not be called while the producer is running.
+    size_t maximumOccupancy() const {
+        return m_occupancyMax;
+    }
+
+private:
+    /**
+     * Wakes the other thread up if \p blocked shows that it is blocking.
+     * The fence orders the index stored before with the load of \p blocked,
+     * which the other thread stores before it checks the index under the
+     * lock: either this thread sees the flag or the other one sees the
+     * index. Taking the lock makes sure the other thread is waiting.
+     *
+     * \param blocked The flag of the other thread
+     */
+    void wake(const std::atomic<bool>& blocked) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!blocked.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changed.notify_all();
+    }
+
+    /// Ring buffer holding the items
+    std::vector<T> m_slots;
+    /// Number of slots - 1 (the number of slots is a power of two)
+    size_t m_mask;
+    /// Index of the next item to pop, written by the consumer only
+    alignas(64) std::atomic<size_t> m_head;
+    /// Index of the next slot to push to, written by the producer only
+    alignas(64) std::atomic<size_t> m_tail;
+    /// Set by the producer after the last item was pushed
+    std::atomic<bool> m_closed;
+    /// Protects blocking on \p m_changed
+    std::mutex m_mutex;
+    /// Signals a change of an index, or the end of the data, to a blocked
+    /// thread
+    std::condition_variable m_changed;
+    /// Set by the producer while it blocks on a full queue
+    std::atomic<bool> m_producerBlocked;
+    /// Set by the consumer while it blocks on an empty queue
+    std::atomic<bool> m_consumerBlocked;
+    /// Sum of the sampled occupancies, written by the producer only
+    size_t m_occupancySum;
+    /// Maximum of the sampled occupancies, written by the producer only
+    size_t m_occupancyMax;
+    /// Number of pushes, written by the producer only
+    size_t m_pushes;
+
+}; // end of class SpscQueue
+
+#endif
@@ -0,0 +1,82 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    SpscQueue_Test.cpp
+ * \brief   Tests the file \p SpscQueue.h.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the file \p SpscQueue.h.
+ */
+
+
+#include "catch.hpp"
+#include "SpscQueue.h"
+#include <thread>
+
+/// Tests the class \p SpscQueue
+TEST_CASE("SpscQueue", "[SpscQueue]") {
+    SECTION("Capacity") {
+        SpscQueue<int> queue(5);
+        REQUIRE(queue.capacity() == 8);
+    }
+
+    SECTION("Without waiting") {
+        SpscQueue<int> queue(2);
+        int item = 0;
+        REQUIRE(queue.tryPop(item) == false);
+        REQUIRE(queue.tryPush(1));
+        REQUIRE(queue.tryPush(2));
+        REQUIRE(queue.size() == 2);
+        REQUIRE(queue.tryPush(3) == false);
+        REQUIRE(queue.tryPop(item));
+        REQUIRE(item == 1);
+        REQUIRE(queue.tryPush(3));
+        REQUIRE(queue.tryPop(item));
+        REQUIRE(queue.tryPop(item));
+        REQUIRE(item == 3);
+        REQUIRE(queue.size() == 0);
+        REQUIRE(queue.tryPop(item) == false);
+    }
+
+    SECTION("Producer and consumer") {
+        const size_t count = 100000;
+        SpscQueue<size_t> queue(4);
+
+        std::thread producer([&]() {
+            for (size_t i = 0; i < count; i++) {
+                queue.push(std::move(i));
+            }
+            queue.close();
+        });
+
+        size_t expected = 0;
+        size_t item;
+        bool ordered = true;
+        while (queue.pop(item)) {
+            ordered = ordered && item == expected;
+            expected++;
+        }
+        producer.join();
+
+        REQUIRE(ordered);
+        REQUIRE(expected == count);
+        REQUIRE(queue.maximumOccupancy() <= queue.capacity());
+        REQUIRE(queue.averageOccupancy() >= 1.0);
+    }
+}
@@ -0,0 +1,99 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Startup.cpp
+ * \brief   Implements functions for measuring the startup of \p GtkPass.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for measuring the startup of \p GtkPass.
+ */
+
+#include "Startup.h"
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+
+namespace {
+
+/// Clock of the marks, never adjusted while running
+typedef std::chrono::steady_clock StartupClock;
+
+/// The marks recorded so far
+struct StartupMarks {
+    /// protects the members below
+    std::mutex mutex;
+    /// time of the first mark
+    StartupClock::time_point first;
+    /// the recorded marks
+    std::vector<startupmark> marks;
+};
+
+/// Returns the marks of the process
+StartupMarks& getMarks() {
+    static StartupMarks marks;
+    return marks;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Marks the end of the phase \p phase of the startup. The first mark is the
+ * start of all times.
+ *
+ * \param phase The name of the phase
+ */
+void markStartup(const std::string& phase) {
+    const StartupClock::time_point now = StartupClock::now();
+    StartupMarks& marks = getMarks();
+    std::lock_guard<std::mutex> lock(marks.mutex);
+    if (marks.marks.empty())
+        marks.first = now;
+    marks.marks.emplace_back(phase, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - marks.first).count()));
+}
+
+/**
+ * Returns the marks recorded so far in the order they were recorded.
+ *
+ * \return The marks of the startup
+ */
+std::vector<startupmark> getStartupMarks() {
+    StartupMarks& marks = getMarks();
+    std::lock_guard<std::mutex> lock(marks.mutex);
+    return marks.marks;
+}
+
+/**
+ * Writes the time from the first mark to the end of every phase in \p marks
+ * and the duration of the phase to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param marks The marks to print
+ */
+void printStartupTimes(std::ostream& out, const std::vector<startupmark>& marks) {
+    out << "Startup in ms:" << std::endl;
+    uint64_t previous = 0;
+    for (const startupmark& mark : marks) {
+        out << "  " << std::left << std::setw(14) << mark.phase << std::right
+            << std::fixed << std::setprecision(3) << std::setw(10)
+            << mark.nanoseconds / 1e6 << "  (+" << (mark.nanoseconds - previous) / 1e6
+            << ")" << std::endl;
+        previous = mark.nanoseconds;
+    }
+}
@@ -0,0 +1,78 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Startup.h
+ * \brief   Defines functions for measuring the startup of \p GtkPass.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for measuring the startup of \p GtkPass. The
+ * end of every phase of the startup, from entering \p main() to the first
+ * frame of the window, is marked with a timestamp. The marks are always
+ * recorded, as this costs a single reading of the clock per phase, and
+ * printed on request.
+ */
+
+#ifndef GTKPASS_STARTUP_H
+#define GTKPASS_STARTUP_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * \typedef startupmark
+ * \brief Defines a struct holding the end of a phase of the startup.
+ */
+typedef struct startupmark {
+    /// Initializes the mark with the phase \p phase ending after
+    /// \p nanoseconds
+    startupmark(const std::string& phase, uint64_t nanoseconds) : phase(phase),
+        nanoseconds(nanoseconds) {}
+    /// name of the phase
+    std::string phase;
+    /// time from the first mark to the end of the phase in nanoseconds
+    uint64_t nanoseconds;
+} startupmark;
+
+/**
+ * Marks the end of the phase \p phase of the startup. The first mark is the
+ * start of all times.
+ *
+ * \param phase The name of the phase
+ */
+void markStartup(const std::string& phase);
+
+/**
+ * Returns the marks recorded so far in the order they were recorded.
+ *
+ * \return The marks of the startup
+ */
+std::vector<startupmark> getStartupMarks();
+
+/**
+ * Writes the time from the first mark to the end of every phase in \p marks
+ * and the duration of the phase to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param marks The marks to print
+ */
+void printStartupTimes(std::ostream& out, const std::vector<startupmark>& marks);
+
+#endif
@@ -0,0 +1,64 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Startup_Test.cpp
+ * \brief   Tests the files \p Startup.h and \p Startup.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Startup.h and \p Startup.cpp.
+ */
+
+#include "catch.hpp"
+#include "Startup.h"
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+/// Tests the functions \p markStartup and \p getStartupMarks of \p Startup
+TEST_CASE("markStartup", "[Startup]") {
+    const size_t before = getStartupMarks().size();
+    markStartup("first");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    markStartup("second");
+
+    const std::vector<startupmark> marks = getStartupMarks();
+    REQUIRE(marks.size() == before + 2);
+    const startupmark& first = marks[before];
+    const startupmark& second = marks[before + 1];
+    REQUIRE(first.phase == "first");
+    REQUIRE(second.phase == "second");
+    REQUIRE(second.nanoseconds - first.nanoseconds >= 2000000);
+    REQUIRE(marks.front().nanoseconds == 0);
+}
+
+/// Tests the function \p printStartupTimes of \p Startup
+TEST_CASE("printStartupTimes", "[Startup]") {
+    std::vector<startupmark> marks;
+    marks.emplace_back("main", 0);
+    marks.emplace_back("sodium_init", 1500000);
+    marks.emplace_back("first frame", 42250000);
+
+    std::ostringstream out;
+    printStartupTimes(out, marks);
+    const std::string text = out.str();
+    REQUIRE(text.find("main") != std::string::npos);
+    REQUIRE(text.find("1.500  (+1.500)") != std::string::npos);
+    REQUIRE(text.find("42.250  (+40.750)") != std::string::npos);
+}
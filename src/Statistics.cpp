@@ -0,0 +1,234 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Statistics.cpp
+ * \brief   Implements functions for collecting and querying statistics about
+ *          password generation.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for collecting and querying statistics about
+ * password generation.
+ */
+
+#include "Statistics.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/// Size of a cache line on all platforms we care about
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Counters of a single thread. Only the owning thread writes to them, so a
+ * relaxed load and store is enough for incrementing. Other threads only read
+ * them when summing up the statistics.
+ */
+struct alignas(CACHE_LINE_SIZE) ThreadCounters {
+    ThreadCounters();
+    ~ThreadCounters();
+
+    std::atomic<uint64_t> passwordsGenerated;
+    std::atomic<uint64_t> charactersEmitted;
+    std::atomic<uint64_t> randomBytesConsumed;
+    std::atomic<uint64_t> rejectionRetries;
+    std::atomic<uint64_t> rngRefills;
+    std::atomic<uint64_t> latencyHistogram[STATS_LATENCY_BUCKETS];
+};
+
+/**
+ * Registry of the counters of all running threads plus the sum of all
+ * counters of terminated threads.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<const ThreadCounters*> threads;
+    genstats retired;
+};
+
+/**
+ * Returns the process wide registry. Being a function local static, it is
+ * constructed before and destroyed after the first thread's counters.
+ */
+Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+/// Adds \p value to the counter \p counter owned by the calling thread
+inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+        std::memory_order_relaxed);
+}
+
+/// Adds the counters in \p counters to \p stats
+void accumulate(genstats& stats, const ThreadCounters& counters) {
+    stats.passwordsGenerated += counters.passwordsGenerated.load(std::memory_order_relaxed);
+    stats.charactersEmitted += counters.charactersEmitted.load(std::memory_order_relaxed);
+    stats.randomBytesConsumed += counters.randomBytesConsumed.load(std::memory_order_relaxed);
+    stats.rejectionRetries += counters.rejectionRetries.load(std::memory_order_relaxed);
+    stats.rngRefills += counters.rngRefills.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        stats.latencyHistogram[i] += counters.latencyHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Registers a new block of counters for the calling thread.
+ */
+ThreadCounters::ThreadCounters() : passwordsGenerated(0), charactersEmitted(0),
+    randomBytesConsumed(0), rejectionRetries(0), rngRefills(0) {
+    for (size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        latencyHistogram[i].store(0, std::memory_order_relaxed);
+    }
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+/**
+ * Folds the counters of the terminating thread into the retired counters and
+ * unregisters them.
+ */
+ThreadCounters::~ThreadCounters() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    accumulate(registry.retired, *this);
+    registry.threads.erase(
+        std::remove(registry.threads.begin(), registry.threads.end(), this),
+        registry.threads.end()
+    );
+}
+
+/// Returns the counters of the calling thread
+ThreadCounters& getThreadCounters() {
+    static thread_local ThreadCounters counters;
+    return counters;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Records that random bytes were fetched from libsodium.
+ */
+void statsRecordRefill() {
+    add(getThreadCounters().rngRefills, 1);
+}
+
+/**
+ * Records that \p bytes random bytes were used for generation.
+ *
+ * \param bytes The number of bytes used
+ */
+void statsRecordBytes(size_t bytes) {
+    add(getThreadCounters().randomBytesConsumed, bytes);
+}
+
+/**
+ * Records that a random number was rejected during rejection sampling.
+ */
+void statsRecordRetry() {
+    add(getThreadCounters().rejectionRetries, 1);
+}
+
+/**
+ * Records that a string of \p length characters was generated in
+ * \p nanoseconds.
+ *
+ * \param length The number of characters in the string
+ * \param nanoseconds The time needed for generating the string
+ */
+void statsRecordString(size_t length, uint64_t nanoseconds) {
+    ThreadCounters& counters = getThreadCounters();
+    add(counters.passwordsGenerated, 1);
+    add(counters.charactersEmitted, length);
+    add(counters.latencyHistogram[getLatencyBucket(nanoseconds)], 1);
+}
+
+/**
+ * Records that \p count strings with \p characters characters in total were
+ * generated by a batch. Their latency is not recorded.
+ *
+ * \param count The number of strings
+ * \param characters The number of characters in all strings
+ */
+void statsRecordBatch(size_t count, size_t characters) {
+    ThreadCounters& counters = getThreadCounters();
+    add(counters.passwordsGenerated, count);
+    add(counters.charactersEmitted, characters);
+}
+
+/**
+ * Returns the index of the latency histogram bucket for \p nanoseconds.
+ *
+ * \param nanoseconds The latency to get the bucket for
+ * \return Index of the bucket between 0 and \p STATS_LATENCY_BUCKETS - 1
+ */
+size_t getLatencyBucket(uint64_t nanoseconds) {
+    size_t bucket = 0;
+    while (nanoseconds > 1 && bucket < STATS_LATENCY_BUCKETS - 1) {
+        nanoseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Sums up the counters of all threads (including threads that already
+ * terminated) and returns them.
+ *
+ * \return Snapshot of the statistics of the whole process
+ */
+genstats getStatistics() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    genstats stats = registry.retired;
+    for (const auto counters : registry.threads) {
+        accumulate(stats, *counters);
+    }
+    return stats;
+}
+
+/**
+ * Writes the statistics in \p stats to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param stats The statistics to print
+ */
+void printStatistics(std::ostream& out, const genstats& stats) {
+    out << "Passwords generated:   " << stats.passwordsGenerated << std::endl
+        << "Characters emitted:    " << stats.charactersEmitted << std::endl
+        << "Random bytes consumed: " << stats.randomBytesConsumed << std::endl
+        << "Rejection retries:     " << stats.rejectionRetries << std::endl
+        << "RNG refills:           " << stats.rngRefills << std::endl
+        << "Latency of getRandomString() in ns:" << std::endl;
+
+    for (size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        if (stats.latencyHistogram[i] == 0)
+            continue;
+        out << "  [" << (1ULL << i) << ", ";
+        if (i < STATS_LATENCY_BUCKETS - 1)
+            out << (1ULL << (i + 1)) << "): ";
+        else
+            out << "inf): ";
+        out << stats.latencyHistogram[i] << std::endl;
+    }
+}
@@ -0,0 +1,126 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Statistics.h
+ * \brief   Defines functions for collecting and querying statistics about
+ *          password generation.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for collecting and querying statistics about
+ * password generation. Every thread counts into its own cache line aligned
+ * block of counters, so recording never needs a lock and threads never write
+ * to the same cache line. The blocks are only summed up when the statistics
+ * are queried.
+ */
+
+#ifndef GTKPASS_STATISTICS_H
+#define GTKPASS_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/// Number of buckets in the latency histogram. Bucket \p i counts the calls
+/// taking between 2^i and 2^(i+1) - 1 nanoseconds, the last bucket also
+/// counts all longer calls.
+#define STATS_LATENCY_BUCKETS 40
+
+/**
+ * \typedef genstats
+ * \brief Defines a struct holding a snapshot of the generation statistics.
+ */
+typedef struct statistics {
+    /// Initializes all counters with 0
+    statistics() : passwordsGenerated(0), charactersEmitted(0),
+        randomBytesConsumed(0), rejectionRetries(0), rngRefills(0),
+        latencyHistogram() {}
+    /// number of strings returned by \p getRandomString()
+    uint64_t passwordsGenerated;
+    /// number of characters in all generated strings
+    uint64_t charactersEmitted;
+    /// number of random bytes used for generation
+    uint64_t randomBytesConsumed;
+    /// number of random numbers rejected to avoid modulo bias
+    uint64_t rejectionRetries;
+    /// number of times random bytes were fetched from libsodium
+    uint64_t rngRefills;
+    /// log2-bucketed histogram of the latency of \p getRandomString()
+    uint64_t latencyHistogram[STATS_LATENCY_BUCKETS];
+} genstats;
+
+/**
+ * Records that random bytes were fetched from libsodium.
+ */
+void statsRecordRefill();
+
+/**
+ * Records that \p bytes random bytes were used for generation.
+ *
+ * \param bytes The number of bytes used
+ */
+void statsRecordBytes(size_t bytes);
+
+/**
+ * Records that a random number was rejected during rejection sampling.
+ */
+void statsRecordRetry();
+
+/**
+ * Records that a string of \p length characters was generated in
+ * \p nanoseconds.
+ *
+ * \param length The number of characters in the string
+ * \param nanoseconds The time needed for generating the string
+ */
+void statsRecordString(size_t length, uint64_t nanoseconds);
+
+/**
+ * Records that \p count strings with \p characters characters in total were
+ * generated by a batch. Their latency is not recorded.
+ *
+ * \param count The number of strings
+ * \param characters The number of characters in all strings
+ */
+void statsRecordBatch(size_t count, size_t characters);
+
+/**
+ * Returns the index of the latency histogram bucket for \p nanoseconds.
+ *
+ * \param nanoseconds The latency to get the bucket for
+ * \return Index of the bucket between 0 and \p STATS_LATENCY_BUCKETS - 1
+ */
+size_t getLatencyBucket(uint64_t nanoseconds);
+
+/**
+ * Sums up the counters of all threads (including threads that already
+ * terminated) and returns them.
+ *
+ * \return Snapshot of the statistics of the whole process
+ */
+genstats getStatistics();
+
+/**
+ * Writes the statistics in \p stats to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param stats The statistics to print
+ */
+void printStatistics(std::ostream& out, const genstats& stats);
+
+#endif
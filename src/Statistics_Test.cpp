@@ -0,0 +1,114 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Statistics_Test.cpp
+ * \brief   Tests the files \p Statistics.h and \p Statistics.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Statistics.h and \p Statistics.cpp.
+ */
+
+#include "catch.hpp"
+#include "Statistics.h"
+#include "RandomGenerator.h"
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/// Returns the sum of all buckets in the latency histogram of \p stats
+static uint64_t histogramTotal(const genstats& stats) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        total += stats.latencyHistogram[i];
+    }
+    return total;
+}
+
+/// Tests the function \p getLatencyBucket of \p Statistics
+TEST_CASE("getLatencyBucket", "[Statistics]") {
+    REQUIRE(getLatencyBucket(0) == 0);
+    REQUIRE(getLatencyBucket(1) == 0);
+    REQUIRE(getLatencyBucket(2) == 1);
+    REQUIRE(getLatencyBucket(3) == 1);
+    REQUIRE(getLatencyBucket(1024) == 10);
+    REQUIRE(getLatencyBucket(2047) == 10);
+    REQUIRE(getLatencyBucket(UINT64_MAX) == STATS_LATENCY_BUCKETS - 1);
+}
+
+/// Tests the function \p getStatistics of \p Statistics
+TEST_CASE("getStatistics", "[Statistics]") {
+    genopts options;
+    const unsigned int length = 16;
+
+    SECTION("Single thread") {
+        const genstats before = getStatistics();
+        for (size_t i = 0; i < 10; i++) {
+            getRandomString(length, options);
+        }
+        const genstats after = getStatistics();
+
+        REQUIRE(after.passwordsGenerated - before.passwordsGenerated == 10);
+        REQUIRE(after.charactersEmitted - before.charactersEmitted == 10 * length);
+        REQUIRE(after.randomBytesConsumed - before.randomBytesConsumed >= 10 * length);
+        REQUIRE(after.rngRefills > before.rngRefills);
+        REQUIRE(histogramTotal(after) - histogramTotal(before) == 10);
+    }
+
+    SECTION("Terminated threads") {
+        const size_t threadCount = 4;
+        const size_t perThread = 25;
+        const genstats before = getStatistics();
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&]() {
+                for (size_t i = 0; i < perThread; i++) {
+                    getRandomString(length, options);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const genstats after = getStatistics();
+
+        REQUIRE(after.passwordsGenerated - before.passwordsGenerated == threadCount * perThread);
+        REQUIRE(after.charactersEmitted - before.charactersEmitted == threadCount * perThread * length);
+        REQUIRE(histogramTotal(after) - histogramTotal(before) == threadCount * perThread);
+    }
+
+    SECTION("Empty strings are not counted") {
+        const genstats before = getStatistics();
+        getRandomString(0, options);
+        const genstats after = getStatistics();
+        REQUIRE(after.passwordsGenerated == before.passwordsGenerated);
+    }
+}
+
+/// Tests the function \p printStatistics of \p Statistics
+TEST_CASE("printStatistics", "[Statistics]") {
+    genstats stats;
+    stats.passwordsGenerated = 3;
+    stats.latencyHistogram[4] = 3;
+
+    std::ostringstream out;
+    printStatistics(out, stats);
+    REQUIRE(out.str().find("Passwords generated:   3") != std::string::npos);
+    REQUIRE(out.str().find("[16, 32): 3") != std::string::npos);
+}
@@ -0,0 +1,987 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Strength.cpp
+ * \brief   Implements a pattern-based strength estimator for typed passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements a pattern-based strength estimator for typed
+ * passwords.
+ */
+
+#include "Strength.h"
+#include "sodium.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+/// Number of guesses per character guessed by brute force
+const double BRUTEFORCE_CARDINALITY = 10;
+/// Penalty for every additional match in a sequence, so sequences of many
+/// tiny matches do not win
+const double MIN_GUESSES_BEFORE_GROWING_SEQUENCE = 10000;
+/// Smallest number of guesses of a match of a single character
+const double MIN_GUESSES_SINGLE_CHAR = 10;
+/// Smallest number of guesses of a match of several characters
+const double MIN_GUESSES_MULTI_CHAR = 50;
+/// Smallest number of years between a year and the reference year
+const double MIN_YEAR_SPACE = 20;
+/// Shortest keyboard walk, repeat and sequence
+const size_t MIN_PATTERN_LENGTH = 3;
+/// Largest distance between the characters of a sequence
+const int MAX_SEQUENCE_DELTA = 5;
+/// Separators allowed in dates
+const char* const DATE_SEPARATORS = " /\\_.-";
+
+/// Upper bounds of the decimal logarithms of the guesses for the scores
+/// 0 to 3, as in zxcvbn
+const double SCORE_THRESHOLDS[] = {
+    3.0021660617565078,  // log10(1e3 + 5)
+    6.0000021714724095,  // log10(1e6 + 5)
+    8.0000000217147241,  // log10(1e8 + 5)
+    10.000000000217147   // log10(1e10 + 5)
+};
+
+/// Characters that are used instead of letters in l33t speak and their
+/// letters
+const char* const L33T_TABLE[][2] = {
+    {"4", "a"}, {"@", "a"}, {"8", "b"}, {"(", "c"}, {"{", "c"}, {"[", "c"},
+    {"<", "c"}, {"3", "e"}, {"6", "g"}, {"9", "g"}, {"1", "il"}, {"!", "i"},
+    {"|", "il"}, {"0", "o"}, {"$", "s"}, {"5", "s"}, {"7", "t"}, {"+", "t"},
+    {"%", "x"}, {"2", "z"}
+};
+
+/// Rows of a QWERTY keyboard without and with shift and their horizontal
+/// offset in keys
+const struct {
+    const char* keys;
+    const char* shifted;
+    double offset;
+} QWERTY_ROWS[] = {
+    {"`1234567890-=", "~!@#$%^&*()_+", 0},
+    {"qwertyuiop[]\\", "QWERTYUIOP{}|", 1.5},
+    {"asdfghjkl;'", "ASDFGHJKL:\"", 1.75},
+    {"zxcvbnm,./", "ZXCVBNM<>?", 2.25}
+};
+
+/// Returns \p a + \p b of the decimal logarithms \p a and \p b
+inline double addLog10(double a, double b) {
+    const double larger = std::max(a, b);
+    return larger + std::log10(1 + std::pow(10.0, std::min(a, b) - larger));
+}
+
+/// Returns the binomial coefficient of \p n and \p k
+double getBinomial(unsigned int n, unsigned int k) {
+    if (k > n)
+        return 0;
+    double result = 1;
+    for (unsigned int i = 1; i <= k; i++) {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+/// Returns the decimal logarithm of \p count factorial
+inline double getLog10Factorial(size_t count) {
+    return std::lgamma(double(count) + 1) / std::log(10.0);
+}
+
+/// Returns whether \p c is an upper case letter
+inline bool isUpper(char c) {
+    return c >= 'A' && c <= 'Z';
+}
+
+/// Returns whether \p c is a lower case letter
+inline bool isLower(char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+/// Returns whether \p c is a digit
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/// Returns \p c in lower case
+inline char toLower(char c) {
+    return isUpper(c) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/// Returns the number of guesses of the cases of the letters of the token
+/// \p begin to \p end
+double getUppercaseVariations(const char* begin, const char* end) {
+    unsigned int upper = 0;
+    unsigned int lower = 0;
+    for (const char* c = begin; c != end; ++c) {
+        upper += isUpper(*c);
+        lower += isLower(*c);
+    }
+    if (upper == 0)
+        return 1;
+    // capitalized, all caps and only the last letter upper case are common
+    const bool firstUpper = isUpper(*begin) && upper == 1;
+    const bool lastUpper = isUpper(*(end - 1)) && upper == 1;
+    if (lower == 0 || firstUpper || lastUpper)
+        return 2;
+    double variations = 0;
+    for (unsigned int i = 1; i <= std::min(upper, lower); i++) {
+        variations += getBinomial(upper + lower, i);
+    }
+    return variations;
+}
+
+/// Keyboard layout for finding keyboard walks
+struct Keyboard {
+    /// Builds the layout from \p QWERTY_ROWS
+    Keyboard() : keyCount(0), averageDegree(0) {
+        for (int c = 0; c < 128; c++) {
+            row[c] = -1;
+            position[c] = 0;
+            shifted[c] = false;
+        }
+        for (int r = 0; r < 4; r++) {
+            for (size_t k = 0; QWERTY_ROWS[r].keys[k] != '\0'; k++) {
+                for (const bool shift : {false, true}) {
+                    const int c = shift ? QWERTY_ROWS[r].shifted[k] : QWERTY_ROWS[r].keys[k];
+                    row[c] = r;
+                    position[c] = QWERTY_ROWS[r].offset + k;
+                    shifted[c] = shift;
+                }
+                keyCount++;
+            }
+        }
+        unsigned int neighbors = 0;
+        for (int r = 0; r < 4; r++) {
+            for (size_t k = 0; QWERTY_ROWS[r].keys[k] != '\0'; k++) {
+                for (size_t other = 0; other < 128; other++) {
+                    neighbors += !shifted[other] &&
+                        getDirection(QWERTY_ROWS[r].keys[k], static_cast<char>(other)) >= 0;
+                }
+            }
+        }
+        averageDegree = double(neighbors) / keyCount;
+    }
+
+    /// Returns the direction from the key of \p from to the neighbouring key
+    /// of \p to (left, right, upper left, upper right, lower left, lower
+    /// right), or -1 if the keys are not neighbours
+    int getDirection(char from, char to) const {
+        if (from < 0 || to < 0 || row[int(from)] < 0 || row[int(to)] < 0)
+            return -1;
+        const int rows = row[int(to)] - row[int(from)];
+        const double distance = position[int(to)] - position[int(from)];
+        if (rows == 0 && std::fabs(distance) == 1)
+            return distance < 0 ? 0 : 1;
+        if ((rows == 1 || rows == -1) && std::fabs(distance) <= 0.75)
+            return (rows < 0 ? 2 : 4) + (distance < 0 ? 0 : 1);
+        return -1;
+    }
+
+    /// row of the key of every character (-1 for none)
+    int row[128];
+    /// horizontal position of the key of every character
+    double position[128];
+    /// whether a character needs shift
+    bool shifted[128];
+    /// number of keys
+    unsigned int keyCount;
+    /// average number of neighbours of a key
+    double averageDegree;
+};
+
+/// Returns the keyboard layout
+const Keyboard& getKeyboard() {
+    static const Keyboard keyboard;
+    return keyboard;
+}
+
+/// Returns the decimal logarithm of the guesses of a keyboard walk of
+/// \p length keys with \p turns turns and \p shiftedCount shifted keys
+double getSpatialGuesses(size_t length, unsigned int turns,
+    unsigned int shiftedCount) {
+    const Keyboard& keyboard = getKeyboard();
+    const double startingPositions = 2.0 * keyboard.keyCount;
+    double guesses = 0;
+    for (unsigned int i = 2; i <= length; i++) {
+        for (unsigned int j = 1; j <= std::min(turns, i - 1); j++) {
+            guesses += getBinomial(i - 1, j - 1) * startingPositions *
+                std::pow(keyboard.averageDegree, j);
+        }
+    }
+    const unsigned int unshifted = length - shiftedCount;
+    if (shiftedCount > 0 && unshifted == 0) {
+        guesses *= 2;
+    } else if (shiftedCount > 0) {
+        double variations = 0;
+        for (unsigned int i = 1; i <= std::min(shiftedCount, unshifted); i++) {
+            variations += getBinomial(shiftedCount + unshifted, i);
+        }
+        guesses *= variations;
+    }
+    return std::log10(guesses);
+}
+
+/// Returns the year the dates are compared with
+int getReferenceYear() {
+    static const int year = [] {
+        const std::time_t now = std::time(nullptr);
+        std::tm local;
+        localtime_r(&now, &local);
+        return local.tm_year + 1900;
+    }();
+    return year;
+}
+
+/// Returns the decimal logarithm of the guesses of the year \p year
+inline double getYearGuesses(int year) {
+    return std::log10(std::max(double(std::abs(year - getReferenceYear())), MIN_YEAR_SPACE));
+}
+
+/// Parses the \p length digits at \p digits
+inline int parseDigits(const char* digits, size_t length) {
+    int value = 0;
+    for (size_t i = 0; i < length; i++) {
+        value = value * 10 + (digits[i] - '0');
+    }
+    return value;
+}
+
+/// Checks whether the numbers \p first, \p second and \p third (with
+/// \p firstDigits and \p thirdDigits digits) are a date with the year
+/// first or last, and stores the year of the date closest to the
+/// reference year in \p year
+bool getDateYear(int first, size_t firstDigits, int second, int third,
+    size_t thirdDigits, int& year) {
+    bool found = false;
+    const int candidates[][4] = {
+        {third, int(thirdDigits), first, second},
+        {first, int(firstDigits), second, third}
+    };
+    for (const auto& candidate : candidates) {
+        int value = candidate[0];
+        if (candidate[1] == 2)
+            value += value > 50 ? 1900 : 2000;
+        else if (candidate[1] != 4 || value < 1000 || value > 2050)
+            continue;
+        const int a = candidate[2];
+        const int b = candidate[3];
+        const bool valid = (a >= 1 && a <= 31 && b >= 1 && b <= 12) ||
+            (b >= 1 && b <= 31 && a >= 1 && a <= 12);
+        if (valid && (!found ||
+            std::abs(value - getReferenceYear()) < std::abs(year - getReferenceYear()))) {
+            year = value;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/// Checks whether the \p length characters at \p token are a date and
+/// returns the decimal logarithm of its guesses in \p guesses
+bool matchDate(const char* token, size_t length, double& guesses) {
+    // positions after the day or month in dates without separators
+    static const size_t SPLITS[][4][2] = {
+        {{1, 2}, {2, 3}, {0, 0}, {0, 0}},
+        {{1, 3}, {2, 3}, {0, 0}, {0, 0}},
+        {{1, 2}, {2, 4}, {4, 5}, {0, 0}},
+        {{1, 3}, {2, 3}, {4, 5}, {4, 6}},
+        {{2, 4}, {4, 6}, {0, 0}, {0, 0}}
+    };
+    size_t digits = 0;
+    while (digits < length && isDigit(token[digits])) {
+        digits++;
+    }
+    int year = 0;
+    bool found = false;
+    if (digits == length && length >= 4 && length <= 8) {
+        for (const auto& split : SPLITS[length - 4]) {
+            if (split[0] == 0)
+                break;
+            int candidate;
+            if (getDateYear(parseDigits(token, split[0]), split[0],
+                parseDigits(token + split[0], split[1] - split[0]),
+                parseDigits(token + split[1], length - split[1]), length - split[1],
+                candidate) && (!found ||
+                std::abs(candidate - getReferenceYear()) < std::abs(year - getReferenceYear()))) {
+                year = candidate;
+                found = true;
+            }
+        }
+        if (found) {
+            guesses = getYearGuesses(year) + std::log10(365.0);
+            return true;
+        }
+        return false;
+    }
+
+    // day, month and year with the same separator in between
+    if (length < 6 || digits == 0 || digits > 4 || strchr(DATE_SEPARATORS, token[digits]) == nullptr)
+        return false;
+    const char separator = token[digits];
+    size_t secondDigits = 0;
+    while (digits + 1 + secondDigits < length && isDigit(token[digits + 1 + secondDigits])) {
+        secondDigits++;
+    }
+    const size_t third = digits + 1 + secondDigits + 1;
+    if (secondDigits == 0 || secondDigits > 2 || third >= length ||
+        token[third - 1] != separator || length - third > 4)
+        return false;
+    for (size_t i = third; i < length; i++) {
+        if (!isDigit(token[i]))
+            return false;
+    }
+    if (!getDateYear(parseDigits(token, digits), digits,
+        parseDigits(token + digits + 1, secondDigits),
+        parseDigits(token + third, length - third), length - third, year))
+        return false;
+    guesses = getYearGuesses(year) + std::log10(365.0 * 4);
+    return true;
+}
+
+/// State of a search for the words ending at a position
+struct WordSearch {
+    /// the trie to search
+    const std::vector<Dictionary::Node>* nodes;
+    /// the password
+    const std::string* password;
+    /// the position after the last character of the words
+    size_t end;
+    /// index of the dictionary
+    size_t index;
+    /// whether the trie holds the words, so the matches are reversed
+    bool reversed;
+    /// receives the matches
+    std::vector<patmatch>* matches;
+    /// letter of the word at every position of the password
+    char letters[STRENGTH_MAX_LENGTH];
+};
+
+/// Returns the index of the child of \p node reached with \p c, or 0 if
+/// there is none
+uint32_t findChild(const std::vector<Dictionary::Node>& nodes,
+    const Dictionary::Node& node, char c) {
+    uint32_t low = node.firstChild;
+    uint32_t high = node.firstChild + node.childCount;
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        const unsigned char character = static_cast<unsigned char>(nodes[middle].character);
+        if (character == static_cast<unsigned char>(c))
+            return middle;
+        if (character < static_cast<unsigned char>(c))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return 0;
+}
+
+/// Adds the match of the word with the rank \p rank at the positions
+/// \p begin to \p search.end
+void addWordMatch(const WordSearch& search, size_t begin, unsigned int rank) {
+    const char* token = search.password->data();
+    const size_t end = search.end;
+    if (search.reversed) {
+        // palindromes are found without reversing
+        bool palindrome = true;
+        for (size_t i = begin, j = end - 1; palindrome && i < j; i++, j--) {
+            palindrome = search.letters[i] == search.letters[j];
+        }
+        if (palindrome)
+            return;
+    }
+
+    // every substitution multiplies the guesses by the number of ways to
+    // choose the substituted ones of the letters
+    double l33tVariations = 1;
+    bool l33t = false;
+    std::vector<std::pair<char, char>> substitutions;
+    for (size_t i = begin; i < end; i++) {
+        const std::pair<char, char> substitution(token[i], search.letters[i]);
+        if (toLower(token[i]) == search.letters[i] ||
+            std::find(substitutions.begin(), substitutions.end(), substitution) != substitutions.end())
+            continue;
+        substitutions.push_back(substitution);
+        l33t = true;
+        unsigned int substituted = 0;
+        unsigned int unsubstituted = 0;
+        for (size_t j = begin; j < end; j++) {
+            substituted += token[j] == substitution.first && search.letters[j] == substitution.second;
+            unsubstituted += toLower(token[j]) == substitution.second;
+        }
+        if (unsubstituted == 0) {
+            l33tVariations *= 2;
+        } else {
+            double variations = 0;
+            for (unsigned int k = 1; k <= std::min(substituted, unsubstituted); k++) {
+                variations += getBinomial(substituted + unsubstituted, k);
+            }
+            l33tVariations *= variations;
+        }
+    }
+
+    patmatch match;
+    match.type = PATTERN_DICTIONARY;
+    match.begin = begin;
+    match.end = end;
+    match.dictionary = search.index;
+    match.rank = rank;
+    match.reversed = search.reversed;
+    match.l33t = l33t;
+    match.log10Guesses = std::log10(double(rank) *
+        getUppercaseVariations(token + begin, token + end) * l33tVariations *
+        (search.reversed ? 2 : 1));
+    search.matches->push_back(match);
+}
+
+/// Walks from \p node of the trie through the characters before \p begin,
+/// adding a match for every word found
+void searchWords(WordSearch& search, uint32_t node, size_t begin) {
+    const Dictionary::Node& current = (*search.nodes)[node];
+    if (current.rank > 0 && begin < search.end)
+        addWordMatch(search, begin, current.rank);
+    if (begin == 0 || current.childCount == 0)
+        return;
+
+    const char c = (*search.password)[begin - 1];
+    char candidates[4] = {toLower(c), '\0', '\0', '\0'};
+    size_t count = 1;
+    for (const auto& entry : L33T_TABLE) {
+        if (entry[0][0] == c) {
+            for (const char* letter = entry[1]; *letter != '\0'; ++letter) {
+                candidates[count++] = *letter;
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t child = findChild(*search.nodes, current, candidates[i]);
+        if (child != 0) {
+            search.letters[begin - 1] = candidates[i];
+            searchWords(search, child, begin - 1);
+        }
+    }
+}
+
+/// Builds a trie of the \p words with their ranks, sorted by word
+std::vector<Dictionary::Node> buildTrie(const std::vector<std::pair<std::string, uint32_t>>& words) {
+    std::vector<Dictionary::Node> nodes(1, Dictionary::Node());
+    nodes[0].firstChild = 0;
+    nodes[0].rank = 0;
+    nodes[0].childCount = 0;
+    nodes[0].character = '\0';
+
+    // breadth first, so the children of every node are stored together
+    struct Range {
+        uint32_t node;
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+    std::deque<Range> queue;
+    queue.push_back({0, 0, words.size(), 0});
+    while (!queue.empty()) {
+        const Range range = queue.front();
+        queue.pop_front();
+        size_t i = range.begin;
+        if (i < range.end && words[i].first.size() == range.depth) {
+            nodes[range.node].rank = words[i].second;
+            i++;
+        }
+        nodes[range.node].firstChild = static_cast<uint32_t>(nodes.size());
+        while (i < range.end) {
+            const char c = words[i].first[range.depth];
+            size_t next = i;
+            while (next < range.end && words[next].first[range.depth] == c) {
+                next++;
+            }
+            Dictionary::Node child;
+            child.firstChild = 0;
+            child.rank = 0;
+            child.childCount = 0;
+            child.character = c;
+            queue.push_back({static_cast<uint32_t>(nodes.size()), i, next, range.depth + 1});
+            nodes.push_back(child);
+            nodes[range.node].childCount++;
+            i = next;
+        }
+    }
+    return nodes;
+}
+
+/// Returns the bruteforce match of the characters \p begin to \p end
+patmatch getBruteforceMatch(size_t begin, size_t end) {
+    patmatch match;
+    match.begin = begin;
+    match.end = end;
+    match.log10Guesses = std::max(double(end - begin) * std::log10(BRUTEFORCE_CARDINALITY),
+        std::log10(end - begin == 1 ? MIN_GUESSES_SINGLE_CHAR + 1 : MIN_GUESSES_MULTI_CHAR + 1));
+    return match;
+}
+
+/// Returns the score of a password with the decimal logarithm of the
+/// guesses \p log10Guesses
+unsigned int getScore(double log10Guesses) {
+    unsigned int score = 0;
+    while (score < 4 && log10Guesses >= SCORE_THRESHOLDS[score]) {
+        score++;
+    }
+    return score;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Constructor of \p Dictionary. Builds the tries of \p words.
+ *
+ * \param name The name of the dictionary
+ * \param words The words, one per line, the most common first
+ */
+Dictionary::Dictionary(const std::string& name, const std::string& words) :
+    m_name(name), m_size(0) {
+    std::vector<std::pair<std::string, uint32_t>> ranked;
+    std::istringstream input(words);
+    std::string word;
+    while (std::getline(input, word)) {
+        if (!word.empty() && word[word.size() - 1] == '\r')
+            word.erase(word.size() - 1);
+        if (word.empty() || word.size() > STRENGTH_MAX_LENGTH)
+            continue;
+        std::transform(word.begin(), word.end(), word.begin(), toLower);
+        ranked.emplace_back(word, static_cast<uint32_t>(ranked.size() + 1));
+    }
+    // keep the best rank of words listed twice
+    std::sort(ranked.begin(), ranked.end());
+    ranked.erase(std::unique(ranked.begin(), ranked.end(),
+        [](const std::pair<std::string, uint32_t>& a, const std::pair<std::string, uint32_t>& b) {
+            return a.first == b.first;
+        }), ranked.end());
+    m_size = ranked.size();
+    m_forward = buildTrie(ranked);
+    for (auto& entry : ranked) {
+        std::reverse(entry.first.begin(), entry.first.end());
+    }
+    std::sort(ranked.begin(), ranked.end());
+    m_reversed = buildTrie(ranked);
+}
+
+/**
+ * Returns the name of the dictionary.
+ *
+ * \return The name
+ */
+const std::string& Dictionary::getName() const {
+    return m_name;
+}
+
+/**
+ * Returns the number of words in the dictionary.
+ *
+ * \return The number of words
+ */
+size_t Dictionary::size() const {
+    return m_size;
+}
+
+/**
+ * Returns the rank of \p word in the dictionary.
+ *
+ * \param word The word in lower case
+ * \return The rank (1 for the most common word) or 0 if the word is not
+ * in the dictionary
+ */
+unsigned int Dictionary::getRank(const std::string& word) const {
+    uint32_t node = 0;
+    for (const char c : word) {
+        node = findChild(m_forward, m_forward[node], c);
+        if (node == 0)
+            return 0;
+    }
+    return m_forward[node].rank;
+}
+
+/**
+ * Appends all matches of words ending at the character before \p end of
+ * \p password to \p matches, including reversed words and words with
+ * l33t substitutions.
+ *
+ * \param password The password
+ * \param end The position after the last character of the matches
+ * \param index The index of the dictionary stored in the matches
+ * \param matches Receives the matches
+ */
+void Dictionary::findMatches(const std::string& password, size_t end, size_t index,
+    std::vector<patmatch>& matches) const {
+    WordSearch search;
+    search.password = &password;
+    search.end = std::min(end, size_t(STRENGTH_MAX_LENGTH));
+    search.index = index;
+    search.matches = &matches;
+    search.nodes = &m_reversed;
+    search.reversed = false;
+    searchWords(search, 0, search.end);
+    search.nodes = &m_forward;
+    search.reversed = true;
+    searchWords(search, 0, search.end);
+    sodium_memzero(search.letters, sizeof(search.letters));
+}
+
+/**
+ * Constructor of \p StrengthEstimator. Creates an estimator without
+ * dictionaries for an empty password.
+ */
+StrengthEstimator::StrengthEstimator() : m_reusedLength(0) {
+    m_password.reserve(STRENGTH_MAX_LENGTH);
+}
+
+/**
+ * Destructor of \p StrengthEstimator. Wipes the password.
+ */
+StrengthEstimator::~StrengthEstimator() {
+    sodium_memzero(&m_password[0], m_password.size());
+}
+
+/**
+ * Adds a dictionary of ranked words and estimates the current password
+ * again.
+ *
+ * \param name The name of the dictionary
+ * \param words The words, one per line, the most common first
+ */
+void StrengthEstimator::addDictionary(const std::string& name, const std::string& words) {
+    addDictionary(std::make_shared<const Dictionary>(name, words));
+}
+
+/**
+ * Adds a dictionary that may be shared with other estimators and
+ * estimates the current password again.
+ *
+ * \param dictionary The dictionary
+ */
+void StrengthEstimator::addDictionary(const std::shared_ptr<const Dictionary>& dictionary) {
+    m_dictionaries.push_back(dictionary);
+    estimate(0, m_password.size());
+}
+
+/**
+ * Returns the dictionary with the index \p index, e.g. for describing a
+ * dictionary match.
+ *
+ * \param index The index of the dictionary
+ * \return The dictionary
+ */
+const Dictionary& StrengthEstimator::getDictionary(size_t index) const {
+    return *m_dictionaries.at(index);
+}
+
+/**
+ * Estimates the strength of \p password, reusing the results of the
+ * prefix it shares with the previous password.
+ *
+ * \param password The password
+ * \return The estimate, valid until the next call
+ */
+const strengthest& StrengthEstimator::update(const std::string& password) {
+    return update(password.data(), password.size());
+}
+
+/**
+ * Estimates the strength of the \p length characters at \p password,
+ * reusing the results of the prefix they share with the previous
+ * password.
+ *
+ * \param password The characters of the password
+ * \param length The number of characters
+ * \return The estimate, valid until the next call
+ */
+const strengthest& StrengthEstimator::update(const char* password, size_t length) {
+    const size_t analyzed = std::min(length, size_t(STRENGTH_MAX_LENGTH));
+    size_t common = 0;
+    while (common < analyzed && common < m_password.size() &&
+        password[common] == m_password[common]) {
+        common++;
+    }
+    m_reusedLength = common;
+    // the buffer was reserved for the longest password, so only the
+    // characters after the common prefix change and none stay behind
+    sodium_memzero(&m_password[common], m_password.size() - common);
+    m_password.resize(common);
+    m_password.append(password + common, analyzed - common);
+    return estimate(common, length);
+}
+
+/**
+ * Wipes the password and estimates the empty password.
+ */
+void StrengthEstimator::clear() {
+    update("", 0);
+}
+
+/**
+ * Estimates \p m_password, reusing the results of its first \p common
+ * characters, for a password of \p length characters. Characters after
+ * \p m_password are guessed by brute force.
+ *
+ * \param common The number of characters whose results are reused
+ * \param length The number of characters of the whole password
+ * \return The estimate, valid until the next call
+ */
+const strengthest& StrengthEstimator::estimate(size_t common, size_t length) {
+    const size_t analyzed = m_password.size();
+
+    // drop the results after the common prefix
+    m_matches.resize(common);
+    m_optimal.resize(common);
+    m_matches.resize(analyzed);
+    m_optimal.resize(analyzed);
+    for (size_t last = common; last < analyzed; last++) {
+        findMatches(last);
+        optimize(last);
+    }
+    finish(analyzed);
+
+    // characters after the analyzed ones are guessed by brute force
+    if (length > analyzed) {
+        const patmatch rest = getBruteforceMatch(analyzed, length);
+        m_estimate.sequence.push_back(rest);
+        m_estimate.log10Guesses += rest.log10Guesses;
+        m_estimate.score = getScore(m_estimate.log10Guesses);
+    }
+    return m_estimate;
+}
+
+/**
+ * Returns the number of leading characters whose results were reused by
+ * the last call of \p update().
+ *
+ * \return The length of the reused prefix
+ */
+size_t StrengthEstimator::getReusedLength() const {
+    return m_reusedLength;
+}
+
+/// Finds the matches ending at the character \p last
+void StrengthEstimator::findMatches(size_t last) {
+    std::vector<patmatch>& matches = m_matches[last];
+    const std::string& password = m_password;
+    for (size_t i = 0; i < m_dictionaries.size(); i++) {
+        m_dictionaries[i]->findMatches(password, last + 1, i, matches);
+    }
+
+    // keyboard walks: walk back while the keys are neighbours
+    const Keyboard& keyboard = getKeyboard();
+    unsigned int turns = 0;
+    unsigned int shiftedCount = password[last] >= 0 && keyboard.shifted[int(password[last])];
+    int nextDirection = -1;
+    for (size_t begin = last; begin > 0; begin--) {
+        const int direction = keyboard.getDirection(password[begin - 1], password[begin]);
+        if (direction < 0)
+            break;
+        turns += direction != nextDirection;
+        nextDirection = direction;
+        shiftedCount += keyboard.shifted[int(password[begin - 1])];
+        if (last - begin + 2 >= MIN_PATTERN_LENGTH) {
+            patmatch match;
+            match.type = PATTERN_SPATIAL;
+            match.begin = begin - 1;
+            match.end = last + 1;
+            match.log10Guesses = getSpatialGuesses(match.end - match.begin, turns, shiftedCount);
+            matches.push_back(match);
+        }
+    }
+
+    findRepeats(last, matches);
+
+    // sequences: the longest run of characters with a constant distance
+    if (last >= MIN_PATTERN_LENGTH - 1) {
+        const int delta = password[last] - password[last - 1];
+        size_t begin = last - 1;
+        while (begin > 0 && password[begin] - password[begin - 1] == delta) {
+            begin--;
+        }
+        if (delta != 0 && std::abs(delta) <= MAX_SEQUENCE_DELTA &&
+            last - begin + 1 >= MIN_PATTERN_LENGTH) {
+            const char first = password[begin];
+            double base = 26;
+            if (strchr("aAzZ019", first) != nullptr)
+                base = 4;
+            else if (isDigit(first))
+                base = 10;
+            patmatch match;
+            match.type = PATTERN_SEQUENCE;
+            match.begin = begin;
+            match.end = last + 1;
+            match.log10Guesses = std::log10(base * (last - begin + 1) * (delta < 0 ? 2 : 1));
+            matches.push_back(match);
+        }
+    }
+
+    // dates and recent years of 4 to 10 characters
+    for (size_t length = 4; length <= 10 && length <= last + 1; length++) {
+        const char* token = password.data() + last + 1 - length;
+        double guesses;
+        bool found = false;
+        if (length == 4 && isDigit(token[0]) && isDigit(token[1]) && isDigit(token[2]) &&
+            isDigit(token[3])) {
+            const int year = parseDigits(token, 4);
+            if (year >= 1900 && year <= 2050) {
+                guesses = getYearGuesses(year);
+                found = true;
+            }
+        }
+        if (!found)
+            found = matchDate(token, length, guesses);
+        if (found) {
+            patmatch match;
+            match.type = PATTERN_DATE;
+            match.begin = last + 1 - length;
+            match.end = last + 1;
+            match.log10Guesses = guesses;
+            matches.push_back(match);
+        }
+    }
+
+    for (auto& match : matches) {
+        match.log10Guesses = std::max(match.log10Guesses, std::log10(
+            match.end - match.begin == 1 ? MIN_GUESSES_SINGLE_CHAR : MIN_GUESSES_MULTI_CHAR));
+    }
+}
+
+/// Appends the repeats ending at the character \p last to \p matches
+void StrengthEstimator::findRepeats(size_t last, std::vector<patmatch>& matches) const {
+    const std::string& password = m_password;
+    const size_t end = last + 1;
+    for (size_t period = 1; 2 * period <= end; period++) {
+        // strings repeating a shorter string are found with its period
+        bool primitive = true;
+        for (size_t shorter = 1; primitive && shorter < period; shorter++) {
+            primitive = period % shorter != 0 ||
+                password.compare(end - period, period - shorter, password,
+                    end - period + shorter, period - shorter) != 0;
+        }
+        if (!primitive)
+            continue;
+        size_t begin = end - period;
+        while (begin >= period &&
+            password.compare(begin - period, period, password, begin, period) == 0) {
+            begin -= period;
+        }
+        const size_t count = (end - begin) / period;
+        if (count < 2 || end - begin < MIN_PATTERN_LENGTH)
+            continue;
+
+        // the repeated string is estimated on its own
+        double baseGuesses;
+        if (period == 1) {
+            baseGuesses = getBruteforceMatch(0, 1).log10Guesses;
+        } else {
+            StrengthEstimator base;
+            base.m_dictionaries = m_dictionaries;
+            baseGuesses = base.update(password.data() + begin, period).log10Guesses;
+        }
+        patmatch match;
+        match.type = PATTERN_REPEAT;
+        match.begin = begin;
+        match.end = end;
+        match.log10Guesses = baseGuesses + std::log10(double(count));
+        matches.push_back(match);
+    }
+}
+
+/// Runs the dynamic program for the prefix ending at the character
+/// \p last
+void StrengthEstimator::optimize(size_t last) {
+    for (const auto& match : m_matches[last]) {
+        if (match.begin == 0) {
+            updateStep(match, 1);
+            continue;
+        }
+        const std::vector<Step>& before = m_optimal[match.begin - 1];
+        for (size_t count = 1; count <= before.size(); count++) {
+            if (before[count - 1].valid)
+                updateStep(match, count + 1);
+        }
+    }
+
+    // characters guessed by brute force, never directly after other ones
+    updateStep(getBruteforceMatch(0, last + 1), 1);
+    for (size_t begin = 1; begin <= last; begin++) {
+        const patmatch match = getBruteforceMatch(begin, last + 1);
+        const std::vector<Step>& before = m_optimal[begin - 1];
+        for (size_t count = 1; count <= before.size(); count++) {
+            if (before[count - 1].valid && before[count - 1].match.type != PATTERN_BRUTEFORCE)
+                updateStep(match, count + 1);
+        }
+    }
+}
+
+/// Updates the best sequence of \p count matches ending with \p match
+void StrengthEstimator::updateStep(const patmatch& match, size_t count) {
+    double log10Product = match.log10Guesses;
+    if (count > 1)
+        log10Product += m_optimal[match.begin - 1][count - 2].log10Product;
+    // the attacker does not know the number of matches nor their order
+    const double log10Score = addLog10(log10Product + getLog10Factorial(count),
+        (count - 1) * std::log10(MIN_GUESSES_BEFORE_GROWING_SEQUENCE));
+
+    std::vector<Step>& steps = m_optimal[match.end - 1];
+    for (size_t other = 0; other < count && other < steps.size(); other++) {
+        if (steps[other].valid && steps[other].log10Score <= log10Score)
+            return;
+    }
+    if (steps.size() < count) {
+        Step invalid;
+        invalid.valid = false;
+        invalid.log10Product = 0;
+        invalid.log10Score = 0;
+        steps.resize(count, invalid);
+    }
+    Step& step = steps[count - 1];
+    step.match = match;
+    step.log10Product = log10Product;
+    step.log10Score = log10Score;
+    step.valid = true;
+}
+
+/// Collects the best sequence covering the whole analyzed password
+void StrengthEstimator::finish(size_t length) {
+    m_estimate = strengthest();
+    if (length == 0)
+        return;
+    const std::vector<Step>& steps = m_optimal[length - 1];
+    size_t count = 0;
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (steps[i].valid && (count == 0 || steps[i].log10Score < steps[count - 1].log10Score))
+            count = i + 1;
+    }
+    m_estimate.log10Guesses = steps[count - 1].log10Score;
+    m_estimate.score = getScore(m_estimate.log10Guesses);
+
+    size_t end = length;
+    while (count > 0 && end > 0) {
+        const patmatch& match = m_optimal[end - 1][count - 1].match;
+        m_estimate.sequence.push_back(match);
+        end = match.begin;
+        count--;
+    }
+    std::reverse(m_estimate.sequence.begin(), m_estimate.sequence.end());
+}
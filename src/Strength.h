@@ -0,0 +1,323 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Strength.h
+ * \brief   Defines a pattern-based strength estimator for typed passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines an estimator for the number of guesses an attacker
+ * needs for a concrete password, in the spirit of zxcvbn (Wheeler, "zxcvbn:
+ * Low-Budget Password Strength Estimation"). Unlike the entropy of the
+ * generator settings, it looks at what the user actually typed.
+ *
+ * Matchers find words of ranked dictionaries (also reversed, capitalized
+ * and with l33t substitutions like "p@ssw0rd"), walks on a QWERTY keyboard,
+ * repeated characters and strings, sequences like "abcd" or "9753" and
+ * dates. Every match has an estimated number of guesses; the rest of the
+ * password is guessed character by character. A dynamic program finds the
+ * sequence of non-overlapping matches covering the password with the fewest
+ * guesses.
+ *
+ * All matchers report matches by their last character, and the dynamic
+ * program runs from the first character to the last, so the matches and
+ * partial results of a prefix only depend on the prefix. When the password
+ * changes, only the positions after the unchanged prefix are evaluated
+ * again, which keeps the estimate of a typed character well below a
+ * millisecond.
+ */
+
+#ifndef GTKPASS_STRENGTH_H
+#define GTKPASS_STRENGTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Number of leading characters analyzed, the rest is guessed by brute force
+#define STRENGTH_MAX_LENGTH 100
+
+/**
+ * \typedef pattype
+ * \brief Defines the kinds of patterns found in a password.
+ */
+typedef enum patterntype {
+    /// characters not matching any pattern
+    PATTERN_BRUTEFORCE,
+    /// word of a dictionary
+    PATTERN_DICTIONARY,
+    /// walk of adjacent keys on a QWERTY keyboard
+    PATTERN_SPATIAL,
+    /// repeated character or string
+    PATTERN_REPEAT,
+    /// characters with a constant distance like "abc" or "9753"
+    PATTERN_SEQUENCE,
+    /// date or recent year
+    PATTERN_DATE
+} pattype;
+
+/**
+ * \typedef patmatch
+ * \brief Defines a struct holding a pattern found in a password.
+ */
+typedef struct patternmatch {
+    /// Initializes an empty match
+    patternmatch() : type(PATTERN_BRUTEFORCE), begin(0), end(0),
+        log10Guesses(0), dictionary(0), rank(0), reversed(false),
+        l33t(false) {}
+    /// the kind of pattern
+    pattype type;
+    /// position of the first character of the match
+    size_t begin;
+    /// position after the last character of the match
+    size_t end;
+    /// decimal logarithm of the estimated number of guesses
+    double log10Guesses;
+    /// index of the dictionary of a dictionary match
+    size_t dictionary;
+    /// rank of the word in its dictionary (1 for the most common word)
+    unsigned int rank;
+    /// whether a dictionary word is reversed
+    bool reversed;
+    /// whether a dictionary word contains l33t substitutions
+    bool l33t;
+} patmatch;
+
+/**
+ * \typedef strengthest
+ * \brief Defines a struct holding the estimated strength of a password.
+ */
+typedef struct strengthestimate {
+    /// Initializes the estimate of an empty password
+    strengthestimate() : log10Guesses(0), score(0) {}
+    /// decimal logarithm of the estimated number of guesses
+    double log10Guesses;
+    /// score from 0 (too guessable) to 4 (very unguessable)
+    unsigned int score;
+    /// the patterns the password consists of, ordered by position
+    std::vector<patmatch> sequence;
+} strengthest;
+
+/**
+ * Dictionary of ranked words stored in two compact tries: one of the
+ * reversed words for finding words by their last character and one of the
+ * words for finding reversed words.
+ */
+class Dictionary {
+
+public:
+    /**
+     * Constructor of \p Dictionary. Builds the tries of \p words.
+     *
+     * \param name The name of the dictionary
+     * \param words The words, one per line, the most common first
+     */
+    Dictionary(const std::string& name, const std::string& words);
+
+    /**
+     * Returns the name of the dictionary.
+     *
+     * \return The name
+     */
+    const std::string& getName() const;
+
+    /**
+     * Returns the number of words in the dictionary.
+     *
+     * \return The number of words
+     */
+    size_t size() const;
+
+    /**
+     * Returns the rank of \p word in the dictionary.
+     *
+     * \param word The word in lower case
+     * \return The rank (1 for the most common word) or 0 if the word is not
+     * in the dictionary
+     */
+    unsigned int getRank(const std::string& word) const;
+
+    /**
+     * Appends all matches of words ending at the character before \p end of
+     * \p password to \p matches, including reversed words and words with
+     * l33t substitutions.
+     *
+     * \param password The password
+     * \param end The position after the last character of the matches
+     * \param index The index of the dictionary stored in the matches
+     * \param matches Receives the matches
+     */
+    void findMatches(const std::string& password, size_t end, size_t index,
+        std::vector<patmatch>& matches) const;
+
+    /// Node of a trie; the children of a node are stored next to each other
+    /// and sorted by their character
+    struct Node {
+        /// index of the first child
+        uint32_t firstChild;
+        /// rank of the word ending at this node (0 if none)
+        uint32_t rank;
+        /// number of children
+        uint16_t childCount;
+        /// character leading to this node
+        char character;
+    };
+
+private:
+    Dictionary(const Dictionary&) = delete;
+    Dictionary& operator=(const Dictionary&) = delete;
+
+    /// the name of the dictionary
+    std::string m_name;
+    /// number of words
+    size_t m_size;
+    /// trie of the reversed words
+    std::vector<Node> m_reversed;
+    /// trie of the words
+    std::vector<Node> m_forward;
+
+}; // end of class Dictionary
+
+/**
+ * Estimator for the strength of a password that is typed or edited. Every
+ * call of \p update() reuses the matches and partial results of the prefix
+ * the new password shares with the previous one.
+ */
+class StrengthEstimator {
+
+public:
+    /**
+     * Constructor of \p StrengthEstimator. Creates an estimator without
+     * dictionaries for an empty password.
+     */
+    StrengthEstimator();
+
+    /**
+     * Destructor of \p StrengthEstimator. Wipes the password.
+     */
+    ~StrengthEstimator();
+
+    /**
+     * Adds a dictionary of ranked words and estimates the current password
+     * again.
+     *
+     * \param name The name of the dictionary
+     * \param words The words, one per line, the most common first
+     */
+    void addDictionary(const std::string& name, const std::string& words);
+
+    /**
+     * Adds a dictionary that may be shared with other estimators and
+     * estimates the current password again.
+     *
+     * \param dictionary The dictionary
+     */
+    void addDictionary(const std::shared_ptr<const Dictionary>& dictionary);
+
+    /**
+     * Returns the dictionary with the index \p index, e.g. for describing a
+     * dictionary match.
+     *
+     * \param index The index of the dictionary
+     * \return The dictionary
+     */
+    const Dictionary& getDictionary(size_t index) const;
+
+    /**
+     * Estimates the strength of \p password, reusing the results of the
+     * prefix it shares with the previous password.
+     *
+     * \param password The password
+     * \return The estimate, valid until the next call
+     */
+    const strengthest& update(const std::string& password);
+
+    /**
+     * Estimates the strength of the \p length characters at \p password,
+     * reusing the results of the prefix they share with the previous
+     * password.
+     *
+     * \param password The characters of the password
+     * \param length The number of characters
+     * \return The estimate, valid until the next call
+     */
+    const strengthest& update(const char* password, size_t length);
+
+    /**
+     * Wipes the password and estimates the empty password.
+     */
+    void clear();
+
+    /**
+     * Returns the number of leading characters whose results were reused by
+     * the last call of \p update().
+     *
+     * \return The length of the reused prefix
+     */
+    size_t getReusedLength() const;
+
+private:
+    StrengthEstimator(const StrengthEstimator&) = delete;
+    StrengthEstimator& operator=(const StrengthEstimator&) = delete;
+
+    /// Best sequence of a number of matches covering a prefix
+    struct Step {
+        /// the last match of the sequence
+        patmatch match;
+        /// decimal logarithm of the product of the guesses of the matches
+        double log10Product;
+        /// decimal logarithm of the guesses of the whole sequence
+        double log10Score;
+        /// whether there is such a sequence
+        bool valid;
+    };
+
+    /// Estimates \p m_password, reusing the results of its first \p common
+    /// characters, for a password of \p length characters
+    const strengthest& estimate(size_t common, size_t length);
+    /// Finds the matches ending at the character \p last
+    void findMatches(size_t last);
+    /// Appends the repeats ending at the character \p last to \p matches
+    void findRepeats(size_t last, std::vector<patmatch>& matches) const;
+    /// Runs the dynamic program for the prefix ending at the character
+    /// \p last
+    void optimize(size_t last);
+    /// Updates the best sequence of \p count matches ending with \p match
+    void updateStep(const patmatch& match, size_t count);
+    /// Collects the best sequence covering the whole analyzed password
+    void finish(size_t length);
+
+    /// the dictionaries, shared with the estimators of repeated strings
+    std::vector<std::shared_ptr<const Dictionary>> m_dictionaries;
+    /// the current password (at most \p STRENGTH_MAX_LENGTH characters),
+    /// reserved once so it is never reallocated and wiped when it shrinks
+    std::string m_password;
+    /// the matches ending at every character
+    std::vector<std::vector<patmatch>> m_matches;
+    /// the best sequences of 1, 2, ... matches ending at every character
+    std::vector<std::vector<Step>> m_optimal;
+    /// the estimate of the current password
+    strengthest m_estimate;
+    /// number of characters reused by the last update
+    size_t m_reusedLength;
+
+}; // end of class StrengthEstimator
+
+#endif
@@ -0,0 +1,105 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Strength_Bench.cpp
+ * \brief   Benchmarks the files \p Strength.h and \p Strength.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Strength.h and \p Strength.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Strength.h"
+#include "RandomGenerator.h"
+#include <algorithm>
+#include <iomanip>
+
+/// Number of words in every dictionary
+static const size_t WORD_COUNT = 30000;
+/// Number of times every password is typed
+static const size_t ROUNDS = 20;
+
+/// Writes the average and largest time of \p times nanoseconds per
+/// keystroke to \p out
+static void printKeystrokes(std::ostream& out, const std::string& label,
+    const std::vector<uint64_t>& times) {
+    uint64_t total = 0;
+    for (const uint64_t time : times) {
+        total += time;
+    }
+    out << std::left << std::setw(40) << label << std::right << std::fixed
+        << std::setprecision(1) << std::setw(8) << double(total) / times.size() / 1000
+        << " us/keystroke, max " << std::setw(8)
+        << *std::max_element(times.begin(), times.end()) / 1000.0 << " us" << std::endl;
+}
+
+/// Measures the time of estimating the strength after every keystroke when
+/// typing passwords and when editing them in the middle
+BENCHMARK_CASE(strength_keystroke) {
+    genopts options;
+    options.bIncludeLettersUpper = false;
+    options.bIncludeNumbers = false;
+    StrengthEstimator estimator;
+    for (const char* name : {"passwords", "english", "names"}) {
+        std::string words;
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            words += getRandomString(3 + getRandomNumber(8), options) + "\n";
+        }
+        const uint64_t start = getNanoseconds();
+        estimator.addDictionary(name, words);
+        out << "Loading " << WORD_COUNT << " words: " << std::fixed << std::setprecision(1)
+            << (getNanoseconds() - start) / 1e6 << " ms" << std::endl;
+    }
+
+    genopts random;
+    random.bIncludeSpecial = true;
+    const std::vector<std::string> passwords = {
+        "correcthorsebatterystaple",
+        "P@ssw0rd1987qwertyuiop!",
+        "aaaaaaaaaabababababab123456789",
+        getRandomString(32, random),
+        getRandomString(STRENGTH_MAX_LENGTH, random)
+    };
+    for (const auto& password : passwords) {
+        std::vector<uint64_t> typing;
+        std::vector<uint64_t> editing;
+        for (size_t round = 0; round < ROUNDS; round++) {
+            estimator.update("");
+            for (size_t length = 1; length <= password.size(); length++) {
+                const std::string prefix = password.substr(0, length);
+                const uint64_t start = getNanoseconds();
+                estimator.update(prefix);
+                typing.push_back(getNanoseconds() - start);
+            }
+            // insert a character in the middle and remove it again
+            std::string edited = password;
+            edited.insert(password.size() / 2, 1, 'x');
+            uint64_t start = getNanoseconds();
+            estimator.update(edited);
+            editing.push_back(getNanoseconds() - start);
+            start = getNanoseconds();
+            estimator.update(password);
+            editing.push_back(getNanoseconds() - start);
+        }
+        const std::string label = password.size() > 30 ?
+            "random, " + std::to_string(password.size()) + " characters" : password;
+        printKeystrokes(out, label + " (typing)", typing);
+        printKeystrokes(out, label + " (editing)", editing);
+    }
+}
@@ -0,0 +1,208 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Strength_Test.cpp
+ * \brief   Tests the files \p Strength.h and \p Strength.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Strength.h and \p Strength.cpp.
+ */
+
+#include "catch.hpp"
+#include "Strength.h"
+#include "RandomGenerator.h"
+#include <cmath>
+
+/// Common passwords for the tests, the most common first
+static const char* const PASSWORDS = "123456\npassword\nqwerty\nmonkey\ndragon\n"
+    "letmein\nfootball\nsunshine\n";
+/// Common words for the tests
+static const char* const WORDS = "the\nhorse\nbattery\nstaple\ncorrect\npass\nword\n"
+    "sun\nshine\n";
+
+/// Returns the types of the patterns in \p estimate
+static std::vector<pattype> getTypes(const strengthest& estimate) {
+    std::vector<pattype> types;
+    for (const auto& match : estimate.sequence) {
+        types.push_back(match.type);
+    }
+    return types;
+}
+
+/// Returns an estimator with the test dictionaries
+static void addDictionaries(StrengthEstimator& estimator) {
+    estimator.addDictionary("passwords", PASSWORDS);
+    estimator.addDictionary("english", WORDS);
+}
+
+/// Tests the class \p Dictionary
+TEST_CASE("Dictionary", "[Strength]") {
+    const Dictionary dictionary("words", "The\nhorse\r\nthe\n\nbattery\nhorses\n");
+    REQUIRE(dictionary.getName() == "words");
+    REQUIRE(dictionary.size() == 4);
+    REQUIRE(dictionary.getRank("the") == 1);
+    REQUIRE(dictionary.getRank("horse") == 2);
+    REQUIRE(dictionary.getRank("battery") == 4);
+    REQUIRE(dictionary.getRank("horses") == 5);
+    REQUIRE(dictionary.getRank("hors") == 0);
+    REQUIRE(dictionary.getRank("") == 0);
+
+    std::vector<patmatch> matches;
+    dictionary.findMatches("xhorses", 7, 3, matches);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].begin == 1);
+    REQUIRE(matches[0].end == 7);
+    REQUIRE(matches[0].dictionary == 3);
+    REQUIRE(matches[0].rank == 5);
+    matches.clear();
+    dictionary.findMatches("xhorses", 6, 0, matches);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].rank == 2);
+
+    // reversed, capitalized and with l33t substitutions
+    matches.clear();
+    dictionary.findMatches("esroh", 5, 0, matches);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].reversed);
+    matches.clear();
+    dictionary.findMatches("B4773ry", 7, 0, matches);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].l33t);
+    REQUIRE_FALSE(matches[0].reversed);
+    REQUIRE(matches[0].log10Guesses > std::log10(4.0 * 2));
+}
+
+/// Tests the matchers of the class \p StrengthEstimator
+TEST_CASE("StrengthEstimator patterns", "[Strength]") {
+    StrengthEstimator estimator;
+    addDictionaries(estimator);
+
+    REQUIRE(estimator.update("").log10Guesses == 0);
+    REQUIRE(estimator.update("").sequence.empty());
+    REQUIRE(estimator.update("password").score == 0);
+    REQUIRE(getTypes(estimator.update("password")) == std::vector<pattype>({PATTERN_DICTIONARY}));
+    REQUIRE(getTypes(estimator.update("P@ssw0rd")) == std::vector<pattype>({PATTERN_DICTIONARY}));
+    REQUIRE(estimator.update("P@ssw0rd").sequence[0].l33t);
+    REQUIRE(getTypes(estimator.update("drowssap")) == std::vector<pattype>({PATTERN_DICTIONARY}));
+    REQUIRE(getTypes(estimator.update("zxcvbnm")) == std::vector<pattype>({PATTERN_SPATIAL}));
+    REQUIRE(getTypes(estimator.update("qazxsw")) == std::vector<pattype>({PATTERN_SPATIAL}));
+    REQUIRE(getTypes(estimator.update("aaaaaaaa")) == std::vector<pattype>({PATTERN_REPEAT}));
+    REQUIRE(getTypes(estimator.update("monkeymonkeymonkey")) == std::vector<pattype>({PATTERN_REPEAT}));
+    REQUIRE(getTypes(estimator.update("hijklmn")) == std::vector<pattype>({PATTERN_SEQUENCE}));
+    REQUIRE(getTypes(estimator.update("97531")) == std::vector<pattype>({PATTERN_SEQUENCE}));
+    REQUIRE(getTypes(estimator.update("13.05.1987")) == std::vector<pattype>({PATTERN_DATE}));
+    REQUIRE(getTypes(estimator.update("1987")) == std::vector<pattype>({PATTERN_DATE}));
+    REQUIRE(getTypes(estimator.update("130587")) == std::vector<pattype>({PATTERN_DATE}));
+    REQUIRE(getTypes(estimator.update("correcthorsebatterystaple")) ==
+        std::vector<pattype>(4, PATTERN_DICTIONARY));
+    REQUIRE(getTypes(estimator.update("Sunshine1987")) ==
+        std::vector<pattype>({PATTERN_DICTIONARY, PATTERN_DATE}));
+
+    // the sequence covers the password without gaps
+    const strengthest& estimate = estimator.update("xkcd-correct_horse7battery");
+    size_t end = 0;
+    for (const auto& match : estimate.sequence) {
+        REQUIRE(match.begin == end);
+        REQUIRE(match.end > match.begin);
+        end = match.end;
+    }
+    REQUIRE(end == 26);
+    REQUIRE(estimator.getDictionary(1).getName() == "english");
+}
+
+/// Tests the scores of the class \p StrengthEstimator
+TEST_CASE("StrengthEstimator scores", "[Strength]") {
+    StrengthEstimator estimator;
+    addDictionaries(estimator);
+
+    REQUIRE(estimator.update("qwerty").score == 0);
+    REQUIRE(estimator.update("letmein1").score <= 1);
+    REQUIRE(estimator.update("correcthorsebatterystaple").score >= 3);
+    REQUIRE(estimator.update("Tr0ub4dour&3").score >= 2);
+
+    // random passwords are as strong as their characters
+    genopts options;
+    for (int i = 0; i < 20; i++) {
+        REQUIRE(estimator.update(getRandomString(20, options)).score == 4);
+    }
+
+    // characters after the analyzed ones are guessed by brute force
+    const std::string longPassword(STRENGTH_MAX_LENGTH, 'a');
+    const double analyzed = estimator.update(longPassword).log10Guesses;
+    const strengthest& estimate = estimator.update(longPassword + "12345");
+    REQUIRE(estimate.log10Guesses == Approx(analyzed + 5));
+    REQUIRE(estimate.sequence.back().begin == STRENGTH_MAX_LENGTH);
+}
+
+/// Tests that the class \p StrengthEstimator reuses the results of the
+/// unchanged prefix and gives the same results as a new estimator
+TEST_CASE("StrengthEstimator incremental", "[Strength]") {
+    StrengthEstimator estimator;
+    addDictionaries(estimator);
+
+    const std::vector<std::string> edits = {"p", "pa", "pas", "pass", "passw",
+        "passwo", "passwor", "password", "password1", "password19", "password198",
+        "password1987", "passXword1987", "passXwrd1987", "", "monkey", "monkeymonkey"};
+    for (const auto& password : edits) {
+        const strengthest& estimate = estimator.update(password);
+        StrengthEstimator fresh;
+        addDictionaries(fresh);
+        const strengthest& expected = fresh.update(password);
+        REQUIRE(estimate.log10Guesses == Approx(expected.log10Guesses));
+        REQUIRE(getTypes(estimate) == getTypes(expected));
+    }
+    estimator.update("password1987");
+    estimator.update("password1988");
+    REQUIRE(estimator.getReusedLength() == 11);
+    estimator.update("pXssword1988");
+    REQUIRE(estimator.getReusedLength() == 1);
+
+    // characters without a string give the same results, clearing forgets
+    // the password
+    const char characters[] = "pXssword1988abc";
+    REQUIRE(estimator.update(characters, 12).log10Guesses ==
+        Approx(estimator.update("pXssword1988").log10Guesses));
+    REQUIRE(estimator.getReusedLength() == 12);
+    estimator.clear();
+    REQUIRE(estimator.update("").sequence.empty());
+    estimator.update("pXssword1988");
+    REQUIRE(estimator.getReusedLength() == 0);
+}
+
+/// Tests that estimators sharing a dictionary give the same results as
+/// estimators with their own copy
+TEST_CASE("StrengthEstimator shared dictionaries", "[Strength]") {
+    const auto passwords = std::make_shared<const Dictionary>("passwords", PASSWORDS);
+    const auto english = std::make_shared<const Dictionary>("english", WORDS);
+    StrengthEstimator first, second, own;
+    for (StrengthEstimator* estimator : {&first, &second}) {
+        estimator->addDictionary(passwords);
+        estimator->addDictionary(english);
+    }
+    addDictionaries(own);
+    REQUIRE(&first.getDictionary(0) == &second.getDictionary(0));
+    REQUIRE(passwords.use_count() == 3);
+
+    for (const std::string password : {"password1987", "correcthorse", "Tr0ub4dor&3"}) {
+        const double expected = own.update(password).log10Guesses;
+        REQUIRE(first.update(password).log10Guesses == Approx(expected));
+        REQUIRE(second.update(password).log10Guesses == Approx(expected));
+    }
+}
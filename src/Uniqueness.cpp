@@ -0,0 +1,779 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Uniqueness.cpp
+ * \brief   Implements functions for generating batches of unique passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file implements functions for generating batches of unique
+ * passwords.
+ */
+
+#include "Uniqueness.h"
+#include "BatchGenerator.h"
+#include "BulkOutput.h"
+#include "RandomGenerator.h"
+#include "Scheduler.h"
+#include "Statistics.h"
+#include "sodium.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/// Number of records generated at once
+const size_t BLOCK_RECORDS = 65536;
+/// Size of the buffers for reading and writing spill files
+const size_t SPILL_BUFFER_SIZE = 256 * 1024;
+
+/// Reports the failure of \p call with the current \p errno to \p errors
+bool reportError(std::ostream& errors, const char* call) {
+    errors << "ERROR: " << call << " failed: " << strerror(errno) << std::endl;
+    return false;
+}
+
+/// Returns the current time of a monotonic clock in nanoseconds
+uint64_t getNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Returns the smallest power of two that is at least \p value
+uint64_t roundUpToPowerOfTwo(uint64_t value) {
+    uint64_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+/// Returns the 64 bit FNV-1a hash of the \p length bytes at \p record,
+/// finished with the mixer of MurmurHash3 so all bits depend on all bytes
+uint64_t hashRecord(const char* record, unsigned int length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned int i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(record[i]);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/// Writes the \p length bytes at \p data to \p fd
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        const ssize_t result = write(fd, data, length);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0)
+            return false;
+        data += result;
+        length -= result;
+    }
+    return true;
+}
+
+/// Reads up to \p length bytes from \p fd to \p data and returns the number
+/// of bytes read (less than \p length only at the end of the file), or -1
+ssize_t readAll(int fd, char* data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        const ssize_t result = read(fd, data + done, length - done);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0)
+            return -1;
+        if (result == 0)
+            break;
+        done += result;
+    }
+    return done;
+}
+
+/**
+ * Generates \p count records of \p length characters from \p alphabet into
+ * \p buffer on \p threads threads.
+ */
+void generateRecords(char* buffer, size_t count, const std::string& alphabet,
+    unsigned int length, unsigned int threads) {
+    const size_t perTask = std::max<size_t>(1, BATCH_CHUNK_CHARS / length);
+    const size_t tasks = (count + perTask - 1) / perTask;
+    runParallel(tasks, threads, [&](size_t task) {
+        const size_t first = task * perTask;
+        const size_t records = std::min(perTask, count - first);
+        fillRandomChars(buffer + first * length, records * length, alphabet);
+        statsRecordBatch(records, records * length);
+    });
+}
+
+/**
+ * Produces the output lines of a sequence of records for \p writeOutput().
+ * The records are requested one after another from a function returning a
+ * pointer to the next record, so the buffers must be filled in order.
+ */
+class LineFiller {
+public:
+    /// Creates a filler for records of \p length bytes returned by \p next
+    LineFiller(unsigned int length, const std::function<const char*()>& next) :
+        m_length(length), m_next(next), m_record(nullptr), m_column(length + 1) {}
+
+    /// Fills \p bytes bytes at \p buffer with the next lines
+    void fill(char* buffer, size_t bytes) {
+        while (bytes > 0) {
+            if (m_column > m_length) {
+                m_record = m_next();
+                m_column = 0;
+            }
+            if (m_column == m_length) {
+                *buffer++ = '\n';
+                bytes--;
+                m_column++;
+                continue;
+            }
+            const size_t run = std::min<size_t>(bytes, m_length - m_column);
+            memcpy(buffer, m_record + m_column, run);
+            buffer += run;
+            bytes -= run;
+            m_column += run;
+        }
+    }
+
+private:
+    /// number of bytes per record
+    const unsigned int m_length;
+    /// returns the next record
+    std::function<const char*()> m_next;
+    /// record of the current line
+    const char* m_record;
+    /// position in the current line (\p m_length + 1 after the line break)
+    size_t m_column;
+};
+
+/**
+ * Open-addressing hash set of fixed-width records with linear probing. The
+ * records are stored in the slots themselves; a slot starting with a null
+ * byte is empty, so records must not start with one.
+ */
+class RecordSet {
+public:
+    /// Creates an empty set of \p capacity slots (a power of two) for
+    /// records of \p length bytes
+    RecordSet(size_t capacity, unsigned int length) :
+        m_slots(capacity * length, '\0'), m_mask(capacity - 1),
+        m_length(length) {}
+
+    /// Wipes the records
+    ~RecordSet() {
+        sodium_memzero(m_slots.data(), m_slots.size());
+    }
+
+    /// Inserts \p record and returns whether it was not in the set before
+    bool insert(const char* record) {
+        size_t slot = hashRecord(record, m_length) & m_mask;
+        while (true) {
+            char* stored = &m_slots[slot * m_length];
+            if (*stored == '\0') {
+                memcpy(stored, record, m_length);
+                return true;
+            }
+            if (memcmp(stored, record, m_length) == 0)
+                return false;
+            slot = (slot + 1) & m_mask;
+        }
+    }
+
+    /// Returns the first record stored in a slot at or after \p slot and
+    /// moves \p slot behind it (the set must hold such a record)
+    const char* next(size_t& slot) const {
+        while (m_slots[slot * m_length] == '\0')
+            slot++;
+        return &m_slots[slot++ * m_length];
+    }
+
+    /// Returns the number of bytes used by the slots
+    size_t getSize() const {
+        return m_slots.size();
+    }
+
+private:
+    /// slots holding a record or starting with a null byte
+    std::vector<char> m_slots;
+    /// number of slots - 1
+    const size_t m_mask;
+    /// number of bytes per record
+    const unsigned int m_length;
+};
+
+/**
+ * Private directory holding the spill files of all partitions. The
+ * directory and all files in it are removed on destruction.
+ */
+class SpillDirectory {
+public:
+    /// Creates a new directory in \p parent
+    explicit SpillDirectory(const std::string& parent) :
+        m_path(parent + "/gtkpass-unique-XXXXXX") {
+        if (mkdtemp(&m_path[0]) == nullptr)
+            m_path.clear();
+    }
+
+    /// Removes the directory and all spill files
+    ~SpillDirectory() {
+        if (m_path.empty())
+            return;
+        for (const auto& file : m_files)
+            unlink(file.c_str());
+        rmdir(m_path.c_str());
+    }
+
+    /// Returns whether the directory was created
+    bool isValid() const {
+        return !m_path.empty();
+    }
+
+    /// Returns the path of the file \p name of \p partition and remembers it
+    /// for removal
+    std::string getPath(size_t partition, const char* name) {
+        const std::string path = m_path + "/" + std::to_string(partition) + "." + name;
+        m_files.insert(path);
+        return path;
+    }
+
+private:
+    /// path of the directory (empty if it could not be created)
+    std::string m_path;
+    /// paths of all files created in the directory
+    std::set<std::string> m_files;
+};
+
+/// Reads the sorted records of a spill file one after another
+class RecordReader {
+public:
+    /// Opens the file \p path of records of \p length bytes; a missing file
+    /// holds no records
+    RecordReader(const std::string& path, unsigned int length) :
+        m_buffer(std::max<size_t>(1, SPILL_BUFFER_SIZE / length) * length),
+        m_length(length), m_position(0), m_end(0), m_failed(false) {
+        m_fd = open(path.c_str(), O_RDONLY);
+        m_failed = m_fd < 0 && errno != ENOENT;
+        advance();
+    }
+
+    /// Closes the file and wipes the buffer
+    ~RecordReader() {
+        if (m_fd >= 0)
+            close(m_fd);
+        sodium_memzero(m_buffer.data(), m_buffer.size());
+    }
+
+    /// Returns the current record or \p nullptr at the end of the file
+    const char* current() const {
+        return m_position < m_end ? &m_buffer[m_position] : nullptr;
+    }
+
+    /// Moves to the next record
+    void advance() {
+        m_position += m_length;
+        if (m_position < m_end || m_fd < 0)
+            return;
+        const ssize_t result = readAll(m_fd, m_buffer.data(), m_buffer.size());
+        m_failed = m_failed || result < 0;
+        m_position = 0;
+        m_end = result < 0 ? 0 : result - result % m_length;
+    }
+
+    /// Returns whether reading failed
+    bool hasFailed() const {
+        return m_failed;
+    }
+
+private:
+    /// descriptor of the file (-1 if it does not exist)
+    int m_fd;
+    /// records read from the file
+    std::vector<char> m_buffer;
+    /// number of bytes per record
+    const unsigned int m_length;
+    /// offset of the current record in the buffer
+    size_t m_position;
+    /// number of valid bytes in the buffer
+    size_t m_end;
+    /// whether reading failed
+    bool m_failed;
+};
+
+/// Writes records to a new spill file through a buffer
+class RecordWriter {
+public:
+    /// Creates the file \p path for records of \p length bytes
+    RecordWriter(const std::string& path, unsigned int length) :
+        m_buffer(std::max<size_t>(1, SPILL_BUFFER_SIZE / length) * length),
+        m_length(length), m_used(0) {
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        m_failed = m_fd < 0;
+    }
+
+    /// Closes the file and wipes the buffer
+    ~RecordWriter() {
+        if (m_fd >= 0)
+            close(m_fd);
+        sodium_memzero(m_buffer.data(), m_buffer.size());
+    }
+
+    /// Appends \p record to the file
+    void write(const char* record) {
+        memcpy(&m_buffer[m_used], record, m_length);
+        m_used += m_length;
+        if (m_used == m_buffer.size())
+            flush();
+    }
+
+    /// Writes the buffered records and closes the file, returns whether all
+    /// records were written
+    bool finish() {
+        flush();
+        if (m_fd >= 0 && close(m_fd) != 0)
+            m_failed = true;
+        m_fd = -1;
+        return !m_failed;
+    }
+
+private:
+    /// Writes the buffered records
+    void flush() {
+        if (!m_failed && !writeAll(m_fd, m_buffer.data(), m_used))
+            m_failed = true;
+        m_used = 0;
+    }
+
+    /// descriptor of the file
+    int m_fd;
+    /// records not written yet
+    std::vector<char> m_buffer;
+    /// number of bytes per record
+    const unsigned int m_length;
+    /// number of bytes in the buffer
+    size_t m_used;
+    /// whether writing failed
+    bool m_failed;
+};
+
+/// Reads the whole file \p path into \p data
+bool readFile(const std::string& path, std::vector<char>& data) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    bool success = fstat(fd, &status) == 0;
+    if (success) {
+        data.resize(status.st_size);
+        success = readAll(fd, data.data(), data.size()) == ssize_t(data.size());
+    }
+    close(fd);
+    return success;
+}
+
+/// Appends the \p length bytes at \p data to the file \p path
+bool appendFile(const std::string& path, const char* data, size_t length) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return false;
+    const bool success = writeAll(fd, data, length);
+    return close(fd) == 0 && success;
+}
+
+/// Returns whether so many passwords were blocked that the blocklist
+/// probably bans almost all passwords of the policy and length
+bool isMostlyBlocked(const uniquerep& report) {
+    return report.blocked >= BLOCKLIST_MAX_ATTEMPTS &&
+        report.generated - report.blocked < report.blocked / BLOCKLIST_MAX_ATTEMPTS;
+}
+
+/// Reports that the blocklist bans almost all passwords
+bool reportBlocked(std::ostream& errors) {
+    errors << "ERROR: Almost all passwords are on the blocklist!" << std::endl;
+    return false;
+}
+
+/// Returns a uniformly distributed random number less than \p upperBound
+uint64_t getRandomIndex(uint64_t upperBound) {
+    if (upperBound <= UINT32_MAX)
+        return randombytes_uniform(static_cast<uint32_t>(upperBound));
+    // reject the values of the incomplete last range like
+    // randombytes_uniform()
+    const uint64_t minimum = (0 - upperBound) % upperBound;
+    uint64_t value;
+    do {
+        randombytes_buf(&value, sizeof(value));
+    } while (value < minimum);
+    return value % upperBound;
+}
+
+/// Returns whether \p attempts passwords in a row added no unique password,
+/// so many that the \p keySpace possible passwords are probably exhausted
+bool isExhausted(uint64_t attempts, uint64_t keySpace) {
+    return attempts / UNIQUE_MAX_STALL >= keySpace;
+}
+
+/// Reports that the blocklist leaves fewer than \p count passwords of
+/// \p length characters
+bool reportExhausted(std::ostream& errors, uint64_t count, unsigned int length) {
+    errors << "ERROR: There are fewer than " << count << " allowed passwords "
+        << "of length " << length << "!" << std::endl;
+    return false;
+}
+
+/**
+ * Generates the batch in an in-memory hash set of \p capacity slots and
+ * writes it to \p fd.
+ */
+bool writeFromMemory(int fd, uint64_t count, const std::string& alphabet,
+    unsigned int length, size_t capacity, std::ostream& errors,
+    uniquerep& report, const uniqueopts& options) {
+    RecordSet set(capacity, length);
+    std::vector<char> block(std::min<uint64_t>(count, BLOCK_RECORDS) * length);
+    report.rounds = 1;
+    report.memoryUsed = set.getSize() + block.size();
+    const uint64_t keySpace = getKeySpace(alphabet.size(), length);
+    // passwords generated since the last new unique one
+    uint64_t stalled = 0;
+
+    while (report.unique < count) {
+        const size_t records = std::min<uint64_t>(count - report.unique, BLOCK_RECORDS);
+        generateRecords(block.data(), records, alphabet, length, options.threads);
+        report.generated += records;
+        for (size_t i = 0; i < records; i++) {
+            const char* record = &block[i * length];
+            if (options.blocklist && options.blocklist->contains(record, length)) {
+                report.blocked++;
+                stalled++;
+            } else if (set.insert(record)) {
+                report.unique++;
+                stalled = 0;
+            } else {
+                report.duplicates++;
+                stalled++;
+            }
+        }
+        if (isMostlyBlocked(report))
+            return reportBlocked(errors);
+        if (isExhausted(stalled, keySpace))
+            return reportExhausted(errors, count, length);
+    }
+    sodium_memzero(block.data(), block.size());
+
+    size_t slot = 0;
+    LineFiller lines(length, [&]() { return set.next(slot); });
+    return writeOutput(fd, count * (uint64_t(length) + 1),
+        [&](char* buffer, size_t bytes, uint64_t) { lines.fill(buffer, bytes); },
+        errors);
+}
+
+/**
+ * Sorts the new records of \p partition, drops the duplicates among them and
+ * merges them with the records the partition already holds, dropping the
+ * new records that are already there. Adds the number of new unique records
+ * to \p added and the number of dropped ones to \p dropped.
+ */
+bool mergePartition(SpillDirectory& directory, size_t partition,
+    unsigned int length, uint64_t& added, uint64_t& dropped, size_t& memoryUsed,
+    std::ostream& errors) {
+    const std::string newPath = directory.getPath(partition, "new");
+    const std::string sortedPath = directory.getPath(partition, "sorted");
+    const std::string mergedPath = directory.getPath(partition, "merged");
+
+    std::vector<char> records;
+    if (!readFile(newPath, records))
+        return reportError(errors, "reading a spill file");
+    const size_t count = records.size() / length;
+    std::vector<const char*> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = &records[i * length];
+    }
+    std::sort(order.begin(), order.end(), [length](const char* a, const char* b) {
+        return memcmp(a, b, length) < 0;
+    });
+    memoryUsed = std::max(memoryUsed,
+        records.size() + order.size() * sizeof(const char*) + 2 * SPILL_BUFFER_SIZE);
+
+    bool success;
+    {
+        RecordReader existing(sortedPath, length);
+        RecordWriter merged(mergedPath, length);
+        const char* previous = nullptr;
+        for (const char* record : order) {
+            if (previous != nullptr && memcmp(previous, record, length) == 0) {
+                dropped++;
+                continue;
+            }
+            previous = record;
+            while (existing.current() != nullptr &&
+                memcmp(existing.current(), record, length) < 0) {
+                merged.write(existing.current());
+                existing.advance();
+            }
+            if (existing.current() != nullptr &&
+                memcmp(existing.current(), record, length) == 0) {
+                dropped++;
+                continue;
+            }
+            merged.write(record);
+            added++;
+        }
+        for (; existing.current() != nullptr; existing.advance()) {
+            merged.write(existing.current());
+        }
+        success = merged.finish() && !existing.hasFailed();
+    }
+    sodium_memzero(records.data(), records.size());
+
+    if (!success)
+        return reportError(errors, "merging a spill file");
+    if (rename(mergedPath.c_str(), sortedPath.c_str()) != 0)
+        return reportError(errors, "rename()");
+    if (unlink(newPath.c_str()) != 0)
+        return reportError(errors, "unlink()");
+    return true;
+}
+
+/**
+ * Generates the batch in \p partitions spill files (a power of two) and
+ * writes it to \p fd.
+ */
+bool writeFromSpill(int fd, uint64_t count, const std::string& alphabet,
+    unsigned int length, size_t partitions, std::ostream& errors,
+    uniquerep& report, const uniqueopts& options) {
+    std::string parent = options.spillDirectory;
+    if (parent.empty()) {
+        const char* temp = getenv("TMPDIR");
+        parent = temp != nullptr && *temp != '\0' ? temp : "/var/tmp";
+    }
+    SpillDirectory directory(parent);
+    if (!directory.isValid())
+        return reportError(errors, "creating the spill directory");
+
+    unsigned int bits = 0;
+    while ((size_t(1) << bits) < partitions)
+        bits++;
+    const size_t bufferRecords = std::max<size_t>(1,
+        std::min<size_t>(OUTPUT_BUFFER_SIZE, options.memoryLimit / (4 * partitions)) / length);
+    std::vector<std::vector<char>> buffers(partitions);
+    std::vector<bool> dirty(partitions, false);
+    std::vector<uint64_t> sizes(partitions, 0);
+    std::vector<char> block(BLOCK_RECORDS * length);
+    report.partitions = partitions;
+    const uint64_t keySpace = getKeySpace(alphabet.size(), length);
+    // passwords generated since the last round adding a new unique one
+    uint64_t stalled = 0;
+
+    // flushes the buffer of a partition to its file of new records
+    auto flush = [&](size_t partition) {
+        std::vector<char>& buffer = buffers[partition];
+        const bool success = appendFile(directory.getPath(partition, "new"),
+            buffer.data(), buffer.size());
+        sodium_memzero(buffer.data(), buffer.size());
+        buffer.clear();
+        dirty[partition] = true;
+        return success || reportError(errors, "writing a spill file");
+    };
+
+    bool success = true;
+    while (success && report.unique < count) {
+        report.rounds++;
+        const uint64_t unique = report.unique;
+        const uint64_t generated = report.generated;
+        uint64_t missing = count - report.unique;
+        while (success && missing > 0) {
+            const size_t records = std::min<uint64_t>(missing, BLOCK_RECORDS);
+            generateRecords(block.data(), records, alphabet, length, options.threads);
+            report.generated += records;
+            missing -= records;
+            for (size_t i = 0; success && i < records; i++) {
+                const char* record = &block[i * length];
+                if (options.blocklist && options.blocklist->contains(record, length)) {
+                    report.blocked++;
+                    missing++;
+                    continue;
+                }
+                const size_t partition = bits == 0 ? 0 : hashRecord(record, length) >> (64 - bits);
+                std::vector<char>& buffer = buffers[partition];
+                buffer.insert(buffer.end(), record, record + length);
+                if (buffer.size() >= bufferRecords * length)
+                    success = flush(partition);
+            }
+            if (isMostlyBlocked(report))
+                success = reportBlocked(errors);
+        }
+        for (size_t partition = 0; success && partition < partitions; partition++) {
+            if (!buffers[partition].empty())
+                success = flush(partition);
+        }
+        for (size_t partition = 0; success && partition < partitions; partition++) {
+            if (!dirty[partition])
+                continue;
+            uint64_t added = 0;
+            success = mergePartition(directory, partition, length, added,
+                report.duplicates, report.memoryUsed, errors);
+            sizes[partition] += added;
+            report.unique += added;
+            dirty[partition] = false;
+        }
+        stalled = report.unique == unique ? stalled + report.generated - generated : 0;
+        if (success && isExhausted(stalled, keySpace))
+            success = reportExhausted(errors, count, length);
+    }
+    sodium_memzero(block.data(), block.size());
+    report.memoryUsed += partitions * bufferRecords * length + block.size();
+
+    // write every partition with its own call, so all records of a
+    // partition can be kept in memory; the records are sorted in the file,
+    // so they are written in the order of a Fisher-Yates shuffle
+    std::vector<char> records;
+    std::vector<size_t> order;
+    for (size_t partition = 0; success && partition < partitions; partition++) {
+        if (sizes[partition] == 0)
+            continue;
+        if (!readFile(directory.getPath(partition, "sorted"), records))
+            return reportError(errors, "reading a spill file");
+        order.resize(records.size() / length);
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        for (size_t i = order.size(); i > 1; i--) {
+            std::swap(order[i - 1], order[getRandomIndex(i)]);
+        }
+        size_t index = 0;
+        LineFiller lines(length, [&]() { return &records[order[index++] * length]; });
+        success = writeOutput(fd, sizes[partition] * (uint64_t(length) + 1),
+            [&](char* buffer, size_t bytes, uint64_t) { lines.fill(buffer, bytes); },
+            errors);
+        sodium_memzero(records.data(), records.size());
+    }
+    return success;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Returns the number of different passwords of \p length characters from an
+ * alphabet of \p alphabetSize characters, or \p UINT64_MAX if there are
+ * more.
+ *
+ * \param alphabetSize The number of characters in the alphabet
+ * \param length The number of characters per password
+ * \return The number of possible passwords
+ */
+uint64_t getKeySpace(size_t alphabetSize, unsigned int length) {
+    uint64_t space = 1;
+    for (unsigned int i = 0; i < length; i++) {
+        if (alphabetSize != 0 && space > UINT64_MAX / alphabetSize)
+            return UINT64_MAX;
+        space *= alphabetSize;
+    }
+    return space;
+}
+
+/**
+ * Writes \p count different passwords of \p length characters from
+ * \p alphabet, one per line, to the file descriptor \p fd (see
+ * \p writeOutput()). The order of the passwords is random: spilled batches
+ * are written one partition after another, and the records of every
+ * partition are shuffled first.
+ *
+ * \param fd The file descriptor to write to
+ * \param count The number of passwords
+ * \param alphabet The characters to choose from
+ * \param length The number of characters per password (at least 1)
+ * \param errors The stream to report errors to
+ * \param report Receives the statistics of the run
+ * \param options The options for generating the batch
+ * \return \p true on success, \p false if there are fewer than \p count
+ * possible or allowed passwords or generating or writing failed
+ */
+bool writeUniquePasswords(int fd, uint64_t count, const std::string& alphabet,
+    unsigned int length, std::ostream& errors, uniquerep& report,
+    const uniqueopts& options) {
+    report = uniquerep();
+    if (length == 0 || alphabet.empty() ||
+        getKeySpace(alphabet.size(), length) < count) {
+        errors << "ERROR: There are fewer than " << count << " different passwords "
+            << "of length " << length << "!" << std::endl;
+        return false;
+    }
+    const uint64_t start = getNanoseconds();
+
+    bool success;
+    const uint64_t capacity = roundUpToPowerOfTwo(std::max<uint64_t>(16, count + count / 2));
+    if (capacity <= options.memoryLimit / length) {
+        success = writeFromMemory(fd, count, alphabet, length, capacity, errors,
+            report, options);
+    } else {
+        // leave room for the variance of the partition sizes and for the
+        // pointers used for sorting
+        const uint64_t bytes = count * (uint64_t(length) + sizeof(const char*));
+        const uint64_t partitions = roundUpToPowerOfTwo(
+            std::max<uint64_t>(2, 2 * bytes / std::max<size_t>(1, options.memoryLimit) + 1));
+        if (partitions > UNIQUE_MAX_PARTITIONS) {
+            errors << "ERROR: The memory limit is too small for " << count
+                << " passwords!" << std::endl;
+            return false;
+        }
+        success = writeFromSpill(fd, count, alphabet, length, partitions, errors,
+            report, options);
+    }
+    report.elapsedNanoseconds = getNanoseconds() - start;
+    return success;
+}
+
+/**
+ * Writes the statistics in \p report to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param report The statistics to print
+ */
+void printUniqueReport(std::ostream& out, const uniquerep& report) {
+    const double elapsed = report.elapsedNanoseconds / 1e9;
+    out << std::fixed << std::setprecision(4)
+        << "Unique passwords:      " << report.unique << std::endl
+        << "Generated passwords:   " << report.generated << std::endl
+        << "Duplicates:            " << report.duplicates << " ("
+        << (report.generated > 0 ? 100.0 * report.duplicates / report.generated : 0.0)
+        << " %)" << std::endl
+        << "Blocked:               " << report.blocked << std::endl
+        << "Rounds:                " << report.rounds << std::endl
+        << "Spill partitions:      " << report.partitions << std::endl
+        << std::setprecision(1)
+        << "Memory used:           " << report.memoryUsed / 1048576.0 << " MiB" << std::endl
+        << std::setprecision(0)
+        << "Passwords/s:           " << (elapsed > 0 ? report.generated / elapsed : 0.0)
+        << std::endl;
+}
@@ -0,0 +1,151 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    Uniqueness.h
+ * \brief   Defines functions for generating batches of unique passwords.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file defines functions for generating a batch of passwords in which
+ * every password occurs only once, e.g. for voucher codes. All passwords of
+ * a batch have the same length, so they are stored as fixed-width records
+ * without terminators.
+ *
+ * If the batch fits into the memory limit, the records live in an
+ * open-addressing hash set with linear probing. Every generated record is
+ * inserted into the set and duplicates are generated again until the set
+ * holds enough records.
+ *
+ * Larger batches are spilled to disk: the records are radix-partitioned by
+ * the top bits of their hash into files small enough to be sorted in
+ * memory. Every partition is sorted, freed of duplicates and merged with
+ * the records the partition already holds from earlier rounds. Only the
+ * number of discarded duplicates is generated again in the next round,
+ * until the batch is complete. Every partition is shuffled when it is
+ * written, as its file is sorted. The spill files are created with mode
+ * 0600 in a private directory and removed afterwards.
+ *
+ * Generated passwords found on an optional blocklist are discarded like
+ * duplicates. If the blocklist leaves fewer passwords than requested, the
+ * batch fails once \p UNIQUE_MAX_STALL times the key space was generated
+ * without a new unique password.
+ */
+
+#ifndef GTKPASS_UNIQUENESS_H
+#define GTKPASS_UNIQUENESS_H
+
+#include "Blocklist.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/// Maximum number of spill partitions (bounds the number of files)
+#define UNIQUE_MAX_PARTITIONS 4096
+/// Number of times the key space is generated in a row without a new unique
+/// password before giving up, as the blocklist leaves too few passwords
+#define UNIQUE_MAX_STALL 32
+
+/**
+ * \typedef uniqueopts
+ * \brief Defines a struct holding the options for generating a batch of
+ * unique passwords.
+ */
+typedef struct uniqueoptions {
+    /// Initializes the options with a memory limit of 1 GiB, the default
+    /// number of threads and the default spill directory
+    uniqueoptions() : memoryLimit(size_t(1) << 30), threads(0),
+        blocklist(nullptr) {}
+    /// memory the hash set or a partition may use in bytes
+    size_t memoryLimit;
+    /// number of threads generating passwords (0 for the default)
+    unsigned int threads;
+    /// directory for the spill files (empty for \p $TMPDIR or /var/tmp)
+    std::string spillDirectory;
+    /// blocklist of passwords to discard (\p nullptr for none)
+    const Blocklist* blocklist;
+} uniqueopts;
+
+/**
+ * \typedef uniquerep
+ * \brief Defines a struct holding the statistics of generating a batch of
+ * unique passwords.
+ */
+typedef struct uniquereport {
+    /// Initializes an empty report
+    uniquereport() : unique(0), generated(0), duplicates(0), blocked(0),
+        rounds(0), partitions(0), memoryUsed(0), elapsedNanoseconds(0) {}
+    /// number of unique passwords written
+    uint64_t unique;
+    /// number of passwords generated, including the regenerated ones
+    uint64_t generated;
+    /// number of generated passwords discarded as duplicates
+    uint64_t duplicates;
+    /// number of generated passwords discarded because of the blocklist
+    uint64_t blocked;
+    /// number of generation rounds (1 without spilling)
+    unsigned int rounds;
+    /// number of spill partitions (0 if the batch fit into memory)
+    size_t partitions;
+    /// maximum number of bytes used for records, the hash set and buffers
+    size_t memoryUsed;
+    /// wall clock time of the whole run
+    uint64_t elapsedNanoseconds;
+} uniquerep;
+
+/**
+ * Returns the number of different passwords of \p length characters from an
+ * alphabet of \p alphabetSize characters, or \p UINT64_MAX if there are
+ * more.
+ *
+ * \param alphabetSize The number of characters in the alphabet
+ * \param length The number of characters per password
+ * \return The number of possible passwords
+ */
+uint64_t getKeySpace(size_t alphabetSize, unsigned int length);
+
+/**
+ * Writes \p count different passwords of \p length characters from
+ * \p alphabet, one per line, to the file descriptor \p fd (see
+ * \p writeOutput()). The order of the passwords is random: spilled batches
+ * are written one partition after another, and the records of every
+ * partition are shuffled first.
+ *
+ * \param fd The file descriptor to write to
+ * \param count The number of passwords
+ * \param alphabet The characters to choose from
+ * \param length The number of characters per password (at least 1)
+ * \param errors The stream to report errors to
+ * \param report Receives the statistics of the run
+ * \param options The options for generating the batch
+ * \return \p true on success, \p false if there are fewer than \p count
+ * possible or allowed passwords or generating or writing failed
+ */
+bool writeUniquePasswords(int fd, uint64_t count, const std::string& alphabet,
+    unsigned int length, std::ostream& errors, uniquerep& report,
+    const uniqueopts& options = uniqueopts());
+
+/**
+ * Writes the statistics in \p report to \p out in a human readable form.
+ *
+ * \param out The stream to write to
+ * \param report The statistics to print
+ */
+void printUniqueReport(std::ostream& out, const uniquerep& report);
+
+#endif
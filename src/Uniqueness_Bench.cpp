@@ -0,0 +1,69 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Uniqueness_Bench.cpp
+ * \brief   Benchmarks the files \p Uniqueness.h and \p Uniqueness.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Benchmarks the files \p Uniqueness.h and \p Uniqueness.cpp.
+ */
+
+#include "Benchmark.h"
+#include "Uniqueness.h"
+#include "RandomGenerator.h"
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/**
+ * Writes \p count unique passwords to /dev/null with a memory limit of
+ * \p memoryLimit bytes and writes the report and the peak resident memory of
+ * the process to \p out.
+ */
+static void measureUnique(std::ostream& out, uint64_t count, size_t memoryLimit) {
+    genopts options;
+    const std::string& alphabet = getAlphabet(options);
+    uniqueopts uniqueness;
+    uniqueness.memoryLimit = memoryLimit;
+
+    const int fd = open("/dev/null", O_WRONLY);
+    uniquerep report;
+    const bool success = writeUniquePasswords(fd, count, alphabet, 6, out,
+        report, uniqueness);
+    close(fd);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out << count << " passwords, memory limit " << (memoryLimit >> 20) << " MiB"
+        << (success ? "" : " (failed)") << std::endl;
+    printUniqueReport(out, report);
+    out << "Peak resident memory:  " << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+}
+
+/// Measures the throughput, collision rate and memory usage of generating
+/// 10 million and 1 billion unique 6 character alphanumeric passwords (about
+/// 5.7e10 possible passwords, so collisions are real), in memory and spilled
+/// to disk. Spilling 1 billion passwords needs about 7 GB in \p $TMPDIR
+/// (default: /var/tmp).
+BENCHMARK_CASE(unique_batch) {
+    measureUnique(out, 10000000, size_t(1) << 30);
+    measureUnique(out, 10000000, size_t(64) << 20);
+    measureUnique(out, 1000000000, size_t(1) << 30);
+}
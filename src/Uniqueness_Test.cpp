@@ -0,0 +1,144 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file    Uniqueness_Test.cpp
+ * \brief   Tests the files \p Uniqueness.h and \p Uniqueness.cpp.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * Tests the files \p Uniqueness.h and \p Uniqueness.cpp.
+ */
+
+#include "catch.hpp"
+#include "Uniqueness.h"
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Writes \p count unique passwords of \p length characters from
+ * \p alphabet to a temporary file with \p options and checks the file.
+ * Returns the report of the run and adds the lines to \p lines if given.
+ */
+static uniquerep checkUnique(uint64_t count, const std::string& alphabet,
+    unsigned int length, const uniqueopts& options,
+    std::vector<std::string>* lines = nullptr) {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    std::ostringstream errors;
+    uniquerep report;
+    REQUIRE(writeUniquePasswords(fileno(file), count, alphabet, length, errors,
+        report, options));
+    REQUIRE(errors.str().empty());
+
+    rewind(file);
+    std::set<std::string> passwords;
+    bool valid = true;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        const std::string password(line);
+        valid = valid && password.size() == length + 1 && password.back() == '\n' &&
+            password.find_first_not_of(alphabet, 0) == length;
+        passwords.insert(password);
+        if (lines != nullptr)
+            lines->push_back(password);
+    }
+    fclose(file);
+    REQUIRE(valid);
+    REQUIRE(passwords.size() == count);
+    REQUIRE(report.unique == count);
+    REQUIRE(report.generated == count + report.duplicates + report.blocked);
+    return report;
+}
+
+/// Tests the function \p getKeySpace of \p Uniqueness
+TEST_CASE("getKeySpace", "[Uniqueness]") {
+    REQUIRE(getKeySpace(2, 12) == 4096);
+    REQUIRE(getKeySpace(10, 0) == 1);
+    REQUIRE(getKeySpace(62, 10) == 839299365868340224ULL);
+    REQUIRE(getKeySpace(62, 11) == UINT64_MAX);
+}
+
+/// Tests the function \p writeUniquePasswords of \p Uniqueness
+TEST_CASE("writeUniquePasswords", "[Uniqueness]") {
+    // 3000 of 4096 possible passwords collide a lot
+    const std::string alphabet = "ab";
+    const unsigned int length = 12;
+    const uint64_t count = 3000;
+
+    SECTION("In memory") {
+        const uniquerep report = checkUnique(count, alphabet, length, uniqueopts());
+        REQUIRE(report.duplicates > 0);
+        REQUIRE(report.partitions == 0);
+        REQUIRE(report.rounds == 1);
+        REQUIRE(checkUnique(0, alphabet, length, uniqueopts()).generated == 0);
+    }
+
+    SECTION("Spilled") {
+        char directory[] = "/tmp/gtkpass-test-XXXXXX";
+        REQUIRE(mkdtemp(directory) != nullptr);
+        uniqueopts options;
+        options.memoryLimit = 16 * 1024;
+        options.threads = 2;
+        options.spillDirectory = directory;
+        std::vector<std::string> lines;
+        const uniquerep report = checkUnique(count, alphabet, length, options, &lines);
+        REQUIRE(report.duplicates > 0);
+        REQUIRE(report.partitions > 1);
+        REQUIRE(report.rounds > 1);
+        // the partitions are shuffled, so only about half of the neighbours
+        // are in ascending order instead of almost all
+        size_t ascending = 0;
+        for (size_t i = 1; i < lines.size(); i++) {
+            ascending += lines[i - 1] < lines[i];
+        }
+        REQUIRE(ascending < 3 * lines.size() / 4);
+        // all spill files are removed, so the directory is empty again
+        REQUIRE(rmdir(directory) == 0);
+    }
+
+    SECTION("Not enough passwords") {
+        std::ostringstream errors;
+        uniquerep report;
+        REQUIRE_FALSE(writeUniquePasswords(-1, 4097, alphabet, length, errors, report));
+        REQUIRE_FALSE(errors.str().empty());
+
+        uniqueopts options;
+        options.memoryLimit = 1;
+        errors.str("");
+        REQUIRE_FALSE(writeUniquePasswords(-1, 4000, alphabet, length, errors,
+            report, options));
+        REQUIRE_FALSE(errors.str().empty());
+    }
+}
+
+/// Tests the function \p printUniqueReport of \p Uniqueness
+TEST_CASE("printUniqueReport", "[Uniqueness]") {
+    uniquerep report;
+    report.unique = 90;
+    report.generated = 100;
+    report.duplicates = 10;
+
+    std::ostringstream out;
+    printUniqueReport(out, report);
+    REQUIRE(out.str().find("Duplicates:            10 (10.0000 %)") != std::string::npos);
+}
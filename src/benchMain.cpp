@@ -0,0 +1,50 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    benchMain.cpp
+ * \brief   Main file of GtkPass' benchmarks.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file is the main file for the benchmarks of GtkPass. It runs all
+ * benchmarks or the ones given on the command line. Do NOT write benchmarks
+ * directly in this file. Benchmarks should be separated in multiple files.
+ */
+
+#include "Benchmark.h"
+#include "sodium.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Main function of the benchmark program.
+ *
+ * \param argc Number of command line arguments
+ * \param argv Names of the benchmarks to run (all if none are given)
+ * \return Integer value indicating success
+ */
+int main(int argc, char* argv[]) {
+    if (sodium_init() < 0) {
+        std::cerr << "ERROR: Failed to initialize libsodium!" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> names(argv + 1, argv + argc);
+    return runBenchmarks(std::cout, names) == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    guiBenchMain.cpp
+ * \brief   Main file of GtkPass' GUI benchmarks.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file is the main file for the benchmarks of the GUI of GtkPass. It
+ * initializes GTK+ and runs all GUI benchmarks or the ones given on the
+ * command line. Do NOT write benchmarks directly in this file.
+ */
+
+#include "Benchmark.h"
+#include "sodium.h"
+#include <gtkmm.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Main function of the GUI benchmark program.
+ *
+ * \param argc Number of command line arguments
+ * \param argv Optionally "--json FILE" for writing the results to FILE,
+ * followed by the names of the benchmarks to run (all if none are given)
+ * \return Integer value indicating success
+ */
+int main(int argc, char* argv[]) {
+    if (sodium_init() < 0) {
+        std::cerr << "ERROR: Failed to initialize libsodium!" << std::endl;
+        return 1;
+    }
+    if (!gtk_init_check(&argc, &argv)) {
+        std::cerr << "ERROR: Failed to open a display!" << std::endl;
+        return 1;
+    }
+    Gtk::Main::init_gtkmm_internals();
+
+    std::vector<std::string> names(argv + 1, argv + argc);
+    std::string json;
+    if (names.size() >= 2 && names[0] == "--json") {
+        json = names[1];
+        names.erase(names.begin(), names.begin() + 2);
+    }
+    const int unknown = runBenchmarks(std::cout, names);
+    if (!json.empty()) {
+        std::ofstream file(json);
+        writeResultsJson(file);
+        if (!file) {
+            std::cerr << "ERROR: Failed to write \"" << json << "\"!" << std::endl;
+            return 1;
+        }
+    }
+    return unknown == 0 ? 0 : 1;
+}
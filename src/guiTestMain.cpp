@@ -0,0 +1,52 @@
+/* Copyright (C) 2017 Kevin Kirchner
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file    guiTestMain.cpp
+ * \brief   Main file of GtkPass' tests of the window.
+ * \author  Kevin Kirchner
+ * \date    2017
+ * \copyright GNU GPL Version 3
+ *
+ * This file is the main file for the tests of the window. It initializes
+ * libsodium and GTK and runs Catch. Do NOT write tests directly in this file.
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+#include "sodium.h"
+#include <gtkmm.h>
+#include <iostream>
+
+/**
+ * Main function of the tests of the window.
+ *
+ * \param argc Number of command line arguments
+ * \param argv Array of strings containing the command line arguments of Catch
+ * \return Integer value indicating success
+ */
+int main(int argc, char* argv[]) {
+    if (sodium_init() < 0) {
+        std::cerr << "ERROR: Failed to initialize libsodium!" << std::endl;
+        return 1;
+    }
+    if (!gtk_init_check(&argc, &argv)) {
+        std::cerr << "ERROR: Failed to open a display!" << std::endl;
+        return 1;
+    }
+    Gtk::Main::init_gtkmm_internals();
+    return Catch::Session().run(argc, argv);
+}
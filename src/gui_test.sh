@@ -0,0 +1,4 @@
+#!/bin/sh
+# Runs the tests of the window on a private headless display.
+
+"${SHELL:-/bin/sh}" "${srcdir:-.}/headless.sh" "./GtkPassGuiTest${EXEEXT}"
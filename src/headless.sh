@@ -0,0 +1,70 @@
+#!/bin/sh
+# Runs the command given as arguments on a private headless display, so the
+# GUI tests and benchmarks do not depend on the desktop: Xvfb if available,
+# the GTK Broadway server otherwise. Exits with 77 (skipped) if neither is
+# installed, otherwise with the status of the command. The display number is
+# never fixed, so parallel runs and other X servers do not get in the way.
+
+# waits up to 5 seconds until the command given as arguments succeeds or the
+# server has exited
+wait_for() {
+    tries=0
+    while ! "$@" && kill -0 "$server" 2>/dev/null && [ $tries -lt 50 ]; do
+        sleep 0.1
+        tries=$((tries + 1))
+    done
+    "$@"
+}
+
+if command -v Xvfb >/dev/null 2>&1; then
+    # Xvfb picks a free display itself and writes its number to the file
+    # once it accepts connections
+    numberfile=$(mktemp "${TMPDIR:-/tmp}/headless.XXXXXX") || exit 1
+    Xvfb -displayfd 3 -screen 0 1280x1024x24 -nolisten tcp \
+        3>"$numberfile" >/dev/null 2>&1 &
+    server=$!
+    trap 'kill $server 2>/dev/null; rm -f "$numberfile"' EXIT
+    trap 'exit 1' INT TERM
+    if ! wait_for test -s "$numberfile"; then
+        echo "Xvfb did not start, skipping $1"
+        exit 77
+    fi
+    display=$(cat "$numberfile")
+    DISPLAY=":$display"
+    export DISPLAY
+    unset WAYLAND_DISPLAY
+    GDK_BACKEND=x11
+elif command -v broadwayd >/dev/null 2>&1; then
+    # broadwayd cannot pick a display, so try the numbers whose socket does
+    # not exist until one of them starts (the port may still be taken)
+    runtime="${XDG_RUNTIME_DIR:-/tmp}"
+    display=1
+    server=
+    trap 'kill $server 2>/dev/null' EXIT
+    trap 'exit 1' INT TERM
+    while [ $display -lt 100 ]; do
+        socket="$runtime/broadway$((display + 1)).socket"
+        if [ ! -e "$socket" ]; then
+            broadwayd ":$display" >/dev/null 2>&1 &
+            server=$!
+            if wait_for test -S "$socket"; then
+                break
+            fi
+            kill $server 2>/dev/null
+        fi
+        display=$((display + 1))
+    done
+    if [ $display -ge 100 ]; then
+        echo "No free Broadway display found, skipping $1"
+        exit 77
+    fi
+    BROADWAY_DISPLAY=":$display"
+    export BROADWAY_DISPLAY
+    GDK_BACKEND=broadway
+else
+    echo "Neither Xvfb nor broadwayd found, skipping $1"
+    exit 77
+fi
+export GDK_BACKEND
+
+"$@"
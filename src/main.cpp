@@ -34,6 +34,7 @@
 
 #include "RandomGenerator.h"
 #include "Application.h"
+#include "Startup.h"
 #include <glibmm/i18n.h>
 #include <iostream>
 
@@ -45,15 +46,18 @@
  * \return Integer value indicating success
  */
 int main(int argc, char* argv[]) {
+    markStartup("main");
     if (sodium_init() == 1) {
         std::cerr << "ERROR: Failed to initialize libsodium!" << std::endl;
         return 1;
     }
+    markStartup("sodium_init");
     // setup gettext for translation
     bindtextdomain(GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR);
     bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
     textdomain(GETTEXT_PACKAGE);
-    
+    markStartup("gettext");
+
     auto application = GtkPassApplication::create();
     return application->run(argc, argv);
 }
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Checks that all USDT probes of the provider "gtkpass" are present in the
+# ELF notes of the built GtkPass binary.
+
+binary="./GtkPass${EXEEXT}"
+probes="
+random_string_entry
+random_string_return
+rng_refill
+rejection_retry
+generate_password_entry
+generate_password_return
+update_entropy_entry
+update_entropy_return
+"
+
+notes=`${READELF:-readelf} -n "$binary"` || exit 99
+echo "$notes" | grep -q "Provider: gtkpass" || {
+    echo "No USDT notes of provider \"gtkpass\" in $binary"
+    exit 1
+}
+
+status=0
+for probe in $probes; do
+    if echo "$notes" | grep -q "Name: $probe\$"; then
+        echo "found probe: $probe"
+    else
+        echo "missing probe: $probe"
+        status=1
+    fi
+done
+exit $status
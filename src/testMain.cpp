@@ -22,10 +22,28 @@
  * \copyright GNU GPL Version 3
  *
  *
- * This file is the main file for the tests written for Polaris. It only
- * initializes Catch and includes its header. Do NOT write test directly in
- * this file. Test should be separated in multiple files.
+ * This file is the main file for the tests written for Polaris. It
+ * initializes libsodium and runs Catch. Do NOT write test directly in this
+ * file. Test should be separated in multiple files.
  */
 
-#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
+#include "sodium.h"
+#include <iostream>
+
+/**
+ * Main function of the unit tests. Initializes libsodium first, as memory
+ * allocated with \p sodium_malloc() by the tested code needs it.
+ *
+ * \param argc Number of command line arguments
+ * \param argv Array of strings containing the command line arguments of Catch
+ * \return Integer value indicating success
+ */
+int main(int argc, char* argv[]) {
+    if (sodium_init() < 0) {
+        std::cerr << "ERROR: Failed to initialize libsodium!" << std::endl;
+        return 1;
+    }
+    return Catch::Session().run(argc, argv);
+}